@@ -0,0 +1,65 @@
+#include <spdlog/spdlog.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "common/job-system.h"
+#include "common/light-clusters.h"
+
+// Usage : clusters [maxThreads]
+// Lights of random radius scattered in a box in front of the camera, binned into the clusters of a 1280x720 view.
+// Only the CPU binning is measured, upload() is never called so no GL context is needed.
+
+using Clock = std::chrono::high_resolution_clock;
+
+std::vector<PointLight> scatterLights(std::size_t count) {
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::vector<PointLight> lights(count);
+    for (PointLight& light : lights) {
+        light.position = glm::vec3(unit(random) * 60.0f - 30.0f, unit(random) * 20.0f - 10.0f, -unit(random) * 80.0f);
+        light.radius = 0.5f + unit(random) * 2.5f;
+        light.color = glm::vec3(unit(random), unit(random), unit(random));
+        light.intensity = 1.0f;
+    }
+    return lights;
+}
+
+template<typename F>
+double bestMs(const F& function) {
+    double best = 1e30;
+    for (int r = 0; r < 10; r++) {
+        const auto start = Clock::now();
+        function();
+        best = std::min(best, std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+    }
+    return best;
+}
+
+int main(int argc, char *argv[]) {
+    spdlog::set_pattern("[%l] %^ %v %$");
+
+    const unsigned int maxThreads = argc > 1 ? static_cast<unsigned int>(std::atoi(argv[1])) : std::max(1u, std::thread::hardware_concurrency());
+    const glm::mat4 projection = glm::perspective(glm::radians(60.0f), 1280.0f / 720.0f, 0.1f, 100.0f);
+    const glm::mat4 view = glm::lookAt(glm::vec3(0, 2, 5), glm::vec3(0, 0, -20), glm::vec3(0, 1, 0));
+
+    spdlog::info("[LightClusters] {}x{}x{} clusters, {} lights at most per cluster", LightClusters::TILES_X, LightClusters::TILES_Y,
+                 LightClusters::SLICES, LightClusters::MAX_LIGHTS_PER_CLUSTER);
+    spdlog::info("threads | lights | bin (ms) | indices | dropped");
+
+    for (unsigned int threads = 1; threads <= maxThreads; threads++) {
+        JobSystem jobs(threads);
+        LightClusters clusters(jobs, 1280, 720);
+        for (std::size_t count : { 1024, 4096, 16384 }) {
+            const std::vector<PointLight> lights = scatterLights(count);
+            const double binMs = bestMs([&] { clusters.bin(lights, view, projection); });
+            spdlog::info("{:7} | {:6} | {:8.3f} | {:7} | {:7}", threads, count, binMs, clusters.indices().size(), clusters.overflowCount());
+        }
+    }
+    return 0;
+}
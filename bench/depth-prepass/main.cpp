@@ -0,0 +1,162 @@
+#include <SDL2/SDL.h>
+#include <glad/glad.h>
+#include <spdlog/spdlog.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "common/app.h"
+#include "common/gl-exception.h"
+#include "common/gpu-timer.h"
+#include "common/index-buffer.h"
+#include "common/material.h"
+#include "common/render-queue.h"
+#include "common/shader-utils.h"
+
+// Layers of tiles covering the whole view, submitted back to front with 4 materials whose fragment shader is heavy.
+// Sorted by state, the draws of a material go front to back but the materials overdraw each other :
+// the nearest layer of the first material is the farthest of the nearest layers.
+// GPU time of the flush and fragments passing the depth test (both passes) are averaged over FRAME_COUNT frames.
+
+const int LAYER_COUNT = 16;
+const int GRID_SIZE = 8;
+const int MATERIAL_COUNT = 4;
+const int WARMUP_FRAMES = 10;
+const int FRAME_COUNT = 100;
+
+const char* VERTEX_SHADER = R"(#version 330 core
+layout (location = 0) in vec3 aPosition;
+uniform mat4 uModel;
+uniform mat4 uViewProj;
+invariant gl_Position;
+out vec2 vUv;
+void main() {
+    vUv = aPosition.xy;
+    gl_Position = uViewProj * uModel * vec4(aPosition, 1.0);
+}
+)";
+
+const char* FRAGMENT_SHADER = R"(#version 330 core
+layout (std140) uniform Material {
+    vec4 uTint;
+};
+in vec2 vUv;
+out vec4 FragColor;
+void main() {
+    // Stands for heavy lighting
+    vec3 color = vec3(0.0);
+    for (int i = 0; i < 64; i++) {
+        color += abs(sin(vec3(vUv * float(i + 1), float(i)) + uTint.rgb));
+    }
+    FragColor = vec4(color / 64.0 * uTint.rgb, 1.0);
+}
+)";
+
+struct Mode {
+    const char* name;
+    bool sorting;
+    bool frontToBack;
+    bool depthPrePass;
+};
+
+int main(int, char*[]) { // SDL_main needs this signature
+    App app;
+
+    // ------------------ Quad of [0, 1]², positions only so that it is also its own depth vertex array
+    const float positions[] = { 0, 0, 0,  1, 0, 0,  1, 1, 0,  0, 1, 0 };
+    const std::uint8_t indices[] = { 0, 1, 2, 0, 2, 3 };
+    GLuint vb, vao;
+    IndexBuffer ib;
+    GLCall(glGenBuffers(1, &vb));
+    GLCall(glGenVertexArrays(1, &vao));
+    GLCall(glBindVertexArray(vao));
+    GLCall(glBindBuffer(GL_ARRAY_BUFFER, vb));
+    GLCall(glBufferData(GL_ARRAY_BUFFER, sizeof(positions), positions, GL_STATIC_DRAW));
+    GLCall(glEnableVertexAttribArray(0));
+    GLCall(glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), NULL));
+    GLCall(glBindVertexArray(0));
+    ib.setData(indices, 6, 4);
+
+    // ------------------ Materials
+    const GLuint program = shaderUtils::createProgram({ { GL_VERTEX_SHADER, VERTEX_SHADER }, { GL_FRAGMENT_SHADER, FRAGMENT_SHADER } });
+    MaterialLibrary materials;
+    std::vector<Material*> layerMaterials;
+    for (int i = 0; i < MATERIAL_COUNT; i++) {
+        Material& material = materials.create("Heavy " + std::to_string(i), program, MaterialLayout().add("uTint", MaterialLayout::Type::VEC4));
+        material.set("uTint", glm::vec4(0.4f + 0.2f * i, 1.0f - 0.2f * i, 0.5f, 1.0f));
+        layerMaterials.push_back(&material);
+    }
+    materials.upload();
+
+    // ------------------ Tiles, the view looks down -Z from the origin
+    const glm::mat4 viewProj = glm::perspective(glm::radians(60.0f), static_cast<float>(app.width()) / app.height(), 0.1f, 100.0f);
+    std::vector<RenderQueue::DrawCall> calls;
+    std::vector<float> depths;
+    for (int layer = LAYER_COUNT - 1; layer >= 0; layer--) {
+        const float depth = 2.0f + layer;
+        const float extent = depth * 1.2f; // Wider than the view at this depth
+        for (int y = 0; y < GRID_SIZE; y++) {
+            for (int x = 0; x < GRID_SIZE; x++) {
+                const float tile = 2.0f * extent / GRID_SIZE;
+                glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(-extent + x * tile, -extent + y * tile, -depth));
+                model = glm::scale(model, glm::vec3(tile, tile, 1.0f));
+                calls.push_back({ layerMaterials[(LAYER_COUNT - 1 - layer) % MATERIAL_COUNT], vao, &ib, 1, model });
+                depths.push_back(depth);
+            }
+        }
+    }
+
+    const Mode modes[] = {
+        { "Submission", false, false, false },
+        { "State order", true, false, false },
+        { "Front to back", true, true, false },
+        { "Depth pre-pass", true, false, true }
+    };
+
+    RenderQueue queue;
+    GpuTimer timer;
+    GLuint samplesQuery;
+    GLCall(glGenQueries(1, &samplesQuery));
+    spdlog::info("[Bench] {} draws of {} layers, {}x{} pixels", calls.size(), LAYER_COUNT, app.width(), app.height());
+
+    for (const Mode& mode : modes) {
+        queue.setSortingEnabled(mode.sorting);
+        queue.setFrontToBackEnabled(mode.frontToBack);
+        queue.setDepthPrePassEnabled(mode.depthPrePass);
+
+        double gpuMs = 0.0;
+        double fragments = 0.0;
+        for (int frame = 0; frame < WARMUP_FRAMES + FRAME_COUNT; frame++) {
+            app.beginFrame();
+            queue.setViewProj(viewProj);
+            for (std::size_t i = 0; i < calls.size(); i++) {
+                queue.submit(RenderPass::SOLID, calls[i], depths[i]);
+            }
+
+            timer.begin();
+            GLCall(glBeginQuery(GL_SAMPLES_PASSED, samplesQuery));
+            queue.flush();
+            GLCall(glEndQuery(GL_SAMPLES_PASSED));
+            timer.end();
+
+            GLuint samples = 0;
+            GLCall(glGetQueryObjectuiv(samplesQuery, GL_QUERY_RESULT, &samples));
+            if (frame >= WARMUP_FRAMES) {
+                gpuMs += timer.lastMs();
+                fragments += samples;
+            }
+            app.endFrame();
+        }
+
+        spdlog::info("[Bench] {:<14} : {:.3f} ms GPU, {:.2f} fragments per pixel", mode.name,
+                     gpuMs / FRAME_COUNT, fragments / FRAME_COUNT / (app.width() * app.height()));
+    }
+
+    GLCall(glDeleteQueries(1, &samplesQuery));
+    GLCall(glDeleteVertexArrays(1, &vao));
+    GLCall(glDeleteBuffers(1, &vb));
+    GLCall(glDeleteProgram(program));
+    return 0;
+}
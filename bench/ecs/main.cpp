@@ -0,0 +1,133 @@
+#include <spdlog/spdlog.h>
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "common/ecs.h"
+#include "common/job-system.h"
+#include "common/scene-culling.h"
+
+// Usage : ecs [maxThreads]
+// 1M entities spread over 4 archetypes : every one has a Transform, Bounds and Renderable, some have Velocity or Tag.
+
+using Clock = std::chrono::high_resolution_clock;
+
+const std::uint32_t ENTITY_COUNT = 1000000;
+
+struct Velocity {
+    glm::vec3 value;
+    float drag;
+};
+
+struct Tag {
+    std::uint32_t value;
+};
+
+double elapsedMs(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+template<typename F>
+double bestMs(int repeat, const F& function) {
+    double best = 1e30;
+    for (int r = 0; r < repeat; r++) {
+        const auto start = Clock::now();
+        function();
+        best = std::min(best, elapsedMs(start));
+    }
+    return best;
+}
+
+std::vector<Entity> buildWorld(EntityWorld& world) {
+    std::vector<Entity> entities;
+    entities.reserve(ENTITY_COUNT);
+    for (std::uint32_t i = 0; i < ENTITY_COUNT; i++) {
+        const Entity entity = world.create(Transform{ glm::vec3(i % 1000, 0, i / 1000) }, Bounds{}, Renderable{ i % 4 });
+        if (i % 2 == 0) {
+            world.add(entity, Velocity{ glm::vec3(0.0f, 1.0f, 0.0f), 0.9f });
+        }
+        if (i % 3 == 0) {
+            world.add(entity, Tag{ i });
+        }
+        entities.push_back(entity);
+    }
+    return entities;
+}
+
+// ------------------ Iteration : integrate velocities, on one thread then on the JobSystem
+
+void integrate(std::uint32_t count, const Entity*, Transform* transforms, Velocity* velocities) {
+    for (std::uint32_t i = 0; i < count; i++) {
+        transforms[i].position += velocities[i].value * 0.016f;
+        velocities[i].value *= velocities[i].drag;
+    }
+}
+
+// ------------------ Churn : add then remove a component on a tenth of the entities
+
+double churnNs(EntityWorld& world, const std::vector<Entity>& entities) {
+    const auto start = Clock::now();
+    std::uint32_t changes = 0;
+    for (std::size_t i = 0; i < entities.size(); i += 10) {
+        world.add(entities[i], Velocity{ glm::vec3(1.0f), 0.5f });
+        world.remove<Tag>(entities[i]);
+        changes += 2;
+    }
+    for (std::size_t i = 0; i < entities.size(); i += 10) {
+        world.remove<Velocity>(entities[i]);
+        world.add(entities[i], Tag{ 0 });
+        changes += 2;
+    }
+    return elapsedMs(start) * 1e6 / changes;
+}
+
+int main(int argc, char *argv[]) {
+    spdlog::set_pattern("[%l] %^ %v %$");
+
+    const unsigned int maxThreads = argc > 1 ? static_cast<unsigned int>(std::atoi(argv[1])) : std::max(1u, std::thread::hardware_concurrency());
+
+    EntityWorld world;
+    auto start = Clock::now();
+    const std::vector<Entity> entities = buildWorld(world);
+    spdlog::info("[EntityWorld] {} entities in {} archetypes and {} chunks, created in {:.1f} ms",
+                 world.entityCount(), world.archetypeCount(), world.chunkCount(), elapsedMs(start));
+
+    // ------------------ Single thread
+    const double eachMs = bestMs(10, [&] { world.eachChunk<Transform, Velocity>(integrate); });
+    const double countUs = bestMs(1000, [&] { volatile std::size_t count = world.count<Transform, Velocity, Tag>(); (void)count; }) * 1000.0;
+    const double lookupNs = bestMs(10, [&] {
+        float sum = 0.0f;
+        for (std::size_t i = 0; i < entities.size(); i += 7) {
+            sum += world.get<Transform>(entities[i]).position.x;
+        }
+        volatile float result = sum; (void)result;
+    }) * 1e6 / (entities.size() / 7);
+    spdlog::info("Iterate {} Transform + Velocity : {:.3f} ms", world.count<Transform, Velocity>(), eachMs);
+    spdlog::info("Query count over {} archetypes : {:.3f} us, random get : {:.1f} ns", world.archetypeCount(), countUs, lookupNs);
+    spdlog::info("Add / remove component : {:.1f} ns per change", churnNs(world, entities));
+
+    // ------------------ Per thread count
+    spdlog::info("threads | iterate (ms) | cull 1M (ms) | visible | speedup");
+    double singleThreadMs = 0.0;
+    for (unsigned int threads = 1; threads <= maxThreads; threads++) {
+        JobSystem jobs(threads);
+        SceneCulling culling(jobs);
+        const glm::mat4 viewProj = glm::mat4(0.004f, 0, 0, 0, 0, 0.002f, 0, 0, 0, 0, 0.002f, 0, -1, 0, -1, 1); // Half of the grid along x
+
+        const double iterateMs = bestMs(10, [&] { world.parallelEachChunk<Transform, Velocity>(jobs, integrate); });
+        const double cullMs = bestMs(10, [&] { culling.cull(world, viewProj); });
+        std::size_t visible = 0;
+        for (std::uint32_t batch = 0; batch < 4; batch++) {
+            visible += culling.visible(batch).size();
+        }
+        if (threads == 1) {
+            singleThreadMs = iterateMs;
+        }
+        spdlog::info("{:7} | {:12.3f} | {:12.3f} | {:7} | {:.2f}x", threads, iterateMs, cullMs, visible, singleThreadMs / iterateMs);
+    }
+    return 0;
+}
@@ -0,0 +1,125 @@
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common/job-system.h"
+#include "common/mesh-importer.h"
+
+// Usage : importer [mesh.obj|mesh.gltf|mesh.glb] [maxThreads]
+// Without a mesh, a sphere of about 10M triangles is generated as OBJ and GLB in the working directory.
+
+const float PI = 3.14159265f;
+
+void writeSphereObj(const std::string& filepath, int rings, int segments) {
+    std::FILE* file = std::fopen(filepath.c_str(), "wb");
+    for (int r = 0; r <= rings; r++) {
+        for (int s = 0; s <= segments; s++) {
+            const float theta = PI * r / rings, phi = 2.0f * PI * s / segments;
+            const float x = std::sin(theta) * std::cos(phi), y = std::cos(theta), z = std::sin(theta) * std::sin(phi);
+            std::fprintf(file, "v %.6f %.6f %.6f\nvn %.6f %.6f %.6f\nvt %.6f %.6f\n", x, y, z, x, y, z, float(s) / segments, 1.0f - float(r) / rings);
+        }
+    }
+    for (int r = 0; r < rings; r++) {
+        for (int s = 0; s < segments; s++) {
+            const int a = r * (segments + 1) + s + 1, b = a + segments + 1;
+            std::fprintf(file, "f %d/%d/%d %d/%d/%d %d/%d/%d\n", a, a, a, b, b, b, a + 1, a + 1, a + 1);
+            std::fprintf(file, "f %d/%d/%d %d/%d/%d %d/%d/%d\n", a + 1, a + 1, a + 1, b, b, b, b + 1, b + 1, b + 1);
+        }
+    }
+    std::fclose(file);
+}
+
+// Same sphere, positions and indices in the binary chunk
+void writeSphereGlb(const std::string& filepath, int rings, int segments) {
+    std::vector<float> positions;
+    std::vector<std::uint32_t> indices;
+    for (int r = 0; r <= rings; r++) {
+        for (int s = 0; s <= segments; s++) {
+            const float theta = PI * r / rings, phi = 2.0f * PI * s / segments;
+            positions.insert(positions.end(), { std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi) });
+        }
+    }
+    for (int r = 0; r < rings; r++) {
+        for (int s = 0; s < segments; s++) {
+            const std::uint32_t a = r * (segments + 1) + s, b = a + segments + 1;
+            indices.insert(indices.end(), { a, b, a + 1, a + 1, b, b + 1 });
+        }
+    }
+
+    const std::size_t positionBytes = positions.size() * sizeof(float), indexBytes = indices.size() * sizeof(std::uint32_t);
+    std::string json = "{\"asset\":{\"version\":\"2.0\"},\"scene\":0,\"scenes\":[{\"nodes\":[0]}],\"nodes\":[{\"mesh\":0}],"
+        "\"meshes\":[{\"primitives\":[{\"attributes\":{\"POSITION\":0},\"indices\":1}]}],"
+        "\"buffers\":[{\"byteLength\":" + std::to_string(positionBytes + indexBytes) + "}],"
+        "\"bufferViews\":[{\"buffer\":0,\"byteLength\":" + std::to_string(positionBytes) + "},"
+        "{\"buffer\":0,\"byteOffset\":" + std::to_string(positionBytes) + ",\"byteLength\":" + std::to_string(indexBytes) + "}],"
+        "\"accessors\":[{\"bufferView\":0,\"componentType\":5126,\"count\":" + std::to_string(positions.size() / 3) + ",\"type\":\"VEC3\"},"
+        "{\"bufferView\":1,\"componentType\":5125,\"count\":" + std::to_string(indices.size()) + ",\"type\":\"SCALAR\"}]}";
+    json.resize((json.size() + 3) & ~std::size_t(3), ' ');
+
+    const std::uint32_t jsonChunk[2] = { static_cast<std::uint32_t>(json.size()), 0x4E4F534A };
+    const std::uint32_t binChunk[2] = { static_cast<std::uint32_t>(positionBytes + indexBytes), 0x004E4942 };
+    const std::uint32_t header[3] = { 0x46546C67, 2, static_cast<std::uint32_t>(12 + 8 + json.size() + 8 + binChunk[0]) };
+
+    std::ofstream stream(filepath, std::ios::binary);
+    stream.write(reinterpret_cast<const char*>(header), sizeof(header));
+    stream.write(reinterpret_cast<const char*>(jsonChunk), sizeof(jsonChunk));
+    stream.write(json.data(), json.size());
+    stream.write(reinterpret_cast<const char*>(binChunk), sizeof(binChunk));
+    stream.write(reinterpret_cast<const char*>(positions.data()), positionBytes);
+    stream.write(reinterpret_cast<const char*>(indices.data()), indexBytes);
+}
+
+int main(int argc, char *argv[]) {
+    spdlog::set_pattern("[%l] %^ %v %$");
+
+    std::vector<std::string> files;
+    if (argc > 1) {
+        files.push_back(argv[1]);
+    } else {
+        const int rings = 1600, segments = 3200; // 10.2M triangles
+        spdlog::info("[Importer] Generating a sphere of {} triangles", rings * segments * 2);
+        writeSphereObj("bench-sphere.obj", rings, segments);
+        writeSphereGlb("bench-sphere.glb", rings, segments);
+        files = { "bench-sphere.obj", "bench-sphere.glb" };
+    }
+    const unsigned int maxThreads = argc > 2 ? std::atoi(argv[2]) : std::max(1u, std::thread::hardware_concurrency());
+
+    for (const std::string& file : files) {
+        spdlog::info("[Importer] {}", file);
+        spdlog::info("threads | read (ms) | parse (ms) | build (ms) | total (ms) | Mtris/s | speedup");
+
+        MeshData mesh;
+        double singleThreadMs = 0.0;
+        for (unsigned int threads = 1; threads <= maxThreads; threads = threads < maxThreads ? std::min(threads * 2, maxThreads) : threads + 1) {
+            JobSystem jobs(threads);
+            MeshImporter importer(jobs);
+
+            // Best of 3, the first run also warms the file cache
+            MeshImporter::Stats best;
+            best.totalMs = 1e30;
+            for (int r = 0; r < 3; r++) {
+                if (!importer.load(file, mesh)) {
+                    return 1;
+                }
+                if (importer.stats().totalMs < best.totalMs) {
+                    best = importer.stats();
+                }
+            }
+            if (threads == 1) {
+                singleThreadMs = best.totalMs;
+            }
+
+            spdlog::info("{:7} | {:9.1f} | {:10.1f} | {:10.1f} | {:10.1f} | {:7.1f} | {:.2f}x", threads, best.readMs, best.parseMs, best.buildMs, best.totalMs,
+                mesh.triangleCount() / best.totalMs / 1e3, singleThreadMs / best.totalMs);
+        }
+        spdlog::info("[Importer] {} vertices, {} triangles", mesh.vertices.size(), mesh.triangleCount());
+    }
+
+    return 0;
+}
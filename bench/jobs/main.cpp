@@ -0,0 +1,112 @@
+#include <spdlog/spdlog.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "common/job-system.h"
+
+using Clock = std::chrono::high_resolution_clock;
+
+double elapsedNs(Clock::time_point start, Clock::time_point end) {
+    return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+}
+
+// ------------------ Spawn : create, run and wait many empty jobs
+
+double spawnLatencyNs(JobSystem& jobs) {
+    const std::uint32_t jobCount = 2000;
+    const int repeat = 200;
+
+    double best = 1e30;
+    for (int r = 0; r < repeat; r++) {
+        auto start = Clock::now();
+        Job* root = jobs.createJob([] {});
+        for (std::uint32_t i = 0; i < jobCount; i++) {
+            jobs.run(jobs.createChildJob(root, [] {}));
+        }
+        jobs.run(root);
+        jobs.wait(root);
+        best = std::min(best, elapsedNs(start, Clock::now()) / jobCount);
+    }
+    return best;
+}
+
+// ------------------ Steal : time between a push on the main thread and the start on a worker
+
+double stealLatencyNs(JobSystem& jobs) {
+    const int repeat = 2000;
+    std::vector<double> samples;
+    samples.reserve(repeat);
+
+    for (int r = 0; r < repeat; r++) {
+        std::atomic<std::int64_t> startedAt(0);
+        Job* job = jobs.createJob([&startedAt] {
+            startedAt.store(Clock::now().time_since_epoch().count());
+        });
+        const auto pushedAt = Clock::now();
+        jobs.run(job);
+
+        // Don't help, so that the job can only be stolen
+        while (!jobs.isFinished(job)) {
+            std::this_thread::yield();
+        }
+        samples.push_back(elapsedNs(pushedAt, Clock::time_point(Clock::duration(startedAt.load()))));
+    }
+
+    std::sort(samples.begin(), samples.end());
+    return samples[samples.size() / 2];
+}
+
+// ------------------ Scaling : per-frame style transform update with parallelFor
+
+double transformUpdateMs(JobSystem& jobs, std::vector<glm::mat4>& matrices, std::uint32_t grainSize) {
+    const int repeat = 20;
+    const std::uint32_t count = static_cast<std::uint32_t>(matrices.size());
+
+    double best = 1e30;
+    for (int r = 0; r < repeat; r++) {
+        auto start = Clock::now();
+        Job* root = jobs.parallelFor(0, count, grainSize, [&](std::uint32_t begin, std::uint32_t end) {
+            for (std::uint32_t i = begin; i < end; i++) {
+                const float angle = static_cast<float>(i) * 0.001f + static_cast<float>(r);
+                glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(i % 100, i / 100 % 100, i / 10000));
+                model = glm::rotate(model, angle, glm::vec3(0, 1, 0));
+                matrices[i] = glm::scale(model, glm::vec3(0.5f));
+            }
+        });
+        jobs.run(root);
+        jobs.wait(root);
+        best = std::min(best, elapsedNs(start, Clock::now()) / 1e6);
+    }
+    return best;
+}
+
+int main() {
+    spdlog::set_pattern("[%l] %^ %v %$");
+
+    const unsigned int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<glm::mat4> matrices(1000000);
+
+    spdlog::info("[JobSystem] {} hardware threads, {} transforms per update", maxThreads, matrices.size());
+    spdlog::info("threads | spawn (ns/job) | steal (ns) | update (ms) | speedup");
+
+    double singleThreadMs = 0.0;
+    for (unsigned int threads = 1; threads <= maxThreads; threads++) {
+        JobSystem jobs(threads);
+
+        const double spawn = spawnLatencyNs(jobs);
+        const double steal = threads > 1 ? stealLatencyNs(jobs) : 0.0;
+        const double update = transformUpdateMs(jobs, matrices, 1024);
+        if (threads == 1) {
+            singleThreadMs = update;
+        }
+
+        spdlog::info("{:7} | {:14.1f} | {:10.0f} | {:11.3f} | {:.2f}x", threads, spawn, steal, update, singleThreadMs / update);
+    }
+
+    return 0;
+}
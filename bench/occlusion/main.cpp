@@ -0,0 +1,72 @@
+#include <spdlog/spdlog.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+
+#include "common/ecs.h"
+#include "common/job-system.h"
+#include "common/occlusion-buffer.h"
+#include "common/scene-culling.h"
+
+// Usage : occlusion [maxThreads]
+// A block of 50x50x50 touching cubes seen from the front, the cubes of the front face are the occluders.
+
+using Clock = std::chrono::high_resolution_clock;
+
+const int BLOCK_SIZE = 50;
+
+void buildBlock(EntityWorld& world) {
+    for (int z = 0; z < BLOCK_SIZE; z++) {
+        for (int y = 0; y < BLOCK_SIZE; y++) {
+            for (int x = 0; x < BLOCK_SIZE; x++) {
+                const glm::vec3 position = glm::vec3(x - BLOCK_SIZE / 2, y - BLOCK_SIZE / 2, -z) * 2.0f;
+                const Entity cube = world.create(Transform{ position }, Bounds{ glm::vec3(0.0f), 1.7320508f }, Renderable{ 0 });
+                if (z == 0) {
+                    world.add(cube, Occluder{});
+                }
+            }
+        }
+    }
+}
+
+template<typename F>
+double bestMs(const F& function) {
+    double best = 1e30;
+    for (int r = 0; r < 10; r++) {
+        const auto start = Clock::now();
+        function();
+        best = std::min(best, std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+    }
+    return best;
+}
+
+int main(int argc, char *argv[]) {
+    spdlog::set_pattern("[%l] %^ %v %$");
+
+    const unsigned int maxThreads = argc > 1 ? static_cast<unsigned int>(std::atoi(argv[1])) : std::max(1u, std::thread::hardware_concurrency());
+    const glm::mat4 viewProj = glm::perspective(glm::radians(60.0f), 1.0f, 0.5f, 500.0f) * glm::lookAt(glm::vec3(0, 0, 80), glm::vec3(0, 0, 0), glm::vec3(0, 1, 0));
+
+    EntityWorld world;
+    buildBlock(world);
+    spdlog::info("[OcclusionBuffer] {} cubes, {} occluders", world.count<Renderable>(), world.count<Occluder>());
+    spdlog::info("threads | frustum only (ms) | visible | with occlusion (ms) | rasterize (ms) | visible | occluded");
+
+    for (unsigned int threads = 1; threads <= maxThreads; threads++) {
+        JobSystem jobs(threads);
+        OcclusionBuffer occlusion(jobs);
+        SceneCulling frustumOnly(jobs);
+        SceneCulling occluded(jobs, &occlusion);
+
+        const double frustumMs = bestMs([&] { frustumOnly.cull(world, viewProj); });
+        const double occlusionMs = bestMs([&] { occluded.cull(world, viewProj); });
+        const double rasterizeMs = bestMs([&] { occlusion.rasterize(); });
+
+        spdlog::info("{:7} | {:17.3f} | {:7} | {:19.3f} | {:14.3f} | {:7} | {:8}", threads,
+                     frustumMs, frustumOnly.visible(0).size(), occlusionMs, rasterizeMs,
+                     occluded.visible(0).size(), frustumOnly.visible(0).size() - occluded.visible(0).size());
+    }
+    return 0;
+}
@@ -0,0 +1,30 @@
+#include <SDL2/SDL.h>
+#include <glad/glad.h>
+#include <spdlog/spdlog.h>
+
+#include "common/app.h"
+#include "common/startup-profiler.h"
+
+// Launch, present one frame and quit : run it several times and keep the median,
+// the first launch after a build also pays for cold file caches and driver shader caches
+int main(int, char*[]) { // SDL_main needs this signature
+    startup::mark("main");
+
+    App app;
+    glClearColor(1, 0, 1, 1);
+
+    SDL_Event e;
+    while (SDL_PollEvent(&e)) {}
+
+    app.beginFrame();
+    app.endFrame();
+
+    // Swap only queues the frame, wait for the GPU to really be done with it
+    glFinish();
+    startup::mark("GPU idle after first frame");
+
+    startup::logReport();
+    spdlog::info("[Startup] Time to first frame : {:.2f} ms", startup::timeToFirstFrameMs());
+
+    return 0;
+}
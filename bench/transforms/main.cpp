@@ -0,0 +1,89 @@
+#include <spdlog/spdlog.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "common/job-system.h"
+#include "common/transform-hierarchy.h"
+
+// Usage : transforms [maxThreads]
+// About 1M nodes : 1000 roots, 30 children each, 33 grandchildren per child.
+
+using Clock = std::chrono::high_resolution_clock;
+
+const std::uint32_t ROOTS = 1000;
+const std::uint32_t CHILDREN = 30;
+const std::uint32_t GRANDCHILDREN = 33;
+
+struct Scene {
+    std::vector<TransformId> roots;
+    std::vector<TransformId> leaves;
+};
+
+Scene buildScene(TransformHierarchy& transforms) {
+    Scene scene;
+    for (std::uint32_t r = 0; r < ROOTS; r++) {
+        const TransformId root = transforms.create(TransformHierarchy::NONE, glm::vec3(r % 32, 0, r / 32));
+        scene.roots.push_back(root);
+        for (std::uint32_t c = 0; c < CHILDREN; c++) {
+            const TransformId child = transforms.create(root, glm::vec3(0, c * 0.1f, 0), glm::angleAxis(c * 0.2f, glm::vec3(0, 1, 0)));
+            for (std::uint32_t g = 0; g < GRANDCHILDREN; g++) {
+                scene.leaves.push_back(transforms.create(child, glm::vec3(g * 0.05f, 0, 0), glm::quat(1, 0, 0, 0), glm::vec3(0.5f)));
+            }
+        }
+    }
+    return scene;
+}
+
+// Best of a few frames, modify() marks nodes dirty before each update
+template<typename F>
+double updateMs(TransformHierarchy& transforms, const F& modify) {
+    double best = 1e30;
+    for (int frame = 0; frame < 20; frame++) {
+        modify(frame);
+        const auto start = Clock::now();
+        transforms.update();
+        best = std::min(best, std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+    }
+    return best;
+}
+
+int main(int argc, char *argv[]) {
+    spdlog::set_pattern("[%l] %^ %v %$");
+
+    const unsigned int maxThreads = argc > 1 ? static_cast<unsigned int>(std::atoi(argv[1])) : std::max(1u, std::thread::hardware_concurrency());
+    spdlog::info("[TransformHierarchy] {} roots x {} children x {} grandchildren", ROOTS, CHILDREN, GRANDCHILDREN);
+    spdlog::info("threads | all dirty (ms) | 10% leaves (ms) | clean (ms) | speedup");
+
+    double singleThreadMs = 0.0;
+    for (unsigned int threads = 1; threads <= maxThreads; threads++) {
+        JobSystem jobs(threads);
+        TransformHierarchy transforms(jobs);
+        const Scene scene = buildScene(transforms);
+        transforms.update();
+
+        const double all = updateMs(transforms, [&](int frame) {
+            for (TransformId root : scene.roots) {
+                transforms.setRotation(root, glm::angleAxis(frame * 0.01f, glm::vec3(0, 1, 0)));
+            }
+        });
+        const double someLeaves = updateMs(transforms, [&](int frame) {
+            for (std::size_t i = frame % 10; i < scene.leaves.size(); i += 10) {
+                transforms.setScale(scene.leaves[i], glm::vec3(0.5f + frame * 0.01f));
+            }
+        });
+        const double clean = updateMs(transforms, [](int) {});
+        if (threads == 1) {
+            singleThreadMs = all;
+        }
+
+        spdlog::info("{:7} | {:14.3f} | {:15.3f} | {:10.3f} | {:.2f}x", threads, all, someLeaves, clean, singleThreadMs / all);
+    }
+
+    spdlog::info("{} nodes", ROOTS * (1 + CHILDREN * (1 + GRANDCHILDREN)));
+    return 0;
+}
@@ -1,10 +1,15 @@
 #include "CubeMesh.hpp"
 
 #include "common/gl-exception.h"
+#include "common/command-buffer.h"
 #include "common/square-data.h"
+#include <cstddef>
+#include <cstring>
 #include <iterator>
 
-CubeMesh::CubeMesh(){
+CubeMesh::CubeMesh()
+	: m_sourceVao(0), m_sourceBuffer(0), m_sourceCount(0)
+{
 	// ------------------ Vertex Buffer 1
 	{
 		GLCall(glGenBuffers(1, &m_vbPos));
@@ -13,8 +18,16 @@ CubeMesh::CubeMesh(){
 		GLCall(glBindBuffer(GL_ARRAY_BUFFER, 0));
 	}
 
+	// ------------------ Vertex Buffer 2
 	{
-		GLCall(glGenBuffers(1, &m_vbTranslations));
+		GLCall(glGenBuffers(1, &m_vbTexCoords));
+		GLCall(glBindBuffer(GL_ARRAY_BUFFER, m_vbTexCoords));
+		GLCall(glBufferData(GL_ARRAY_BUFFER, sizeof(squareData::texCoords), squareData::texCoords, GL_STATIC_DRAW));
+		GLCall(glBindBuffer(GL_ARRAY_BUFFER, 0));
+	}
+
+	{
+		GLCall(glGenBuffers(1, &m_vbInstances));
 	}
 
 	// ------------------ Vertex Array
@@ -29,41 +42,103 @@ CubeMesh::CubeMesh(){
 			GLCall(glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), NULL));
 		}
 		{
-			GLCall(glEnableVertexAttribArray(1));
-			GLCall(glBindBuffer(GL_ARRAY_BUFFER, m_vbTranslations));
-			GLCall(glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), NULL));
-			GLCall(glVertexAttribDivisor(1, 1));
+			GLCall(glEnableVertexAttribArray(2));
+			GLCall(glBindBuffer(GL_ARRAY_BUFFER, m_vbTexCoords));
+			GLCall(glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), NULL));
 		}
 
+		// Instance input description
+		setInstanceAttributes(m_vbInstances);
+
 		GLCall(glBindVertexArray(0));
 	}
 
-	// ------------------ Index buffer
-	{
-		GLCall(glGenBuffers(1, &m_ib));
-		GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ib));
-		GLCall(glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(squareData::indices), squareData::indices, GL_STATIC_DRAW));
-		GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0));
-	}
+	// ------------------ Index buffer, 24 vertices fit in 8 bits indices
+	m_indices.setData(squareData::indices, std::size(squareData::indices), std::size(squareData::positions));
 }
 
 CubeMesh::~CubeMesh() {
 	GLCall(glDeleteBuffers(1, &m_vbPos));
-	GLCall(glDeleteBuffers(1, &m_vbTranslations));
-	GLCall(glDeleteBuffers(1, &m_ib));
+	GLCall(glDeleteBuffers(1, &m_vbTexCoords));
+	GLCall(glDeleteBuffers(1, &m_vbInstances));
 	GLCall(glDeleteVertexArrays(1, &m_vao));
+	if (m_sourceVao != 0) {
+		GLCall(glDeleteVertexArrays(1, &m_sourceVao));
+	}
 }
 
-void CubeMesh::addCube(const glm::vec3& translation) {
-	m_translations.push_back(translation);
+void CubeMesh::addCube(const glm::vec3& translation, const TextureRegion& texture) {
+	m_instances.push_back({ translation, texture.layer, texture.uvRect });
 	// Update GPU
-	GLCall(glBindBuffer(GL_ARRAY_BUFFER, m_vbTranslations));
-	GLCall(glBufferData(GL_ARRAY_BUFFER, 3 * sizeof(float) * m_translations.size(), &(m_translations[0]), GL_STATIC_DRAW));
+	GLCall(glBindBuffer(GL_ARRAY_BUFFER, m_vbInstances));
+	GLCall(glBufferData(GL_ARRAY_BUFFER, sizeof(Instance) * m_instances.size(), &(m_instances[0]), GL_STATIC_DRAW));
+	GLCall(glBindBuffer(GL_ARRAY_BUFFER, 0));
+}
+
+void CubeMesh::setCubes(const std::vector<SceneCulling::Instance>& instances) {
+	static_assert(sizeof(SceneCulling::Instance) == sizeof(Instance), "Culled instances must match the instance attributes !");
+	m_instances.resize(instances.size());
+	std::memcpy(m_instances.data(), instances.data(), sizeof(Instance) * instances.size());
+	// Orphan the previous storage, the last frame may still be reading it
+	GLCall(glBindBuffer(GL_ARRAY_BUFFER, m_vbInstances));
+	GLCall(glBufferData(GL_ARRAY_BUFFER, sizeof(Instance) * m_instances.size(), m_instances.data(), GL_STREAM_DRAW));
 	GLCall(glBindBuffer(GL_ARRAY_BUFFER, 0));
 }
 
+void CubeMesh::setInstanceSource(GLuint buffer, GLsizei count) {
+	m_sourceBuffer = buffer;
+	m_sourceCount = count;
+	if (buffer == 0) {
+		return;
+	}
+
+	// Same vertices, only the instance attributes point to the other buffer
+	if (m_sourceVao == 0) {
+		GLCall(glGenVertexArrays(1, &m_sourceVao));
+		GLCall(glBindVertexArray(m_sourceVao));
+		GLCall(glEnableVertexAttribArray(0));
+		GLCall(glBindBuffer(GL_ARRAY_BUFFER, m_vbPos));
+		GLCall(glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), NULL));
+		GLCall(glEnableVertexAttribArray(2));
+		GLCall(glBindBuffer(GL_ARRAY_BUFFER, m_vbTexCoords));
+		GLCall(glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), NULL));
+		GLCall(glBindVertexArray(0));
+	}
+	GLCall(glBindVertexArray(m_sourceVao));
+	setInstanceAttributes(buffer);
+	GLCall(glBindVertexArray(0));
+}
+
 void CubeMesh::draw() {
-	GLCall(glBindVertexArray(m_vao));
-	GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ib));
-	GLCall(glDrawElementsInstanced(GL_TRIANGLES, std::size(squareData::indices), GL_UNSIGNED_SHORT, (void*)0, m_translations.size()));
-}
\ No newline at end of file
+	GLCall(glBindVertexArray(drawnVertexArray()));
+	m_indices.drawInstanced(GL_TRIANGLES, drawnInstanceCount());
+}
+
+void CubeMesh::draw(CommandBuffer& commands) const {
+	commands.bindVertexArray(drawnVertexArray());
+	commands.drawIndexed(m_indices, GL_TRIANGLES, drawnInstanceCount());
+}
+
+GLuint CubeMesh::vertexArray() const { return m_vao; }
+const IndexBuffer& CubeMesh::indices() const { return m_indices; }
+GLsizei CubeMesh::instanceCount() const { return static_cast<GLsizei>(m_instances.size()); }
+GLuint CubeMesh::instanceBuffer() const { return m_vbInstances; }
+
+///////////////////////////// PRIVATE METHODS ///////////////////////////////
+
+void CubeMesh::setInstanceAttributes(GLuint buffer) {
+	GLCall(glBindBuffer(GL_ARRAY_BUFFER, buffer));
+	GLCall(glEnableVertexAttribArray(1));
+	GLCall(glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)offsetof(Instance, translation)));
+	GLCall(glVertexAttribDivisor(1, 1));
+	GLCall(glEnableVertexAttribArray(3));
+	GLCall(glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)offsetof(Instance, textureLayer)));
+	GLCall(glVertexAttribDivisor(3, 1));
+	GLCall(glEnableVertexAttribArray(4));
+	GLCall(glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)offsetof(Instance, textureRect)));
+	GLCall(glVertexAttribDivisor(4, 1));
+	GLCall(glBindBuffer(GL_ARRAY_BUFFER, 0));
+}
+
+GLuint CubeMesh::drawnVertexArray() const { return m_sourceBuffer != 0 ? m_sourceVao : m_vao; }
+GLsizei CubeMesh::drawnInstanceCount() const { return m_sourceBuffer != 0 ? m_sourceCount : instanceCount(); }
\ No newline at end of file
@@ -4,19 +4,65 @@
 #include <vector>
 #include "glm/glm.hpp"
 
+#include "common/index-buffer.h"
+#include "common/texture-array.h"
+#include "common/scene-culling.h"
+
+class CommandBuffer;
+
 class CubeMesh {
 public:
 	CubeMesh();
 	~CubeMesh();
 
-	void addCube(const glm::vec3& translation);
+	/**
+	 * @param texture - Region of the TextureArray bound when drawing, the whole first layer by default
+	 */
+	void addCube(const glm::vec3& translation, const TextureRegion& texture = TextureRegion());
+
+	/**
+	 * @brief Replace every cube by the instances kept by SceneCulling, meant to be called each frame
+	 */
+	void setCubes(const std::vector<SceneCulling::Instance>& instances);
+
+	/**
+	 * @brief Draw count instances read from another buffer laid out like SceneCulling::Instance, or its own ones with buffer 0
+	 */
+	void setInstanceSource(GLuint buffer, GLsizei count);
 	void draw();
 
+	/**
+	 * @brief Record the draw for later, can be called from any thread while no cube is added
+	 */
+	void draw(CommandBuffer& commands) const;
+
+	GLuint vertexArray() const;
+	const IndexBuffer& indices() const;
+	GLsizei instanceCount() const;
+	GLuint instanceBuffer() const;
+
 private:
-	GLuint m_ib;
+	// Per instance vertex attributes, interleaved in m_vbInstances
+	struct Instance {
+		glm::vec3 translation;
+		float textureLayer;
+		glm::vec4 textureRect;
+	};
+
+	IndexBuffer m_indices;
 	GLuint m_vbPos;
+	GLuint m_vbTexCoords;
 	GLuint m_vao;
 
-	std::vector<glm::vec3> m_translations;
-	GLuint m_vbTranslations;
+	std::vector<Instance> m_instances;
+	GLuint m_vbInstances;
+
+	// Vertex array reading instances from an external buffer, created on first use
+	GLuint m_sourceVao;
+	GLuint m_sourceBuffer;
+	GLsizei m_sourceCount;
+
+	void setInstanceAttributes(GLuint buffer);
+	GLuint drawnVertexArray() const;
+	GLsizei drawnInstanceCount() const;
 };
\ No newline at end of file
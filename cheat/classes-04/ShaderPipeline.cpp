@@ -1,19 +1,31 @@
 #include "ShaderPipeline.hpp"
 
 #include "common/gl-exception.h"
+#include "common/command-buffer.h"
 #include <spdlog/spdlog.h>
 
 #include <fstream>
 #include <iostream>
 
 ShaderPipeline::ShaderPipeline(const std::string& vertexFilepath, const std::string& fragmentFilepath) {
+	compile(readSources(vertexFilepath, fragmentFilepath));
+}
+
+ShaderPipeline::ShaderPipeline(const Sources& sources) {
+	compile(sources);
+}
+
+ShaderPipeline::~ShaderPipeline() {
+	GLCall(glDeleteProgram(m_pipelineID));
+}
+
+void ShaderPipeline::compile(const Sources& sources) {
 	// ------------------ Vertex shader
 	unsigned int vs;
 	int success;
 	char infoLog[512];
 	{
-		std::string vsSource = readFile(vertexFilepath);
-		const char* vsSourceCstr = vsSource.c_str();
+		const char* vsSourceCstr = sources.vertex.c_str();
 		vs = glCreateShader(GL_VERTEX_SHADER);
 		GLCall(glShaderSource(vs, 1, &vsSourceCstr, NULL));
 		GLCall(glCompileShader(vs));
@@ -30,8 +42,7 @@ ShaderPipeline::ShaderPipeline(const std::string& vertexFilepath, const std::str
 	// ------------------ Fragment shader
 	unsigned int fs;
 	{
-		std::string fsSource = readFile(fragmentFilepath);
-		const char* fsSourceCstr = fsSource.c_str();
+		const char* fsSourceCstr = sources.fragment.c_str();
 		fs = glCreateShader(GL_FRAGMENT_SHADER);
 		GLCall(glShaderSource(fs, 1, &fsSourceCstr, NULL));
 		GLCall(glCompileShader(fs));
@@ -67,10 +78,6 @@ ShaderPipeline::ShaderPipeline(const std::string& vertexFilepath, const std::str
 	}
 }
 
-ShaderPipeline::~ShaderPipeline() {
-	GLCall(glDeleteProgram(m_pipelineID));
-}
-
 void ShaderPipeline::bind() {
 	GLCall(glUseProgram(m_pipelineID));
 }
@@ -79,10 +86,22 @@ void ShaderPipeline::unbind() {
 	GLCall(glUseProgram(0));
 }
 
+GLuint ShaderPipeline::id() const {
+	return m_pipelineID;
+}
+
 void ShaderPipeline::setUniformMat4f(const std::string& uniformName, const glm::mat4x4& mat) {
 	GLCall(glUniformMatrix4fv(getUniformLocation(uniformName), 1, GL_FALSE, &mat[0][0]));
 }
 
+void ShaderPipeline::bind(CommandBuffer& commands) const {
+	commands.bindPipeline(m_pipelineID);
+}
+
+void ShaderPipeline::setUniformMat4f(CommandBuffer& commands, const char* uniformName, const glm::mat4x4& mat) const {
+	commands.setUniformMat4(uniformName, mat);
+}
+
 int ShaderPipeline::getUniformLocation(const std::string& name) {
 	if (m_uniformLocationCache.find(name) != m_uniformLocationCache.end()) {
 		return m_uniformLocationCache[name];
@@ -97,6 +116,10 @@ int ShaderPipeline::getUniformLocation(const std::string& name) {
 	return location;
 }
 
+ShaderPipeline::Sources ShaderPipeline::readSources(const std::string& vertexFilepath, const std::string& fragmentFilepath) {
+	return { readFile(vertexFilepath), readFile(fragmentFilepath) };
+}
+
 std::string ShaderPipeline::readFile(const std::string& filepath) {
 	// Open file
 	std::ifstream stream(filepath);
@@ -6,18 +6,40 @@
 
 #include <glm/glm.hpp>
 
+class CommandBuffer;
+
 class ShaderPipeline {
 public:
+	struct Sources {
+		std::string vertex;
+		std::string fragment;
+	};
+
 	ShaderPipeline(const std::string& vertexFilepath, const std::string& fragmentFilepath);
+	ShaderPipeline(const Sources& sources);
 	~ShaderPipeline();
 
 	void bind();
 	void unbind();
+	GLuint id() const;
 	void setUniformMat4f(const std::string& uniformName, const glm::mat4x4& mat);
 
+	/**
+	 * @brief Same operations recorded for later, can be called from any thread
+	 * @param uniformName - Not copied, must outlive the replay (eg: a string literal)
+	 */
+	void bind(CommandBuffer& commands) const;
+	void setUniformMat4f(CommandBuffer& commands, const char* uniformName, const glm::mat4x4& mat) const;
+
+	/**
+	 * @brief Read both shader files, does not need an OpenGL context so it can run on any thread
+	 */
+	static Sources readSources(const std::string& vertexFilepath, const std::string& fragmentFilepath);
+
 private:
+	void compile(const Sources& sources);
 	int getUniformLocation(const std::string& name);
-	std::string readFile(const std::string& filepath);
+	static std::string readFile(const std::string& filepath);
 
 private:
 	GLuint m_pipelineID;
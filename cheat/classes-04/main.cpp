@@ -2,75 +2,511 @@
 #include <glad/glad.h>
 #include <spdlog/spdlog.h>
 #include <debug_break/debug_break.h>
+#include <imgui.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <cmath>
+#include <atomic>
+#include <cstdint>
+#include <future>
+#include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "common/app.h"
+#include "common/asset-loader.h"
+#include "common/asset-pack.h"
+#include "common/frame-loop.h"
+#include "common/frame-pipeline.h"
 #include "common/gl-exception.h"
+#include "common/job-system.h"
+#include "common/startup-profiler.h"
 #include "common/square-data.h"
+#include "common/texture-array.h"
+#include "common/voxel-world.h"
+#include "common/render-queue.h"
+#include "common/command-buffer.h"
+#include "common/material.h"
+#include "common/transform-hierarchy.h"
+#include "common/ecs.h"
+#include "common/scene-culling.h"
+#include "common/occlusion-buffer.h"
+#include "common/gpu-culling.h"
+#include "common/deferred-renderer.h"
+#include "common/light-clusters.h"
+#include "common/texture-loader.h"
+#include "common/texture-residency.h"
 
 #include "ShaderPipeline.hpp"
 #include "CubeMesh.hpp"
 
+// Checkerboard of the given color, stands for an image loaded from disk
+std::vector<std::uint8_t> makeCheckerImage(int size, const glm::vec3& color) {
+    std::vector<std::uint8_t> pixels(size * size * 4);
+    for (int y = 0; y < size; y++) {
+        for (int x = 0; x < size; x++) {
+            const float shade = ((x * 8 / size + y * 8 / size) % 2) ? 1.0f : 0.5f;
+            std::uint8_t* pixel = &pixels[(y * size + x) * 4];
+            pixel[0] = static_cast<std::uint8_t>(color.r * shade * 255);
+            pixel[1] = static_cast<std::uint8_t>(color.g * shade * 255);
+            pixel[2] = static_cast<std::uint8_t>(color.b * shade * 255);
+            pixel[3] = 255;
+        }
+    }
+    return pixels;
+}
+
 int main(int argc, char *argv[]) {
+    // Read shaders while the window and the OpenGL context are created
+    std::future<ShaderPipeline::Sources> shaderSources = std::async(std::launch::async, [] {
+        startup::Scope scope("Read shader files");
+
+        // Made with : asset-packer res/assets.pack res/cheat-classes04.vert res/cheat-classes04.frag builtin:cube [images...]
+        AssetPack pack;
+        if (pack.open("res/assets.pack")) {
+            const assetPack::Entry* vertex = pack.find("res/cheat-classes04.vert");
+            const assetPack::Entry* fragment = pack.find("res/cheat-classes04.frag");
+            if (vertex != nullptr && fragment != nullptr) {
+                return ShaderPipeline::Sources{ pack.shaderSource(*vertex), pack.shaderSource(*fragment) };
+            }
+        }
+        return ShaderPipeline::readSources("res/cheat-classes04.vert", "res/cheat-classes04.frag");
+    });
+
     App app;
 
     glClearColor(1, 0, 1, 1);
 
-	// ------------------ Cube mesh
+	// ------------------ Textures, one full layer and smaller images packed in an atlas layer
+
+	TextureArray textures(128, 16);
+	std::vector<TextureRegion> textureRegions;
+	{
+		const int sizes[] = { 128, 64, 32, 64 };
+		const glm::vec3 colors[] = { glm::vec3(1, 0, 0), glm::vec3(0, 1, 0), glm::vec3(0, 0, 1), glm::vec3(1, 1, 0) };
+		for (int i = 0; i < 4; i++) {
+			std::vector<std::uint8_t> pixels = makeCheckerImage(sizes[i], colors[i]);
+			TextureRegion region;
+			if (textures.add(pixels.data(), sizes[i], sizes[i], region)) {
+				textureRegions.push_back(region);
+			}
+		}
+	}
+
+	// ------------------ Large images streamed within a budget too small for all of them, see the "Streamed textures" window
+
+	TextureResidencyManager residency(8 * 1024 * 1024);
+	std::vector<TextureResidencyManager::Handle> streamedTextures;
+	{
+		const glm::vec3 colors[] = { glm::vec3(1, 0.5, 0), glm::vec3(0, 0.5, 1), glm::vec3(0.5, 1, 0), glm::vec3(1, 0, 0.5) };
+		for (const glm::vec3& color : colors) {
+			const std::vector<std::uint8_t> pixels = makeCheckerImage(1024, color);
+			streamedTextures.push_back(residency.add(pixels.data(), 1024, 1024));
+		}
+	}
+	bool streamedVisible[4] = { true, true, false, false };
+	float streamedSize = 128.0f;
+
+	// ------------------ Meshes and textures of the asset pack, uploaded straight from the mapping, see the "Packed assets" window
+
+	std::vector<std::pair<std::string, assetLoader::Mesh>> packedMeshes;
+	std::vector<std::pair<std::string, GLuint>> packedTextures;
+	{
+		startup::Scope scope("Upload packed assets");
+		AssetPack pack;
+		if (pack.open("res/assets.pack")) {
+			for (const assetPack::Entry& entry : pack) {
+				if (entry.type == assetPack::AssetType::MESH) {
+					packedMeshes.emplace_back(entry.name, assetLoader::createMesh(pack, entry));
+				} else if (entry.type == assetPack::AssetType::TEXTURE) {
+					const GLuint texture = assetLoader::createTexture(pack, entry);
+					if (texture != 0) {
+						packedTextures.emplace_back(entry.name, texture);
+					}
+				}
+			}
+		}
+	}
+
+	// ------------------ Cube mesh, its instances are the visible cube entities of each frame
 
 	CubeMesh cube;
-	cube.addCube(glm::vec3(0., 0., 1.));
-	cube.addCube(glm::vec3(4., 0., 1.));
-	cube.addCube(glm::vec3(-4., 0., 1.));
+	EntityWorld entities;
+	const std::uint32_t CUBE_BATCH = 0;
+	auto createCube = [&](const glm::vec3& position, const TextureRegion& texture) {
+		entities.create(Transform{ position }, Bounds{ glm::vec3(0.0f), 1.7320508f }, Renderable{ CUBE_BATCH, texture.layer, texture.uvRect }, Occluder{});
+	};
+	createCube(glm::vec3(0., 0., 1.), textureRegions[0]);
+	createCube(glm::vec3(4., 0., 1.), textureRegions[1]);
+	createCube(glm::vec3(-4., 0., 1.), textureRegions[2]);
+	unsigned int clickCount = 0;
+	textures.bind(0); // Generate mipmaps now, draws are recorded with the texture name only
+	startup::mark("Cube mesh uploaded");
 
 	// ------------------ Shader pipeline
 
-	ShaderPipeline shaderPipeline("res/cheat-classes04.vert", "res/shader.frag");
+	ShaderPipeline shaderPipeline(shaderSources.get());
+	ShaderPipeline voxelPipeline("res/voxel.vert", "res/voxel.frag");
+	ShaderPipeline voxelGBufferPipeline("res/voxel-gbuffer.vert", "res/voxel-gbuffer.frag");
+	ShaderPipeline voxelClusteredPipeline("res/voxel-clustered.vert", "res/voxel-clustered.frag");
+	LightClusters::setupProgram(voxelClusteredPipeline.id());
+	startup::mark("Shaders compiled");
 
+	// ------------------ Materials, their parameters share a few uniform buffers
+
+	MaterialLibrary materials;
+	Material& cubeMaterial = materials.create("Cubes", shaderPipeline.id(), MaterialLayout().add("uTint", MaterialLayout::Type::VEC4));
+	cubeMaterial.set("uTint", glm::vec4(1.0f));
+	cubeMaterial.setTexture(0, "uTextures", GL_TEXTURE_2D_ARRAY, textures.id());
+
+	// Two palettes on alternate chunks, so that sorting by material shows up in the render queue
+	const MaterialLayout voxelLayout = MaterialLayout().add("uPalette", MaterialLayout::Type::VEC4, 4).add("uLight", MaterialLayout::Type::VEC4);
+	// The deferred ones write the same palettes to the G-buffer, the clustered ones are lit forward by the lights of their cluster
+	Material* voxelMaterials[6] = {
+		&materials.create("Voxels (spring)", voxelPipeline.id(), voxelLayout),
+		&materials.create("Voxels (autumn)", voxelPipeline.id(), voxelLayout),
+		&materials.create("Voxels deferred (spring)", voxelGBufferPipeline.id(), voxelLayout),
+		&materials.create("Voxels deferred (autumn)", voxelGBufferPipeline.id(), voxelLayout),
+		&materials.create("Voxels clustered (spring)", voxelClusteredPipeline.id(), voxelLayout),
+		&materials.create("Voxels clustered (autumn)", voxelClusteredPipeline.id(), voxelLayout)
+	};
+	const glm::vec4 grass[2] = { glm::vec4(0.35f, 0.7f, 0.25f, 1.0f), glm::vec4(0.75f, 0.55f, 0.2f, 1.0f) };
+	for (int i = 0; i < 6; i++) {
+		voxelMaterials[i]->set("uPalette", glm::vec4(1.0f, 0.0f, 1.0f, 1.0f), 0);   // Unknown
+		voxelMaterials[i]->set("uPalette", grass[i % 2], 1);                        // Grass
+		voxelMaterials[i]->set("uPalette", glm::vec4(0.5f, 0.38f, 0.28f, 1.0f), 2); // Dirt
+		voxelMaterials[i]->set("uPalette", glm::vec4(0.6f, 0.6f, 0.65f, 1.0f), 3);  // Stone
+		voxelMaterials[i]->set("uLight", glm::vec4(0.4f, 1.0f, 0.3f, 0.55f));
+	}
+
+	// ------------------ Voxel ground, 8x2x8 chunks of rolling hills
+
+	JobSystem jobs;
+	VoxelWorld voxels(jobs);
+	RenderQueue renderQueue(100.0f, &jobs);
+	OcclusionBuffer occlusion(jobs);
+	SceneCulling culling(jobs, &occlusion);
+	GpuCulling gpuCulling(app.width(), app.height());
+	bool gpuCullingEnabled = false; // Toggled with G
+	std::vector<SceneCulling::Instance> allCubes;
+	CommandArena commandArena(jobs.threadCount());
+	CommandBuffer cubeCommands;
+	CommandReplayer commandReplayer;
+	const int groundSize = 8 * VoxelChunk::SIZE;
+	voxels.generate(glm::ivec3(0, 0, 0), glm::ivec3(7, 1, 7), [](const glm::ivec3& p) -> Voxel {
+		const float height = 28.0f + 12.0f * std::sin(p.x * 0.04f) * std::cos(p.z * 0.05f) + 4.0f * std::sin(p.x * 0.13f + p.z * 0.11f);
+		if (p.y >= height) return 0;
+		return p.y < height - 4.0f ? 3 : p.y < height - 1.0f ? 2 : 1;
+	});
+	startup::mark("Voxels generated");
+
+	// ------------------ Transforms, the ground hangs below the rotating scene
+
+	TransformHierarchy transforms(jobs);
+	const TransformId sceneNode = transforms.create();
+	const TransformId groundNode = transforms.create(sceneNode, glm::vec3(-4.0f, -3.5f, -4.0f), glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(8.0f / groundSize));
+
+	// ------------------ Deferred shading or clustered forward lighting, a grid of colored lights hovering over the ground
+
+	DeferredRenderer deferred(app.width(), app.height());
+	bool deferredEnabled = false; // Toggled with L
+	LightClusters lightClusters(jobs, app.width(), app.height());
+	bool clusteredEnabled = false; // Toggled with C
+	const int LIGHT_GRID = 32;
+	std::vector<glm::vec3> groundLights; // In voxels, relative to the ground
+	std::vector<PointLight> lights;
+	for (int z = 0; z < LIGHT_GRID; z++) {
+		for (int x = 0; x < LIGHT_GRID; x++) {
+			groundLights.push_back(glm::vec3((x + 0.5f) * groundSize / LIGHT_GRID, 48.0f, (z + 0.5f) * groundSize / LIGHT_GRID));
+			const glm::vec3 color = glm::vec3(0.5f) + 0.5f * glm::cos(6.2831853f * (static_cast<float>(x * LIGHT_GRID + z) / 37.0f + glm::vec3(0.0f, 0.33f, 0.67f)));
+			lights.push_back({ glm::vec3(0.0f), 0.7f, color, 1.5f });
+		}
+	}
+
+    // ------------------ Simulation, runs on its own thread
+
+    struct SceneSnapshot {
+        glm::quat sceneRotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+        glm::mat4x4 viewMat = glm::mat4(1.0f);
+        glm::mat4x4 projMat = glm::mat4(1.0f);
+        glm::mat4x4 viewProjMat = glm::mat4(1.0f);
+        FrameLoop timings;
+    };
+
+    FrameLoop frameLoop;
+    std::atomic<float> aspectRatio(static_cast<float>(app.width()) / app.height()); // Written by the loop on resize
     float counter = 0.0f;
+    float previousCounter = 0.0f;
+    FramePipeline<SceneSnapshot> pipeline([&](SceneSnapshot& next) {
+        // Fixed timestep simulation
+        frameLoop.advance();
+        while (frameLoop.step()) {
+            previousCounter = counter;
+            counter += 0.05f;
+            if (counter > 100) {
+                counter = 0;
+                previousCounter = 0;
+            }
+        }
+        float renderCounter = glm::mix(previousCounter, counter, static_cast<float>(frameLoop.alpha()));
+
+        next.sceneRotation = glm::angleAxis(renderCounter, glm::vec3(0, 1, 0));
+        glm::mat4x4 viewMat = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -10.0f));
+        glm::mat4x4 projMat = glm::perspective(glm::radians(45.0f), aspectRatio.load(), 0.1f, 100.0f);
+        next.viewMat = viewMat;
+        next.projMat = projMat;
+        next.viewProjMat = projMat * viewMat;
+        next.timings = frameLoop;
+    });
+
+	// ------------------ Loop :
+
+    bool onDemandRendering = false; // Toggled with O, the scene then only moves while there are inputs
+    bool dynamicResolutionEnabled = false; // Toggled with R, deferred and GPU culling use full size framebuffers of their own so they exclude it
+
+    // Images dropped on the window are decoded and uploaded in the background
+    TextureLoader textureLoader;
+    std::vector<std::shared_ptr<Texture>> droppedImages;
+
     while (app.isRunning()) {
         SDL_Event e;
-        while (SDL_PollEvent(&e)) {
+        // Events also go to ImGui, so that the metrics windows react
+        while (app.pollEvent(e)) {
             switch (e.type) {
             case SDL_QUIT: app.exit();
 				break;
+			case SDL_WINDOWEVENT:
+				// The App already follows the new drawable size, targets of the sample follow it too
+				if (e.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
+					gpuCulling.resize(app.width(), app.height());
+					deferred.resize(app.width(), app.height());
+					aspectRatio = static_cast<float>(app.width()) / app.height();
+				}
+				break;
+			case SDL_DROPFILE:
+				droppedImages.push_back(textureLoader.load(e.drop.file));
+				SDL_free(e.drop.file);
+				break;
 			case SDL_MOUSEBUTTONDOWN:
-				int x, y;
-				SDL_GetMouseState(&x, &y);
-				cube.addCube(glm::vec3((x / 325.0f -1.0f) * 6.0f, -(y / 325.0f -1.0f) * 6.0f, 1.0f));
+				// A click on a window is not for the scene
+				if (ImGui::GetIO().WantCaptureMouse) {
+					break;
+				}
+				{
+					// Mouse positions are in window points, which are not framebuffer pixels on high DPI displays
+					int windowWidth, windowHeight;
+					SDL_GetWindowSize(SDL_GetWindowFromID(e.button.windowID), &windowWidth, &windowHeight);
+					const float u = static_cast<float>(e.button.x) / windowWidth;
+					const float v = static_cast<float>(e.button.y) / windowHeight;
+					createCube(glm::vec3((u * 2.0f - 1.0f) * 6.0f, -(v * 2.0f - 1.0f) * 6.0f, 1.0f), textureRegions[clickCount++ % textureRegions.size()]);
+
+					// Stack a stone voxel on the ground below the click, only its chunk is meshed again
+					glm::ivec3 top(std::min(std::max(static_cast<int>(u * groundSize), 0), groundSize - 1), 0, groundSize / 2);
+					while (voxels.get(top) != 0) {
+						top.y++;
+					}
+					voxels.set(top, 3);
+				}
+				break;
+			case SDL_KEYDOWN:
+				if (ImGui::GetIO().WantCaptureKeyboard) {
+					break;
+				}
+				if (e.key.keysym.sym == SDLK_F12) {
+					app.captureFrame("capture.png");
+				} else if (e.key.keysym.sym == SDLK_g) {
+					gpuCullingEnabled = !gpuCullingEnabled;
+					if (gpuCullingEnabled && dynamicResolutionEnabled) {
+						dynamicResolutionEnabled = false;
+						app.setDynamicResolution(false);
+					}
+				} else if (e.key.keysym.sym == SDLK_l) {
+					deferredEnabled = !deferredEnabled;
+					clusteredEnabled = false;
+					if (deferredEnabled && dynamicResolutionEnabled) {
+						dynamicResolutionEnabled = false;
+						app.setDynamicResolution(false);
+					}
+				} else if (e.key.keysym.sym == SDLK_c) {
+					clusteredEnabled = !clusteredEnabled;
+					deferredEnabled = false;
+				} else if (e.key.keysym.sym == SDLK_o) {
+					onDemandRendering = !onDemandRendering;
+					app.setOnDemandRendering(onDemandRendering);
+				} else if (e.key.keysym.sym == SDLK_r) {
+					dynamicResolutionEnabled = !dynamicResolutionEnabled;
+					app.setDynamicResolution(dynamicResolutionEnabled);
+					if (dynamicResolutionEnabled) {
+						gpuCullingEnabled = false;
+						deferredEnabled = false;
+					}
+				}
 				break;
 
             default: break;
             };
         }
 
-        counter += 0.05f;
-        if (counter > 100) {
-            counter = 0;
+        // Nothing changed since the last frame in on-demand mode
+        if (!app.shouldRender()) {
+            continue;
         }
 
+        // Simulate next frame while this one is submitted
+        const SceneSnapshot& scene = pipeline.beginFrame();
+
         app.beginFrame();
+        textureLoader.update();
+        // Loads in progress need update() on the next frames too, so do not sleep in on-demand mode
+        if (textureLoader.pendingDecodeCount() + textureLoader.pendingUploadCount() > 0) {
+            app.requestRedraw();
+        }
+
+        // Only the scene rotates, the ground follows as its child
+		transforms.setRotation(sceneNode, scene.sceneRotation);
+		transforms.update();
+		const glm::mat4& sceneMat = transforms.world(sceneNode);
+		const glm::mat4& groundMat = transforms.world(groundNode);
+
+        // Only the cubes inside the view and not behind other cubes are instanced, then recorded on a worker while chunks are meshed and uploaded
+		if (gpuCullingEnabled) {
+			// Every cube is uploaded, the GPU compacts the visible ones against the depth of the last frame
+			allCubes.clear();
+			entities.each<const Transform, const Renderable>([&](const Transform& transform, const Renderable& renderable) {
+				if (renderable.batch == CUBE_BATCH) {
+					allCubes.push_back({ transform.position, renderable.textureLayer, renderable.textureRect });
+				}
+			});
+			cube.setCubes(allCubes);
+			gpuCulling.cull(cube.instanceBuffer(), cube.instanceCount(), scene.viewProjMat * sceneMat, 1.7320508f);
+			cube.setInstanceSource(gpuCulling.outputBuffer(), gpuCulling.visibleCount());
+		} else {
+			culling.cull(entities, scene.viewProjMat * sceneMat);
+			cube.setCubes(culling.visible(CUBE_BATCH));
+			cube.setInstanceSource(0, 0);
+		}
+		cubeCommands.reset(commandArena);
+		Job* cubeJob = jobs.createJob([&] {
+			shaderPipeline.bind(cubeCommands);
+			shaderPipeline.setUniformMat4f(cubeCommands, "uModel", sceneMat);
+			shaderPipeline.setUniformMat4f(cubeCommands, "uViewProj", scene.viewProjMat);
+			cubeMaterial.bind(cubeCommands);
+			cube.draw(cubeCommands);
+		});
+		jobs.run(cubeJob);
 
-        // Update uniforms
-		shaderPipeline.bind();
-        {
-            glm::mat4x4 modelMat = glm::rotate(glm::mat4(1.0f), counter, glm::vec3(0, 1, 0));
-			shaderPipeline.setUniformMat4f("uModel", modelMat);
+        // Voxel ground under the cubes, one draw per chunk
+		materials.upload();
+		voxels.update();
+		voxels.forEachMesh([&](const glm::vec3& origin, GLuint vertexArray, GLuint depthVertexArray, const IndexBuffer& indices) {
+			const glm::mat4 chunkMat = groundMat * glm::translate(glm::mat4(1.0f), origin);
+			// w in clip space is the distance along the view axis
+			const float viewDepth = (scene.viewProjMat * chunkMat * glm::vec4(glm::vec3(VoxelChunk::SIZE / 2.0f), 1.0f)).w;
+			const Material* material = voxelMaterials[(static_cast<int>(origin.x + origin.z) / VoxelChunk::SIZE) % 2 + (deferredEnabled ? 2 : clusteredEnabled ? 4 : 0)];
+			renderQueue.submit(RenderPass::SOLID, { material, vertexArray, &indices, 1, chunkMat, depthVertexArray }, viewDepth);
+		});
+
+        // Lights follow the ground, with clustered lighting they are binned before the ground is drawn
+		for (std::size_t i = 0; i < lights.size(); i++) {
+			lights[i].position = glm::vec3(groundMat * glm::vec4(groundLights[i], 1.0f));
+		}
+		if (clusteredEnabled) {
+			// Tiles are picked from gl_FragCoord, so they follow the scaled viewport of dynamic resolution
+			const DynamicResolution& resolution = app.dynamicResolution();
+			lightClusters.resize(dynamicResolutionEnabled ? resolution.scaled(app.width()) : app.width(),
+				dynamicResolutionEnabled ? resolution.scaled(app.height()) : app.height());
+			lightClusters.bin(lights, scene.viewMat, scene.projMat);
+			lightClusters.upload();
+		}
+
+        // Sorted by depth or by state, with an optional depth pre-pass, recorded on workers then drawn
+		if (deferredEnabled) {
+			deferred.beginGeometry();
+		}
+		renderQueue.setViewProj(scene.viewProjMat);
+		renderQueue.flush();
+
+        // Ground lit by every light, the cubes are then drawn forward over it
+		if (deferredEnabled) {
+			deferred.endGeometry();
+			deferred.light(lights, scene.viewProjMat, glm::vec3(0.0f, 0.0f, 10.0f));
+			deferred.beginForward();
+		}
+
+        // Every cube in one go whatever its texture
+		jobs.wait(cubeJob);
+		commandReplayer.replay(cubeCommands);
+		commandArena.reset();
+		if (deferredEnabled) {
+			deferred.endForward();
+			deferred.composite();
+		}
+		if (gpuCullingEnabled) {
+			gpuCulling.captureDepth(deferredEnabled ? deferred.lightingFramebuffer() : 0);
+		}
+
+        scene.timings.showMetrics();
+        app.showIdleMetrics();
+        if (dynamicResolutionEnabled) {
+            app.dynamicResolution().showMetrics();
+        }
+        voxels.showMetrics();
+        renderQueue.showMetrics();
+        materials.showMetrics();
+        transforms.showMetrics();
+        entities.showMetrics();
+        culling.showMetrics();
+        occlusion.showMetrics();
+        gpuCulling.showMetrics();
+        deferred.showMetrics();
+        lightClusters.showMetrics();
+        textureLoader.showMetrics();
+
+        // The checker placeholder until an image is resident, rows are bottom-up so v is flipped
+        // Ticked images are visible at the chosen size, the manager streams the mips they need and evicts the others
+        ImGui::Begin("Streamed textures");
+        ImGui::SliderFloat("Size on screen", &streamedSize, 16.0f, 1024.0f);
+        for (std::size_t i = 0; i < streamedTextures.size(); i++) {
+            ImGui::Checkbox(("Image " + std::to_string(i)).c_str(), &streamedVisible[i]);
+            if (streamedVisible[i]) {
+                residency.markVisible(streamedTextures[i], streamedSize);
+                ImGui::Image(reinterpret_cast<ImTextureID>(static_cast<std::intptr_t>(residency.id(streamedTextures[i]))), ImVec2(streamedSize, streamedSize));
+            }
+        }
+        ImGui::End();
+        // Only drawn by ImGui at the end of the frame, after the new mips are in
+        if (residency.update() > 0) {
+            app.requestRedraw();
+        }
+        residency.showMetrics();
+
+        ImGui::Begin("Packed assets");
+        for (const std::pair<std::string, assetLoader::Mesh>& mesh : packedMeshes) {
+            ImGui::Text("%s : %d indices", mesh.first.c_str(), mesh.second.indexCount);
         }
-        {
-            glm::mat4x4 viewMat = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -10.0f));
-            glm::mat4x4 projMat = glm::perspective(glm::radians(45.0f), 1.0f, 0.1f, 100.0f);
-            glm::mat4x4 viewProjMat = projMat * viewMat;
-			shaderPipeline.setUniformMat4f("uViewProj", viewProjMat);
+        for (const std::pair<std::string, GLuint>& texture : packedTextures) {
+            ImGui::Text("%s", texture.first.c_str());
+            ImGui::Image(reinterpret_cast<ImTextureID>(static_cast<std::intptr_t>(texture.second)), ImVec2(128.0f, 128.0f));
         }
+        ImGui::End();
 
-        // Draw call
-		cube.draw();
+        ImGui::Begin("Dropped images");
+        for (const std::shared_ptr<Texture>& image : droppedImages) {
+            ImGui::Text("%s%s", image->filepath().c_str(), image->hasFailed() ? " (failed)" : "");
+            ImGui::Image(reinterpret_cast<ImTextureID>(static_cast<std::intptr_t>(image->id())), ImVec2(128.0f, 128.0f), ImVec2(0.0f, 1.0f), ImVec2(1.0f, 0.0f));
+        }
+        ImGui::End();
 
         app.endFrame();
     }
+
+	for (std::pair<std::string, assetLoader::Mesh>& mesh : packedMeshes) {
+		assetLoader::destroyMesh(mesh.second);
+	}
+	for (const std::pair<std::string, GLuint>& texture : packedTextures) {
+		GLCall(glDeleteTextures(1, &texture.second));
+	}
     
     return 0;
 }
@@ -8,7 +8,9 @@
 #include <unordered_map>
 
 #include "common/app.h"
+#include "common/frame-loop.h"
 #include "common/gl-exception.h"
+#include "common/index-buffer.h"
 #include "common/square-data.h"
 
 std::unordered_map<std::string, int> uniformLocationCache;
@@ -58,13 +60,8 @@ int main(int argc, char *argv[]) {
     }
 
     // ------------------ Index buffer
-    unsigned int ib;
-    {
-        GLCall(glGenBuffers(1, &ib));
-        GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ib));
-        GLCall(glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(squareData::indices), squareData::indices, GL_STATIC_DRAW));
-        GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0));
-    }
+    IndexBuffer indices;
+    indices.setData(squareData::indices, std::size(squareData::indices), std::size(squareData::positions));
 
     // ------------------ Vertex shader
     unsigned int vs;
@@ -153,7 +150,9 @@ int main(int argc, char *argv[]) {
         GLCall(glUseProgram(0));
     }
 
+    FrameLoop frameLoop;
     float counter = 0.0f;
+    float previousCounter = 0.0f;
     while (app.isRunning()) {
         SDL_Event e;
         while (SDL_PollEvent(&e)) {
@@ -164,17 +163,24 @@ int main(int argc, char *argv[]) {
             };
         }
 
-        counter += 0.05f;
-        if (counter > 100) {
-            counter = 0;
+        // Fixed timestep simulation
+        frameLoop.advance();
+        while (frameLoop.step()) {
+            previousCounter = counter;
+            counter += 0.05f;
+            if (counter > 100) {
+                counter = 0;
+                previousCounter = 0;
+            }
         }
+        float renderCounter = glm::mix(previousCounter, counter, static_cast<float>(frameLoop.alpha()));
 
         app.beginFrame();
 
         // Update uniforms
         GLCall(glUseProgram(pipeline));
         {
-            modelMat = glm::rotate(glm::mat4(1.0f), counter, glm::vec3(0, 1, 0));
+            modelMat = glm::rotate(glm::mat4(1.0f), renderCounter, glm::vec3(0, 1, 0));
             GLCall(glUniformMatrix4fv(getUniformLocation("uModel", pipeline), 1, GL_FALSE, &modelMat[0][0]));
         }
         {
@@ -186,8 +192,7 @@ int main(int argc, char *argv[]) {
 
         // Draw call
         GLCall(glBindVertexArray(vao));
-        GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ib));
-        GLCall(glDrawElements(GL_TRIANGLES, std::size(squareData::indices), GL_UNSIGNED_SHORT, (void*) 0));
+        indices.draw(GL_TRIANGLES);
 
         app.endFrame();
     }
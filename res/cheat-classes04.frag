@@ -0,0 +1,14 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec3 vTexCoord;
+
+uniform sampler2DArray uTextures;
+
+layout (std140) uniform Material {
+    vec4 uTint;
+};
+
+void main() {
+    FragColor = texture(uTextures, vTexCoord) * uTint;
+}
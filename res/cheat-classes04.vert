@@ -3,11 +3,18 @@
 //Cubes rotating on themselves :
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aTranslation;
+layout (location = 2) in vec2 aTexCoord;
+layout (location = 3) in float aTextureLayer;
+layout (location = 4) in vec4 aTextureRect;
 
 uniform mat4 uModel;
 uniform mat4 uViewProj;
 
+out vec3 vTexCoord;
+
 void main() {
+    // Each instance picks its own image in the texture array
+    vTexCoord = vec3(aTextureRect.xy + aTexCoord * aTextureRect.zw, aTextureLayer);
     gl_Position = uViewProj * uModel * vec4(aPos + aTranslation, 1.0);
 }
 
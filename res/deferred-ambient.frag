@@ -0,0 +1,31 @@
+#version 330 core
+
+// First lighting pass of the DeferredRenderer : ambient and sun on every covered pixel, background elsewhere
+uniform sampler2D uAlbedoRoughness;
+uniform sampler2D uNormal;
+uniform sampler2D uDepth;
+uniform vec3 uAmbient;
+uniform vec3 uSunDirection; // Towards the sun
+uniform vec3 uSunColor;
+uniform vec3 uBackground;
+
+out vec4 FragColor;
+
+vec3 decodeNormal(vec2 encoded) {
+    vec2 f = encoded * 2.0 - 1.0;
+    vec3 n = vec3(f, 1.0 - abs(f.x) - abs(f.y));
+    float t = clamp(-n.z, 0.0, 1.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
+
+void main() {
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    if (texelFetch(uDepth, texel, 0).r == 1.0) {
+        FragColor = vec4(uBackground, 1.0);
+        return;
+    }
+    vec3 albedo = texelFetch(uAlbedoRoughness, texel, 0).rgb;
+    vec3 normal = decodeNormal(texelFetch(uNormal, texel, 0).rg);
+    FragColor = vec4(albedo * (uAmbient + uSunColor * max(dot(normal, uSunDirection), 0.0)), 1.0);
+}
@@ -0,0 +1,47 @@
+#version 330 core
+
+// Point light added to the pixels its volume covers, position is rebuilt from depth
+uniform sampler2D uAlbedoRoughness;
+uniform sampler2D uNormal;
+uniform sampler2D uDepth;
+uniform mat4 uInvViewProj;
+uniform vec2 uScreenSize;
+uniform vec3 uCameraPosition;
+
+flat in vec4 vLightPositionRadius;
+flat in vec3 vLightColor;
+
+out vec4 FragColor;
+
+vec3 decodeNormal(vec2 encoded) {
+    vec2 f = encoded * 2.0 - 1.0;
+    vec3 n = vec3(f, 1.0 - abs(f.x) - abs(f.y));
+    float t = clamp(-n.z, 0.0, 1.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
+
+void main() {
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    float depth = texelFetch(uDepth, texel, 0).r;
+    vec4 clip = vec4(gl_FragCoord.xy / uScreenSize * 2.0 - 1.0, depth * 2.0 - 1.0, 1.0);
+    vec4 world = uInvViewProj * clip;
+    vec3 position = world.xyz / world.w;
+
+    vec3 toLight = vLightPositionRadius.xyz - position;
+    float distance = length(toLight);
+    if (distance >= vLightPositionRadius.w) {
+        discard;
+    }
+    float falloff = 1.0 - (distance * distance) / (vLightPositionRadius.w * vLightPositionRadius.w);
+
+    vec4 albedoRoughness = texelFetch(uAlbedoRoughness, texel, 0);
+    vec3 normal = decodeNormal(texelFetch(uNormal, texel, 0).rg);
+    vec3 lightDirection = toLight / distance;
+    vec3 halfway = normalize(lightDirection + normalize(uCameraPosition - position));
+    float shininess = 2.0 / max(pow(albedoRoughness.a, 4.0), 1e-4) - 2.0;
+    float diffuse = max(dot(normal, lightDirection), 0.0);
+    float specular = diffuse > 0.0 ? pow(max(dot(normal, halfway), 0.0), shininess) * (1.0 - albedoRoughness.a) : 0.0;
+
+    FragColor = vec4((albedoRoughness.rgb * diffuse + specular) * vLightColor * falloff * falloff, 1.0);
+}
@@ -0,0 +1,17 @@
+#version 330 core
+
+// Light volume of the DeferredRenderer, a unit polyhedron around the unit sphere per instance
+layout (location = 0) in vec3 aPosition;
+layout (location = 1) in vec4 aLightPositionRadius;
+layout (location = 2) in vec4 aLightColorIntensity;
+
+uniform mat4 uViewProj;
+
+flat out vec4 vLightPositionRadius;
+flat out vec3 vLightColor;
+
+void main() {
+    vLightPositionRadius = aLightPositionRadius;
+    vLightColor = aLightColorIntensity.rgb * aLightColorIntensity.a;
+    gl_Position = uViewProj * vec4(aLightPositionRadius.xyz + aPosition * aLightPositionRadius.w, 1.0);
+}
@@ -0,0 +1,5 @@
+#version 330 core
+
+// Color writes are masked, only depth is written
+void main() {
+}
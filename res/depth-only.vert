@@ -0,0 +1,14 @@
+#version 330 core
+
+// Position only, for the depth pre-pass of the RenderQueue.
+// Invariant like the shaders of the main pass, so that GL_EQUAL sees the same depth.
+layout (location = 0) in vec3 aPosition;
+
+uniform mat4 uModel;
+uniform mat4 uViewProj;
+
+invariant gl_Position;
+
+void main() {
+    gl_Position = uViewProj * uModel * vec4(aPosition, 1.0);
+}
@@ -0,0 +1,32 @@
+#version 330 core
+
+// Level 0 copies the depth buffer, the next levels keep the max of the texels they cover.
+// The source is restricted to a single level, which is then its lod 0.
+uniform sampler2D uSource;
+uniform bool uReduce;
+uniform ivec2 uTargetSize;
+
+out float fDepth;
+
+void main() {
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    if (!uReduce) {
+        fDepth = texelFetch(uSource, texel, 0).r;
+        return;
+    }
+
+    ivec2 sourceSize = textureSize(uSource, 0);
+    ivec2 first = texel * 2;
+    ivec2 last = min(first + 1, sourceSize - 1);
+    // Odd sizes, the last texel of the level also covers the extra row or column
+    if (texel.x == uTargetSize.x - 1) last.x = sourceSize.x - 1;
+    if (texel.y == uTargetSize.y - 1) last.y = sourceSize.y - 1;
+
+    float depth = 0.0;
+    for (int y = first.y; y <= last.y; y++) {
+        for (int x = first.x; x <= last.x; x++) {
+            depth = max(depth, texelFetch(uSource, ivec2(x, y), 0).r);
+        }
+    }
+    fDepth = depth;
+}
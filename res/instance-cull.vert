@@ -0,0 +1,72 @@
+#version 330 core
+
+// One point per instance, the geometry shader only keeps the visible ones
+layout (location = 0) in vec3 aTranslation;
+layout (location = 1) in float aTextureLayer;
+layout (location = 2) in vec4 aTextureRect;
+
+uniform mat4 uViewProj;
+uniform mat4 uHiZViewProj; // Of the frame the Hi-Z was captured from
+uniform float uRadius;
+uniform bool uHiZEnabled;
+uniform sampler2D uHiZ;     // Max depth pyramid
+uniform ivec2 uHiZSize;
+uniform int uHiZLevelCount;
+
+out vec3 vTranslation;
+out float vTextureLayer;
+out vec4 vTextureRect;
+flat out int vVisible;
+
+bool insideFrustum(vec3 center) {
+    // Clip space bounds grown by the radius projected on each axis
+    vec4 clip = uViewProj * vec4(center, 1.0);
+    for (int axis = 0; axis < 3; axis++) {
+        vec4 row = vec4(uViewProj[0][axis], uViewProj[1][axis], uViewProj[2][axis], uViewProj[3][axis]);
+        vec4 w = vec4(uViewProj[0][3], uViewProj[1][3], uViewProj[2][3], uViewProj[3][3]);
+        float lengthPlus = length((w + row).xyz);
+        float lengthMinus = length((w - row).xyz);
+        if (clip.w + clip[axis] < -uRadius * lengthPlus || clip.w - clip[axis] < -uRadius * lengthMinus) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool behindHiZ(vec3 center) {
+    vec2 minPos = vec2(1.0), maxPos = vec2(0.0);
+    float nearest = 1.0;
+    for (int c = 0; c < 8; c++) {
+        vec3 corner = center + uRadius * vec3((c & 1) != 0 ? 1.0 : -1.0, (c & 2) != 0 ? 1.0 : -1.0, (c & 4) != 0 ? 1.0 : -1.0);
+        vec4 clip = uHiZViewProj * vec4(corner, 1.0);
+        if (clip.w < 1e-5) {
+            return false;
+        }
+        vec3 window = clip.xyz / clip.w * 0.5 + 0.5;
+        minPos = min(minPos, window.xy);
+        maxPos = max(maxPos, window.xy);
+        nearest = min(nearest, window.z);
+    }
+    minPos = clamp(minPos, 0.0, 1.0);
+    maxPos = clamp(maxPos, 0.0, 1.0);
+
+    // Level where the rectangle covers at most 2x2 texels
+    vec2 size = (maxPos - minPos) * vec2(uHiZSize);
+    int level = clamp(int(ceil(log2(max(max(size.x, size.y), 1.0)))), 0, uHiZLevelCount - 1);
+    ivec2 levelSize = max(uHiZSize >> level, ivec2(1));
+    ivec2 texelMin = clamp(ivec2(minPos * vec2(levelSize)), ivec2(0), levelSize - 1);
+    ivec2 texelMax = clamp(ivec2(maxPos * vec2(levelSize)), ivec2(0), levelSize - 1);
+
+    float farthest = max(
+        max(texelFetch(uHiZ, texelMin, level).r, texelFetch(uHiZ, ivec2(texelMax.x, texelMin.y), level).r),
+        max(texelFetch(uHiZ, ivec2(texelMin.x, texelMax.y), level).r, texelFetch(uHiZ, texelMax, level).r)
+    );
+    return nearest > farthest;
+}
+
+void main() {
+    vTranslation = aTranslation;
+    vTextureLayer = aTextureLayer;
+    vTextureRect = aTextureRect;
+    vVisible = insideFrustum(aTranslation) && !(uHiZEnabled && behindHiZ(aTranslation)) ? 1 : 0;
+}
@@ -0,0 +1,7 @@
+#version 330 core
+out vec4 FragColor;
+
+// Added by every shaded fragment, white after 8 layers
+void main() {
+    FragColor = vec4(0.125, 0.125, 0.125, 1.0);
+}
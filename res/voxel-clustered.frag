@@ -0,0 +1,47 @@
+#version 330 core
+
+layout (std140) uniform Material {
+    vec4 uPalette[4]; // Color of each voxel material, 0 is unknown
+    vec4 uLight;      // Direction towards the light, ambient term in w
+};
+
+// Filled by the LightClusters
+layout (std140) uniform Clusters {
+    vec4 uClusterScale;  // Tiles per pixel in xy, slice = log(view depth) * z + w
+    vec4 uClusterDepth;  // Near and far planes
+    ivec4 uClusterCount; // Tiles in x and y, slices
+};
+uniform usamplerBuffer uClusterGrid;    // Offset and count in uClusterIndices of each cluster
+uniform usamplerBuffer uClusterIndices;
+uniform samplerBuffer uClusterLights;   // World position and radius, then color times intensity
+
+in vec3 vPosition;
+flat in vec3 vNormal;
+flat in uint vMaterial;
+
+out vec4 FragColor;
+
+void main() {
+    // View depth back from the window one of a perspective projection
+    float near = uClusterDepth.x;
+    float far = uClusterDepth.y;
+    float viewDepth = near * far / (far - gl_FragCoord.z * (far - near));
+    ivec3 cluster = ivec3(ivec2(gl_FragCoord.xy * uClusterScale.xy), int(floor(log(viewDepth) * uClusterScale.z + uClusterScale.w)));
+    cluster = clamp(cluster, ivec3(0), uClusterCount.xyz - 1);
+    uvec2 range = texelFetch(uClusterGrid, (cluster.z * uClusterCount.y + cluster.y) * uClusterCount.x + cluster.x).xy;
+
+    vec3 albedo = uPalette[vMaterial].rgb;
+    vec3 color = albedo * (uLight.w + (1.0 - uLight.w) * max(dot(vNormal, normalize(uLight.xyz)), 0.0));
+    for (uint i = 0u; i < range.y; i++) {
+        int light = int(texelFetch(uClusterIndices, int(range.x + i)).r);
+        vec4 positionRadius = texelFetch(uClusterLights, light * 2);
+        vec3 toLight = positionRadius.xyz - vPosition;
+        float distance2 = dot(toLight, toLight);
+        if (distance2 < positionRadius.w * positionRadius.w) {
+            float falloff = 1.0 - distance2 / (positionRadius.w * positionRadius.w);
+            float diffuse = max(dot(vNormal, toLight * inversesqrt(max(distance2, 1e-8))), 0.0);
+            color += albedo * diffuse * falloff * falloff * texelFetch(uClusterLights, light * 2 + 1).rgb;
+        }
+    }
+    FragColor = vec4(color, 1.0);
+}
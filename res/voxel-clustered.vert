@@ -0,0 +1,29 @@
+#version 330 core
+
+// Merged quad corners of a VoxelWorld chunk, lit by the lights of their cluster in res/voxel-clustered.frag
+layout (location = 0) in uvec4 aPositionFace;
+layout (location = 1) in uvec4 aMaterial;
+
+uniform mat4 uModel;
+uniform mat4 uViewProj;
+
+// Same depth as the depth pre-pass of the RenderQueue
+invariant gl_Position;
+
+out vec3 vPosition;
+flat out vec3 vNormal;
+flat out uint vMaterial;
+
+const vec3 NORMALS[6] = vec3[6](
+    vec3(-1, 0, 0), vec3(1, 0, 0),
+    vec3(0, -1, 0), vec3(0, 1, 0),
+    vec3(0, 0, -1), vec3(0, 0, 1)
+);
+
+void main() {
+    vPosition = vec3(uModel * vec4(vec3(aPositionFace.xyz), 1.0));
+    vNormal = normalize(mat3(uModel) * NORMALS[aPositionFace.w]);
+    vMaterial = min(aMaterial.x, 3u);
+    // Same expression as res/depth-only.vert, invariance only holds for identical computations
+    gl_Position = uViewProj * uModel * vec4(vec3(aPositionFace.xyz), 1.0);
+}
@@ -0,0 +1,26 @@
+#version 330 core
+
+// Same block as voxel.frag, uLight is unused since lights come later
+layout (std140) uniform Material {
+    vec4 uPalette[4];
+    vec4 uLight;
+};
+
+flat in vec3 vNormal;
+flat in uint vMaterial;
+
+layout (location = 0) out vec4 gAlbedoRoughness;
+layout (location = 1) out vec2 gNormal;
+
+// Octahedral encoding in [0, 1], decoded by the lighting shaders of the DeferredRenderer
+vec2 encodeNormal(vec3 n) {
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    vec2 folded = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    return (n.z >= 0.0 ? n.xy : folded) * 0.5 + 0.5;
+}
+
+void main() {
+    // Stone is smoother than grass and dirt
+    gAlbedoRoughness = vec4(uPalette[vMaterial].rgb, vMaterial == 3u ? 0.4 : 0.9);
+    gNormal = encodeNormal(vNormal);
+}
@@ -0,0 +1,26 @@
+#version 330 core
+
+// Merged quad corners of a VoxelWorld chunk, written to the G-buffer of a DeferredRenderer
+layout (location = 0) in uvec4 aPositionFace;
+layout (location = 1) in uvec4 aMaterial;
+
+uniform mat4 uModel;
+uniform mat4 uViewProj;
+
+// Same depth as the depth pre-pass of the RenderQueue
+invariant gl_Position;
+
+flat out vec3 vNormal;
+flat out uint vMaterial;
+
+const vec3 NORMALS[6] = vec3[6](
+    vec3(-1, 0, 0), vec3(1, 0, 0),
+    vec3(0, -1, 0), vec3(0, 1, 0),
+    vec3(0, 0, -1), vec3(0, 0, 1)
+);
+
+void main() {
+    vNormal = normalize(mat3(uModel) * NORMALS[aPositionFace.w]);
+    vMaterial = min(aMaterial.x, 3u);
+    gl_Position = uViewProj * uModel * vec4(vec3(aPositionFace.xyz), 1.0);
+}
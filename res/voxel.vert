@@ -0,0 +1,31 @@
+#version 330 core
+
+// Merged quad corners of a VoxelWorld chunk
+layout (location = 0) in uvec4 aPositionFace;
+layout (location = 1) in uvec4 aMaterial;
+
+uniform mat4 uModel;
+uniform mat4 uViewProj;
+
+layout (std140) uniform Material {
+    vec4 uPalette[4]; // Color of each voxel material, 0 is unknown
+    vec4 uLight;      // Direction towards the light, ambient term in w
+};
+
+out vec3 vColor;
+
+// Same depth as the depth pre-pass of the RenderQueue
+invariant gl_Position;
+
+const vec3 NORMALS[6] = vec3[6](
+    vec3(-1, 0, 0), vec3(1, 0, 0),
+    vec3(0, -1, 0), vec3(0, 1, 0),
+    vec3(0, 0, -1), vec3(0, 0, 1)
+);
+
+void main() {
+    vec3 normal = NORMALS[aPositionFace.w];
+    float light = uLight.w + (1.0 - uLight.w) * max(dot(normal, normalize(uLight.xyz)), 0.0);
+    vColor = uPalette[min(aMaterial.x, 3u)].rgb * light;
+    gl_Position = uViewProj * uModel * vec4(vec3(aPositionFace.xyz), 1.0);
+}
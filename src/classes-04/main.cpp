@@ -7,6 +7,7 @@
 #include <string>
 
 #include "common/app.h"
+#include "common/frame-loop.h"
 #include "common/gl-exception.h"
 #include "common/square-data.h"
 
@@ -28,7 +29,9 @@ int main(int argc, char *argv[]) {
 
 	// ------------------ Loop :
 
+    FrameLoop frameLoop;
     float counter = 0.0f;
+    float previousCounter = 0.0f;
     while (app.isRunning()) {
         SDL_Event e;
         while (SDL_PollEvent(&e)) {
@@ -39,17 +42,24 @@ int main(int argc, char *argv[]) {
             };
         }
 
-        counter += 0.05f;
-        if (counter > 100) {
-            counter = 0;
+        // Fixed timestep simulation
+        frameLoop.advance();
+        while (frameLoop.step()) {
+            previousCounter = counter;
+            counter += 0.05f;
+            if (counter > 100) {
+                counter = 0;
+                previousCounter = 0;
+            }
         }
+        float renderCounter = glm::mix(previousCounter, counter, static_cast<float>(frameLoop.alpha()));
 
         app.beginFrame();
 
         // Update uniforms
 		shaderPipeline.bind();
         {
-            glm::mat4x4 modelMat = glm::rotate(glm::mat4(1.0f), counter, glm::vec3(0, 1, 0));
+            glm::mat4x4 modelMat = glm::rotate(glm::mat4(1.0f), renderCounter, glm::vec3(0, 1, 0));
 			shaderPipeline.setUniformMat4f("uModel", modelMat);
         }
         {
@@ -1,27 +1,61 @@
 #include "app.h"
 
+#include "async-readback.h"
+#include "gpu-timer.h"
+#include "png-writer.h"
+#include "render-target.h"
+#include "startup-profiler.h"
 #include <glad/glad.h>
 #include <spdlog/spdlog.h>
 #include <debug_break/debug_break.h>
 #include <imgui.h>
 #include <imgui_impl_opengl3.h>
 #include <imgui_impl_sdl.h>
+#include <ctime>
+#include <thread>
 
 bool App::m_instanciated = false;
 
-App::App() {
+App::App()
+	: m_running(true), m_width(0), m_height(0), m_dynamicResolutionEnabled(false),
+	  m_onDemandRendering(false), m_maxWaitMs(100), m_waitedThisFrame(false), m_redrawFrames(0),
+	  m_renderedFrames(0), m_idleMs(0.0), m_refreshMs(1000.0 / 60.0), m_cpuSampleCounter(0), m_cpuSampleClock(0), m_cpuUsage(0.0f),
+	  m_firstFramePresented(false)
+{
     assert(!m_instanciated && "App already created !");
 	m_instanciated = true;
 
     spdlog::set_pattern("[%l] %^ %v %$");
 
+	// The font atlas is pure CPU work, build it while the window and the GL context are created
+	std::thread imguiThread([] {
+		startup::Scope scope("ImGui context and font atlas");
+		IMGUI_CHECKVERSION();
+		ImGui::CreateContext();
+		ImGui::StyleColorsDark();
+		unsigned char* pixels;
+		int width, height;
+		ImGui::GetIO().Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+	});
+
 	initSDL();
+	{
+		startup::Scope scope("Wait for ImGui thread");
+		imguiThread.join();
+	}
 	initImgui();
 
 	glEnable(GL_DEPTH_TEST);
 }
 
 App::~App() {
+	// GL objects must go before the context
+	m_sceneTarget.reset();
+	m_resolveTarget.reset();
+	m_sceneTimer.reset();
+	m_readback.reset();
+	m_pngWriter.reset();
+
 	ImGui_ImplOpenGL3_Shutdown();
 	ImGui_ImplSDL2_Shutdown();
 	ImGui::DestroyContext();
@@ -31,17 +65,162 @@ App::~App() {
 	SDL_Quit();
 }
 
-void App::beginFrame() const {
+void App::beginFrame() {
+	if (m_dynamicResolutionEnabled) {
+		m_sceneTarget->bind(m_dynamicResolution.scaled(m_width), m_dynamicResolution.scaled(m_height));
+		m_sceneTimer->begin();
+	}
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 	ImGui_ImplOpenGL3_NewFrame();
 	ImGui_ImplSDL2_NewFrame(m_window);
 	ImGui::NewFrame();
 }
 
-void App::endFrame() const {
+void App::endFrame() {
+	if (m_dynamicResolutionEnabled) {
+		m_sceneTimer->end();
+
+		// Upscale the scene to the window, then let ImGui draw on top at native resolution
+		const int sceneWidth = m_dynamicResolution.scaled(m_width);
+		const int sceneHeight = m_dynamicResolution.scaled(m_height);
+		if (m_resolveTarget) {
+			m_sceneTarget->resolve(*m_resolveTarget, sceneWidth, sceneHeight);
+			m_resolveTarget->blitToScreen(sceneWidth, sceneHeight, m_width, m_height);
+		} else {
+			m_sceneTarget->blitToScreen(sceneWidth, sceneHeight, m_width, m_height);
+		}
+		m_dynamicResolution.update(m_sceneTimer->lastMs());
+	}
+
 	ImGui::Render();
 	ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+
+	if (m_readback) {
+		if (!m_capturePath.empty()) {
+			const std::string filepath = m_capturePath;
+			PngWriter* pngWriter = m_pngWriter.get();
+			const bool started = m_readback->request([this, filepath, pngWriter](ReadbackFrame& frame) {
+				// Image diff against the previous capture, e.g. before and after a change of settings
+				if (m_lastCapture && m_lastCapture->width == frame.width && m_lastCapture->height == frame.height) {
+					spdlog::info("[App] {} pixels differ from the previous capture", countDifferentPixels(*m_lastCapture, frame));
+				}
+				m_lastCapture.reset(new ReadbackFrame(frame));
+				pngWriter->write(filepath, std::move(frame.pixels), frame.width, frame.height);
+			});
+			if (started) {
+				m_capturePath.clear();
+			}
+		}
+		m_readback->poll();
+	}
+
 	SDL_GL_SwapWindow(m_window);
+
+	if (!m_firstFramePresented) {
+		m_firstFramePresented = true;
+		startup::mark("First frame");
+		spdlog::info("[Startup] First frame after {:.1f} ms", startup::timeToFirstFrameMs());
+	}
+}
+
+void App::captureFrame(const std::string& filepath) {
+	if (!m_readback) {
+		m_readback.reset(new AsyncReadback(m_width, m_height));
+		m_pngWriter.reset(new PngWriter());
+	}
+	m_capturePath = filepath;
+}
+
+void App::setDynamicResolution(bool enabled, double targetGpuMs, int samples) {
+	m_dynamicResolutionEnabled = enabled;
+	m_dynamicResolution.setTargetGpuMs(targetGpuMs);
+	if (!enabled) {
+		m_sceneTarget.reset();
+		m_resolveTarget.reset();
+		m_sceneTimer.reset();
+		glViewport(0, 0, m_width, m_height);
+		return;
+	}
+
+	// Allocated once at full size, scaling only changes the viewport so that nothing is reallocated per frame
+	m_sceneTarget.reset(new RenderTarget(m_width, m_height, samples));
+	m_resolveTarget.reset(samples > 0 ? new RenderTarget(m_width, m_height, 0, false) : nullptr);
+	m_sceneTimer.reset(new GpuTimer());
+}
+
+void App::setOnDemandRendering(bool enabled, int maxWaitMs) {
+	m_onDemandRendering = enabled;
+	m_maxWaitMs = maxWaitMs;
+	m_cpuSampleCounter = SDL_GetPerformanceCounter();
+	m_cpuSampleClock = static_cast<long>(std::clock());
+	SDL_DisplayMode mode;
+	if (SDL_GetWindowDisplayMode(m_window, &mode) == 0 && mode.refresh_rate > 0) {
+		m_refreshMs = 1000.0 / mode.refresh_rate;
+	}
+	requestRedraw();
+}
+
+bool App::pollEvent(SDL_Event& e) {
+	int hasEvent;
+	if (m_onDemandRendering && !m_waitedThisFrame && m_redrawFrames == 0) {
+		// Nothing to draw : sleep until the OS has something for us
+		m_waitedThisFrame = true;
+		const Uint64 start = SDL_GetPerformanceCounter();
+		hasEvent = SDL_WaitEventTimeout(&e, m_maxWaitMs);
+		// Until it wakes up there is no event and nothing to redraw, whether it times out or not
+		m_idleMs += 1000.0 * static_cast<double>(SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency();
+	} else {
+		hasEvent = SDL_PollEvent(&e);
+	}
+
+	if (hasEvent) {
+		ImGui_ImplSDL2_ProcessEvent(&e);
+		if (e.type == SDL_WINDOWEVENT && e.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
+			onResize();
+		}
+		requestRedraw();
+	}
+	return hasEvent != 0;
+}
+
+void App::requestRedraw() {
+	// ImGui reacts to inputs one frame late, so keep one extra frame to let widgets settle
+	m_redrawFrames = 2;
+}
+
+bool App::shouldRender() {
+	m_waitedThisFrame = false;
+
+	// CPU usage of the process, sampled every second (std::clock is wall time with MSVC, so it reads 100% there)
+	const Uint64 now = SDL_GetPerformanceCounter();
+	const double wallSeconds = static_cast<double>(now - m_cpuSampleCounter) / SDL_GetPerformanceFrequency();
+	if (wallSeconds >= 1.0) {
+		const long clockNow = static_cast<long>(std::clock());
+		const double cpuSeconds = static_cast<double>(clockNow - m_cpuSampleClock) / CLOCKS_PER_SEC;
+		m_cpuUsage = static_cast<float>(cpuSeconds / wallSeconds);
+		m_cpuSampleCounter = now;
+		m_cpuSampleClock = clockNow;
+	}
+
+	if (!m_onDemandRendering) {
+		m_renderedFrames++;
+		return true;
+	}
+	if (m_redrawFrames > 0) {
+		m_redrawFrames--;
+		m_renderedFrames++;
+		return true;
+	}
+	return false;
+}
+
+void App::showIdleMetrics() const {
+	ImGui::Begin("Idle rendering");
+	ImGui::Text("Mode : %s", m_onDemandRendering ? "on demand" : "continuous");
+	ImGui::Text("Rendered frames : %llu", m_renderedFrames);
+	ImGui::Text("Skipped frames  : %llu", static_cast<unsigned long long>(m_idleMs / m_refreshMs));
+	ImGui::Text("CPU usage : %.1f %%", m_cpuUsage * 100.0f);
+	ImGui::End();
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -50,15 +229,21 @@ void App::endFrame() const {
 
 bool App::isRunning() const { return m_running; }
 void App::exit() { m_running = false; }
+int App::width() const { return m_width; }
+int App::height() const { return m_height; }
+DynamicResolution& App::dynamicResolution() { return m_dynamicResolution; }
 
 /////////////////////////////////////////////////////////////////////////////
 ///////////////////////////// PRIVATE METHODS ///////////////////////////////
 /////////////////////////////////////////////////////////////////////////////
 
 void App::initSDL() {
-	if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_TIMER) != 0) {
-		spdlog::critical("[SDL2] Unable to initialize SDL: {}", SDL_GetError());
-		debug_break();
+	{
+		startup::Scope scope("SDL_Init");
+		if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_TIMER) != 0) {
+			spdlog::critical("[SDL2] Unable to initialize SDL: {}", SDL_GetError());
+			debug_break();
+		}
 	}
 	
     // Use OpenGL 3.3
@@ -73,36 +258,63 @@ void App::initSDL() {
 	SDL_GL_SetAttribute(SDL_GL_STENCIL_SIZE, 8);
 	SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);	
 	
-	m_window = SDL_CreateWindow(
-		"OpenGL Tutorials !",
-		SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
-		650, 650,
-		SDL_WINDOW_OPENGL | SDL_WINDOW_ALLOW_HIGHDPI
-    );
-	if (m_window == nullptr) {
-        spdlog::critical("[SDL2] Window is null: {}", SDL_GetError());
-        debug_break();
-    }
-
-    m_glContext = SDL_GL_CreateContext(m_window);
-    if (m_glContext == nullptr) {
-        spdlog::critical("[SDL2] OpenGL context is null: {}",  SDL_GetError());
-        debug_break();
-    }
-
-	SDL_GL_MakeCurrent(m_window, m_glContext);
-    SDL_GL_SetSwapInterval(1); // Enable vsync
-
-	if (!gladLoadGL()) {
-		spdlog::critical("[Glad] Glad not init");
-		debug_break();
+	{
+		startup::Scope scope("Window creation");
+		m_window = SDL_CreateWindow(
+			"OpenGL Tutorials !",
+			SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
+			650, 650,
+			SDL_WINDOW_OPENGL | SDL_WINDOW_ALLOW_HIGHDPI
+		);
+		if (m_window == nullptr) {
+			spdlog::critical("[SDL2] Window is null: {}", SDL_GetError());
+			debug_break();
+		}
 	}
+
+	{
+		startup::Scope scope("OpenGL context creation");
+		m_glContext = SDL_GL_CreateContext(m_window);
+		if (m_glContext == nullptr) {
+			spdlog::critical("[SDL2] OpenGL context is null: {}",  SDL_GetError());
+			debug_break();
+		}
+
+		SDL_GL_MakeCurrent(m_window, m_glContext);
+		SDL_GL_SetSwapInterval(1); // Enable vsync
+	}
+
+	{
+		startup::Scope scope("gladLoadGL");
+		if (!gladLoadGL()) {
+			spdlog::critical("[Glad] Glad not init");
+			debug_break();
+		}
+	}
+
+	SDL_GL_GetDrawableSize(m_window, &m_width, &m_height);
 }
 
 void App::initImgui() const {
-	IMGUI_CHECKVERSION();
-	ImGui::CreateContext();
-	ImGui::StyleColorsDark();
+	// Context and font atlas are already created by the constructor
+	startup::Scope scope("ImGui backends");
     ImGui_ImplSDL2_InitForOpenGL(m_window, m_glContext);
 	ImGui_ImplOpenGL3_Init("#version 330 core");
 }
+
+void App::onResize() {
+	// Window events are in points, targets are in pixels
+	SDL_GL_GetDrawableSize(m_window, &m_width, &m_height);
+	if (m_sceneTarget) {
+		m_sceneTarget->resize(m_width, m_height);
+	}
+	if (m_resolveTarget) {
+		m_resolveTarget->resize(m_width, m_height);
+	}
+	if (m_readback) {
+		m_readback->resize(m_width, m_height);
+	}
+	if (!m_dynamicResolutionEnabled) {
+		glViewport(0, 0, m_width, m_height);
+	}
+}
@@ -1,6 +1,16 @@
 #pragma once
 
 #include <SDL2/SDL.h>
+#include <memory>
+#include <string>
+
+#include "dynamic-resolution.h"
+
+class RenderTarget;
+class GpuTimer;
+class AsyncReadback;
+class PngWriter;
+struct ReadbackFrame;
 
 /**
  * @brief Base root of the app
@@ -14,23 +24,113 @@ public:
      * @brief Prepare for a new frame
      * @note Must be called after handling SDL events
      */
-    void beginFrame() const;
+    void beginFrame();
 
     /**
      * @brief Render the preparred frame
      */
-    void endFrame() const;
+    void endFrame();
+
+    /**
+     * @brief Render the scene offscreen at a scale driven by its GPU time, then upscale it to the window
+     * @note ImGui is still drawn at native resolution
+     *
+     * @param enabled
+     * @param targetGpuMs - GPU budget of the scene
+     * @param samples - MSAA samples of the offscreen target, 0 to disable
+     */
+    void setDynamicResolution(bool enabled, double targetGpuMs = 12.0, int samples = 0);
+
+    /**
+     * @brief Save the next presented frame to a PNG file
+     * @note Pixels are read back asynchronously and encoded on a worker thread, the frame is not delayed.
+     *       The number of pixels that differ from the previous capture of the same size is logged.
+     */
+    void captureFrame(const std::string& filepath);
+
+    /**
+     * @brief Only redraw when something changed, and sleep in between
+     * @note The loop must then go through pollEvent() and shouldRender() :
+     * @code
+     * while (app.isRunning()) {
+     *     SDL_Event e;
+     *     while (app.pollEvent(e)) { ... }
+     *     if (!app.shouldRender()) continue;
+     *     app.beginFrame(); ... app.endFrame();
+     * }
+     * @endcode
+     *
+     * @param enabled
+     * @param maxWaitMs - Longest sleep without any event, so that the loop still wakes up from time to time
+     */
+    void setOnDemandRendering(bool enabled, int maxWaitMs = 100);
+
+    /**
+     * @brief Same as SDL_PollEvent, but blocks on the first call of an idle frame in on-demand mode
+     * @note Events are forwarded to ImGui and mark the frame dirty.
+     *       On SDL_WINDOWEVENT_SIZE_CHANGED, width() and height() are updated and the targets of the App resized
+     *       before the event is returned, so that the caller can resize its own targets to them.
+     */
+    bool pollEvent(SDL_Event& e);
+
+    /**
+     * @brief Mark the next frame dirty, to call each frame while something animates
+     */
+    void requestRedraw();
+
+    /**
+     * @brief Tell if beginFrame()/endFrame() must run for this loop iteration
+     */
+    bool shouldRender();
+
+    /**
+     * @brief Display rendered/skipped frames and CPU usage in an ImGui window
+     * @note Must be called between App::beginFrame() and App::endFrame()
+     *       Skipped frames are the display refreshes slept through by pollEvent(), without any event and nothing to redraw.
+     */
+    void showIdleMetrics() const;
 
     bool isRunning() const;
     void exit();
 
+    int width() const;
+    int height() const;
+    DynamicResolution& dynamicResolution();
+
 private:
     void initSDL();
     void initImgui() const;
+    void onResize();
 
 private:
     SDL_Window* m_window;
     SDL_GLContext m_glContext;
     static bool m_instanciated;
     bool m_running;
+    int m_width;
+    int m_height;
+
+    bool m_dynamicResolutionEnabled;
+    DynamicResolution m_dynamicResolution;
+    std::unique_ptr<RenderTarget> m_sceneTarget;
+    std::unique_ptr<RenderTarget> m_resolveTarget;
+    std::unique_ptr<GpuTimer> m_sceneTimer;
+
+    std::unique_ptr<AsyncReadback> m_readback;
+    std::unique_ptr<PngWriter> m_pngWriter;
+    std::string m_capturePath;
+    std::unique_ptr<ReadbackFrame> m_lastCapture;
+
+    bool m_onDemandRendering;
+    int m_maxWaitMs;
+    bool m_waitedThisFrame;
+    unsigned int m_redrawFrames;
+    unsigned long long m_renderedFrames;
+    double m_idleMs;
+    double m_refreshMs;
+    Uint64 m_cpuSampleCounter;
+    long m_cpuSampleClock;
+    float m_cpuUsage;
+
+    bool m_firstFramePresented;
 };
@@ -0,0 +1,101 @@
+#include "asset-loader.h"
+
+#include "gl-exception.h"
+#include <spdlog/spdlog.h>
+#include <cstring>
+
+namespace {
+	// From GL_EXT_texture_compression_s3tc, not part of the core profile loaded by glad
+	const GLenum COMPRESSED_RGB_S3TC_DXT1 = 0x83F0;
+}
+
+namespace assetLoader {
+
+Mesh createMesh(const AssetPack& pack, const assetPack::Entry& entry) {
+	assert(entry.type == assetPack::AssetType::MESH && "Entry is not a mesh !");
+	const std::uint8_t* data = pack.data(entry);
+
+	Mesh mesh;
+	mesh.indexCount = static_cast<GLsizei>(entry.indexCount);
+	mesh.indexType = entry.indexSize == 1 ? GL_UNSIGNED_BYTE : entry.indexSize == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+
+	GLCall(glGenVertexArrays(1, &mesh.vao));
+	GLCall(glBindVertexArray(mesh.vao));
+
+	GLCall(glGenBuffers(1, &mesh.vb));
+	GLCall(glBindBuffer(GL_ARRAY_BUFFER, mesh.vb));
+	GLCall(glBufferData(GL_ARRAY_BUFFER, entry.vertexCount * entry.vertexStride, data, GL_STATIC_DRAW));
+
+	const GLsizei stride = static_cast<GLsizei>(entry.vertexStride);
+	GLCall(glEnableVertexAttribArray(0));
+	GLCall(glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*) offsetof(assetPack::Vertex, position)));
+	GLCall(glEnableVertexAttribArray(1));
+	GLCall(glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*) offsetof(assetPack::Vertex, normal)));
+	GLCall(glEnableVertexAttribArray(2));
+	GLCall(glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*) offsetof(assetPack::Vertex, texCoord)));
+
+	GLCall(glGenBuffers(1, &mesh.ib));
+	GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.ib));
+	GLCall(glBufferData(GL_ELEMENT_ARRAY_BUFFER, entry.indexCount * entry.indexSize, data + entry.indexOffset, GL_STATIC_DRAW));
+
+	GLCall(glBindVertexArray(0));
+	return mesh;
+}
+
+void destroyMesh(Mesh& mesh) {
+	GLCall(glDeleteBuffers(1, &mesh.ib));
+	GLCall(glDeleteBuffers(1, &mesh.vb));
+	GLCall(glDeleteVertexArrays(1, &mesh.vao));
+	mesh = Mesh();
+}
+
+GLuint createTexture(const AssetPack& pack, const assetPack::Entry& entry) {
+	assert(entry.type == assetPack::AssetType::TEXTURE && "Entry is not a texture !");
+	const bool compressed = entry.format == assetPack::TextureFormat::BC1;
+	if (compressed && !supportsBC1()) {
+		spdlog::warn("[AssetLoader] '{}' is BC1 compressed but S3TC is not supported, repack it without --bc1", entry.name);
+		return 0;
+	}
+
+	GLuint id;
+	GLCall(glGenTextures(1, &id));
+	GLCall(glBindTexture(GL_TEXTURE_2D, id));
+	GLCall(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+
+	const std::uint8_t* data = pack.data(entry);
+	const assetPack::MipInfo* mips = pack.mips(entry);
+	for (std::uint32_t level = 0; level < entry.mipCount; level++) {
+		const assetPack::MipInfo& mip = mips[level];
+		if (compressed) {
+			GLCall(glCompressedTexImage2D(GL_TEXTURE_2D, level, COMPRESSED_RGB_S3TC_DXT1, mip.width, mip.height, 0, static_cast<GLsizei>(mip.size), data + mip.offset));
+		} else {
+			GLCall(glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, mip.width, mip.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data + mip.offset));
+		}
+	}
+
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, entry.mipCount - 1));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT));
+	GLCall(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+	GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+	return id;
+}
+
+bool supportsBC1() {
+	static const bool supported = [] {
+		GLint count = 0;
+		GLCall(glGetIntegerv(GL_NUM_EXTENSIONS, &count));
+		for (GLint i = 0; i < count; i++) {
+			const char* name = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+			if (name != nullptr && std::strcmp(name, "GL_EXT_texture_compression_s3tc") == 0) {
+				return true;
+			}
+		}
+		return false;
+	}();
+	return supported;
+}
+
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <glad/glad.h>
+#include "asset-pack.h"
+
+/**
+ * @brief OpenGL objects made straight from a mapped AssetPack, without intermediate copies
+ */
+namespace assetLoader {
+    struct Mesh {
+        GLuint vao = 0;
+        GLuint vb = 0;
+        GLuint ib = 0;
+        GLsizei indexCount = 0;
+        GLenum indexType = GL_UNSIGNED_SHORT;
+    };
+
+    /**
+     * @brief Vertex attributes : 0 position, 1 normal, 2 texCoord
+     */
+    Mesh createMesh(const AssetPack& pack, const assetPack::Entry& entry);
+    void destroyMesh(Mesh& mesh);
+
+    /**
+     * @brief Upload every mip level of a packed texture
+     * @return GLuint - 0 if the format is not supported by the driver
+     */
+    GLuint createTexture(const AssetPack& pack, const assetPack::Entry& entry);
+
+    /**
+     * @brief Is GL_EXT_texture_compression_s3tc available, BC1 textures need it
+     */
+    bool supportsBC1();
+}
@@ -0,0 +1,305 @@
+#include "asset-pack.h"
+
+#include "image-utils.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+using namespace assetPack;
+
+namespace {
+	std::uint64_t alignUp(std::uint64_t value) {
+		return (value + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+	}
+
+	// [offset, offset + size] within [0, limit], written so that nothing overflows
+	bool fits(std::uint64_t offset, std::uint64_t size, std::uint64_t limit) {
+		return offset <= limit && size <= limit - offset;
+	}
+
+	// Everything data(), shaderSource() and mips() may read must be inside the file
+	bool isValidEntry(const Entry& entry, const std::uint8_t* mapping, std::uint64_t fileSize) {
+		if (std::memchr(entry.name, '\0', sizeof(entry.name)) == nullptr || !fits(entry.offset, entry.size, fileSize)) {
+			return false;
+		}
+		if (entry.type == AssetType::MESH) {
+			if (entry.indexSize != 1 && entry.indexSize != 2 && entry.indexSize != 4) {
+				return false;
+			}
+			return static_cast<std::uint64_t>(entry.vertexCount) * entry.vertexStride <= entry.size
+				&& fits(entry.indexOffset, static_cast<std::uint64_t>(entry.indexCount) * entry.indexSize, entry.size);
+		}
+		if (entry.type == AssetType::TEXTURE) {
+			if (static_cast<std::uint64_t>(entry.mipCount) * sizeof(MipInfo) > entry.size) {
+				return false;
+			}
+			const MipInfo* mips = reinterpret_cast<const MipInfo*>(mapping + entry.offset);
+			for (std::uint32_t i = 0; i < entry.mipCount; i++) {
+				if (!fits(mips[i].offset, mips[i].size, entry.size)) {
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+////////////////////////////////// READER ///////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+AssetPack::AssetPack()
+	: m_mapping(nullptr), m_size(0), m_entries(nullptr), m_entryCount(0),
+#ifdef _WIN32
+	  m_file(INVALID_HANDLE_VALUE), m_fileMapping(nullptr)
+#else
+	  m_file(-1)
+#endif
+{}
+
+AssetPack::~AssetPack() {
+	close();
+}
+
+bool AssetPack::open(const std::string& filepath) {
+	close();
+
+#ifdef _WIN32
+	m_file = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (m_file == INVALID_HANDLE_VALUE) {
+		spdlog::warn("Failed to open file : |{}|", filepath);
+		return false;
+	}
+	LARGE_INTEGER fileSize;
+	GetFileSizeEx(m_file, &fileSize);
+	m_size = static_cast<std::size_t>(fileSize.QuadPart);
+	m_fileMapping = CreateFileMappingA(m_file, NULL, PAGE_READONLY, 0, 0, NULL);
+	m_mapping = m_fileMapping != nullptr ? static_cast<const std::uint8_t*>(MapViewOfFile(m_fileMapping, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+#else
+	m_file = ::open(filepath.c_str(), O_RDONLY);
+	if (m_file == -1) {
+		spdlog::warn("Failed to open file : |{}|", filepath);
+		return false;
+	}
+	struct stat fileStat;
+	fstat(m_file, &fileStat);
+	m_size = static_cast<std::size_t>(fileStat.st_size);
+	void* mapping = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_file, 0);
+	m_mapping = mapping != MAP_FAILED ? static_cast<const std::uint8_t*>(mapping) : nullptr;
+	if (m_mapping != nullptr) {
+		// Assets are read front to back while uploading
+		madvise(mapping, m_size, MADV_SEQUENTIAL);
+	}
+#endif
+
+	if (m_mapping == nullptr) {
+		spdlog::error("[AssetPack] Could not map '{}'", filepath);
+		close();
+		return false;
+	}
+
+	// ------------------ Validate
+	const Header* header = reinterpret_cast<const Header*>(m_mapping);
+	if (m_size < sizeof(Header) || header->magic != MAGIC || header->version != VERSION
+		|| !fits(header->tocOffset, static_cast<std::uint64_t>(header->entryCount) * sizeof(Entry), m_size)) {
+		spdlog::error("[AssetPack] '{}' is not a valid version {} pack", filepath, VERSION);
+		close();
+		return false;
+	}
+	// A truncated or corrupt pack is rejected here, so that accessors never read past the mapping
+	const Entry* entries = reinterpret_cast<const Entry*>(m_mapping + header->tocOffset);
+	for (std::uint32_t i = 0; i < header->entryCount; i++) {
+		if (!isValidEntry(entries[i], m_mapping, m_size)) {
+			spdlog::error("[AssetPack] Entry {} of '{}' is out of the file or malformed, the pack is corrupt", i, filepath);
+			close();
+			return false;
+		}
+	}
+	m_entries = entries;
+	m_entryCount = header->entryCount;
+	return true;
+}
+
+void AssetPack::close() {
+#ifdef _WIN32
+	if (m_mapping != nullptr) {
+		UnmapViewOfFile(m_mapping);
+	}
+	if (m_fileMapping != nullptr) {
+		CloseHandle(m_fileMapping);
+		m_fileMapping = nullptr;
+	}
+	if (m_file != INVALID_HANDLE_VALUE) {
+		CloseHandle(m_file);
+		m_file = INVALID_HANDLE_VALUE;
+	}
+#else
+	if (m_mapping != nullptr) {
+		munmap(const_cast<std::uint8_t*>(m_mapping), m_size);
+	}
+	if (m_file != -1) {
+		::close(m_file);
+		m_file = -1;
+	}
+#endif
+	m_mapping = nullptr;
+	m_size = 0;
+	m_entries = nullptr;
+	m_entryCount = 0;
+}
+
+const Entry* AssetPack::find(const std::string& name) const {
+	for (const Entry& entry : *this) {
+		if (name == entry.name) {
+			return &entry;
+		}
+	}
+	return nullptr;
+}
+
+const std::uint8_t* AssetPack::data(const Entry& entry) const {
+	return m_mapping + entry.offset;
+}
+
+std::string AssetPack::shaderSource(const Entry& entry) const {
+	return std::string(reinterpret_cast<const char*>(data(entry)), static_cast<std::size_t>(entry.size));
+}
+
+const MipInfo* AssetPack::mips(const Entry& entry) const {
+	return reinterpret_cast<const MipInfo*>(data(entry));
+}
+
+const Entry* AssetPack::begin() const { return m_entries; }
+const Entry* AssetPack::end() const { return m_entries + m_entryCount; }
+std::size_t AssetPack::size() const { return m_entryCount; }
+
+/////////////////////////////////////////////////////////////////////////////
+////////////////////////////////// WRITER ///////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+void AssetPackWriter::addShader(const std::string& name, const std::string& source) {
+	addEntry(name, AssetType::SHADER, std::vector<std::uint8_t>(source.begin(), source.end()));
+}
+
+void AssetPackWriter::addMesh(const std::string& name, const std::vector<Vertex>& vertices, const std::vector<std::uint32_t>& indices) {
+	// Smallest type able to address every vertex
+	const std::uint32_t indexSize = vertices.size() <= 0x100 ? 1 : vertices.size() <= 0x10000 ? 2 : 4;
+	const std::uint64_t vertexBytes = vertices.size() * sizeof(Vertex);
+	const std::uint64_t indexOffset = alignUp(vertexBytes);
+
+	std::vector<std::uint8_t> data(static_cast<std::size_t>(indexOffset + indices.size() * indexSize));
+	std::memcpy(data.data(), vertices.data(), static_cast<std::size_t>(vertexBytes));
+	for (std::size_t i = 0; i < indices.size(); i++) {
+		if (indexSize == 1) {
+			data[indexOffset + i] = static_cast<std::uint8_t>(indices[i]);
+		} else if (indexSize == 2) {
+			const std::uint16_t index = static_cast<std::uint16_t>(indices[i]);
+			std::memcpy(&data[indexOffset + i * 2], &index, 2);
+		} else {
+			std::memcpy(&data[indexOffset + i * 4], &indices[i], 4);
+		}
+	}
+
+	Entry& entry = addEntry(name, AssetType::MESH, std::move(data));
+	entry.vertexCount = static_cast<std::uint32_t>(vertices.size());
+	entry.indexCount = static_cast<std::uint32_t>(indices.size());
+	entry.indexSize = indexSize;
+	entry.vertexStride = sizeof(Vertex);
+	entry.indexOffset = indexOffset;
+}
+
+void AssetPackWriter::addTexture(const std::string& name, const std::uint8_t* pixels, int width, int height, TextureFormat format) {
+	std::vector<std::vector<std::uint8_t>> levels = imageUtils::mipChain(pixels, width, height);
+	if (format == TextureFormat::BC1) {
+		int levelWidth = width, levelHeight = height;
+		for (auto& level : levels) {
+			level = imageUtils::compressBC1(level.data(), levelWidth, levelHeight);
+			levelWidth = std::max(1, levelWidth / 2);
+			levelHeight = std::max(1, levelHeight / 2);
+		}
+	}
+
+	// ------------------ Mip table, then every level aligned
+	std::vector<MipInfo> mips(levels.size());
+	std::uint64_t offset = alignUp(mips.size() * sizeof(MipInfo));
+	int levelWidth = width, levelHeight = height;
+	for (std::size_t i = 0; i < levels.size(); i++) {
+		mips[i] = { offset, levels[i].size(), static_cast<std::uint32_t>(levelWidth), static_cast<std::uint32_t>(levelHeight) };
+		offset = alignUp(offset + levels[i].size());
+		levelWidth = std::max(1, levelWidth / 2);
+		levelHeight = std::max(1, levelHeight / 2);
+	}
+
+	std::vector<std::uint8_t> data(static_cast<std::size_t>(offset));
+	std::memcpy(data.data(), mips.data(), mips.size() * sizeof(MipInfo));
+	for (std::size_t i = 0; i < levels.size(); i++) {
+		std::memcpy(&data[static_cast<std::size_t>(mips[i].offset)], levels[i].data(), levels[i].size());
+	}
+
+	Entry& entry = addEntry(name, AssetType::TEXTURE, std::move(data));
+	entry.width = static_cast<std::uint32_t>(width);
+	entry.height = static_cast<std::uint32_t>(height);
+	entry.mipCount = static_cast<std::uint32_t>(levels.size());
+	entry.format = format;
+}
+
+bool AssetPackWriter::write(const std::string& filepath) const {
+	std::ofstream stream(filepath, std::ios::binary);
+	if (!stream.is_open()) {
+		spdlog::warn("Failed to open file : |{}|", filepath);
+		return false;
+	}
+
+	// ------------------ Offsets
+	std::vector<Entry> entries = m_entries;
+	std::uint64_t offset = alignUp(sizeof(Header));
+	for (std::size_t i = 0; i < entries.size(); i++) {
+		entries[i].offset = offset;
+		offset = alignUp(offset + m_data[i].size());
+	}
+
+	Header header = { MAGIC, VERSION, static_cast<std::uint32_t>(entries.size()), 0, offset };
+
+	// ------------------ Content
+	const std::vector<char> padding(static_cast<std::size_t>(ALIGNMENT), 0);
+	std::uint64_t written = 0;
+	auto writeAt = [&](std::uint64_t position, const void* data, std::size_t size) {
+		stream.write(padding.data(), static_cast<std::streamsize>(position - written));
+		stream.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+		written = position + size;
+	};
+	writeAt(0, &header, sizeof(header));
+	for (std::size_t i = 0; i < entries.size(); i++) {
+		writeAt(entries[i].offset, m_data[i].data(), m_data[i].size());
+	}
+	writeAt(header.tocOffset, entries.data(), entries.size() * sizeof(Entry));
+
+	return stream.good();
+}
+
+Entry& AssetPackWriter::addEntry(const std::string& name, AssetType type, std::vector<std::uint8_t> data) {
+	Entry entry;
+	std::memset(&entry, 0, sizeof(entry));
+	if (name.size() >= sizeof(entry.name)) {
+		spdlog::warn("[AssetPack] Name '{}' is truncated to {} characters", name, sizeof(entry.name) - 1);
+	}
+	std::strncpy(entry.name, name.c_str(), sizeof(entry.name) - 1);
+	entry.type = type;
+	entry.size = data.size();
+
+	m_entries.push_back(entry);
+	m_data.push_back(std::move(data));
+	return m_entries.back();
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Binary pack of shaders, meshes and textures, made offline by tools/asset-packer
+ * @note Layout : Header, then every asset aligned on ALIGNMENT bytes, then the table of contents.
+ *       All data is stored exactly as OpenGL wants it, so that loading is a pointer into the mapped file.
+ */
+namespace assetPack {
+    const std::uint32_t MAGIC = 0x4B504741; // "AGPK"
+    const std::uint32_t VERSION = 2; // 2 : 1 byte mesh indices
+    const std::uint64_t ALIGNMENT = 256;
+
+    enum class AssetType : std::uint32_t {
+        SHADER = 0,
+        MESH = 1,
+        TEXTURE = 2
+    };
+
+    enum class TextureFormat : std::uint32_t {
+        RGBA8 = 0,
+        BC1 = 1 // S3TC DXT1, needs GL_EXT_texture_compression_s3tc
+    };
+
+    struct Header {
+        std::uint32_t magic;
+        std::uint32_t version;
+        std::uint32_t entryCount;
+        std::uint32_t reserved;
+        std::uint64_t tocOffset;
+    };
+
+    /**
+     * @brief Interleaved vertex of packed meshes
+     */
+    struct Vertex {
+        float position[3];
+        float normal[3];
+        float texCoord[2];
+    };
+
+    /**
+     * @brief Mip level of a packed texture, stored at the start of the texture data
+     */
+    struct MipInfo {
+        std::uint64_t offset; // From the start of the texture data
+        std::uint64_t size;
+        std::uint32_t width;
+        std::uint32_t height;
+    };
+
+    struct Entry {
+        char name[96];
+        AssetType type;
+        std::uint32_t reserved;
+        std::uint64_t offset; // From the start of the file
+        std::uint64_t size;
+
+        // Meshes : vertices first, indices at indexOffset from the start of the mesh data
+        std::uint32_t vertexCount;
+        std::uint32_t indexCount;
+        std::uint32_t indexSize; // 1, 2 or 4 bytes
+        std::uint32_t vertexStride;
+        std::uint64_t indexOffset;
+
+        // Textures
+        std::uint32_t width;
+        std::uint32_t height;
+        std::uint32_t mipCount;
+        TextureFormat format;
+    };
+
+    static_assert(sizeof(Header) == 24, "Pack header layout changed !");
+    static_assert(sizeof(Entry) == 160, "Pack entry layout changed !");
+}
+
+/**
+ * @brief Read-only memory mapped asset pack
+ * @note Nothing is copied : pointers returned by data() point into the mapping and stay valid as long as the pack is open
+ */
+class AssetPack {
+public:
+    AssetPack();
+    ~AssetPack();
+
+    AssetPack(const AssetPack&) = delete;
+    AssetPack& operator=(const AssetPack&) = delete;
+
+    bool open(const std::string& filepath);
+    void close();
+
+    /**
+     * @return nullptr if there is no asset with this name
+     */
+    const assetPack::Entry* find(const std::string& name) const;
+
+    const std::uint8_t* data(const assetPack::Entry& entry) const;
+    std::string shaderSource(const assetPack::Entry& entry) const;
+    const assetPack::MipInfo* mips(const assetPack::Entry& entry) const;
+
+    const assetPack::Entry* begin() const;
+    const assetPack::Entry* end() const;
+    std::size_t size() const;
+
+private:
+    const std::uint8_t* m_mapping;
+    std::size_t m_size;
+    const assetPack::Entry* m_entries;
+    std::uint32_t m_entryCount;
+#ifdef _WIN32
+    void* m_file;
+    void* m_fileMapping;
+#else
+    int m_file;
+#endif
+};
+
+/**
+ * @brief Build a pack, used by the offline packer
+ */
+class AssetPackWriter {
+public:
+    AssetPackWriter() = default;
+    ~AssetPackWriter() = default;
+
+    void addShader(const std::string& name, const std::string& source);
+    void addMesh(const std::string& name, const std::vector<assetPack::Vertex>& vertices, const std::vector<std::uint32_t>& indices);
+
+    /**
+     * @brief Add an RGBA 8 bits image, mip chain is generated here
+     */
+    void addTexture(const std::string& name, const std::uint8_t* pixels, int width, int height, assetPack::TextureFormat format);
+
+    bool write(const std::string& filepath) const;
+
+private:
+    assetPack::Entry& addEntry(const std::string& name, assetPack::AssetType type, std::vector<std::uint8_t> data);
+
+private:
+    std::vector<assetPack::Entry> m_entries;
+    std::vector<std::vector<std::uint8_t>> m_data;
+};
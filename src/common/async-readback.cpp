@@ -0,0 +1,134 @@
+#include "async-readback.h"
+
+#include "gl-exception.h"
+#include <cstring>
+#include <cstdlib>
+
+AsyncReadback::AsyncReadback(int width, int height, unsigned int ringSize)
+	: m_slots(ringSize), m_head(0), m_inFlight(0), m_width(width), m_height(height), m_requestCount(0), m_droppedCount(0)
+{
+	assert(ringSize > 0 && "Ring must have at least one buffer !");
+	for (Slot& slot : m_slots) {
+		GLCall(glGenBuffers(1, &slot.pbo));
+		slot.fence = nullptr;
+		slot.frameIndex = 0;
+	}
+	allocateBuffers();
+}
+
+AsyncReadback::~AsyncReadback() {
+	for (Slot& slot : m_slots) {
+		releaseSlot(slot);
+		GLCall(glDeleteBuffers(1, &slot.pbo));
+	}
+}
+
+bool AsyncReadback::request(Callback callback) {
+	m_requestCount++;
+	if (m_inFlight == m_slots.size()) {
+		m_droppedCount++;
+		return false;
+	}
+
+	Slot& slot = m_slots[(m_head + m_inFlight) % m_slots.size()];
+	slot.callback = callback;
+	slot.frameIndex = m_requestCount - 1;
+
+	// The copy happens on the GPU timeline, glReadPixels returns immediately when a pack buffer is bound
+	GLCall(glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo));
+	GLCall(glPixelStorei(GL_PACK_ALIGNMENT, 4));
+	GLCall(glReadPixels(0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, (void*)0));
+	GLCall(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+	GLCall(slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+
+	m_inFlight++;
+	return true;
+}
+
+void AsyncReadback::poll() {
+	while (m_inFlight > 0) {
+		Slot& slot = m_slots[m_head];
+
+		// Zero timeout : only ask if it is done. The flush makes sure the fence will eventually signal.
+		GLCall(GLenum status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0));
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+			return;
+		}
+
+		ReadbackFrame frame;
+		frame.frameIndex = slot.frameIndex;
+		frame.width = m_width;
+		frame.height = m_height;
+		frame.pixels.resize(static_cast<std::size_t>(m_width) * m_height * 4);
+
+		GLCall(glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo));
+		GLCall(void* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, frame.pixels.size(), GL_MAP_READ_BIT));
+		if (data != nullptr) {
+			std::memcpy(frame.pixels.data(), data, frame.pixels.size());
+			GLCall(glUnmapBuffer(GL_PIXEL_PACK_BUFFER));
+		}
+		GLCall(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+
+		Callback callback = std::move(slot.callback);
+		releaseSlot(slot);
+		m_head = (m_head + 1) % m_slots.size();
+		m_inFlight--;
+
+		if (data != nullptr && callback) {
+			callback(frame);
+		}
+	}
+}
+
+void AsyncReadback::resize(int width, int height) {
+	for (Slot& slot : m_slots) {
+		releaseSlot(slot);
+	}
+	m_head = 0;
+	m_inFlight = 0;
+	m_width = width;
+	m_height = height;
+	allocateBuffers();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//////////////////////////// GETTERS & SETTERS //////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+unsigned int AsyncReadback::inFlightCount() const { return m_inFlight; }
+std::uint64_t AsyncReadback::droppedCount() const { return m_droppedCount; }
+
+/////////////////////////////////////////////////////////////////////////////
+///////////////////////////// PRIVATE METHODS ///////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+void AsyncReadback::allocateBuffers() {
+	const GLsizeiptr size = static_cast<GLsizeiptr>(m_width) * m_height * 4;
+	for (Slot& slot : m_slots) {
+		GLCall(glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo));
+		GLCall(glBufferData(GL_PIXEL_PACK_BUFFER, size, NULL, GL_STREAM_READ));
+	}
+	GLCall(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+}
+
+void AsyncReadback::releaseSlot(Slot& slot) {
+	if (slot.fence != nullptr) {
+		GLCall(glDeleteSync(slot.fence));
+		slot.fence = nullptr;
+	}
+	slot.callback = nullptr;
+}
+
+unsigned int countDifferentPixels(const ReadbackFrame& a, const ReadbackFrame& b, int tolerance) {
+	assert(a.width == b.width && a.height == b.height && "Frames must have the same size !");
+	unsigned int count = 0;
+	for (std::size_t i = 0; i < a.pixels.size(); i += 4) {
+		for (std::size_t c = 0; c < 4; c++) {
+			if (std::abs(static_cast<int>(a.pixels[i + c]) - static_cast<int>(b.pixels[i + c])) > tolerance) {
+				count++;
+				break;
+			}
+		}
+	}
+	return count;
+}
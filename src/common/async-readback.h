@@ -0,0 +1,86 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/**
+ * @brief Pixels of a finished readback, RGBA 8 bits, first row is the bottom of the image
+ */
+struct ReadbackFrame {
+    std::uint64_t frameIndex;
+    int width;
+    int height;
+    std::vector<std::uint8_t> pixels;
+};
+
+/**
+ * @brief Read framebuffers back to the CPU without stalling the pipeline
+ * @note glReadPixels goes into a ring of pixel pack buffers, a fence tells when each copy is done.
+ *       poll() only maps buffers whose fence is already signaled, so it never waits for the GPU.
+ *
+ * @code
+ * readback.request([&](ReadbackFrame& frame) { pngWriter.write("frame.png", std::move(frame.pixels), frame.width, frame.height); });
+ * ...
+ * readback.poll(); // Once per frame
+ * @endcode
+ */
+class AsyncReadback {
+public:
+    using Callback = std::function<void(ReadbackFrame&)>;
+
+    /**
+     * @param ringSize - Readbacks in flight at once. 3 covers the usual latency of a double buffered swap chain.
+     */
+    AsyncReadback(int width, int height, unsigned int ringSize = 3);
+    ~AsyncReadback();
+
+    AsyncReadback(const AsyncReadback&) = delete;
+    AsyncReadback& operator=(const AsyncReadback&) = delete;
+
+    /**
+     * @brief Start reading the [0, width]x[0, height] area of the bound read framebuffer
+     * @return false if every buffer of the ring is still in flight, the request is then dropped
+     */
+    bool request(Callback callback);
+
+    /**
+     * @brief Call back every finished readback, in request order
+     */
+    void poll();
+
+    /**
+     * @brief Resize future readbacks, the ones in flight are dropped
+     */
+    void resize(int width, int height);
+
+    unsigned int inFlightCount() const;
+    std::uint64_t droppedCount() const;
+
+private:
+    struct Slot {
+        GLuint pbo;
+        GLsync fence;
+        Callback callback;
+        std::uint64_t frameIndex;
+    };
+
+    void allocateBuffers();
+    void releaseSlot(Slot& slot);
+
+private:
+    std::vector<Slot> m_slots;
+    unsigned int m_head; // Oldest readback in flight
+    unsigned int m_inFlight;
+    int m_width;
+    int m_height;
+    std::uint64_t m_requestCount;
+    std::uint64_t m_droppedCount;
+};
+
+/**
+ * @brief Count pixels which differ by more than tolerance on any channel
+ * @note Meant for image-diff regression tests against golden captures
+ */
+unsigned int countDifferentPixels(const ReadbackFrame& a, const ReadbackFrame& b, int tolerance = 0);
@@ -0,0 +1,289 @@
+#include "command-buffer.h"
+
+#include "gl-exception.h"
+#include "index-buffer.h"
+#include "job-system.h"
+#include <cstring>
+
+/////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////// ARENA ///////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+CommandArena::CommandArena(unsigned int threadCount) : m_pools(threadCount > 0 ? threadCount : 1) {}
+
+unsigned char* CommandArena::allocatePage() {
+	// A single pool belongs to the only recording thread, which may not be part of any JobSystem
+	const unsigned int index = m_pools.size() > 1 ? JobSystem::threadIndex() : 0;
+	assert(index < m_pools.size() && "Thread has no command pool, create the arena with JobSystem::threadCount() !");
+	ThreadPool& pool = m_pools[index];
+
+	const std::size_t block = pool.usedPages / PAGES_PER_BLOCK;
+	if (block == pool.blocks.size()) {
+		pool.blocks.emplace_back(new unsigned char[PAGE_SIZE * PAGES_PER_BLOCK]);
+	}
+	unsigned char* page = pool.blocks[block].get() + (pool.usedPages % PAGES_PER_BLOCK) * PAGE_SIZE;
+	pool.usedPages++;
+	return page;
+}
+
+void CommandArena::reset() {
+	for (ThreadPool& pool : m_pools) {
+		pool.usedPages = 0;
+	}
+}
+
+std::size_t CommandArena::usedBytes() const {
+	std::size_t pages = 0;
+	for (const ThreadPool& pool : m_pools) {
+		pages += pool.usedPages;
+	}
+	return pages * PAGE_SIZE;
+}
+
+std::size_t CommandArena::reservedBytes() const {
+	std::size_t blocks = 0;
+	for (const ThreadPool& pool : m_pools) {
+		blocks += pool.blocks.size();
+	}
+	return blocks * PAGES_PER_BLOCK * PAGE_SIZE;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////// BUFFER //////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+CommandBuffer::CommandBuffer()
+	: m_arena(nullptr), m_first(nullptr), m_cursor(nullptr), m_pageEnd(nullptr), m_commandCount(0)
+{}
+
+void CommandBuffer::reset(CommandArena& arena) {
+	m_arena = &arena;
+	m_first = nullptr;
+	m_cursor = nullptr;
+	m_pageEnd = nullptr;
+	m_commandCount = 0;
+}
+
+void CommandBuffer::bindPipeline(GLuint program) {
+	push<command::BindPipeline>(command::Type::BIND_PIPELINE).program = program;
+}
+
+void CommandBuffer::setUniformMat4(const char* name, const glm::mat4& value) {
+	command::SetUniformMat4& cmd = push<command::SetUniformMat4>(command::Type::SET_UNIFORM_MAT4);
+	cmd.name = name;
+	std::memcpy(cmd.value, &value[0][0], sizeof(cmd.value));
+}
+
+void CommandBuffer::bindTexture(GLuint slot, GLenum target, GLuint texture) {
+	command::BindTexture& cmd = push<command::BindTexture>(command::Type::BIND_TEXTURE);
+	cmd.slot = slot;
+	cmd.target = target;
+	cmd.texture = texture;
+}
+
+void CommandBuffer::bindUniformRange(GLuint binding, GLuint buffer, GLuint offset, GLuint size) {
+	command::BindUniformRange& cmd = push<command::BindUniformRange>(command::Type::BIND_UNIFORM_RANGE);
+	cmd.binding = binding;
+	cmd.buffer = buffer;
+	cmd.offset = offset;
+	cmd.size = size;
+}
+
+void CommandBuffer::bindVertexArray(GLuint vertexArray) {
+	push<command::BindVertexArray>(command::Type::BIND_VERTEX_ARRAY).vertexArray = vertexArray;
+}
+
+void CommandBuffer::setDepthState(GLenum func, bool depthWrite, bool colorWrite) {
+	command::SetDepthState& cmd = push<command::SetDepthState>(command::Type::SET_DEPTH_STATE);
+	cmd.func = func;
+	cmd.depthWrite = depthWrite;
+	cmd.colorWrite = colorWrite;
+}
+
+void CommandBuffer::setBlendState(bool enabled, GLenum sourceFactor, GLenum destinationFactor) {
+	command::SetBlendState& cmd = push<command::SetBlendState>(command::Type::SET_BLEND_STATE);
+	cmd.enabled = enabled;
+	cmd.sourceFactor = sourceFactor;
+	cmd.destinationFactor = destinationFactor;
+}
+
+void CommandBuffer::drawIndexed(const IndexBuffer& indices, GLenum mode, GLsizei instanceCount) {
+	command::DrawIndexed& cmd = push<command::DrawIndexed>(command::Type::DRAW_INDEXED);
+	cmd.primitiveRestart = indices.hasPrimitiveRestart();
+	cmd.mode = mode;
+	cmd.indexType = indices.type();
+	cmd.count = indices.count();
+	cmd.instanceCount = instanceCount;
+	cmd.elementBuffer = indices.id();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//////////////////////////// GETTERS & SETTERS //////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+const unsigned char* CommandBuffer::begin() const { return m_first; }
+std::size_t CommandBuffer::commandCount() const { return m_commandCount; }
+bool CommandBuffer::isEmpty() const { return m_commandCount == 0; }
+
+/////////////////////////////////////////////////////////////////////////////
+///////////////////////////// PRIVATE METHODS ///////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+unsigned char* CommandBuffer::reserve(std::size_t size) {
+	assert(m_arena && "Command buffer must be reset with an arena before recording !");
+
+	// Always keep room for the jump or the end marker after the command
+	const std::size_t tail = command::alignedSize<command::Jump>();
+	assert(size + tail <= CommandArena::PAGE_SIZE && "Command does not fit in a page !");
+
+	if (m_cursor == nullptr || m_cursor + size + tail > m_pageEnd) {
+		unsigned char* page = m_arena->allocatePage();
+		if (m_cursor == nullptr) {
+			m_first = page;
+		} else {
+			command::Jump* jump = reinterpret_cast<command::Jump*>(m_cursor);
+			jump->type = command::Type::JUMP;
+			jump->next = page;
+		}
+		m_cursor = page;
+		m_pageEnd = page + CommandArena::PAGE_SIZE;
+	}
+
+	unsigned char* cmd = m_cursor;
+	m_cursor += size;
+	*m_cursor = static_cast<unsigned char>(command::Type::END);
+	return cmd;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+////////////////////////////////// REPLAYER /////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+void CommandReplayer::replay(const CommandBuffer& buffer) {
+	m_stats.buffers++;
+	m_stats.commands += static_cast<unsigned int>(buffer.commandCount());
+
+	const unsigned char* cursor = buffer.begin();
+	while (cursor != nullptr) {
+		switch (static_cast<command::Type>(*cursor)) {
+		case command::Type::END:
+			cursor = nullptr;
+			break;
+
+		case command::Type::JUMP:
+			cursor = reinterpret_cast<const command::Jump*>(cursor)->next;
+			break;
+
+		case command::Type::BIND_PIPELINE: {
+			const auto& cmd = *reinterpret_cast<const command::BindPipeline*>(cursor);
+			m_program = cmd.program;
+			GLCall(glUseProgram(cmd.program));
+			cursor += command::alignedSize<command::BindPipeline>();
+			break;
+		}
+
+		case command::Type::SET_UNIFORM_MAT4: {
+			const auto& cmd = *reinterpret_cast<const command::SetUniformMat4*>(cursor);
+			GLCall(glUniformMatrix4fv(uniformLocation(cmd.name), 1, GL_FALSE, cmd.value));
+			cursor += command::alignedSize<command::SetUniformMat4>();
+			break;
+		}
+
+		case command::Type::BIND_TEXTURE: {
+			const auto& cmd = *reinterpret_cast<const command::BindTexture*>(cursor);
+			GLCall(glActiveTexture(GL_TEXTURE0 + cmd.slot));
+			GLCall(glBindTexture(cmd.target, cmd.texture));
+			cursor += command::alignedSize<command::BindTexture>();
+			break;
+		}
+
+		case command::Type::BIND_UNIFORM_RANGE: {
+			const auto& cmd = *reinterpret_cast<const command::BindUniformRange*>(cursor);
+			GLCall(glBindBufferRange(GL_UNIFORM_BUFFER, cmd.binding, cmd.buffer, cmd.offset, cmd.size));
+			cursor += command::alignedSize<command::BindUniformRange>();
+			break;
+		}
+
+		case command::Type::BIND_VERTEX_ARRAY: {
+			const auto& cmd = *reinterpret_cast<const command::BindVertexArray*>(cursor);
+			GLCall(glBindVertexArray(cmd.vertexArray));
+			cursor += command::alignedSize<command::BindVertexArray>();
+			break;
+		}
+
+		case command::Type::SET_DEPTH_STATE: {
+			const auto& cmd = *reinterpret_cast<const command::SetDepthState*>(cursor);
+			const GLboolean color = cmd.colorWrite ? GL_TRUE : GL_FALSE;
+			GLCall(glDepthFunc(cmd.func));
+			GLCall(glDepthMask(cmd.depthWrite ? GL_TRUE : GL_FALSE));
+			GLCall(glColorMask(color, color, color, color));
+			cursor += command::alignedSize<command::SetDepthState>();
+			break;
+		}
+
+		case command::Type::SET_BLEND_STATE: {
+			const auto& cmd = *reinterpret_cast<const command::SetBlendState*>(cursor);
+			if (cmd.enabled) {
+				GLCall(glEnable(GL_BLEND));
+				GLCall(glBlendFunc(cmd.sourceFactor, cmd.destinationFactor));
+			} else {
+				GLCall(glDisable(GL_BLEND));
+			}
+			cursor += command::alignedSize<command::SetBlendState>();
+			break;
+		}
+
+		case command::Type::DRAW_INDEXED: {
+			const auto& cmd = *reinterpret_cast<const command::DrawIndexed*>(cursor);
+			GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, cmd.elementBuffer));
+			if (cmd.primitiveRestart) {
+				GLCall(glEnable(GL_PRIMITIVE_RESTART));
+				GLCall(glPrimitiveRestartIndex(IndexBuffer::restartIndex(cmd.indexType)));
+			}
+			if (cmd.instanceCount == 1) {
+				GLCall(glDrawElements(cmd.mode, cmd.count, cmd.indexType, (void*)0));
+			} else {
+				GLCall(glDrawElementsInstanced(cmd.mode, cmd.count, cmd.indexType, (void*)0, cmd.instanceCount));
+			}
+			if (cmd.primitiveRestart) {
+				GLCall(glDisable(GL_PRIMITIVE_RESTART));
+			}
+			m_stats.draws++;
+			cursor += command::alignedSize<command::DrawIndexed>();
+			break;
+		}
+
+		default:
+			assert(false && "Unknown command type !");
+			cursor = nullptr;
+			break;
+		}
+	}
+}
+
+void CommandReplayer::replay(const std::vector<CommandBuffer>& buffers) {
+	for (const CommandBuffer& buffer : buffers) {
+		replay(buffer);
+	}
+	GLCall(glBindVertexArray(0));
+}
+
+CommandReplayer::Stats CommandReplayer::takeStats() {
+	const Stats stats = m_stats;
+	m_stats = Stats();
+	return stats;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+///////////////////////////// PRIVATE METHODS ///////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+GLint CommandReplayer::uniformLocation(const char* name) {
+	const UniformKey key = { m_program, name };
+	auto it = m_uniformLocations.find(key);
+	if (it == m_uniformLocations.end()) {
+		GLCall(GLint location = glGetUniformLocation(m_program, name));
+		it = m_uniformLocations.emplace(key, location).first;
+	}
+	return it->second;
+}
@@ -0,0 +1,246 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+class IndexBuffer;
+
+/**
+ * @brief Plain data commands, each one starts with its type so that a buffer can be walked without any vtable
+ */
+namespace command {
+    enum class Type : std::uint8_t {
+        END = 0,
+        JUMP,             // Continue in another page of the arena
+        BIND_PIPELINE,
+        SET_UNIFORM_MAT4,
+        BIND_TEXTURE,
+        BIND_UNIFORM_RANGE,
+        BIND_VERTEX_ARRAY,
+        SET_DEPTH_STATE,
+        SET_BLEND_STATE,
+        DRAW_INDEXED
+    };
+
+    struct Jump {
+        Type type;
+        const unsigned char* next;
+    };
+
+    struct BindPipeline {
+        Type type;
+        GLuint program;
+    };
+
+    struct SetUniformMat4 {
+        Type type;
+        const char* name; // Not copied, must outlive the replay (eg: a string literal)
+        float value[16];
+    };
+
+    struct BindTexture {
+        Type type;
+        GLuint slot;
+        GLenum target;
+        GLuint texture;
+    };
+
+    struct BindUniformRange {
+        Type type;
+        GLuint binding;
+        GLuint buffer;
+        GLuint offset;
+        GLuint size;
+    };
+
+    struct BindVertexArray {
+        Type type;
+        GLuint vertexArray;
+    };
+
+    struct SetDepthState {
+        Type type;
+        GLenum func;
+        bool depthWrite;
+        bool colorWrite; // Off for depth only passes
+    };
+
+    struct SetBlendState {
+        Type type;
+        bool enabled;
+        GLenum sourceFactor;
+        GLenum destinationFactor;
+    };
+
+    struct DrawIndexed {
+        Type type;
+        bool primitiveRestart;
+        GLenum mode;
+        GLenum indexType;
+        GLsizei count;
+        GLsizei instanceCount;
+        GLuint elementBuffer;
+    };
+
+    static constexpr std::size_t ALIGNMENT = 8;
+
+    template<typename T>
+    constexpr std::size_t alignedSize() { return (sizeof(T) + ALIGNMENT - 1) & ~(ALIGNMENT - 1); }
+}
+
+/**
+ * @brief Linear memory for command buffers, one pool of pages per JobSystem thread
+ * @note A thread only takes pages from its own pool so recording never locks.
+ *       Pages are kept from one frame to the next, reset() just rewinds every pool.
+ *       Threads outside of the JobSystem share the pool of thread 0, only one of them may record.
+ */
+class CommandArena {
+public:
+    static constexpr std::size_t PAGE_SIZE = 4096;
+    static constexpr std::size_t PAGES_PER_BLOCK = 64;
+
+    /**
+     * @param threadCount - Number of threads which can record, usually JobSystem::threadCount()
+     */
+    CommandArena(unsigned int threadCount = 1);
+    ~CommandArena() = default;
+
+    CommandArena(const CommandArena&) = delete;
+    CommandArena& operator=(const CommandArena&) = delete;
+
+    /**
+     * @brief Page of PAGE_SIZE bytes from the pool of the calling thread (JobSystem::threadIndex())
+     * @note With a single pool, any one thread can record without a JobSystem
+     */
+    unsigned char* allocatePage();
+
+    /**
+     * @brief Make every page available again, no buffer recorded from this arena may be used afterwards
+     */
+    void reset();
+
+    std::size_t usedBytes() const;
+    std::size_t reservedBytes() const;
+
+private:
+    struct alignas(64) ThreadPool {
+        std::vector<std::unique_ptr<unsigned char[]>> blocks;
+        std::size_t usedPages = 0;
+    };
+
+    std::vector<ThreadPool> m_pools;
+};
+
+/**
+ * @brief List of commands recorded on any thread, replayed later on the OpenGL thread by a CommandReplayer
+ * @note A buffer must only be recorded by one thread at a time. Several buffers recorded in parallel
+ *       are replayed in the order they are given to the replayer, whichever thread recorded them.
+ *
+ * @code
+ * jobs.parallelFor(0, sliceCount, 1, [&](std::uint32_t begin, std::uint32_t end) {
+ *     for (std::uint32_t i = begin; i < end; i++) {
+ *         buffers[i].reset(arena);
+ *         buffers[i].bindVertexArray(vao);
+ *         ...
+ *     }
+ * });
+ * replayer.replay(buffers);
+ * arena.reset();
+ * @endcode
+ */
+class CommandBuffer {
+public:
+    CommandBuffer();
+    ~CommandBuffer() = default;
+
+    /**
+     * @brief Forget previous commands and take new pages from arena while recording
+     */
+    void reset(CommandArena& arena);
+
+    void bindPipeline(GLuint program);
+    void setUniformMat4(const char* name, const glm::mat4& value);
+    void bindTexture(GLuint slot, GLenum target, GLuint texture);
+    void bindUniformRange(GLuint binding, GLuint buffer, GLuint offset, GLuint size);
+    void bindVertexArray(GLuint vertexArray);
+    void setDepthState(GLenum func, bool depthWrite, bool colorWrite = true);
+    void setBlendState(bool enabled, GLenum sourceFactor = GL_SRC_ALPHA, GLenum destinationFactor = GL_ONE_MINUS_SRC_ALPHA);
+
+    /**
+     * @brief Draw indices with the vertex array bound by a previous command, the buffer is only read for its description
+     */
+    void drawIndexed(const IndexBuffer& indices, GLenum mode, GLsizei instanceCount = 1);
+
+    const unsigned char* begin() const;
+    std::size_t commandCount() const;
+    bool isEmpty() const;
+
+private:
+    template<typename T>
+    T& push(command::Type type) {
+        static_assert(std::is_trivially_copyable<T>::value && std::is_trivially_destructible<T>::value, "Commands must be plain data !");
+        static_assert(alignof(T) <= command::ALIGNMENT, "Command is over-aligned !");
+        T* cmd = reinterpret_cast<T*>(reserve(command::alignedSize<T>()));
+        cmd->type = type;
+        m_commandCount++;
+        return *cmd;
+    }
+
+    unsigned char* reserve(std::size_t size);
+
+private:
+    CommandArena* m_arena;
+    unsigned char* m_first;
+    unsigned char* m_cursor;
+    unsigned char* m_pageEnd;
+    std::size_t m_commandCount;
+};
+
+/**
+ * @brief Execute command buffers on the OpenGL thread
+ * @note Uniform locations are looked up once per program and name, then cached
+ */
+class CommandReplayer {
+public:
+    struct Stats {
+        unsigned int buffers = 0;
+        unsigned int commands = 0;
+        unsigned int draws = 0;
+    };
+
+public:
+    CommandReplayer() = default;
+    ~CommandReplayer() = default;
+
+    void replay(const CommandBuffer& buffer);
+    void replay(const std::vector<CommandBuffer>& buffers);
+
+    /**
+     * @brief Counters accumulated since the last call, then reset
+     */
+    Stats takeStats();
+
+private:
+    GLint uniformLocation(const char* name);
+
+private:
+    struct UniformKey {
+        GLuint program;
+        const char* name;
+        bool operator==(const UniformKey& other) const { return program == other.program && name == other.name; }
+    };
+    struct UniformKeyHash {
+        std::size_t operator()(const UniformKey& key) const { return std::hash<const char*>()(key.name) ^ (static_cast<std::size_t>(key.program) << 1); }
+    };
+
+    GLuint m_program = 0;
+    std::unordered_map<UniformKey, GLint, UniformKeyHash> m_uniformLocations;
+    Stats m_stats;
+};
@@ -0,0 +1,299 @@
+#include "deferred-renderer.h"
+
+#include "gl-exception.h"
+#include "shader-utils.h"
+#include <spdlog/spdlog.h>
+#include <imgui.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace {
+	void createTexture(GLuint& texture, GLenum internalFormat, GLenum format, GLenum type, int width, int height) {
+		GLCall(glGenTextures(1, &texture));
+		GLCall(glBindTexture(GL_TEXTURE_2D, texture));
+		GLCall(glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, NULL));
+		GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST));
+		GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
+		GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+		GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+	}
+
+	void checkFramebuffer() {
+		GLCall(GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER));
+		if (status != GL_FRAMEBUFFER_COMPLETE) {
+			spdlog::critical("[DeferredRenderer] Framebuffer incomplete : {:#x}", status);
+			debug_break();
+		}
+	}
+
+	void bindGBuffer(GLuint program, GLuint albedoRoughness, GLuint normal, GLuint depth) {
+		GLCall(glUniform1i(glGetUniformLocation(program, "uAlbedoRoughness"), 0));
+		GLCall(glUniform1i(glGetUniformLocation(program, "uNormal"), 1));
+		GLCall(glUniform1i(glGetUniformLocation(program, "uDepth"), 2));
+		GLCall(glActiveTexture(GL_TEXTURE0));
+		GLCall(glBindTexture(GL_TEXTURE_2D, albedoRoughness));
+		GLCall(glActiveTexture(GL_TEXTURE1));
+		GLCall(glBindTexture(GL_TEXTURE_2D, normal));
+		GLCall(glActiveTexture(GL_TEXTURE2));
+		GLCall(glBindTexture(GL_TEXTURE_2D, depth));
+	}
+}
+
+DeferredRenderer::DeferredRenderer(int width, int height, Precision precision)
+	: m_width(width), m_height(height), m_precision(precision),
+	  m_ambient(0.15f), m_sunDirection(glm::normalize(glm::vec3(0.4f, 1.0f, 0.3f))), m_sunColor(0.25f), m_background(0.05f, 0.05f, 0.1f),
+	  m_lightCount(0)
+{
+	m_ambientProgram = shaderUtils::createProgram("res/fullscreen.vert", "res/deferred-ambient.frag");
+	m_lightProgram = shaderUtils::createProgram("res/deferred-light.vert", "res/deferred-light.frag");
+	GLCall(glGenVertexArrays(1, &m_emptyVao));
+	createLightVolume();
+	create();
+}
+
+DeferredRenderer::~DeferredRenderer() {
+	destroy();
+	GLCall(glDeleteBuffers(1, &m_lightsVb));
+	GLCall(glDeleteBuffers(1, &m_volumeIb));
+	GLCall(glDeleteBuffers(1, &m_volumeVb));
+	GLCall(glDeleteVertexArrays(1, &m_volumeVao));
+	GLCall(glDeleteVertexArrays(1, &m_emptyVao));
+	GLCall(glDeleteProgram(m_lightProgram));
+	GLCall(glDeleteProgram(m_ambientProgram));
+}
+
+void DeferredRenderer::resize(int width, int height) {
+	if (width == m_width && height == m_height) {
+		return;
+	}
+	destroy();
+	m_width = width;
+	m_height = height;
+	create();
+}
+
+void DeferredRenderer::setPrecision(Precision precision) {
+	if (precision == m_precision) {
+		return;
+	}
+	destroy();
+	m_precision = precision;
+	create();
+}
+
+void DeferredRenderer::beginGeometry() {
+	m_geometryTimer.begin();
+	GLCall(glBindFramebuffer(GL_FRAMEBUFFER, m_gBufferFb));
+	GLCall(glViewport(0, 0, m_width, m_height));
+	GLCall(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
+}
+
+void DeferredRenderer::endGeometry() {
+	m_geometryTimer.end();
+}
+
+void DeferredRenderer::light(const std::vector<PointLight>& lights, const glm::mat4& viewProj, const glm::vec3& cameraPosition) {
+	m_lightingTimer.begin();
+	m_lightCount = lights.size();
+
+	// ------------------ Depth of the G-buffer, tested by the light volumes and the forward pass
+	GLCall(glBindFramebuffer(GL_READ_FRAMEBUFFER, m_gBufferFb));
+	GLCall(glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_lightingFb));
+	GLCall(glBlitFramebuffer(0, 0, m_width, m_height, 0, 0, m_width, m_height, GL_DEPTH_BUFFER_BIT, GL_NEAREST));
+	GLCall(glBindFramebuffer(GL_FRAMEBUFFER, m_lightingFb));
+	GLCall(glViewport(0, 0, m_width, m_height));
+
+	// ------------------ Ambient and sun, every pixel is written so nothing has to be cleared
+	GLCall(glDisable(GL_DEPTH_TEST));
+	GLCall(glUseProgram(m_ambientProgram));
+	bindGBuffer(m_ambientProgram, m_albedoRoughness, m_normal, m_depth);
+	GLCall(glUniform3fv(glGetUniformLocation(m_ambientProgram, "uAmbient"), 1, &m_ambient[0]));
+	GLCall(glUniform3fv(glGetUniformLocation(m_ambientProgram, "uSunDirection"), 1, &m_sunDirection[0]));
+	GLCall(glUniform3fv(glGetUniformLocation(m_ambientProgram, "uSunColor"), 1, &m_sunColor[0]));
+	GLCall(glUniform3fv(glGetUniformLocation(m_ambientProgram, "uBackground"), 1, &m_background[0]));
+	GLCall(glBindVertexArray(m_emptyVao));
+	GLCall(glDrawArrays(GL_TRIANGLES, 0, 3));
+
+	// ------------------ Light volumes, back faces behind the surface shade it. Clamped so that far lights are not clipped.
+	if (!lights.empty()) {
+		GLCall(glBindBuffer(GL_ARRAY_BUFFER, m_lightsVb));
+		GLCall(glBufferData(GL_ARRAY_BUFFER, lights.size() * sizeof(PointLight), lights.data(), GL_STREAM_DRAW));
+		GLCall(glBindBuffer(GL_ARRAY_BUFFER, 0));
+
+		const glm::mat4 invViewProj = glm::inverse(viewProj);
+		GLCall(glUseProgram(m_lightProgram));
+		bindGBuffer(m_lightProgram, m_albedoRoughness, m_normal, m_depth);
+		GLCall(glUniformMatrix4fv(glGetUniformLocation(m_lightProgram, "uViewProj"), 1, GL_FALSE, &viewProj[0][0]));
+		GLCall(glUniformMatrix4fv(glGetUniformLocation(m_lightProgram, "uInvViewProj"), 1, GL_FALSE, &invViewProj[0][0]));
+		GLCall(glUniform2f(glGetUniformLocation(m_lightProgram, "uScreenSize"), static_cast<float>(m_width), static_cast<float>(m_height)));
+		GLCall(glUniform3fv(glGetUniformLocation(m_lightProgram, "uCameraPosition"), 1, &cameraPosition[0]));
+
+		GLCall(glEnable(GL_DEPTH_TEST));
+		GLCall(glDepthFunc(GL_GEQUAL));
+		GLCall(glDepthMask(GL_FALSE));
+		GLCall(glEnable(GL_DEPTH_CLAMP));
+		GLCall(glEnable(GL_CULL_FACE));
+		GLCall(glCullFace(GL_FRONT));
+		GLCall(glEnable(GL_BLEND));
+		GLCall(glBlendFunc(GL_ONE, GL_ONE));
+
+		GLCall(glBindVertexArray(m_volumeVao));
+		GLCall(glDrawElementsInstanced(GL_TRIANGLES, m_volumeIndexCount, GL_UNSIGNED_BYTE, (void*)0, static_cast<GLsizei>(lights.size())));
+
+		GLCall(glDisable(GL_BLEND));
+		GLCall(glCullFace(GL_BACK));
+		GLCall(glDisable(GL_CULL_FACE));
+		GLCall(glDisable(GL_DEPTH_CLAMP));
+		GLCall(glDepthMask(GL_TRUE));
+		GLCall(glDepthFunc(GL_LESS));
+	}
+
+	GLCall(glEnable(GL_DEPTH_TEST));
+	GLCall(glBindVertexArray(0));
+	GLCall(glActiveTexture(GL_TEXTURE0));
+	m_lightingTimer.end();
+}
+
+void DeferredRenderer::beginForward() {
+	m_forwardTimer.begin();
+	GLCall(glBindFramebuffer(GL_FRAMEBUFFER, m_lightingFb));
+	GLCall(glViewport(0, 0, m_width, m_height));
+	GLCall(glEnable(GL_BLEND));
+	GLCall(glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
+}
+
+void DeferredRenderer::endForward() {
+	GLCall(glDisable(GL_BLEND));
+	m_forwardTimer.end();
+}
+
+void DeferredRenderer::composite(GLuint targetFramebuffer) {
+	m_compositeTimer.begin();
+	GLCall(glBindFramebuffer(GL_READ_FRAMEBUFFER, m_lightingFb));
+	GLCall(glBindFramebuffer(GL_DRAW_FRAMEBUFFER, targetFramebuffer));
+	GLCall(glBlitFramebuffer(0, 0, m_width, m_height, 0, 0, m_width, m_height, GL_COLOR_BUFFER_BIT, GL_NEAREST));
+	GLCall(glBindFramebuffer(GL_FRAMEBUFFER, targetFramebuffer));
+	m_compositeTimer.end();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//////////////////////////// GETTERS & SETTERS //////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+void DeferredRenderer::setAmbient(const glm::vec3& ambient) { m_ambient = ambient; }
+void DeferredRenderer::setSun(const glm::vec3& direction, const glm::vec3& color) { m_sunDirection = glm::normalize(direction); m_sunColor = color; }
+void DeferredRenderer::setBackground(const glm::vec3& background) { m_background = background; }
+GLuint DeferredRenderer::lightingFramebuffer() const { return m_lightingFb; }
+DeferredRenderer::Precision DeferredRenderer::precision() const { return m_precision; }
+
+int DeferredRenderer::bytesPerPixel() const {
+	// Albedo, normal, depth, then lighting and its depth
+	return m_precision == Precision::LOW ? 4 + 2 + 4 + 4 + 4 : 4 + 4 + 4 + 8 + 4;
+}
+
+void DeferredRenderer::showMetrics() {
+	ImGui::Begin("Deferred");
+	int precision = static_cast<int>(m_precision);
+	if (ImGui::Combo("Precision", &precision, "Low (RG8, R11G11B10F)\0High (RG16, RGBA16F)\0")) {
+		setPrecision(static_cast<Precision>(precision));
+	}
+	ImGui::Text("Buffers : %d bytes per pixel, %.2f MB", bytesPerPixel(), bytesPerPixel() * m_width * m_height / (1024.0 * 1024.0));
+	ImGui::Text("Lights : %zu", m_lightCount);
+	ImGui::Text("Geometry : %.3f ms", m_geometryTimer.lastMs());
+	ImGui::Text("Lighting : %.3f ms", m_lightingTimer.lastMs());
+	ImGui::Text("Forward : %.3f ms", m_forwardTimer.lastMs());
+	ImGui::Text("Composite : %.3f ms", m_compositeTimer.lastMs());
+	ImGui::End();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+///////////////////////////// PRIVATE METHODS ///////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+void DeferredRenderer::create() {
+	const bool high = m_precision == Precision::HIGH;
+
+	// ------------------ G-buffer
+	GLCall(glGenFramebuffers(1, &m_gBufferFb));
+	GLCall(glBindFramebuffer(GL_FRAMEBUFFER, m_gBufferFb));
+	createTexture(m_albedoRoughness, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, m_width, m_height);
+	GLCall(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_albedoRoughness, 0));
+	createTexture(m_normal, high ? GL_RG16 : GL_RG8, GL_RG, GL_UNSIGNED_BYTE, m_width, m_height);
+	GLCall(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, m_normal, 0));
+	createTexture(m_depth, GL_DEPTH24_STENCIL8, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, m_width, m_height);
+	GLCall(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, m_depth, 0));
+	const GLenum drawBuffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+	GLCall(glDrawBuffers(2, drawBuffers));
+	checkFramebuffer();
+
+	// ------------------ Lighting
+	GLCall(glGenFramebuffers(1, &m_lightingFb));
+	GLCall(glBindFramebuffer(GL_FRAMEBUFFER, m_lightingFb));
+	createTexture(m_lighting, high ? GL_RGBA16F : GL_R11F_G11F_B10F, GL_RGB, GL_FLOAT, m_width, m_height);
+	GLCall(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_lighting, 0));
+	GLCall(glGenRenderbuffers(1, &m_lightingDepth));
+	GLCall(glBindRenderbuffer(GL_RENDERBUFFER, m_lightingDepth));
+	GLCall(glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, m_width, m_height));
+	GLCall(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_lightingDepth));
+	GLCall(glBindRenderbuffer(GL_RENDERBUFFER, 0));
+	checkFramebuffer();
+
+	GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+	GLCall(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+}
+
+void DeferredRenderer::destroy() {
+	GLCall(glDeleteRenderbuffers(1, &m_lightingDepth));
+	GLCall(glDeleteTextures(1, &m_lighting));
+	GLCall(glDeleteFramebuffers(1, &m_lightingFb));
+	GLCall(glDeleteTextures(1, &m_depth));
+	GLCall(glDeleteTextures(1, &m_normal));
+	GLCall(glDeleteTextures(1, &m_albedoRoughness));
+	GLCall(glDeleteFramebuffers(1, &m_gBufferFb));
+}
+
+void DeferredRenderer::createLightVolume() {
+	// Icosahedron scaled so that its faces are outside of the unit sphere, 1.2584 is the ratio of its circumradius to its inradius
+	const float t = (1.0f + std::sqrt(5.0f)) / 2.0f;
+	const float a = 1.2584086f / std::sqrt(1.0f + t * t);
+	const float b = a * t;
+	const float positions[] = {
+		-a, b, 0,   a, b, 0,   -a, -b, 0,   a, -b, 0,
+		0, -a, b,   0, a, b,   0, -a, -b,   0, a, -b,
+		b, 0, -a,   b, 0, a,   -b, 0, -a,   -b, 0, a
+	};
+	const std::uint8_t indices[] = {
+		0, 11, 5,   0, 5, 1,    0, 1, 7,    0, 7, 10,   0, 10, 11,
+		1, 5, 9,    5, 11, 4,   11, 10, 2,  10, 7, 6,   7, 1, 8,
+		3, 9, 4,    3, 4, 2,    3, 2, 6,    3, 6, 8,    3, 8, 9,
+		4, 9, 5,    2, 4, 11,   6, 2, 10,   8, 6, 7,    9, 8, 1
+	};
+	m_volumeIndexCount = static_cast<GLsizei>(sizeof(indices));
+
+	GLCall(glGenVertexArrays(1, &m_volumeVao));
+	GLCall(glGenBuffers(1, &m_volumeVb));
+	GLCall(glGenBuffers(1, &m_volumeIb));
+	GLCall(glGenBuffers(1, &m_lightsVb));
+	GLCall(glBindVertexArray(m_volumeVao));
+
+	GLCall(glBindBuffer(GL_ARRAY_BUFFER, m_volumeVb));
+	GLCall(glBufferData(GL_ARRAY_BUFFER, sizeof(positions), positions, GL_STATIC_DRAW));
+	GLCall(glEnableVertexAttribArray(0));
+	GLCall(glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), NULL));
+
+	GLCall(glBindBuffer(GL_ARRAY_BUFFER, m_lightsVb));
+	GLCall(glEnableVertexAttribArray(1));
+	GLCall(glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(PointLight), (void*)offsetof(PointLight, position)));
+	GLCall(glVertexAttribDivisor(1, 1));
+	GLCall(glEnableVertexAttribArray(2));
+	GLCall(glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(PointLight), (void*)offsetof(PointLight, color)));
+	GLCall(glVertexAttribDivisor(2, 1));
+
+	GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_volumeIb));
+	GLCall(glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW));
+	GLCall(glBindVertexArray(0));
+	GLCall(glBindBuffer(GL_ARRAY_BUFFER, 0));
+	GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0));
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "gpu-timer.h"
+#include "point-light.h"
+
+/**
+ * @brief Deferred shading : opaque surfaces are written once to a G-buffer, then every light shades only the pixels it covers
+ * @note G-buffer, with multiple render targets :
+ *       0 albedo and roughness (RGBA8), 1 octahedral normal (RG8 or RG16), depth (24 bits texture).
+ *       Geometry shaders write "gAlbedoRoughness" at location 0 and "gNormal" at 1, see res/voxel-gbuffer.frag for the encoding.
+ *       Lighting accumulates into R11G11B10F or RGBA16F : a fullscreen ambient and sun pass, then one instanced draw
+ *       of light volumes whose back faces are tested with GL_GEQUAL, so that the camera can be inside a light.
+ *       Depth is copied to the lighting framebuffer, where objects which cannot go in the G-buffer (eg: transparent ones)
+ *       are drawn forward between beginForward() and endForward(). composite() copies the result to a framebuffer.
+ *       Each stage has its own GpuTimer, they cannot be used while another GpuTimer is active (eg: dynamic resolution).
+ *
+ * @code
+ * deferred.beginGeometry();
+ * ... draw opaque objects with G-buffer shaders
+ * deferred.endGeometry();
+ * deferred.light(lights, viewProj, cameraPosition);
+ * deferred.beginForward();
+ * ... draw transparent objects with forward shaders, back to front
+ * deferred.endForward();
+ * deferred.composite();
+ * @endcode
+ */
+class DeferredRenderer {
+public:
+    /**
+     * @brief Bandwidth against precision, LOW is 18 bytes per pixel and HIGH 24
+     */
+    enum class Precision {
+        LOW = 0,  // RG8 normals, R11G11B10F lighting
+        HIGH = 1  // RG16 normals, RGBA16F lighting
+    };
+
+public:
+    DeferredRenderer(int width, int height, Precision precision = Precision::LOW);
+    ~DeferredRenderer();
+
+    DeferredRenderer(const DeferredRenderer&) = delete;
+    DeferredRenderer& operator=(const DeferredRenderer&) = delete;
+
+    /**
+     * @brief Reallocate the buffers, content is lost
+     */
+    void resize(int width, int height);
+    void setPrecision(Precision precision);
+
+    /**
+     * @brief Bind and clear the G-buffer
+     */
+    void beginGeometry();
+    void endGeometry();
+
+    /**
+     * @brief Ambient and sun then every light, into the lighting buffer
+     */
+    void light(const std::vector<PointLight>& lights, const glm::mat4& viewProj, const glm::vec3& cameraPosition);
+
+    /**
+     * @brief Bind the lighting buffer with the depth of the G-buffer and alpha blending
+     */
+    void beginForward();
+    void endForward();
+
+    /**
+     * @brief Copy the lighting buffer, the target must be the size of the renderer
+     */
+    void composite(GLuint targetFramebuffer = 0);
+
+    void setAmbient(const glm::vec3& ambient);
+    void setSun(const glm::vec3& direction, const glm::vec3& color);
+    void setBackground(const glm::vec3& background);
+
+    /**
+     * @brief Lit image and depth after light(), with a 24 bits depth and 8 bits stencil buffer
+     */
+    GLuint lightingFramebuffer() const;
+    Precision precision() const;
+    int bytesPerPixel() const;
+
+    void showMetrics();
+
+private:
+    void create();
+    void destroy();
+    void createLightVolume();
+
+private:
+    int m_width;
+    int m_height;
+    Precision m_precision;
+
+    // ------------------ G-buffer
+    GLuint m_gBufferFb;
+    GLuint m_albedoRoughness;
+    GLuint m_normal;
+    GLuint m_depth;
+
+    // ------------------ Lighting, with its own copy of depth so that the G-buffer one can be sampled
+    GLuint m_lightingFb;
+    GLuint m_lighting;
+    GLuint m_lightingDepth;
+
+    // ------------------ Passes
+    GLuint m_ambientProgram;
+    GLuint m_lightProgram;
+    GLuint m_emptyVao;
+    GLuint m_volumeVao;
+    GLuint m_volumeVb;
+    GLuint m_volumeIb;
+    GLsizei m_volumeIndexCount;
+    GLuint m_lightsVb;
+
+    glm::vec3 m_ambient;
+    glm::vec3 m_sunDirection;
+    glm::vec3 m_sunColor;
+    glm::vec3 m_background;
+
+    // ------------------ Last frame
+    std::size_t m_lightCount;
+    GpuTimer m_geometryTimer;
+    GpuTimer m_lightingTimer;
+    GpuTimer m_forwardTimer;
+    GpuTimer m_compositeTimer;
+};
@@ -0,0 +1,56 @@
+#include "dynamic-resolution.h"
+
+#include <imgui.h>
+#include <algorithm>
+#include <cmath>
+#include <assert.h>
+
+namespace {
+	// Applied scale in 1/64 steps to avoid sub-pixel size jitter
+	float quantize(float scale) { return std::round(scale * 64.0f) / 64.0f; }
+}
+
+DynamicResolution::DynamicResolution(double targetGpuMs, float minScale, float maxScale)
+	: m_targetGpuMs(targetGpuMs), m_minScale(minScale), m_maxScale(maxScale), m_scale(maxScale), m_lastGpuMs(0.0)
+{
+	assert(minScale > 0.0f && minScale <= maxScale && "Invalid scale range !");
+}
+
+void DynamicResolution::update(double gpuMs) {
+	m_lastGpuMs = gpuMs;
+	if (gpuMs <= 0.0) {
+		return;
+	}
+
+	// Move a fraction of the way to the ideal scale, so that a single spike does not make the image pump
+	const float ideal = m_scale * static_cast<float>(std::sqrt(m_targetGpuMs / gpuMs));
+	// The controller keeps the exact scale : rounded here, steps smaller than 1/64 would never add up
+	const float next = m_scale + (ideal - m_scale) * 0.1f;
+	m_scale = std::min(m_maxScale, std::max(m_minScale, next));
+}
+
+int DynamicResolution::scaled(int fullSize) const {
+	return std::max(1, static_cast<int>(fullSize * scale()));
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//////////////////////////// GETTERS & SETTERS //////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+float DynamicResolution::scale() const { return std::min(m_maxScale, std::max(m_minScale, quantize(m_scale))); }
+float DynamicResolution::minScale() const { return m_minScale; }
+float DynamicResolution::maxScale() const { return m_maxScale; }
+double DynamicResolution::targetGpuMs() const { return m_targetGpuMs; }
+double DynamicResolution::lastGpuMs() const { return m_lastGpuMs; }
+void DynamicResolution::setTargetGpuMs(double targetGpuMs) { m_targetGpuMs = targetGpuMs; }
+
+void DynamicResolution::showMetrics() {
+	ImGui::Begin("Dynamic resolution");
+	ImGui::Text("Scene GPU time : %.3f ms", m_lastGpuMs);
+	ImGui::Text("Scale : %.0f %%", scale() * 100.0f);
+	float target = static_cast<float>(m_targetGpuMs);
+	if (ImGui::SliderFloat("Budget (ms)", &target, 1.0f, 33.0f)) {
+		m_targetGpuMs = target;
+	}
+	ImGui::End();
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+/**
+ * @brief Pick the scene rendering scale from the measured GPU time
+ * @note Pixel count grows with the square of the scale, so the correction uses the square root of the time ratio
+ */
+class DynamicResolution {
+public:
+    /**
+     * @param targetGpuMs - GPU budget of the scene, keep some headroom below the vsync interval
+     */
+    DynamicResolution(double targetGpuMs = 12.0, float minScale = 0.5f, float maxScale = 1.0f);
+    ~DynamicResolution() = default;
+
+    /**
+     * @brief Adjust the scale from the last GPU time measured for the scene
+     */
+    void update(double gpuMs);
+
+    /**
+     * @brief Size in pixels of a full size dimension once scaled, at least 1
+     */
+    int scaled(int fullSize) const;
+
+    /**
+     * @brief Scale applied to the scene, in 1/64 steps
+     */
+    float scale() const;
+    float minScale() const;
+    float maxScale() const;
+    double targetGpuMs() const;
+    double lastGpuMs() const;
+    void setTargetGpuMs(double targetGpuMs);
+
+    /**
+     * @brief Display the controller state in an ImGui window
+     * @note Must be called between App::beginFrame() and App::endFrame()
+     */
+    void showMetrics();
+
+private:
+    double m_targetGpuMs;
+    float m_minScale;
+    float m_maxScale;
+    float m_scale;
+    double m_lastGpuMs;
+};
@@ -0,0 +1,253 @@
+#include "ecs.h"
+
+#include <imgui.h>
+#include <mutex>
+#include <new>
+
+namespace ecs {
+    namespace {
+        std::mutex s_registryMutex;
+        ComponentInfo s_components[MAX_COMPONENTS];
+        ComponentId s_componentCount = 0;
+    }
+
+    ComponentId registerComponent(std::uint32_t size, std::uint32_t alignment) {
+        std::lock_guard<std::mutex> lock(s_registryMutex);
+        assert(s_componentCount < MAX_COMPONENTS && "Too many component types !");
+        assert(alignment <= Archetype::CACHE_LINE && "Component alignment is larger than a cache line !");
+        s_components[s_componentCount] = { size, alignment };
+        return s_componentCount++;
+    }
+
+    const ComponentInfo& componentInfo(ComponentId id) {
+        return s_components[id];
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+////////////////////////////////// ARCHETYPE ////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+namespace {
+    std::size_t alignUp(std::size_t value, std::size_t alignment) {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+}
+
+Archetype::Archetype(ComponentMask mask)
+	: m_mask(mask), m_capacity(0), m_activeChunks(0)
+{
+	std::fill(std::begin(m_columns), std::end(m_columns), NO_COLUMN);
+	std::fill(std::begin(m_addEdges), std::end(m_addEdges), nullptr);
+	std::fill(std::begin(m_removeEdges), std::end(m_removeEdges), nullptr);
+
+	std::size_t rowSize = sizeof(Entity);
+	for (ComponentId id = 0; id < ecs::MAX_COMPONENTS; id++) {
+		if (mask & (ComponentMask(1) << id)) {
+			m_columns[id] = static_cast<std::uint32_t>(m_components.size());
+			m_components.push_back(id);
+			rowSize += ecs::componentInfo(id).size;
+		}
+	}
+
+	// Every array starts on a cache line, the estimate is lowered until the padding fits
+	std::size_t capacity = CHUNK_SIZE / rowSize;
+	for (;; capacity--) {
+		assert(capacity > 0 && "Components are too large for a chunk !");
+		std::size_t offset = alignUp(capacity * sizeof(Entity), CACHE_LINE);
+		m_offsets.clear();
+		for (ComponentId id : m_components) {
+			m_offsets.push_back(static_cast<std::uint32_t>(offset));
+			offset = alignUp(offset + capacity * ecs::componentInfo(id).size, CACHE_LINE);
+		}
+		if (offset <= CHUNK_SIZE) {
+			break;
+		}
+	}
+	m_capacity = static_cast<std::uint32_t>(capacity);
+}
+
+Archetype::~Archetype() {
+	for (Chunk& chunk : m_chunks) {
+		::operator delete(chunk.data, std::align_val_t(CACHE_LINE));
+	}
+}
+
+std::pair<std::uint32_t, std::uint32_t> Archetype::allocate(Entity entity) {
+	if (m_activeChunks == 0 || m_chunks[m_activeChunks - 1].count == m_capacity) {
+		if (m_activeChunks == m_chunks.size()) {
+			m_chunks.push_back({ static_cast<unsigned char*>(::operator new(CHUNK_SIZE, std::align_val_t(CACHE_LINE))), 0 });
+		}
+		m_activeChunks++;
+	}
+
+	const std::uint32_t chunkIndex = m_activeChunks - 1;
+	Chunk& chunk = m_chunks[chunkIndex];
+	const std::uint32_t row = chunk.count++;
+	entities(chunk)[row] = entity;
+	return { chunkIndex, row };
+}
+
+Entity Archetype::remove(std::uint32_t chunkIndex, std::uint32_t row) {
+	Chunk& last = m_chunks[m_activeChunks - 1];
+	const std::uint32_t lastRow = last.count - 1;
+	Entity moved;
+
+	if (chunkIndex != m_activeChunks - 1 || row != lastRow) {
+		Chunk& chunk = m_chunks[chunkIndex];
+		moved = entities(last)[lastRow];
+		entities(chunk)[row] = moved;
+		for (std::size_t column = 0; column < m_components.size(); column++) {
+			const std::uint32_t size = ecs::componentInfo(m_components[column]).size;
+			std::memcpy(chunk.data + m_offsets[column] + row * size, last.data + m_offsets[column] + lastRow * size, size);
+		}
+	}
+
+	// The chunk stays allocated, churn around a chunk boundary would allocate every time otherwise
+	if (--last.count == 0) {
+		m_activeChunks--;
+	}
+	return moved;
+}
+
+void* Archetype::component(ComponentId id, std::uint32_t chunk, std::uint32_t row) {
+	const std::uint32_t column = m_columns[id];
+	assert(column != NO_COLUMN && "Archetype does not have this component !");
+	return m_chunks[chunk].data + m_offsets[column] + row * ecs::componentInfo(id).size;
+}
+
+std::size_t Archetype::entityCount() const {
+	return m_activeChunks == 0 ? 0 : std::size_t(m_activeChunks - 1) * m_capacity + m_chunks[m_activeChunks - 1].count;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//////////////////////////////// ENTITY WORLD ///////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+EntityWorld::EntityWorld()
+	: m_aliveCount(0), m_emptyArchetype(nullptr)
+{
+	m_emptyArchetype = archetypeFor(0);
+}
+
+Entity EntityWorld::create() {
+	std::uint32_t index;
+	if (m_freeIndices.empty()) {
+		index = static_cast<std::uint32_t>(m_records.size());
+		m_records.push_back({ nullptr, 0, 0, 0 });
+	} else {
+		index = m_freeIndices.back();
+		m_freeIndices.pop_back();
+	}
+
+	Record& record = m_records[index];
+	const Entity entity = { index, record.generation };
+	const auto location = m_emptyArchetype->allocate(entity);
+	record.archetype = m_emptyArchetype;
+	record.chunk = location.first;
+	record.row = location.second;
+	m_aliveCount++;
+	return entity;
+}
+
+void EntityWorld::destroy(Entity entity) {
+	assert(isAlive(entity) && "Entity was destroyed !");
+	Record& record = m_records[entity.index];
+	const Entity moved = record.archetype->remove(record.chunk, record.row);
+	if (moved.index != UINT32_MAX) {
+		m_records[moved.index].chunk = record.chunk;
+		m_records[moved.index].row = record.row;
+	}
+
+	record.archetype = nullptr;
+	record.generation++;
+	m_freeIndices.push_back(entity.index);
+	m_aliveCount--;
+}
+
+bool EntityWorld::isAlive(Entity entity) const {
+	return entity.index < m_records.size() && m_records[entity.index].archetype != nullptr && m_records[entity.index].generation == entity.generation;
+}
+
+void EntityWorld::showMetrics() {
+	ImGui::Begin("Entities");
+	ImGui::Text("Entities : %zu in %zu archetypes, %zu chunks of %zu KB", entityCount(), archetypeCount(), chunkCount(), Archetype::CHUNK_SIZE / 1024);
+	ImGui::Separator();
+	ImGui::Columns(3, "archetypes");
+	ImGui::Text("Components"); ImGui::NextColumn();
+	ImGui::Text("Entities"); ImGui::NextColumn();
+	ImGui::Text("Per chunk"); ImGui::NextColumn();
+	ImGui::Separator();
+	for (const Archetype* archetype : m_archetypeList) {
+		ImGui::Text("0x%llx", static_cast<unsigned long long>(archetype->mask())); ImGui::NextColumn();
+		ImGui::Text("%zu", archetype->entityCount()); ImGui::NextColumn();
+		ImGui::Text("%u", archetype->capacity()); ImGui::NextColumn();
+	}
+	ImGui::Columns(1);
+	ImGui::End();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//////////////////////////// GETTERS & SETTERS //////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+std::size_t EntityWorld::entityCount() const { return m_aliveCount; }
+std::size_t EntityWorld::archetypeCount() const { return m_archetypeList.size(); }
+
+std::size_t EntityWorld::chunkCount() const {
+	std::size_t count = 0;
+	for (const Archetype* archetype : m_archetypeList) {
+		count += archetype->chunkCount();
+	}
+	return count;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+///////////////////////////// PRIVATE METHODS ///////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+Archetype* EntityWorld::archetypeFor(ComponentMask mask) {
+	std::unique_ptr<Archetype>& archetype = m_archetypes[mask];
+	if (!archetype) {
+		archetype = std::make_unique<Archetype>(mask);
+		m_archetypeList.push_back(archetype.get());
+	}
+	return archetype.get();
+}
+
+void EntityWorld::moveTo(std::uint32_t index, Archetype* to) {
+	Record& record = m_records[index];
+	Archetype* from = record.archetype;
+	if (from == to) {
+		return;
+	}
+
+	// Components present in both archetypes are copied, the new ones are left to the caller
+	const auto location = to->allocate({ index, record.generation });
+	for (ComponentId id : to->components()) {
+		if (from->has(id)) {
+			std::memcpy(to->component(id, location.first, location.second), from->component(id, record.chunk, record.row), ecs::componentInfo(id).size);
+		}
+	}
+
+	const Entity moved = from->remove(record.chunk, record.row);
+	if (moved.index != UINT32_MAX) {
+		m_records[moved.index].chunk = record.chunk;
+		m_records[moved.index].row = record.row;
+	}
+	record.archetype = to;
+	record.chunk = location.first;
+	record.row = location.second;
+}
+
+void EntityWorld::collectChunks(ComponentMask query, std::vector<std::pair<const Archetype*, std::uint32_t>>& chunks) const {
+	chunks.clear();
+	for (const Archetype* archetype : m_archetypeList) {
+		if ((archetype->mask() & query) != query) {
+			continue;
+		}
+		for (std::uint32_t c = 0; c < archetype->chunkCount(); c++) {
+			chunks.emplace_back(archetype, c);
+		}
+	}
+}
@@ -0,0 +1,331 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <assert.h>
+
+#include "job-system.h"
+
+using ComponentId = std::uint32_t;
+using ComponentMask = std::uint64_t;
+
+/**
+ * @brief Handle to an entity, the generation tells apart entities which reused the same slot
+ */
+struct Entity {
+    std::uint32_t index = UINT32_MAX;
+    std::uint32_t generation = 0;
+
+    bool operator==(const Entity& other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const Entity& other) const { return !(*this == other); }
+};
+
+namespace ecs {
+    static constexpr ComponentId MAX_COMPONENTS = 64;
+
+    struct ComponentInfo {
+        std::uint32_t size;
+        std::uint32_t alignment;
+    };
+
+    /**
+     * @brief Thread safe, called once per component type by componentId()
+     */
+    ComponentId registerComponent(std::uint32_t size, std::uint32_t alignment);
+    const ComponentInfo& componentInfo(ComponentId id);
+
+    template<typename T>
+    struct ComponentType {
+        static_assert(std::is_trivially_copyable<T>::value && std::is_trivially_destructible<T>::value,
+                      "Components are moved with memcpy, they must be plain data !");
+        static ComponentId id() {
+            static const ComponentId id = registerComponent(sizeof(T), alignof(T));
+            return id;
+        }
+    };
+
+    /**
+     * @brief Same id for T and const T, queries use const for read only components
+     */
+    template<typename T>
+    ComponentId componentId() {
+        return ComponentType<typename std::remove_const<T>::type>::id();
+    }
+
+    template<typename... Cs>
+    ComponentMask componentMask() {
+        ComponentMask mask = 0;
+        using Expand = int[];
+        (void)Expand{ 0, (mask |= ComponentMask(1) << componentId<Cs>(), 0)... };
+        return mask;
+    }
+}
+
+/**
+ * @brief Every entity which has exactly the same set of components, stored in chunks of CHUNK_SIZE bytes
+ * @note Inside a chunk each component is an array aligned on a cache line (SoA), after the array of entities.
+ *       Chunks are kept dense : removing a row moves the last entity of the archetype into it.
+ */
+class Archetype {
+public:
+    static constexpr std::size_t CHUNK_SIZE = 16 * 1024;
+    static constexpr std::size_t CACHE_LINE = 64;
+    static constexpr std::uint32_t NO_COLUMN = UINT32_MAX;
+
+    struct Chunk {
+        unsigned char* data;
+        std::uint32_t count;
+    };
+
+public:
+    Archetype(ComponentMask mask);
+    ~Archetype();
+
+    Archetype(const Archetype&) = delete;
+    Archetype& operator=(const Archetype&) = delete;
+
+    /**
+     * @brief Append a row, components are left uninitialized
+     * @return Chunk index then row
+     */
+    std::pair<std::uint32_t, std::uint32_t> allocate(Entity entity);
+
+    /**
+     * @brief Fill the row with the last one of the archetype
+     * @return Entity moved into the row, or an invalid one if the row was the last
+     */
+    Entity remove(std::uint32_t chunk, std::uint32_t row);
+
+    void* component(ComponentId id, std::uint32_t chunk, std::uint32_t row);
+
+    template<typename T>
+    T* array(const Chunk& chunk) const {
+        const std::uint32_t column = m_columns[ecs::componentId<T>()];
+        assert(column != NO_COLUMN && "Archetype does not have this component !");
+        return reinterpret_cast<T*>(chunk.data + m_offsets[column]);
+    }
+
+    Entity* entities(const Chunk& chunk) const { return reinterpret_cast<Entity*>(chunk.data); }
+
+    bool has(ComponentId id) const { return m_columns[id] != NO_COLUMN; }
+    ComponentMask mask() const { return m_mask; }
+    const std::vector<ComponentId>& components() const { return m_components; }
+    const Chunk* chunks() const { return m_chunks.data(); }
+    std::uint32_t chunkCount() const { return m_activeChunks; }
+    std::uint32_t capacity() const { return m_capacity; }
+    std::size_t entityCount() const;
+
+private:
+    friend class EntityWorld;
+
+    ComponentMask m_mask;
+    std::vector<ComponentId> m_components; // Ascending
+    std::vector<std::uint32_t> m_offsets;  // Per column, in bytes from the start of a chunk
+    std::uint32_t m_columns[ecs::MAX_COMPONENTS];
+    std::uint32_t m_capacity;
+
+    // Chunks after m_activeChunks are empty and kept for reuse
+    std::vector<Chunk> m_chunks;
+    std::uint32_t m_activeChunks;
+
+    // Archetype reached by adding or removing one component
+    Archetype* m_addEdges[ecs::MAX_COMPONENTS];
+    Archetype* m_removeEdges[ecs::MAX_COMPONENTS];
+};
+
+/**
+ * @brief Entities grouped by archetype, iterated chunk by chunk without any virtual call
+ * @note Components must be plain data. Adding or removing a component moves the entity to another archetype,
+ *       so pointers and references to components are only valid until the next structural change.
+ *       Queries only change component values, they can run on the JobSystem.
+ *
+ * @code
+ * Entity e = world.create(Transform{ ... }, Bounds{ ... });
+ * world.add(e, Renderable{ ... });
+ * world.eachChunk<const Transform, Bounds>([](std::uint32_t count, const Entity*, const Transform* transforms, Bounds* bounds) {
+ *     for (std::uint32_t i = 0; i < count; i++) { ... }
+ * });
+ * world.parallelEach<Transform>(jobs, [](Transform& transform) { ... });
+ * @endcode
+ */
+class EntityWorld {
+public:
+    EntityWorld();
+    ~EntityWorld() = default;
+
+    EntityWorld(const EntityWorld&) = delete;
+    EntityWorld& operator=(const EntityWorld&) = delete;
+
+    Entity create();
+
+    template<typename... Cs>
+    Entity create(const Cs&... components) {
+        const Entity entity = create();
+        moveTo(entity.index, archetypeFor(ecs::componentMask<Cs...>()));
+        using Expand = int[];
+        (void)Expand{ 0, (write(entity.index, components), 0)... };
+        return entity;
+    }
+
+    void destroy(Entity entity);
+    bool isAlive(Entity entity) const;
+
+    /**
+     * @brief Add the component, or overwrite it if the entity already has it
+     */
+    template<typename T>
+    void add(Entity entity, const T& value = T()) {
+        assert(isAlive(entity) && "Entity was destroyed !");
+        const ComponentId id = ecs::componentId<T>();
+        Archetype* from = m_records[entity.index].archetype;
+        if (!from->has(id)) {
+            if (from->m_addEdges[id] == nullptr) {
+                from->m_addEdges[id] = archetypeFor(from->mask() | (ComponentMask(1) << id));
+            }
+            moveTo(entity.index, from->m_addEdges[id]);
+        }
+        write(entity.index, value);
+    }
+
+    template<typename T>
+    void remove(Entity entity) {
+        assert(isAlive(entity) && "Entity was destroyed !");
+        const ComponentId id = ecs::componentId<T>();
+        Archetype* from = m_records[entity.index].archetype;
+        if (!from->has(id)) {
+            return;
+        }
+        if (from->m_removeEdges[id] == nullptr) {
+            from->m_removeEdges[id] = archetypeFor(from->mask() & ~(ComponentMask(1) << id));
+        }
+        moveTo(entity.index, from->m_removeEdges[id]);
+    }
+
+    template<typename T>
+    bool has(Entity entity) const {
+        return isAlive(entity) && m_records[entity.index].archetype->has(ecs::componentId<T>());
+    }
+
+    template<typename T>
+    T& get(Entity entity) {
+        assert(has<T>(entity) && "Entity does not have this component !");
+        const Record& record = m_records[entity.index];
+        return *static_cast<T*>(record.archetype->component(ecs::componentId<T>(), record.chunk, record.row));
+    }
+
+    /**
+     * @brief Call function(count, entities, arrays...) on every chunk which has all of Cs
+     */
+    template<typename... Cs, typename F>
+    void eachChunk(const F& function) {
+        const ComponentMask query = ecs::componentMask<Cs...>();
+        for (Archetype* archetype : m_archetypeList) {
+            if ((archetype->mask() & query) != query) {
+                continue;
+            }
+            for (std::uint32_t c = 0; c < archetype->chunkCount(); c++) {
+                const Archetype::Chunk& chunk = archetype->chunks()[c];
+                function(chunk.count, archetype->entities(chunk), archetype->array<Cs>(chunk)...);
+            }
+        }
+    }
+
+    /**
+     * @brief Call function(components...) on every entity which has all of Cs
+     */
+    template<typename... Cs, typename F>
+    void each(const F& function) {
+        eachChunk<Cs...>([&](std::uint32_t count, const Entity*, Cs*... arrays) {
+            for (std::uint32_t i = 0; i < count; i++) {
+                function(arrays[i]...);
+            }
+        });
+    }
+
+    /**
+     * @brief Same as eachChunk() with chunks split across the JobSystem, function must be thread safe
+     */
+    template<typename... Cs, typename F>
+    void parallelEachChunk(JobSystem& jobs, const F& function) {
+        collectChunks(ecs::componentMask<Cs...>(), m_queryChunks);
+        const std::uint32_t chunkCount = static_cast<std::uint32_t>(m_queryChunks.size());
+        const std::uint32_t grainSize = std::max(1u, chunkCount / (jobs.threadCount() * 16));
+
+        Job* root = jobs.parallelFor(0, chunkCount, grainSize, [&](std::uint32_t begin, std::uint32_t end) {
+            for (std::uint32_t i = begin; i < end; i++) {
+                const Archetype& archetype = *m_queryChunks[i].first;
+                const Archetype::Chunk& chunk = archetype.chunks()[m_queryChunks[i].second];
+                function(chunk.count, archetype.entities(chunk), archetype.array<Cs>(chunk)...);
+            }
+        });
+        jobs.run(root);
+        jobs.wait(root);
+    }
+
+    template<typename... Cs, typename F>
+    void parallelEach(JobSystem& jobs, const F& function) {
+        parallelEachChunk<Cs...>(jobs, [&](std::uint32_t count, const Entity*, Cs*... arrays) {
+            for (std::uint32_t i = 0; i < count; i++) {
+                function(arrays[i]...);
+            }
+        });
+    }
+
+    /**
+     * @brief Number of entities which have all of Cs
+     */
+    template<typename... Cs>
+    std::size_t count() const {
+        const ComponentMask query = ecs::componentMask<Cs...>();
+        std::size_t result = 0;
+        for (const Archetype* archetype : m_archetypeList) {
+            if ((archetype->mask() & query) == query) {
+                result += archetype->entityCount();
+            }
+        }
+        return result;
+    }
+
+    void showMetrics();
+
+    std::size_t entityCount() const;
+    std::size_t archetypeCount() const;
+    std::size_t chunkCount() const;
+
+private:
+    struct Record {
+        Archetype* archetype;
+        std::uint32_t chunk;
+        std::uint32_t row;
+        std::uint32_t generation;
+    };
+
+    template<typename T>
+    void write(std::uint32_t index, const T& value) {
+        const Record& record = m_records[index];
+        *static_cast<T*>(record.archetype->component(ecs::componentId<T>(), record.chunk, record.row)) = value;
+    }
+
+    Archetype* archetypeFor(ComponentMask mask);
+    void moveTo(std::uint32_t index, Archetype* to);
+    void collectChunks(ComponentMask query, std::vector<std::pair<const Archetype*, std::uint32_t>>& chunks) const;
+
+private:
+    std::vector<Record> m_records;
+    std::vector<std::uint32_t> m_freeIndices;
+    std::size_t m_aliveCount;
+
+    std::unordered_map<ComponentMask, std::unique_ptr<Archetype>> m_archetypes;
+    std::vector<Archetype*> m_archetypeList;
+    Archetype* m_emptyArchetype;
+
+    std::vector<std::pair<const Archetype*, std::uint32_t>> m_queryChunks;
+};
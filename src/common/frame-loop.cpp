@@ -0,0 +1,85 @@
+#include "frame-loop.h"
+
+#include <imgui.h>
+#include <assert.h>
+
+FrameLoop::FrameLoop(double fixedStep, unsigned int maxStepsPerFrame)
+	: m_fixedStep(fixedStep), m_maxStepsPerFrame(maxStepsPerFrame), m_accumulator(0.0),
+	  m_frequency(static_cast<double>(SDL_GetPerformanceFrequency())),
+	  m_lastFrameCounter(SDL_GetPerformanceCounter()), m_updateStartCounter(0),
+	  m_stepsThisFrame(0), m_droppedFrames(0), m_updating(false),
+	  m_frameTime(0.0), m_updateTime(0.0), m_renderTime(0.0)
+{
+	assert(fixedStep > 0.0 && "Fixed step must be positive !");
+	assert(maxStepsPerFrame > 0 && "At least one step per frame is needed !");
+}
+
+void FrameLoop::advance() {
+	const Uint64 now = SDL_GetPerformanceCounter();
+	m_frameTime = secondsSince(m_lastFrameCounter, now);
+	m_lastFrameCounter = now;
+
+	// Everything between the end of the updates and now was spent rendering
+	if (m_updateStartCounter != 0) {
+		m_renderTime = m_frameTime - m_updateTime;
+	}
+
+	m_accumulator += m_frameTime;
+
+	// Spiral of death : if we are too late, forget about the extra time instead of trying to catch up
+	const double maxAccumulated = m_fixedStep * m_maxStepsPerFrame;
+	if (m_accumulator > maxAccumulated) {
+		m_accumulator = maxAccumulated;
+		m_droppedFrames++;
+	}
+
+	m_stepsThisFrame = 0;
+	m_updating = false;
+}
+
+bool FrameLoop::step() {
+	const Uint64 now = SDL_GetPerformanceCounter();
+	if (!m_updating) {
+		m_updating = true;
+		m_updateStartCounter = now;
+	}
+
+	if (m_accumulator >= m_fixedStep) {
+		m_accumulator -= m_fixedStep;
+		m_stepsThisFrame++;
+		return true;
+	}
+
+	m_updateTime = secondsSince(m_updateStartCounter, now);
+	return false;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//////////////////////////// GETTERS & SETTERS //////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+double FrameLoop::alpha() const { return m_accumulator / m_fixedStep; }
+double FrameLoop::fixedStep() const { return m_fixedStep; }
+unsigned int FrameLoop::stepsThisFrame() const { return m_stepsThisFrame; }
+unsigned int FrameLoop::droppedFrames() const { return m_droppedFrames; }
+double FrameLoop::frameTimeMs() const { return m_frameTime * 1000.0; }
+double FrameLoop::updateTimeMs() const { return m_updateTime * 1000.0; }
+double FrameLoop::renderTimeMs() const { return m_renderTime * 1000.0; }
+
+void FrameLoop::showMetrics() const {
+	ImGui::Begin("Frame loop");
+	ImGui::Text("Frame  : %.3f ms", frameTimeMs());
+	ImGui::Text("Update : %.3f ms (%u steps of %.2f ms)", updateTimeMs(), m_stepsThisFrame, m_fixedStep * 1000.0);
+	ImGui::Text("Render : %.3f ms", renderTimeMs());
+	ImGui::Text("Alpha  : %.2f", alpha());
+	ImGui::Text("Frames too late : %u", m_droppedFrames);
+	ImGui::End();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+///////////////////////////// PRIVATE METHODS ///////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+double FrameLoop::secondsSince(Uint64 since, Uint64 now) const {
+	return static_cast<double>(now - since) / m_frequency;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+
+/**
+ * @brief Fixed timestep helper for the main loop
+ * @note Simulation advances in constant steps no matter the framerate,
+ *       rendering blends the last two states with alpha()
+ *
+ * @code
+ * frameLoop.advance();
+ * while (frameLoop.step()) {
+ *     previous = current;
+ *     current += speed * frameLoop.fixedStep();
+ * }
+ * float rendered = glm::mix(previous, current, frameLoop.alpha());
+ * @endcode
+ */
+class FrameLoop {
+public:
+    /**
+     * @param fixedStep - Duration of a simulation step in seconds
+     * @param maxStepsPerFrame - Steps allowed in one frame before dropping time (spiral of death protection)
+     */
+    FrameLoop(double fixedStep = 1.0 / 60.0, unsigned int maxStepsPerFrame = 5);
+    ~FrameLoop() = default;
+
+    /**
+     * @brief Measure the time spent since the last call and feed the accumulator
+     * @note Must be called once per rendered frame, before step()
+     */
+    void advance();
+
+    /**
+     * @brief Consume one fixed step from the accumulator
+     * @return true while the simulation must be updated again this frame
+     */
+    bool step();
+
+    /**
+     * @brief Interpolation factor between the previous and the current simulation state
+     * @return double - In [0, 1)
+     */
+    double alpha() const;
+
+    double fixedStep() const;
+    unsigned int stepsThisFrame() const;
+    unsigned int droppedFrames() const;
+
+    double frameTimeMs() const;
+    double updateTimeMs() const;
+    double renderTimeMs() const;
+
+    /**
+     * @brief Display timings in an ImGui window
+     * @note Must be called between App::beginFrame() and App::endFrame()
+     */
+    void showMetrics() const;
+
+private:
+    double secondsSince(Uint64 since, Uint64 now) const;
+
+private:
+    double m_fixedStep;
+    unsigned int m_maxStepsPerFrame;
+    double m_accumulator;
+    double m_frequency;
+
+    Uint64 m_lastFrameCounter;
+    Uint64 m_updateStartCounter;
+    unsigned int m_stepsThisFrame;
+    unsigned int m_droppedFrames;
+    bool m_updating;
+
+    double m_frameTime;
+    double m_updateTime;
+    double m_renderTime;
+};
@@ -0,0 +1,197 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <assert.h>
+
+/**
+ * @brief Lock-free single producer / single consumer triple buffer
+ * @note The producer always has a slot to write into and the consumer always reads
+ *       the most recent published slot. Neither of them ever waits for the other.
+ */
+template<typename T>
+class TripleBuffer {
+public:
+    TripleBuffer() : m_shared(1), m_write(0), m_read(2) {}
+    ~TripleBuffer() = default;
+
+    /**
+     * @brief Slot owned by the producer until publish()
+     */
+    T& writeBuffer() { return m_slots[m_write]; }
+
+    /**
+     * @brief Hand the write slot to the consumer and take back the shared one
+     */
+    void publish() {
+        m_write = m_shared.exchange(static_cast<unsigned char>(m_write | FRESH_BIT), std::memory_order_acq_rel) & INDEX_MASK;
+    }
+
+    /**
+     * @brief Take the latest published slot if there is a new one
+     * @return true if readBuffer() changed
+     */
+    bool acquire() {
+        if ((m_shared.load(std::memory_order_relaxed) & FRESH_BIT) == 0) {
+            return false;
+        }
+        m_read = m_shared.exchange(m_read, std::memory_order_acq_rel) & INDEX_MASK;
+        return true;
+    }
+
+    /**
+     * @brief Slot owned by the consumer until the next acquire()
+     */
+    const T& readBuffer() const { return m_slots[m_read]; }
+
+private:
+    static constexpr unsigned char INDEX_MASK = 0x3;
+    static constexpr unsigned char FRESH_BIT = 0x4;
+
+    T m_slots[3];
+    std::atomic<unsigned char> m_shared;
+    unsigned char m_write;
+    unsigned char m_read;
+};
+
+/**
+ * @brief Run the simulation of frame N+1 on a worker thread while the GL thread renders frame N
+ * @note The update function only writes into its snapshot, the render side only reads the
+ *       snapshot it got from beginFrame(), so no lock is needed on scene data.
+ *       SDL events must stay on the main thread : forward them with post().
+ *
+ * @code
+ * FramePipeline<Scene> pipeline([&](Scene& next) { ... simulate, cull ... });
+ * while (app.isRunning()) {
+ *     // poll events, pipeline.post(...) inputs
+ *     const Scene& scene = pipeline.beginFrame();
+ *     // render scene
+ * }
+ * @endcode
+ */
+template<typename Snapshot>
+class FramePipeline {
+public:
+    using UpdateFn = std::function<void(Snapshot&)>;
+
+    /**
+     * @param update - Fill the next snapshot. Called on the worker thread when threaded.
+     * @param threaded - If false, the update runs inline in beginFrame()
+     */
+    FramePipeline(UpdateFn update, bool threaded = true)
+        : m_update(update), m_threaded(threaded), m_kicked(false), m_stop(false),
+          m_frequency(static_cast<double>(SDL_GetPerformanceFrequency())), m_updateTime(0.0)
+    {
+        assert(update && "An update function is required !");
+
+        // Prime the first snapshot so beginFrame() never returns an empty scene
+        runUpdate();
+        m_buffer.acquire();
+
+        if (m_threaded) {
+            m_worker = std::thread(&FramePipeline::workerLoop, this);
+        }
+    }
+
+    ~FramePipeline() {
+        if (m_threaded) {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stop = true;
+            }
+            m_wakeUp.notify_one();
+            m_worker.join();
+        }
+    }
+
+    FramePipeline(const FramePipeline&) = delete;
+    FramePipeline& operator=(const FramePipeline&) = delete;
+
+    /**
+     * @brief Queue a command to run on the simulation thread right before the next update
+     */
+    void post(std::function<void()> command) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_commands.push_back(std::move(command));
+    }
+
+    /**
+     * @brief Start the simulation of the next frame and get the latest finished one
+     * @return const Snapshot& - Valid until the next call to beginFrame()
+     */
+    const Snapshot& beginFrame() {
+        if (!m_threaded) {
+            runUpdate();
+            m_buffer.acquire();
+            return m_buffer.readBuffer();
+        }
+
+        m_buffer.acquire();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_kicked = true;
+        }
+        m_wakeUp.notify_one();
+        return m_buffer.readBuffer();
+    }
+
+    bool isThreaded() const { return m_threaded; }
+
+    /**
+     * @brief Duration of the last simulation update, measured on the thread which ran it
+     */
+    double updateTimeMs() const { return m_updateTime.load(std::memory_order_relaxed) * 1000.0; }
+
+private:
+    void workerLoop() {
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_wakeUp.wait(lock, [this] { return m_kicked || m_stop; });
+                if (m_stop) {
+                    return;
+                }
+                m_kicked = false;
+            }
+            runUpdate();
+        }
+    }
+
+    void runUpdate() {
+        const Uint64 start = SDL_GetPerformanceCounter();
+
+        std::vector<std::function<void()>> commands;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            commands.swap(m_commands);
+        }
+        for (auto& command : commands) {
+            command();
+        }
+
+        m_update(m_buffer.writeBuffer());
+        m_buffer.publish();
+
+        m_updateTime.store(static_cast<double>(SDL_GetPerformanceCounter() - start) / m_frequency, std::memory_order_relaxed);
+    }
+
+private:
+    UpdateFn m_update;
+    TripleBuffer<Snapshot> m_buffer;
+    bool m_threaded;
+
+    std::thread m_worker;
+    std::mutex m_mutex;
+    std::condition_variable m_wakeUp;
+    std::vector<std::function<void()>> m_commands;
+    bool m_kicked;
+    bool m_stop;
+
+    double m_frequency;
+    std::atomic<double> m_updateTime;
+};
@@ -0,0 +1,227 @@
+#include "gpu-culling.h"
+
+#include "gl-exception.h"
+#include "scene-culling.h"
+#include "shader-utils.h"
+#include <imgui.h>
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+
+GpuCulling::GpuCulling(int width, int height)
+	: m_output(0), m_outputCapacity(0), m_instanceCount(0), m_visibleCount(0), m_countPending(false),
+	  m_width(width), m_height(height), m_levelCount(0), m_depthFb(0), m_depth(0), m_pyramidFb(0), m_pyramid(0),
+	  m_hiZEnabled(true), m_hiZValid(false), m_viewProj(1.0f), m_hiZViewProj(1.0f), m_waitMs(0.0)
+{
+	m_cullProgram = shaderUtils::createProgram({
+		{ GL_VERTEX_SHADER, shaderUtils::readFile("res/instance-cull.vert") },
+		{ GL_GEOMETRY_SHADER, shaderUtils::readFile("res/instance-cull.geom") }
+	}, { "gTranslation", "gTextureLayer", "gTextureRect" });
+	m_hiZProgram = shaderUtils::createProgram("res/fullscreen.vert", "res/hiz.frag");
+
+	GLCall(glGenVertexArrays(1, &m_cullVao));
+	GLCall(glGenVertexArrays(1, &m_emptyVao));
+	GLCall(glGenBuffers(1, &m_output));
+	GLCall(glGenQueries(1, &m_query));
+
+	createPyramid();
+}
+
+GpuCulling::~GpuCulling() {
+	destroyPyramid();
+	GLCall(glDeleteQueries(1, &m_query));
+	GLCall(glDeleteBuffers(1, &m_output));
+	GLCall(glDeleteVertexArrays(1, &m_emptyVao));
+	GLCall(glDeleteVertexArrays(1, &m_cullVao));
+	GLCall(glDeleteProgram(m_hiZProgram));
+	GLCall(glDeleteProgram(m_cullProgram));
+}
+
+void GpuCulling::resize(int width, int height) {
+	if (width == m_width && height == m_height) {
+		return;
+	}
+	m_width = width;
+	m_height = height;
+	destroyPyramid();
+	createPyramid();
+}
+
+void GpuCulling::cull(GLuint instanceBuffer, GLsizei instanceCount, const glm::mat4& viewProj, float radius) {
+	m_viewProj = viewProj;
+	m_instanceCount = instanceCount;
+	if (instanceCount > m_outputCapacity) {
+		m_outputCapacity = std::max(instanceCount, m_outputCapacity * 2);
+		GLCall(glBindBuffer(GL_ARRAY_BUFFER, m_output));
+		GLCall(glBufferData(GL_ARRAY_BUFFER, m_outputCapacity * sizeof(SceneCulling::Instance), nullptr, GL_DYNAMIC_COPY));
+	}
+
+	// ------------------ Instances as points
+	GLCall(glBindVertexArray(m_cullVao));
+	GLCall(glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer));
+	GLCall(glEnableVertexAttribArray(0));
+	GLCall(glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(SceneCulling::Instance), (void*)offsetof(SceneCulling::Instance, translation)));
+	GLCall(glEnableVertexAttribArray(1));
+	GLCall(glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, sizeof(SceneCulling::Instance), (void*)offsetof(SceneCulling::Instance, textureLayer)));
+	GLCall(glEnableVertexAttribArray(2));
+	GLCall(glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(SceneCulling::Instance), (void*)offsetof(SceneCulling::Instance, textureRect)));
+	GLCall(glBindBuffer(GL_ARRAY_BUFFER, 0));
+
+	GLCall(glUseProgram(m_cullProgram));
+	GLCall(glUniformMatrix4fv(glGetUniformLocation(m_cullProgram, "uViewProj"), 1, GL_FALSE, &viewProj[0][0]));
+	GLCall(glUniformMatrix4fv(glGetUniformLocation(m_cullProgram, "uHiZViewProj"), 1, GL_FALSE, &m_hiZViewProj[0][0]));
+	GLCall(glUniform1f(glGetUniformLocation(m_cullProgram, "uRadius"), radius));
+	GLCall(glUniform1i(glGetUniformLocation(m_cullProgram, "uHiZEnabled"), m_hiZEnabled && m_hiZValid));
+	GLCall(glUniform1i(glGetUniformLocation(m_cullProgram, "uHiZ"), 0));
+	GLCall(glUniform2i(glGetUniformLocation(m_cullProgram, "uHiZSize"), m_width, m_height));
+	GLCall(glUniform1i(glGetUniformLocation(m_cullProgram, "uHiZLevelCount"), m_levelCount));
+	GLCall(glActiveTexture(GL_TEXTURE0));
+	GLCall(glBindTexture(GL_TEXTURE_2D, m_pyramid));
+
+	// ------------------ Visible ones streamed into the output buffer, nothing is rasterized
+	GLCall(glEnable(GL_RASTERIZER_DISCARD));
+	GLCall(glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, m_output));
+	GLCall(glBeginQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN, m_query));
+	GLCall(glBeginTransformFeedback(GL_POINTS));
+	GLCall(glDrawArrays(GL_POINTS, 0, instanceCount));
+	GLCall(glEndTransformFeedback());
+	GLCall(glEndQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN));
+	GLCall(glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0));
+	GLCall(glDisable(GL_RASTERIZER_DISCARD));
+
+	GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+	GLCall(glBindVertexArray(0));
+	m_countPending = true;
+}
+
+GLsizei GpuCulling::visibleCount() {
+	if (m_countPending) {
+		const auto start = std::chrono::high_resolution_clock::now();
+		GLuint count = 0;
+		GLCall(glGetQueryObjectuiv(m_query, GL_QUERY_RESULT, &count));
+		m_waitMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		m_visibleCount = static_cast<GLsizei>(count);
+		m_countPending = false;
+	}
+	return m_visibleCount;
+}
+
+void GpuCulling::captureDepth(GLuint sourceFramebuffer) {
+	if (!m_hiZEnabled) {
+		return;
+	}
+
+	GLint previousFb;
+	GLCall(glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFb));
+	GLint viewport[4];
+	GLCall(glGetIntegerv(GL_VIEWPORT, viewport));
+
+	// ------------------ Depth buffers cannot be sampled, copy it into a texture first
+	GLCall(glBindFramebuffer(GL_READ_FRAMEBUFFER, sourceFramebuffer));
+	GLCall(glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_depthFb));
+	GLCall(glBlitFramebuffer(0, 0, m_width, m_height, 0, 0, m_width, m_height, GL_DEPTH_BUFFER_BIT, GL_NEAREST));
+
+	// ------------------ Max pyramid, each level reads the previous one which is the only level visible to the sampler
+	GLCall(glBindFramebuffer(GL_FRAMEBUFFER, m_pyramidFb));
+	GLCall(glUseProgram(m_hiZProgram));
+	GLCall(glUniform1i(glGetUniformLocation(m_hiZProgram, "uSource"), 0));
+	GLCall(glBindVertexArray(m_emptyVao));
+	GLCall(glDisable(GL_DEPTH_TEST));
+	GLCall(glActiveTexture(GL_TEXTURE0));
+
+	int width = m_width, height = m_height;
+	for (int level = 0; level < m_levelCount; level++) {
+		GLCall(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_pyramid, level));
+		GLCall(glViewport(0, 0, width, height));
+		GLCall(glUniform1i(glGetUniformLocation(m_hiZProgram, "uReduce"), level > 0));
+		GLCall(glUniform2i(glGetUniformLocation(m_hiZProgram, "uTargetSize"), width, height));
+		if (level == 0) {
+			GLCall(glBindTexture(GL_TEXTURE_2D, m_depth));
+		} else {
+			GLCall(glBindTexture(GL_TEXTURE_2D, m_pyramid));
+			GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level - 1));
+			GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, level - 1));
+		}
+		GLCall(glDrawArrays(GL_TRIANGLES, 0, 3));
+		width = std::max(1, width / 2);
+		height = std::max(1, height / 2);
+	}
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, m_levelCount - 1));
+	GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+
+	GLCall(glEnable(GL_DEPTH_TEST));
+	GLCall(glBindVertexArray(0));
+	GLCall(glBindFramebuffer(GL_FRAMEBUFFER, previousFb));
+	GLCall(glViewport(viewport[0], viewport[1], viewport[2], viewport[3]));
+
+	m_hiZViewProj = m_viewProj;
+	m_hiZValid = true;
+}
+
+void GpuCulling::showMetrics() {
+	ImGui::Begin("GPU culling");
+	ImGui::Checkbox("Hi-Z", &m_hiZEnabled);
+	ImGui::Text("Visible : %d / %d", m_visibleCount, m_instanceCount);
+	ImGui::Text("Hi-Z : %dx%d, %d levels", m_width, m_height, m_levelCount);
+	ImGui::Text("Wait for count : %.3f ms", m_waitMs);
+	ImGui::End();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//////////////////////////// GETTERS & SETTERS //////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+void GpuCulling::setHiZEnabled(bool enabled) { m_hiZEnabled = enabled; }
+bool GpuCulling::isHiZEnabled() const { return m_hiZEnabled; }
+GLuint GpuCulling::outputBuffer() const { return m_output; }
+
+/////////////////////////////////////////////////////////////////////////////
+///////////////////////////// PRIVATE METHODS ///////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+void GpuCulling::createPyramid() {
+	m_levelCount = 1;
+	while ((m_width >> (m_levelCount - 1)) > 1 || (m_height >> (m_levelCount - 1)) > 1) {
+		m_levelCount++;
+	}
+
+	// ------------------ Depth copy, same format as the window depth buffer so that it can be blitted
+	GLCall(glGenTextures(1, &m_depth));
+	GLCall(glBindTexture(GL_TEXTURE_2D, m_depth));
+	GLCall(glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, m_width, m_height, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, nullptr));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
+	GLCall(glGenFramebuffers(1, &m_depthFb));
+	GLCall(glBindFramebuffer(GL_FRAMEBUFFER, m_depthFb));
+	GLCall(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, m_depth, 0));
+	GLCall(glDrawBuffer(GL_NONE));
+	GLCall(glReadBuffer(GL_NONE));
+
+	// ------------------ Pyramid
+	GLCall(glGenTextures(1, &m_pyramid));
+	GLCall(glBindTexture(GL_TEXTURE_2D, m_pyramid));
+	int width = m_width, height = m_height;
+	for (int level = 0; level < m_levelCount; level++) {
+		GLCall(glTexImage2D(GL_TEXTURE_2D, level, GL_R32F, width, height, 0, GL_RED, GL_FLOAT, nullptr));
+		width = std::max(1, width / 2);
+		height = std::max(1, height / 2);
+	}
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, m_levelCount - 1));
+	GLCall(glGenFramebuffers(1, &m_pyramidFb));
+	GLCall(glBindFramebuffer(GL_FRAMEBUFFER, m_pyramidFb));
+	GLCall(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_pyramid, 0));
+
+	GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+	GLCall(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+	m_hiZValid = false;
+}
+
+void GpuCulling::destroyPyramid() {
+	GLCall(glDeleteFramebuffers(1, &m_pyramidFb));
+	GLCall(glDeleteTextures(1, &m_pyramid));
+	GLCall(glDeleteFramebuffers(1, &m_depthFb));
+	GLCall(glDeleteTextures(1, &m_depth));
+}
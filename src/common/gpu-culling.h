@@ -0,0 +1,94 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+/**
+ * @brief Frustum and Hi-Z culling of instances on the GPU, visible ones are compacted into outputBuffer() by transform feedback
+ * @note Instances are SceneCulling::Instance, the bounding sphere of the mesh is the same for all of them.
+ *       A vertex shader tests each instance against the frustum, then against a max depth pyramid of the previous frame,
+ *       and a geometry shader only emits the visible ones while rasterization is disabled.
+ *       GL 3.3 has no indirect draw, so the instance count of the draw comes from a query : visibleCount() waits for
+ *       the culling pass, which is short but still syncs the CPU with the GPU once per frame.
+ *       An instance hidden in the previous frame shows up one frame late when it is uncovered.
+ *
+ * @code
+ * culling.cull(mesh.instanceBuffer(), mesh.instanceCount(), viewProj * model, radius);
+ * mesh.setInstanceSource(culling.outputBuffer(), culling.visibleCount());
+ * ... draw the scene
+ * culling.captureDepth(); // Depth of this frame hides instances in the next one
+ * @endcode
+ */
+class GpuCulling {
+public:
+    /**
+     * @param width, height - Size of the depth buffer captured by captureDepth()
+     */
+    GpuCulling(int width, int height);
+    ~GpuCulling();
+
+    GpuCulling(const GpuCulling&) = delete;
+    GpuCulling& operator=(const GpuCulling&) = delete;
+
+    /**
+     * @brief Reallocate the pyramid, Hi-Z is skipped until the next captureDepth()
+     */
+    void resize(int width, int height);
+
+    /**
+     * @param instanceBuffer - Every instance, interleaved SceneCulling::Instance
+     * @param viewProj - Clip space of the instances, so including the model matrix they are drawn with
+     * @param radius - Bounding sphere of the mesh around each translation
+     */
+    void cull(GLuint instanceBuffer, GLsizei instanceCount, const glm::mat4& viewProj, float radius);
+
+    /**
+     * @brief Instances written by the last cull(), waits for the GPU to finish it
+     */
+    GLsizei visibleCount();
+
+    /**
+     * @brief Copy the depth of the framebuffer and build its max pyramid, tested against by the next cull()
+     * @note The framebuffer must be width x height, with a 24 bits depth and 8 bits stencil buffer like the window one
+     */
+    void captureDepth(GLuint sourceFramebuffer = 0);
+
+    void setHiZEnabled(bool enabled);
+    bool isHiZEnabled() const;
+    GLuint outputBuffer() const;
+
+    void showMetrics();
+
+private:
+    void createPyramid();
+    void destroyPyramid();
+
+private:
+    GLuint m_cullProgram;
+    GLuint m_hiZProgram;
+    GLuint m_cullVao;
+    GLuint m_emptyVao;
+    GLuint m_query;
+
+    // ------------------ Compacted instances
+    GLuint m_output;
+    GLsizei m_outputCapacity;
+    GLsizei m_instanceCount;
+    GLsizei m_visibleCount;
+    bool m_countPending;
+
+    // ------------------ Hi-Z, the depth copy then its max pyramid in a R32F texture
+    int m_width;
+    int m_height;
+    int m_levelCount;
+    GLuint m_depthFb;
+    GLuint m_depth;
+    GLuint m_pyramidFb;
+    GLuint m_pyramid;
+    bool m_hiZEnabled;
+    bool m_hiZValid;
+    glm::mat4 m_viewProj;
+    glm::mat4 m_hiZViewProj;
+
+    double m_waitMs;
+};
@@ -0,0 +1,62 @@
+#include "gpu-timer.h"
+
+#include "gl-exception.h"
+
+GpuTimer::GpuTimer() : m_current(0), m_active(false), m_lastMs(0.0) {
+	GLCall(glGenQueries(QUERY_COUNT, m_queries));
+	for (unsigned int i = 0; i < QUERY_COUNT; i++) {
+		m_pending[i] = false;
+	}
+}
+
+GpuTimer::~GpuTimer() {
+	GLCall(glDeleteQueries(QUERY_COUNT, m_queries));
+}
+
+void GpuTimer::begin() {
+	collectResults();
+
+	// Every query is still in flight : skip this measure rather than waiting for the GPU
+	if (m_pending[m_current]) {
+		return;
+	}
+	GLCall(glBeginQuery(GL_TIME_ELAPSED, m_queries[m_current]));
+	m_pending[m_current] = true;
+	m_active = true;
+}
+
+void GpuTimer::end() {
+	if (!m_active) {
+		return;
+	}
+	GLCall(glEndQuery(GL_TIME_ELAPSED));
+	m_active = false;
+	m_current = (m_current + 1) % QUERY_COUNT;
+}
+
+double GpuTimer::lastMs() const { return m_lastMs; }
+
+/////////////////////////////////////////////////////////////////////////////
+///////////////////////////// PRIVATE METHODS ///////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+void GpuTimer::collectResults() {
+	// Oldest queries first, so that m_lastMs ends up with the most recent one
+	for (unsigned int i = 1; i <= QUERY_COUNT; i++) {
+		const unsigned int index = (m_current + i) % QUERY_COUNT;
+		if (!m_pending[index]) {
+			continue;
+		}
+
+		GLint available = 0;
+		GLCall(glGetQueryObjectiv(m_queries[index], GL_QUERY_RESULT_AVAILABLE, &available));
+		if (!available) {
+			continue;
+		}
+
+		GLuint64 elapsedNs = 0;
+		GLCall(glGetQueryObjectui64v(m_queries[index], GL_QUERY_RESULT, &elapsedNs));
+		m_lastMs = static_cast<double>(elapsedNs) / 1e6;
+		m_pending[index] = false;
+	}
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <glad/glad.h>
+
+/**
+ * @brief Measure GPU time between begin() and end() without stalling
+ * @note Results come back a few frames later through a ring of queries.
+ *       GL_TIME_ELAPSED queries cannot be nested, so only one GpuTimer can be active at once.
+ */
+class GpuTimer {
+public:
+    GpuTimer();
+    ~GpuTimer();
+
+    GpuTimer(const GpuTimer&) = delete;
+    GpuTimer& operator=(const GpuTimer&) = delete;
+
+    void begin();
+    void end();
+
+    /**
+     * @brief Last available measure
+     * @return double - In milliseconds, 0 until the first result is available
+     */
+    double lastMs() const;
+
+private:
+    void collectResults();
+
+private:
+    static constexpr unsigned int QUERY_COUNT = 4;
+
+    GLuint m_queries[QUERY_COUNT];
+    bool m_pending[QUERY_COUNT];
+    unsigned int m_current;
+    bool m_active;
+    double m_lastMs;
+};
@@ -0,0 +1,116 @@
+#include "image-utils.h"
+
+#include <algorithm>
+
+std::vector<std::uint8_t> imageUtils::downsample(const std::uint8_t* pixels, int& width, int& height) {
+	const int nextWidth = std::max(1, width / 2);
+	const int nextHeight = std::max(1, height / 2);
+	std::vector<std::uint8_t> next(static_cast<std::size_t>(nextWidth) * nextHeight * 4);
+
+	for (int y = 0; y < nextHeight; y++) {
+		for (int x = 0; x < nextWidth; x++) {
+			const int x0 = std::min(x * 2, width - 1), x1 = std::min(x * 2 + 1, width - 1);
+			const int y0 = std::min(y * 2, height - 1), y1 = std::min(y * 2 + 1, height - 1);
+			for (int c = 0; c < 4; c++) {
+				const int sum = pixels[(y0 * width + x0) * 4 + c] + pixels[(y0 * width + x1) * 4 + c]
+				              + pixels[(y1 * width + x0) * 4 + c] + pixels[(y1 * width + x1) * 4 + c];
+				next[(y * nextWidth + x) * 4 + c] = static_cast<std::uint8_t>((sum + 2) / 4);
+			}
+		}
+	}
+
+	width = nextWidth;
+	height = nextHeight;
+	return next;
+}
+
+std::vector<std::vector<std::uint8_t>> imageUtils::mipChain(const std::uint8_t* pixels, int width, int height) {
+	std::vector<std::vector<std::uint8_t>> levels;
+	levels.emplace_back(pixels, pixels + static_cast<std::size_t>(width) * height * 4);
+	while (width > 1 || height > 1) {
+		std::vector<std::uint8_t> next = downsample(levels.back().data(), width, height);
+		levels.push_back(std::move(next));
+	}
+	return levels;
+}
+
+namespace {
+	std::uint16_t toRGB565(int r, int g, int b) {
+		return static_cast<std::uint16_t>(((r * 31 + 127) / 255) << 11 | ((g * 63 + 127) / 255) << 5 | ((b * 31 + 127) / 255));
+	}
+
+	void fromRGB565(std::uint16_t color, int rgb[3]) {
+		rgb[0] = ((color >> 11) & 31) * 255 / 31;
+		rgb[1] = ((color >> 5) & 63) * 255 / 63;
+		rgb[2] = (color & 31) * 255 / 31;
+	}
+}
+
+std::vector<std::uint8_t> imageUtils::compressBC1(const std::uint8_t* pixels, int width, int height) {
+	const int blocksX = (width + 3) / 4;
+	const int blocksY = (height + 3) / 4;
+	std::vector<std::uint8_t> out(static_cast<std::size_t>(blocksX) * blocksY * 8);
+
+	for (int by = 0; by < blocksY; by++) {
+		for (int bx = 0; bx < blocksX; bx++) {
+			// ------------------ Gather the block, clamping at the borders
+			int block[16][3];
+			int minColor[3] = { 255, 255, 255 };
+			int maxColor[3] = { 0, 0, 0 };
+			for (int i = 0; i < 16; i++) {
+				const int x = std::min(bx * 4 + i % 4, width - 1);
+				const int y = std::min(by * 4 + i / 4, height - 1);
+				for (int c = 0; c < 3; c++) {
+					block[i][c] = pixels[(y * width + x) * 4 + c];
+					minColor[c] = std::min(minColor[c], block[i][c]);
+					maxColor[c] = std::max(maxColor[c], block[i][c]);
+				}
+			}
+
+			// ------------------ Endpoints, color0 > color1 selects the 4 colors mode
+			std::uint16_t color0 = toRGB565(maxColor[0], maxColor[1], maxColor[2]);
+			std::uint16_t color1 = toRGB565(minColor[0], minColor[1], minColor[2]);
+			if (color0 < color1) {
+				std::swap(color0, color1);
+			}
+
+			std::uint32_t indices = 0;
+			if (color0 != color1) {
+				int palette[4][3];
+				fromRGB565(color0, palette[0]);
+				fromRGB565(color1, palette[1]);
+				for (int c = 0; c < 3; c++) {
+					palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+					palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+				}
+				for (int i = 0; i < 16; i++) {
+					int best = 0;
+					int bestDistance = 1 << 30;
+					for (int p = 0; p < 4; p++) {
+						int distance = 0;
+						for (int c = 0; c < 3; c++) {
+							const int d = block[i][c] - palette[p][c];
+							distance += d * d;
+						}
+						if (distance < bestDistance) {
+							bestDistance = distance;
+							best = p;
+						}
+					}
+					indices |= static_cast<std::uint32_t>(best) << (i * 2);
+				}
+			}
+
+			std::uint8_t* dst = &out[(static_cast<std::size_t>(by) * blocksX + bx) * 8];
+			dst[0] = static_cast<std::uint8_t>(color0);
+			dst[1] = static_cast<std::uint8_t>(color0 >> 8);
+			dst[2] = static_cast<std::uint8_t>(color1);
+			dst[3] = static_cast<std::uint8_t>(color1 >> 8);
+			dst[4] = static_cast<std::uint8_t>(indices);
+			dst[5] = static_cast<std::uint8_t>(indices >> 8);
+			dst[6] = static_cast<std::uint8_t>(indices >> 16);
+			dst[7] = static_cast<std::uint8_t>(indices >> 24);
+		}
+	}
+	return out;
+}
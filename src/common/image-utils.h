@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace imageUtils {
+    /**
+     * @brief Halve an RGBA 8 bits image with a 2x2 box filter, odd sizes clamp to the last row/column
+     *
+     * @param pixels
+     * @param width - Replaced by the new width
+     * @param height - Replaced by the new height
+     */
+    std::vector<std::uint8_t> downsample(const std::uint8_t* pixels, int& width, int& height);
+
+    /**
+     * @brief Every level of the mip chain, from the full image to 1x1
+     */
+    std::vector<std::vector<std::uint8_t>> mipChain(const std::uint8_t* pixels, int width, int height);
+
+    /**
+     * @brief Compress an RGBA 8 bits image to BC1 (DXT1), alpha is dropped
+     * @note Bounding box endpoints, fast but not the best quality
+     */
+    std::vector<std::uint8_t> compressBC1(const std::uint8_t* pixels, int width, int height);
+}
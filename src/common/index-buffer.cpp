@@ -0,0 +1,98 @@
+#include "index-buffer.h"
+
+#include "gl-exception.h"
+
+IndexBuffer::IndexBuffer() : m_type(GL_UNSIGNED_SHORT), m_count(0), m_primitiveRestart(false) {
+	GLCall(glGenBuffers(1, &m_id));
+}
+
+IndexBuffer::~IndexBuffer() {
+	GLCall(glDeleteBuffers(1, &m_id));
+}
+
+void IndexBuffer::setRawData(const void* indices, std::size_t count, GLenum type, bool primitiveRestart, GLenum usage) {
+	m_type = type;
+	m_count = static_cast<GLsizei>(count);
+	m_primitiveRestart = primitiveRestart;
+
+	// The element buffer binding belongs to the bound vertex array, don't change it behind its back
+	GLint vertexArray;
+	GLCall(glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &vertexArray));
+	GLCall(glBindVertexArray(0));
+	GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_id));
+	GLCall(glBufferData(GL_ELEMENT_ARRAY_BUFFER, count * typeSize(type), indices, usage));
+	GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0));
+	GLCall(glBindVertexArray(vertexArray));
+}
+
+void IndexBuffer::draw(GLenum mode) const {
+	bind();
+	beginRestart();
+	GLCall(glDrawElements(mode, m_count, m_type, (void*)0));
+	endRestart();
+}
+
+void IndexBuffer::drawInstanced(GLenum mode, GLsizei instanceCount) const {
+	bind();
+	beginRestart();
+	GLCall(glDrawElementsInstanced(mode, m_count, m_type, (void*)0, instanceCount));
+	endRestart();
+}
+
+void IndexBuffer::bind() const {
+	GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_id));
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//////////////////////////// GETTERS & SETTERS //////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+GLuint IndexBuffer::id() const { return m_id; }
+GLenum IndexBuffer::type() const { return m_type; }
+GLsizei IndexBuffer::count() const { return m_count; }
+std::size_t IndexBuffer::sizeInBytes() const { return m_count * typeSize(m_type); }
+bool IndexBuffer::hasPrimitiveRestart() const { return m_primitiveRestart; }
+
+GLenum IndexBuffer::typeFor(std::size_t vertexCount, bool primitiveRestart) {
+	const std::size_t reserved = primitiveRestart ? 1 : 0;
+	if (vertexCount + reserved <= 0x100) {
+		return GL_UNSIGNED_BYTE;
+	} else if (vertexCount + reserved <= 0x10000) {
+		return GL_UNSIGNED_SHORT;
+	}
+	return GL_UNSIGNED_INT;
+}
+
+std::size_t IndexBuffer::typeSize(GLenum type) {
+	switch (type) {
+	case GL_UNSIGNED_BYTE: return 1;
+	case GL_UNSIGNED_SHORT: return 2;
+	default: return 4;
+	}
+}
+
+std::uint32_t IndexBuffer::restartIndex(GLenum type) {
+	switch (type) {
+	case GL_UNSIGNED_BYTE: return 0xFF;
+	case GL_UNSIGNED_SHORT: return 0xFFFF;
+	default: return 0xFFFFFFFF;
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+///////////////////////////// PRIVATE METHODS ///////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+void IndexBuffer::beginRestart() const {
+	// GL_PRIMITIVE_RESTART_FIXED_INDEX is only core in 4.3, so the index is set for the type
+	if (m_primitiveRestart) {
+		GLCall(glEnable(GL_PRIMITIVE_RESTART));
+		GLCall(glPrimitiveRestartIndex(restartIndex(m_type)));
+	}
+}
+
+void IndexBuffer::endRestart() const {
+	if (m_primitiveRestart) {
+		GLCall(glDisable(GL_PRIMITIVE_RESTART));
+	}
+}
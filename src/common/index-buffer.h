@@ -0,0 +1,93 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief Element buffer which stores indices in the smallest type able to address the mesh
+ * @note The maximum value of the input type (0xFFFF for unsigned short...) marks a primitive restart,
+ *       it becomes the maximum value of the stored type and restart is enabled while drawing.
+ *       8 bits indices save the most memory but a few old GPUs convert them in the driver,
+ *       pass allowBytes = false to setData() for those.
+ */
+class IndexBuffer {
+public:
+    IndexBuffer();
+    ~IndexBuffer();
+
+    IndexBuffer(const IndexBuffer&) = delete;
+    IndexBuffer& operator=(const IndexBuffer&) = delete;
+
+    /**
+     * @param vertexCount - Number of vertices the indices refer to, which decides the stored type
+     */
+    template<typename T>
+    void setData(const T* indices, std::size_t count, std::size_t vertexCount, bool allowBytes = true, GLenum usage = GL_STATIC_DRAW) {
+        static_assert(std::is_unsigned<T>::value, "Indices must be unsigned !");
+        const T marker = std::numeric_limits<T>::max();
+        const bool restart = std::find(indices, indices + count, marker) != indices + count;
+
+        GLenum type = typeFor(vertexCount, restart);
+        if (type == GL_UNSIGNED_BYTE && !allowBytes) {
+            type = GL_UNSIGNED_SHORT;
+        }
+        switch (type) {
+        case GL_UNSIGNED_BYTE: upload(convert<std::uint8_t>(indices, count, marker), type, restart, usage); break;
+        case GL_UNSIGNED_SHORT: upload(convert<std::uint16_t>(indices, count, marker), type, restart, usage); break;
+        default: upload(convert<std::uint32_t>(indices, count, marker), type, restart, usage); break;
+        }
+    }
+
+    /**
+     * @brief Upload indices already stored in the given type, for example straight from an AssetPack
+     */
+    void setRawData(const void* indices, std::size_t count, GLenum type, bool primitiveRestart = false, GLenum usage = GL_STATIC_DRAW);
+
+    /**
+     * @brief Bind then draw with the vertex array currently bound
+     */
+    void draw(GLenum mode) const;
+    void drawInstanced(GLenum mode, GLsizei instanceCount) const;
+
+    void bind() const;
+    GLuint id() const;
+    GLenum type() const;
+    GLsizei count() const;
+    std::size_t sizeInBytes() const;
+    bool hasPrimitiveRestart() const;
+
+    /**
+     * @brief Smallest type for indices in [0, vertexCount), keeping the maximum value free when restart is used
+     */
+    static GLenum typeFor(std::size_t vertexCount, bool primitiveRestart = false);
+    static std::size_t typeSize(GLenum type);
+    static std::uint32_t restartIndex(GLenum type);
+
+private:
+    template<typename Dst, typename Src>
+    static std::vector<Dst> convert(const Src* indices, std::size_t count, Src marker) {
+        std::vector<Dst> result(count);
+        for (std::size_t i = 0; i < count; i++) {
+            result[i] = indices[i] == marker ? std::numeric_limits<Dst>::max() : static_cast<Dst>(indices[i]);
+        }
+        return result;
+    }
+
+    template<typename Dst>
+    void upload(const std::vector<Dst>& indices, GLenum type, bool primitiveRestart, GLenum usage) {
+        setRawData(indices.data(), indices.size(), type, primitiveRestart, usage);
+    }
+
+    void beginRestart() const;
+    void endRestart() const;
+
+private:
+    GLuint m_id;
+    GLenum m_type;
+    GLsizei m_count;
+    bool m_primitiveRestart;
+};
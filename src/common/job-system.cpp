@@ -0,0 +1,272 @@
+#include "job-system.h"
+
+#include <chrono>
+#include <cstring>
+
+namespace {
+    const unsigned int NOT_A_JOB_THREAD = ~0u;
+    thread_local unsigned int t_threadIndex = NOT_A_JOB_THREAD;
+}
+
+bool JobSystem::m_instanciated = false;
+
+/////////////////////////////////////////////////////////////////////////////
+///////////////////////////// WORK STEALING QUEUE ///////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+WorkStealingQueue::WorkStealingQueue() : m_top(0), m_bottom(0) {
+	for (auto& job : m_jobs) {
+		job.store(nullptr, std::memory_order_relaxed);
+	}
+}
+
+void WorkStealingQueue::push(Job* job) {
+	const std::int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+	assert(bottom - m_top.load(std::memory_order_acquire) < CAPACITY && "Job queue is full !");
+	m_jobs[bottom & MASK].store(job, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	m_bottom.store(bottom + 1, std::memory_order_relaxed);
+}
+
+Job* WorkStealingQueue::pop() {
+	const std::int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+	m_bottom.store(bottom, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	std::int64_t top = m_top.load(std::memory_order_relaxed);
+
+	if (top > bottom) {
+		// Empty queue
+		m_bottom.store(bottom + 1, std::memory_order_relaxed);
+		return nullptr;
+	}
+
+	Job* job = m_jobs[bottom & MASK].load(std::memory_order_relaxed);
+	if (top == bottom) {
+		// Last job, race against thieves
+		if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+			job = nullptr;
+		}
+		m_bottom.store(bottom + 1, std::memory_order_relaxed);
+	}
+	return job;
+}
+
+Job* WorkStealingQueue::steal() {
+	std::int64_t top = m_top.load(std::memory_order_acquire);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	const std::int64_t bottom = m_bottom.load(std::memory_order_acquire);
+
+	if (top >= bottom) {
+		return nullptr;
+	}
+
+	Job* job = m_jobs[top & MASK].load(std::memory_order_relaxed);
+	if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+		// Lost the race against another thief or the owner
+		return nullptr;
+	}
+	return job;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+///////////////////////////////// JOB SYSTEM ////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+JobSystem::JobSystem(unsigned int threadCount)
+	: m_threadData(threadCount > 0 ? threadCount : 1), m_running(true), m_sleepingWorkers(0)
+{
+	assert(!m_instanciated && "JobSystem already created !");
+	m_instanciated = true;
+
+	for (auto& threadData : m_threadData) {
+		threadData.jobs.reset(new Job[MAX_JOBS_PER_THREAD]);
+		for (std::uint32_t i = 0; i < MAX_JOBS_PER_THREAD; i++) {
+			threadData.jobs[i].unfinishedJobs.store(0, std::memory_order_relaxed);
+		}
+	}
+
+	t_threadIndex = 0;
+	for (unsigned int i = 1; i < m_threadData.size(); i++) {
+		m_threadData[i].random = i * 2654435761u;
+		m_workers.emplace_back(&JobSystem::workerLoop, this, i);
+	}
+}
+
+JobSystem::~JobSystem() {
+	m_running.store(false);
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+	}
+	m_sleepCondition.notify_all();
+
+	for (auto& worker : m_workers) {
+		worker.join();
+	}
+	m_instanciated = false;
+}
+
+Job* JobSystem::createJob(JobFunction function, const void* data, std::size_t size) {
+	return createChildJob(nullptr, function, data, size);
+}
+
+Job* JobSystem::createChildJob(Job* parent, JobFunction function, const void* data, std::size_t size) {
+	assert(size <= Job::DATA_SIZE && "Job data is too big !");
+	Job* job = allocateJob(parent, function);
+	if (data != nullptr) {
+		std::memcpy(job->data, data, size);
+	}
+	return job;
+}
+
+void JobSystem::addContinuation(Job* ancestor, Job* continuation) {
+	const std::int32_t index = ancestor->continuationCount.fetch_add(1, std::memory_order_relaxed);
+	assert(index < static_cast<std::int32_t>(Job::MAX_CONTINUATIONS) && "Too many continuations !");
+	ancestor->continuations[index] = continuation;
+}
+
+void JobSystem::run(Job* job) {
+	m_threadData[threadIndex()].queue.push(job);
+	wakeUpWorkers();
+}
+
+void JobSystem::wait(const Job* job) {
+	while (!isFinished(job)) {
+		Job* next = getJob();
+		if (next != nullptr) {
+			execute(next);
+		} else {
+			std::this_thread::yield();
+		}
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//////////////////////////// GETTERS & SETTERS //////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+bool JobSystem::isFinished(const Job* job) const {
+	return job->unfinishedJobs.load(std::memory_order_acquire) == 0;
+}
+
+unsigned int JobSystem::threadCount() const { return static_cast<unsigned int>(m_threadData.size()); }
+unsigned int JobSystem::threadIndex() {
+	// Another thread would share the deque and the job slots of the creator thread, which are not thread safe
+	assert(t_threadIndex != NOT_A_JOB_THREAD && "Not a JobSystem thread !");
+	return t_threadIndex;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+///////////////////////////// PRIVATE METHODS ///////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+Job* JobSystem::allocateJob(Job* parent, JobFunction function) {
+	ThreadData& threadData = m_threadData[threadIndex()];
+
+	// Ring of slots, those of unfinished jobs are skipped : a job waiting in a queue while newer ones come and go is not overwritten
+	Job* job = nullptr;
+	for (std::uint32_t i = 0; i < MAX_JOBS_PER_THREAD && job == nullptr; i++) {
+		Job* slot = &threadData.jobs[threadData.allocatedJobs++ & (MAX_JOBS_PER_THREAD - 1)];
+		if (slot->unfinishedJobs.load(std::memory_order_acquire) == 0) {
+			job = slot;
+		}
+	}
+	assert(job != nullptr && "Too many unfinished jobs on this thread !");
+
+	job->function = function;
+	job->parent = parent;
+	job->unfinishedJobs.store(1, std::memory_order_relaxed);
+	job->continuationCount.store(0, std::memory_order_relaxed);
+	if (parent != nullptr) {
+		parent->unfinishedJobs.fetch_add(1, std::memory_order_relaxed);
+	}
+	return job;
+}
+
+Job* JobSystem::getJob() {
+	ThreadData& threadData = m_threadData[threadIndex()];
+	Job* job = threadData.queue.pop();
+	if (job != nullptr) {
+		return job;
+	}
+
+	// Own queue is empty, try to steal from a random victim
+	const unsigned int count = threadCount();
+	if (count == 1) {
+		return nullptr;
+	}
+	threadData.random ^= threadData.random << 13;
+	threadData.random ^= threadData.random >> 17;
+	threadData.random ^= threadData.random << 5;
+	const unsigned int start = threadData.random % count;
+	for (unsigned int i = 0; i < count; i++) {
+		const unsigned int victim = (start + i) % count;
+		if (victim == threadIndex()) {
+			continue;
+		}
+		job = m_threadData[victim].queue.steal();
+		if (job != nullptr) {
+			return job;
+		}
+	}
+	return nullptr;
+}
+
+void JobSystem::execute(Job* job) {
+	job->function(*job);
+	finish(job);
+}
+
+void JobSystem::finish(Job* job) {
+	// Read everything before the decrement : once it reaches 0, the owner thread may reuse the slot at any time
+	// Continuations are all added before the job runs, so they cannot change meanwhile
+	Job* parent = job->parent;
+	const std::int32_t continuationCount = job->continuationCount.load(std::memory_order_relaxed);
+	Job* continuations[Job::MAX_CONTINUATIONS];
+	for (std::int32_t i = 0; i < continuationCount; i++) {
+		continuations[i] = job->continuations[i];
+	}
+
+	const std::int32_t unfinishedJobs = job->unfinishedJobs.fetch_sub(1, std::memory_order_acq_rel) - 1;
+	if (unfinishedJobs != 0) {
+		return;
+	}
+
+	if (parent != nullptr) {
+		finish(parent);
+	}
+	for (std::int32_t i = 0; i < continuationCount; i++) {
+		run(continuations[i]);
+	}
+}
+
+void JobSystem::workerLoop(unsigned int index) {
+	t_threadIndex = index;
+	unsigned int idleLoops = 0;
+
+	while (m_running.load(std::memory_order_relaxed)) {
+		Job* job = getJob();
+		if (job != nullptr) {
+			execute(job);
+			idleLoops = 0;
+			continue;
+		}
+
+		// Spin a bit to stay reactive within a frame, then sleep to leave the CPU to the app
+		idleLoops++;
+		if (idleLoops < 64) {
+			std::this_thread::yield();
+		} else {
+			std::unique_lock<std::mutex> lock(m_sleepMutex);
+			m_sleepingWorkers.fetch_add(1);
+			m_sleepCondition.wait_for(lock, std::chrono::milliseconds(1));
+			m_sleepingWorkers.fetch_sub(1);
+			idleLoops = 0;
+		}
+	}
+}
+
+void JobSystem::wakeUpWorkers() {
+	if (m_sleepingWorkers.load(std::memory_order_relaxed) > 0) {
+		m_sleepCondition.notify_all();
+	}
+}
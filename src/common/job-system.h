@@ -0,0 +1,238 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <assert.h>
+
+struct Job;
+using JobFunction = void(*)(Job&);
+
+/**
+ * @brief Unit of work for the JobSystem
+ * @note Small enough to fit two cache lines, the callable is stored inline so spawning never allocates
+ */
+struct alignas(64) Job {
+    static constexpr std::size_t MAX_CONTINUATIONS = 4;
+    static constexpr std::size_t DATA_SIZE = 64;
+
+    JobFunction function;
+    Job* parent;
+    std::atomic<std::int32_t> unfinishedJobs;
+    std::atomic<std::int32_t> continuationCount;
+    Job* continuations[MAX_CONTINUATIONS];
+    alignas(16) unsigned char data[DATA_SIZE];
+
+    template<typename T>
+    T& dataAs() {
+        static_assert(sizeof(T) <= DATA_SIZE, "Job data is too big, capture by reference instead !");
+        return *reinterpret_cast<T*>(data);
+    }
+};
+
+/**
+ * @brief Chase-Lev work stealing deque
+ * @note The owner thread push() and pop() at the bottom, any other thread can steal() at the top
+ */
+class WorkStealingQueue {
+public:
+    static constexpr std::int64_t CAPACITY = 4096;
+
+    WorkStealingQueue();
+    ~WorkStealingQueue() = default;
+
+    void push(Job* job);
+    Job* pop();
+    Job* steal();
+
+private:
+    static constexpr std::int64_t MASK = CAPACITY - 1;
+
+    alignas(64) std::atomic<std::int64_t> m_top;
+    alignas(64) std::atomic<std::int64_t> m_bottom;
+    std::atomic<Job*> m_jobs[CAPACITY];
+};
+
+/**
+ * @brief Work stealing thread pool for per-frame CPU work
+ * @note The thread which creates the JobSystem is worker 0 and executes jobs while it waits.
+ *       Jobs come from a per-thread ring of MAX_JOBS_PER_THREAD slots which skips unfinished jobs,
+ *       so a thread must not have more than MAX_JOBS_PER_THREAD jobs created and not finished at once.
+ *       A finished slot is reused once the ring comes back to it, a Job* must not be waited on
+ *       after its thread created MAX_JOBS_PER_THREAD more jobs.
+ *
+ * @code
+ * Job* root = jobs.parallelFor(0, count, 256, [&](std::uint32_t begin, std::uint32_t end) { ... });
+ * jobs.run(root);
+ * jobs.wait(root);
+ * @endcode
+ */
+class JobSystem {
+public:
+    static constexpr std::uint32_t MAX_JOBS_PER_THREAD = 4096;
+
+    /**
+     * @param threadCount - Total number of threads executing jobs, including the calling one
+     */
+    JobSystem(unsigned int threadCount = std::thread::hardware_concurrency());
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    /**
+     * @brief Create a job which runs a raw function, data is copied inline
+     */
+    Job* createJob(JobFunction function, const void* data = nullptr, std::size_t size = 0);
+
+    /**
+     * @brief Create a job which counts as unfinished work of parent until it is done
+     */
+    Job* createChildJob(Job* parent, JobFunction function, const void* data = nullptr, std::size_t size = 0);
+
+    /**
+     * @brief Create a job from a callable taking no argument
+     */
+    template<typename F>
+    Job* createJob(F&& callable) {
+        return createCallableJob(nullptr, std::forward<F>(callable));
+    }
+
+    template<typename F>
+    Job* createChildJob(Job* parent, F&& callable) {
+        return createCallableJob(parent, std::forward<F>(callable));
+    }
+
+    /**
+     * @brief Run continuation once ancestor and all its children are finished
+     * @note Must be called before ancestor is run, continuation must not be run manually
+     */
+    void addContinuation(Job* ancestor, Job* continuation);
+
+    /**
+     * @brief Split [begin, end) in chunks of at most grainSize and call function(chunkBegin, chunkEnd) on each
+     * @note A temporary function is copied into the jobs, so it must be small and trivially copyable : capture by reference.
+     *       A named one is only referenced and must outlive wait().
+     * @return Job* - Root job, to run() then wait()
+     */
+    template<typename F>
+    Job* parallelFor(std::uint32_t begin, std::uint32_t end, std::uint32_t grainSize, F&& function) {
+        using Callable = typename std::decay<F>::type;
+        using Stored = typename std::conditional<std::is_lvalue_reference<F>::value, CallableRef<Callable>, Callable>::type;
+        static_assert(sizeof(ParallelForData<Stored>) <= Job::DATA_SIZE, "parallelFor lambda captures too much, capture by reference instead !");
+        static_assert(alignof(Stored) <= 16, "parallelFor lambda is over-aligned !");
+        static_assert(std::is_trivially_copyable<Stored>::value, "parallelFor lambda must be trivially copyable, capture by reference instead !");
+        assert(grainSize > 0 && "Grain size must be positive !");
+        const ParallelForData<Stored> data = { this, begin, end, grainSize, Stored(function) };
+        return createJob(&parallelForJob<Stored>, &data, sizeof(data));
+    }
+
+    /**
+     * @brief Push the job in the queue of the calling thread
+     */
+    void run(Job* job);
+
+    /**
+     * @brief Execute other jobs until job and all its children are finished
+     */
+    void wait(const Job* job);
+
+    bool isFinished(const Job* job) const;
+    unsigned int threadCount() const;
+
+    /**
+     * @brief Index of the calling thread in the pool, 0 being the creator thread
+     * @note Asserts on any other thread, jobs can only be created and run from threads of the pool
+     */
+    static unsigned int threadIndex();
+
+private:
+    /**
+     * @brief Named callable of parallelFor(), the caller keeps it alive
+     */
+    template<typename F>
+    struct CallableRef {
+        const F* callable;
+
+        explicit CallableRef(const F& f) : callable(&f) {}
+        void operator()(std::uint32_t begin, std::uint32_t end) const { (*callable)(begin, end); }
+    };
+
+    template<typename F>
+    struct ParallelForData {
+        JobSystem* system;
+        std::uint32_t begin;
+        std::uint32_t end;
+        std::uint32_t grainSize;
+        F function;
+    };
+
+    template<typename F>
+    static void parallelForJob(Job& job) {
+        const ParallelForData<F>& data = job.dataAs<ParallelForData<F>>();
+
+        // Split in two halves until it fits the grain, each half can be stolen by another thread
+        if (data.end - data.begin > data.grainSize) {
+            const std::uint32_t middle = data.begin + (data.end - data.begin) / 2;
+            ParallelForData<F> left = data;
+            left.end = middle;
+            ParallelForData<F> right = data;
+            right.begin = middle;
+            data.system->run(data.system->createChildJob(&job, &parallelForJob<F>, &left, sizeof(left)));
+            data.system->run(data.system->createChildJob(&job, &parallelForJob<F>, &right, sizeof(right)));
+        } else if (data.begin < data.end) {
+            data.function(data.begin, data.end);
+        }
+    }
+
+    template<typename F>
+    static void callableJob(Job& job) {
+        using Callable = typename std::decay<F>::type;
+        Callable& callable = job.dataAs<Callable>();
+        callable();
+        callable.~Callable();
+    }
+
+    template<typename F>
+    Job* createCallableJob(Job* parent, F&& callable) {
+        using Callable = typename std::decay<F>::type;
+        static_assert(sizeof(Callable) <= Job::DATA_SIZE, "Job lambda captures too much, capture by reference instead !");
+        static_assert(alignof(Callable) <= 16, "Job lambda is over-aligned !");
+        Job* job = allocateJob(parent, &callableJob<F>);
+        new (job->data) Callable(std::forward<F>(callable));
+        return job;
+    }
+
+    Job* allocateJob(Job* parent, JobFunction function);
+    Job* getJob();
+    void execute(Job* job);
+    void finish(Job* job);
+    void workerLoop(unsigned int index);
+    void wakeUpWorkers();
+
+private:
+    struct alignas(64) ThreadData {
+        WorkStealingQueue queue;
+        std::unique_ptr<Job[]> jobs;
+        std::uint32_t allocatedJobs = 0;
+        std::uint32_t random = 0;
+    };
+
+    std::vector<ThreadData> m_threadData;
+    std::vector<std::thread> m_workers;
+    std::atomic<bool> m_running;
+
+    std::mutex m_sleepMutex;
+    std::condition_variable m_sleepCondition;
+    std::atomic<int> m_sleepingWorkers;
+
+    static bool m_instanciated;
+};
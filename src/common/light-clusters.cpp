@@ -0,0 +1,329 @@
+#include "light-clusters.h"
+
+#include "gl-exception.h"
+#include "job-system.h"
+#include <spdlog/spdlog.h>
+#include <imgui.h>
+#include <assert.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+    #define LIGHT_CLUSTERS_AVX2
+#elif defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+    #include <xmmintrin.h>
+    #define LIGHT_CLUSTERS_SSE
+#endif
+
+namespace {
+    const int CLUSTER_COUNT = LightClusters::TILES_X * LightClusters::TILES_Y * LightClusters::SLICES;
+    const int SIMD_WIDTH = 8;
+
+    // Position of the padding lights, far enough to never touch a cluster but still finite once squared
+    const float FAR_AWAY = 1e18f;
+
+    // Same layout as the Clusters block of the shaders
+    struct ClustersBlock {
+        glm::vec4 scale; // Tiles per pixel, then slices per log of the view depth and their bias
+        glm::vec4 depth; // Near and far planes
+        glm::ivec4 count;
+    };
+
+    enum BufferIndex {
+        GRID = 0,
+        INDICES = 1,
+        LIGHTS = 2
+    };
+
+    void uploadBuffer(GLuint buffer, const void* data, std::size_t size) {
+        GLCall(glBindBuffer(GL_TEXTURE_BUFFER, buffer));
+        // Never empty, a buffer texture without storage is incomplete
+        GLCall(glBufferData(GL_TEXTURE_BUFFER, std::max<std::size_t>(size, 16), size > 0 ? data : nullptr, GL_STREAM_DRAW));
+    }
+}
+
+LightClusters::LightClusters(JobSystem& jobs, int width, int height)
+	: m_jobs(jobs), m_width(width), m_height(height),
+	  m_tanHalfFovY(0.0f), m_aspect(0.0f), m_near(0.0f), m_far(0.0f), m_sliceScale(0.0f), m_sliceBias(0.0f),
+	  m_bounds(CLUSTER_COUNT), m_slices(SLICES), m_grid(CLUSTER_COUNT, glm::uvec2(0)),
+	  m_overflowCount(0), m_maxCount(0), m_binMs(0.0),
+	  m_blockBuffer(0), m_buffers{ 0, 0, 0 }, m_textures{ 0, 0, 0 }, m_uploadedBytes(0)
+{}
+
+LightClusters::~LightClusters() {
+	if (m_blockBuffer != 0) {
+		GLCall(glDeleteTextures(3, m_textures));
+		GLCall(glDeleteBuffers(3, m_buffers));
+		GLCall(glDeleteBuffers(1, &m_blockBuffer));
+	}
+}
+
+void LightClusters::setupProgram(GLuint program) {
+	GLCall(GLuint blockIndex = glGetUniformBlockIndex(program, "Clusters"));
+	if (blockIndex == GL_INVALID_INDEX) {
+		spdlog::warn("[LightClusters] Program {} has no Clusters uniform block", program);
+	} else {
+		GLCall(glUniformBlockBinding(program, blockIndex, BLOCK_BINDING));
+	}
+
+	const char* samplers[3] = { "uClusterGrid", "uClusterIndices", "uClusterLights" };
+	GLCall(glUseProgram(program));
+	for (int i = 0; i < 3; i++) {
+		GLCall(GLint location = glGetUniformLocation(program, samplers[i]));
+		if (location != -1) {
+			GLCall(glUniform1i(location, FIRST_TEXTURE_UNIT + i));
+		}
+	}
+	GLCall(glUseProgram(0));
+}
+
+void LightClusters::resize(int width, int height) {
+	m_width = width;
+	m_height = height;
+}
+
+void LightClusters::bin(const std::vector<PointLight>& lights, const glm::mat4& view, const glm::mat4& projection) {
+	assert(lights.size() <= 0xFFFF && "Light indices of the clusters are 16 bits !");
+	const auto start = std::chrono::high_resolution_clock::now();
+
+	// ------------------ Frustum of the projection, the bounds only change with it
+	const float tanHalfFovY = 1.0f / projection[1][1];
+	const float aspect = projection[1][1] / projection[0][0];
+	const float nearPlane = projection[3][2] / (projection[2][2] - 1.0f);
+	const float farPlane = projection[3][2] / (projection[2][2] + 1.0f);
+	if (tanHalfFovY != m_tanHalfFovY || aspect != m_aspect || nearPlane != m_near || farPlane != m_far) {
+		buildBounds(tanHalfFovY, aspect, nearPlane, farPlane);
+	}
+
+	// ------------------ Bucket the lights in view space by the slices their sphere overlaps
+	for (Slice& slice : m_slices) {
+		slice.x.clear();
+		slice.y.clear();
+		slice.z.clear();
+		slice.radius2.clear();
+		slice.lights.clear();
+	}
+	m_lightData.resize(lights.size() * 2);
+	for (std::size_t i = 0; i < lights.size(); i++) {
+		const PointLight& light = lights[i];
+		m_lightData[i * 2] = glm::vec4(light.position, light.radius);
+		m_lightData[i * 2 + 1] = glm::vec4(light.color * light.intensity, 0.0f);
+
+		const glm::vec3 center = glm::vec3(view * glm::vec4(light.position, 1.0f));
+		if (-center.z + light.radius < m_near || -center.z - light.radius > m_far) {
+			continue;
+		}
+		const int first = sliceOf(std::max(-center.z - light.radius, m_near));
+		const int last = sliceOf(std::min(-center.z + light.radius, m_far));
+		for (int s = first; s <= last; s++) {
+			Slice& slice = m_slices[s];
+			slice.x.push_back(center.x);
+			slice.y.push_back(center.y);
+			slice.z.push_back(center.z);
+			slice.radius2.push_back(light.radius * light.radius);
+			slice.lights.push_back(static_cast<std::uint16_t>(i));
+		}
+	}
+	for (Slice& slice : m_slices) {
+		while (slice.x.size() % SIMD_WIDTH != 0) {
+			slice.x.push_back(FAR_AWAY);
+			slice.y.push_back(0.0f);
+			slice.z.push_back(0.0f);
+			slice.radius2.push_back(0.0f);
+			slice.lights.push_back(0);
+		}
+	}
+
+	// ------------------ Tiles of each slice against its candidates, offsets are relative to the slice for now
+	Job* root = m_jobs.parallelFor(0, SLICES, 1, [this](std::uint32_t begin, std::uint32_t end) {
+		for (std::uint32_t s = begin; s < end; s++) {
+			binSlice(static_cast<int>(s));
+		}
+	});
+	m_jobs.run(root);
+	m_jobs.wait(root);
+
+	// ------------------ Concatenate the lists of every slice
+	m_indices.clear();
+	m_overflowCount = 0;
+	m_maxCount = 0;
+	for (int s = 0; s < SLICES; s++) {
+		const std::uint32_t offset = static_cast<std::uint32_t>(m_indices.size());
+		glm::uvec2* grid = &m_grid[s * TILES_X * TILES_Y];
+		for (int tile = 0; tile < TILES_X * TILES_Y; tile++) {
+			grid[tile].x += offset;
+			m_maxCount = std::max(m_maxCount, grid[tile].y);
+		}
+		m_indices.insert(m_indices.end(), m_slices[s].indices.begin(), m_slices[s].indices.end());
+		m_overflowCount += m_slices[s].overflow;
+	}
+
+	m_binMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void LightClusters::upload() {
+	if (m_blockBuffer == 0) {
+		const GLenum formats[3] = { GL_RG32UI, GL_R16UI, GL_RGBA32F };
+		GLCall(glGenBuffers(1, &m_blockBuffer));
+		GLCall(glGenBuffers(3, m_buffers));
+		GLCall(glGenTextures(3, m_textures));
+		for (int i = 0; i < 3; i++) {
+			uploadBuffer(m_buffers[i], nullptr, 0);
+			GLCall(glBindTexture(GL_TEXTURE_BUFFER, m_textures[i]));
+			GLCall(glTexBuffer(GL_TEXTURE_BUFFER, formats[i], m_buffers[i]));
+		}
+		GLCall(glBindTexture(GL_TEXTURE_BUFFER, 0));
+	}
+
+	const ClustersBlock block = {
+		glm::vec4(static_cast<float>(TILES_X) / m_width, static_cast<float>(TILES_Y) / m_height, m_sliceScale, m_sliceBias),
+		glm::vec4(m_near, m_far, 0.0f, 0.0f),
+		glm::ivec4(TILES_X, TILES_Y, SLICES, 0)
+	};
+	GLCall(glBindBuffer(GL_UNIFORM_BUFFER, m_blockBuffer));
+	GLCall(glBufferData(GL_UNIFORM_BUFFER, sizeof(block), &block, GL_STREAM_DRAW));
+	GLCall(glBindBuffer(GL_UNIFORM_BUFFER, 0));
+
+	// Orphaned every frame, the previous content may still be read by the GPU
+	uploadBuffer(m_buffers[GRID], m_grid.data(), m_grid.size() * sizeof(glm::uvec2));
+	uploadBuffer(m_buffers[INDICES], m_indices.data(), m_indices.size() * sizeof(std::uint16_t));
+	uploadBuffer(m_buffers[LIGHTS], m_lightData.data(), m_lightData.size() * sizeof(glm::vec4));
+	GLCall(glBindBuffer(GL_TEXTURE_BUFFER, 0));
+	m_uploadedBytes = sizeof(block) + m_grid.size() * sizeof(glm::uvec2) + m_indices.size() * sizeof(std::uint16_t) + m_lightData.size() * sizeof(glm::vec4);
+
+	GLCall(glBindBufferBase(GL_UNIFORM_BUFFER, BLOCK_BINDING, m_blockBuffer));
+	for (int i = 0; i < 3; i++) {
+		GLCall(glActiveTexture(GL_TEXTURE0 + FIRST_TEXTURE_UNIT + i));
+		GLCall(glBindTexture(GL_TEXTURE_BUFFER, m_textures[i]));
+	}
+	GLCall(glActiveTexture(GL_TEXTURE0));
+}
+
+void LightClusters::showMetrics() {
+	ImGui::Begin("Clusters");
+	ImGui::Text("Grid : %dx%dx%d, %u lights at most per cluster", TILES_X, TILES_Y, SLICES, MAX_LIGHTS_PER_CLUSTER);
+	ImGui::Text("Lights : %zu, %zu indices", m_lightData.size() / 2, m_indices.size());
+	ImGui::Text("Busiest cluster : %u lights", m_maxCount);
+	ImGui::Text("Dropped : %u", m_overflowCount);
+	ImGui::Text("Last bin : %.3f ms", m_binMs);
+	ImGui::Text("Upload : %.1f KB", m_uploadedBytes / 1024.0);
+	ImGui::End();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//////////////////////////// GETTERS & SETTERS //////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+glm::uvec2 LightClusters::cluster(int x, int y, int slice) const {
+	return m_grid[(slice * TILES_Y + y) * TILES_X + x];
+}
+
+const std::vector<std::uint16_t>& LightClusters::indices() const {
+	return m_indices;
+}
+
+std::uint32_t LightClusters::overflowCount() const {
+	return m_overflowCount;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+///////////////////////////// PRIVATE METHODS ///////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+void LightClusters::buildBounds(float tanHalfFovY, float aspect, float nearPlane, float farPlane) {
+	m_tanHalfFovY = tanHalfFovY;
+	m_aspect = aspect;
+	m_near = nearPlane;
+	m_far = farPlane;
+	m_sliceScale = SLICES / std::log(farPlane / nearPlane);
+	m_sliceBias = -SLICES * std::log(nearPlane) / std::log(farPlane / nearPlane);
+
+	// A tile is a pyramid between the near and far depths of its slice, boxed by its 4 corners on both
+	const glm::vec2 halfExtents(tanHalfFovY * aspect, tanHalfFovY);
+	for (int s = 0; s < SLICES; s++) {
+		const float sliceNear = nearPlane * std::pow(farPlane / nearPlane, static_cast<float>(s) / SLICES);
+		const float sliceFar = nearPlane * std::pow(farPlane / nearPlane, static_cast<float>(s + 1) / SLICES);
+		for (int y = 0; y < TILES_Y; y++) {
+			for (int x = 0; x < TILES_X; x++) {
+				const glm::vec2 ndcMin = glm::vec2(x * 2.0f / TILES_X, y * 2.0f / TILES_Y) - 1.0f;
+				const glm::vec2 ndcMax = glm::vec2((x + 1) * 2.0f / TILES_X, (y + 1) * 2.0f / TILES_Y) - 1.0f;
+				ClusterBounds& bounds = m_bounds[(s * TILES_Y + y) * TILES_X + x];
+				const glm::vec2 min = glm::min(ndcMin * sliceNear, ndcMin * sliceFar) * halfExtents;
+				const glm::vec2 max = glm::max(ndcMax * sliceNear, ndcMax * sliceFar) * halfExtents;
+				bounds.min = glm::vec3(min, -sliceFar);
+				bounds.max = glm::vec3(max, -sliceNear);
+			}
+		}
+	}
+}
+
+void LightClusters::binSlice(int s) {
+	Slice& slice = m_slices[s];
+	slice.indices.clear();
+	slice.overflow = 0;
+	const std::size_t candidateCount = slice.x.size();
+
+	for (int tile = 0; tile < TILES_X * TILES_Y; tile++) {
+		const int index = s * TILES_X * TILES_Y + tile;
+		const ClusterBounds& bounds = m_bounds[index];
+		const std::uint32_t begin = static_cast<std::uint32_t>(slice.indices.size());
+		std::uint32_t count = 0;
+		auto keep = [&](std::size_t candidate) {
+			if (count < MAX_LIGHTS_PER_CLUSTER) {
+				slice.indices.push_back(slice.lights[candidate]);
+				count++;
+			} else {
+				slice.overflow++;
+			}
+		};
+
+		// Sphere against box : squared distance from the center to the box, 0 inside, below the squared radius
+		for (std::size_t i = 0; i < candidateCount; i += SIMD_WIDTH) {
+#if defined(LIGHT_CLUSTERS_AVX2)
+			const __m256 zero = _mm256_setzero_ps();
+			const __m256 x = _mm256_loadu_ps(&slice.x[i]);
+			const __m256 y = _mm256_loadu_ps(&slice.y[i]);
+			const __m256 z = _mm256_loadu_ps(&slice.z[i]);
+			const __m256 dx = _mm256_max_ps(_mm256_max_ps(_mm256_sub_ps(_mm256_set1_ps(bounds.min.x), x), _mm256_sub_ps(x, _mm256_set1_ps(bounds.max.x))), zero);
+			const __m256 dy = _mm256_max_ps(_mm256_max_ps(_mm256_sub_ps(_mm256_set1_ps(bounds.min.y), y), _mm256_sub_ps(y, _mm256_set1_ps(bounds.max.y))), zero);
+			const __m256 dz = _mm256_max_ps(_mm256_max_ps(_mm256_sub_ps(_mm256_set1_ps(bounds.min.z), z), _mm256_sub_ps(z, _mm256_set1_ps(bounds.max.z))), zero);
+			const __m256 distance2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+			int mask = _mm256_movemask_ps(_mm256_cmp_ps(distance2, _mm256_loadu_ps(&slice.radius2[i]), _CMP_LE_OQ));
+#elif defined(LIGHT_CLUSTERS_SSE)
+			const __m128 zero = _mm_setzero_ps();
+			int mask = 0;
+			for (int half = 0; half < SIMD_WIDTH; half += 4) {
+				const __m128 x = _mm_loadu_ps(&slice.x[i + half]);
+				const __m128 y = _mm_loadu_ps(&slice.y[i + half]);
+				const __m128 z = _mm_loadu_ps(&slice.z[i + half]);
+				const __m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_set1_ps(bounds.min.x), x), _mm_sub_ps(x, _mm_set1_ps(bounds.max.x))), zero);
+				const __m128 dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_set1_ps(bounds.min.y), y), _mm_sub_ps(y, _mm_set1_ps(bounds.max.y))), zero);
+				const __m128 dz = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_set1_ps(bounds.min.z), z), _mm_sub_ps(z, _mm_set1_ps(bounds.max.z))), zero);
+				const __m128 distance2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+				mask |= _mm_movemask_ps(_mm_cmple_ps(distance2, _mm_loadu_ps(&slice.radius2[i + half]))) << half;
+			}
+#else
+			int mask = 0;
+			for (int lane = 0; lane < SIMD_WIDTH; lane++) {
+				const glm::vec3 center(slice.x[i + lane], slice.y[i + lane], slice.z[i + lane]);
+				const glm::vec3 d = glm::max(glm::max(bounds.min - center, center - bounds.max), glm::vec3(0.0f));
+				mask |= (glm::dot(d, d) <= slice.radius2[i + lane] ? 1 : 0) << lane;
+			}
+#endif
+			for (int lane = 0; mask != 0; lane++, mask >>= 1) {
+				if (mask & 1) {
+					keep(i + lane);
+				}
+			}
+		}
+
+		m_grid[index] = glm::uvec2(begin, count);
+	}
+}
+
+int LightClusters::sliceOf(float viewDepth) const {
+	const int slice = static_cast<int>(std::floor(std::log(viewDepth) * m_sliceScale + m_sliceBias));
+	return std::min(std::max(slice, 0), SLICES - 1);
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+#include "point-light.h"
+
+class JobSystem;
+
+/**
+ * @brief Clustered forward lighting : lights are binned on the CPU into a 3D grid of the view, fragments only shade the lights of their cluster
+ * @note Clusters are TILES_X x TILES_Y screen tiles, split into SLICES along the view depth with exponential slices.
+ *       Lights are first bucketed by the slices their sphere overlaps, then slices are split across the JobSystem
+ *       and each tile tests 8 (AVX2) or 4 (SSE) lights at a time against its view space bounding box.
+ *       At most MAX_LIGHTS_PER_CLUSTER lights are kept per cluster so that the cost of a fragment is bounded,
+ *       the extra ones are dropped and counted in the metrics. Light indices are 16 bits, so 65535 lights at most.
+ *
+ *       GL 3.3 has no storage buffers, the result goes to buffer textures bound to FIRST_TEXTURE_UNIT and the next two :
+ *       usamplerBuffer uClusterGrid (RG32UI, offset and count per cluster), usamplerBuffer uClusterIndices (R16UI)
+ *       and samplerBuffer uClusterLights (RGBA32F, world position and radius then color times intensity).
+ *       Shaders also declare layout (std140) uniform Clusters { ... }; bound to BLOCK_BINDING, see res/voxel-clustered.frag.
+ *
+ * @code
+ * LightClusters::setupProgram(program); // Once per program
+ * clusters.bin(lights, view, projection);
+ * clusters.upload();
+ * ... draw with the program
+ * @endcode
+ */
+class LightClusters {
+public:
+    static constexpr int TILES_X = 16;
+    static constexpr int TILES_Y = 9;
+    static constexpr int SLICES = 24;
+    static constexpr std::uint32_t MAX_LIGHTS_PER_CLUSTER = 128;
+    static constexpr GLuint BLOCK_BINDING = 2;
+    static constexpr GLuint FIRST_TEXTURE_UNIT = 13;
+
+public:
+    /**
+     * @param width, height - Size of the viewport the fragments are drawn to
+     */
+    LightClusters(JobSystem& jobs, int width, int height);
+    ~LightClusters();
+
+    LightClusters(const LightClusters&) = delete;
+    LightClusters& operator=(const LightClusters&) = delete;
+
+    /**
+     * @brief Point the Clusters block and the buffer textures of the program to the bindings of the LightClusters
+     */
+    static void setupProgram(GLuint program);
+
+    void resize(int width, int height);
+
+    /**
+     * @brief Fill the light list of every cluster, the calling thread must be a JobSystem one
+     * @param lights - In world space
+     * @param projection - Symmetric perspective, like the ones of glm::perspective()
+     */
+    void bin(const std::vector<PointLight>& lights, const glm::mat4& view, const glm::mat4& projection);
+
+    /**
+     * @brief Send the last bin() to the GPU and bind it
+     */
+    void upload();
+
+    /**
+     * @brief Offset and count in indices() of a cluster, after bin()
+     */
+    glm::uvec2 cluster(int x, int y, int slice) const;
+    const std::vector<std::uint16_t>& indices() const;
+    std::uint32_t overflowCount() const;
+
+    void showMetrics();
+
+private:
+    /**
+     * @brief View space bounding boxes of the clusters, when the projection changes
+     */
+    void buildBounds(float tanHalfFovY, float aspect, float nearPlane, float farPlane);
+    void binSlice(int slice);
+    int sliceOf(float viewDepth) const;
+
+private:
+    struct ClusterBounds {
+        glm::vec3 min;
+        glm::vec3 max;
+    };
+
+    /**
+     * @brief Candidate lights of a slice in view space, padded to a multiple of 8 so that SIMD never reads past the end
+     */
+    struct Slice {
+        std::vector<float> x;
+        std::vector<float> y;
+        std::vector<float> z;
+        std::vector<float> radius2;
+        std::vector<std::uint16_t> lights;
+        std::vector<std::uint16_t> indices; // Lists of the tiles of the slice, one after the other
+        std::uint32_t overflow;
+    };
+
+    JobSystem& m_jobs;
+    int m_width;
+    int m_height;
+
+    // ------------------ Projection of the bounds, in slices = log(depth) * m_sliceScale + m_sliceBias
+    float m_tanHalfFovY;
+    float m_aspect;
+    float m_near;
+    float m_far;
+    float m_sliceScale;
+    float m_sliceBias;
+    std::vector<ClusterBounds> m_bounds;
+
+    // ------------------ Last bin
+    std::vector<Slice> m_slices;
+    std::vector<glm::uvec2> m_grid;
+    std::vector<std::uint16_t> m_indices;
+    std::vector<glm::vec4> m_lightData; // Two texels per light
+    std::uint32_t m_overflowCount;
+    std::uint32_t m_maxCount;
+    double m_binMs;
+
+    // ------------------ GPU copy, created on the first upload()
+    GLuint m_blockBuffer;
+    GLuint m_buffers[3];
+    GLuint m_textures[3];
+    std::size_t m_uploadedBytes;
+};
@@ -0,0 +1,305 @@
+#include "material.h"
+
+#include "gl-exception.h"
+#include "command-buffer.h"
+#include <spdlog/spdlog.h>
+#include <imgui.h>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+	std::uint32_t alignUp(std::uint32_t value, std::uint32_t alignment) {
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	// Arrays and matrices have every element aligned on a vec4
+	std::uint32_t arrayStride(MaterialLayout::Type type) {
+		return alignUp(MaterialLayout::typeSize(type), 16);
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+////////////////////////////////// LAYOUT ///////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+MaterialLayout::MaterialLayout() : m_size(0) {}
+
+MaterialLayout& MaterialLayout::add(const std::string& name, Type type, std::uint32_t arraySize) {
+	assert(find(name) == nullptr && "Material parameter already exists !");
+	const std::uint32_t alignment = arraySize > 0 ? 16 : typeAlignment(type);
+	const std::uint32_t size = arraySize > 0 ? arrayStride(type) * arraySize : typeSize(type);
+
+	const std::uint32_t offset = alignUp(m_size, alignment);
+	m_params.push_back({ name, type, offset, arraySize });
+	m_size = offset + size;
+	return *this;
+}
+
+const MaterialLayout::Param* MaterialLayout::find(const std::string& name) const {
+	for (const Param& param : m_params) {
+		if (param.name == name) {
+			return &param;
+		}
+	}
+	return nullptr;
+}
+
+const std::vector<MaterialLayout::Param>& MaterialLayout::params() const { return m_params; }
+std::uint32_t MaterialLayout::size() const { return alignUp(std::max(m_size, 1u), 16); }
+
+std::uint32_t MaterialLayout::typeSize(Type type) {
+	switch (type) {
+	case Type::FLOAT: return 4;
+	case Type::VEC2: return 8;
+	case Type::VEC3: return 12;
+	case Type::VEC4: return 16;
+	default: return 64;
+	}
+}
+
+std::uint32_t MaterialLayout::typeAlignment(Type type) {
+	switch (type) {
+	case Type::FLOAT: return 4;
+	case Type::VEC2: return 8;
+	default: return 16;
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+///////////////////////////////// MATERIAL //////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+Material::Material(MaterialLibrary& library, std::uint16_t id, const std::string& name, GLuint program, const MaterialLayout& layout,
+                   std::size_t page, std::uint32_t offset)
+	: m_library(library), m_id(id), m_name(name), m_program(program), m_layout(layout), m_page(page), m_offset(offset)
+{}
+
+void Material::set(const std::string& name, float value, std::uint32_t index) {
+	write(name, MaterialLayout::Type::FLOAT, &value, index);
+}
+
+void Material::set(const std::string& name, const glm::vec2& value, std::uint32_t index) {
+	write(name, MaterialLayout::Type::VEC2, &value[0], index);
+}
+
+void Material::set(const std::string& name, const glm::vec3& value, std::uint32_t index) {
+	write(name, MaterialLayout::Type::VEC3, &value[0], index);
+}
+
+void Material::set(const std::string& name, const glm::vec4& value, std::uint32_t index) {
+	write(name, MaterialLayout::Type::VEC4, &value[0], index);
+}
+
+void Material::set(const std::string& name, const glm::mat4& value, std::uint32_t index) {
+	write(name, MaterialLayout::Type::MAT4, &value[0][0], index);
+}
+
+void Material::setTexture(unsigned int slot, const char* samplerName, GLenum target, GLuint texture) {
+	assert(slot < MAX_TEXTURES && "Material texture slot out of range !");
+	m_textures[slot].target = target;
+	m_textures[slot].texture = texture;
+
+	GLCall(GLint location = glGetUniformLocation(m_program, samplerName));
+	if (location == -1) {
+		spdlog::warn("[Material] '{}' : sampler {} is not used by the pipeline", m_name, samplerName);
+		return;
+	}
+
+	GLint previousProgram = 0;
+	GLCall(glGetIntegerv(GL_CURRENT_PROGRAM, &previousProgram));
+	GLCall(glUseProgram(m_program));
+	GLCall(glUniform1i(location, static_cast<GLint>(slot)));
+	GLCall(glUseProgram(previousProgram));
+}
+
+void Material::bind() const {
+	const MaterialLibrary::Page& page = m_library.m_pages[m_page];
+	GLCall(glBindBufferRange(GL_UNIFORM_BUFFER, MaterialLibrary::BLOCK_BINDING, page.buffer, m_offset, m_layout.size()));
+	for (unsigned int slot = 0; slot < MAX_TEXTURES; slot++) {
+		if (m_textures[slot].texture != 0) {
+			GLCall(glActiveTexture(GL_TEXTURE0 + slot));
+			GLCall(glBindTexture(m_textures[slot].target, m_textures[slot].texture));
+		}
+	}
+}
+
+void Material::bind(CommandBuffer& commands) const {
+	const MaterialLibrary::Page& page = m_library.m_pages[m_page];
+	commands.bindUniformRange(MaterialLibrary::BLOCK_BINDING, page.buffer, m_offset, m_layout.size());
+	for (unsigned int slot = 0; slot < MAX_TEXTURES; slot++) {
+		if (m_textures[slot].texture != 0) {
+			commands.bindTexture(slot, m_textures[slot].target, m_textures[slot].texture);
+		}
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//////////////////////////// GETTERS & SETTERS //////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+std::uint16_t Material::id() const { return m_id; }
+GLuint Material::program() const { return m_program; }
+const std::string& Material::name() const { return m_name; }
+const MaterialLayout& Material::layout() const { return m_layout; }
+
+/////////////////////////////////////////////////////////////////////////////
+///////////////////////////// PRIVATE METHODS ///////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+void Material::write(const std::string& name, MaterialLayout::Type type, const void* value, std::uint32_t index) {
+	const MaterialLayout::Param* param = m_layout.find(name);
+	if (param == nullptr) {
+		spdlog::warn("[Material] '{}' has no parameter {}", m_name, name);
+		return;
+	}
+	assert(param->type == type && "Material parameter written with the wrong type !");
+	assert(index < std::max(param->arraySize, 1u) && "Material parameter index out of range !");
+
+	const std::uint32_t offset = m_offset + param->offset + index * arrayStride(type);
+	const std::uint32_t size = MaterialLayout::typeSize(type);
+	std::memcpy(m_library.m_pages[m_page].data.data() + offset, value, size);
+	m_library.markDirty(m_page, offset, offset + size);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+////////////////////////////////// LIBRARY //////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+MaterialLibrary::MaterialLibrary() : m_uploadedBytes(0) {
+	GLint offsetAlignment = 0, maxBlockSize = 0;
+	GLCall(glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &offsetAlignment));
+	GLCall(glGetIntegerv(GL_MAX_UNIFORM_BLOCK_SIZE, &maxBlockSize));
+	m_offsetAlignment = static_cast<std::size_t>(std::max(offsetAlignment, 16));
+	m_maxBlockSize = static_cast<std::size_t>(maxBlockSize);
+}
+
+MaterialLibrary::~MaterialLibrary() {
+	for (const Page& page : m_pages) {
+		GLCall(glDeleteBuffers(1, &page.buffer));
+	}
+}
+
+Material& MaterialLibrary::create(const std::string& name, GLuint program, const MaterialLayout& layout) {
+	assert(m_materials.size() < UINT16_MAX && "Too many materials for sort keys !");
+	assert(layout.size() <= m_maxBlockSize && "Material block is bigger than GL_MAX_UNIFORM_BLOCK_SIZE !");
+
+	// ------------------ Range in the first page with enough room
+	std::size_t pageIndex = 0;
+	std::size_t offset = 0;
+	for (; pageIndex < m_pages.size(); pageIndex++) {
+		offset = (m_pages[pageIndex].used + m_offsetAlignment - 1) / m_offsetAlignment * m_offsetAlignment;
+		if (offset + layout.size() <= PAGE_SIZE) {
+			break;
+		}
+	}
+	if (pageIndex == m_pages.size()) {
+		Page page;
+		GLCall(glGenBuffers(1, &page.buffer));
+		GLCall(glBindBuffer(GL_UNIFORM_BUFFER, page.buffer));
+		GLCall(glBufferData(GL_UNIFORM_BUFFER, PAGE_SIZE, nullptr, GL_DYNAMIC_DRAW));
+		GLCall(glBindBuffer(GL_UNIFORM_BUFFER, 0));
+		page.data.assign(PAGE_SIZE, 0);
+		page.used = 0;
+		page.dirtyBegin = PAGE_SIZE;
+		page.dirtyEnd = 0;
+		m_pages.push_back(std::move(page));
+		offset = 0;
+	}
+	m_pages[pageIndex].used = offset + layout.size();
+	markDirty(pageIndex, offset, offset + layout.size());
+
+	// ------------------ Point the block of the pipeline to the shared binding
+	GLCall(GLuint blockIndex = glGetUniformBlockIndex(program, "Material"));
+	if (blockIndex == GL_INVALID_INDEX) {
+		spdlog::warn("[Material] '{}' : pipeline has no Material uniform block", name);
+	} else {
+		GLCall(glUniformBlockBinding(program, blockIndex, BLOCK_BINDING));
+		GLint blockSize = 0;
+		GLCall(glGetActiveUniformBlockiv(program, blockIndex, GL_UNIFORM_BLOCK_DATA_SIZE, &blockSize));
+		if (static_cast<std::uint32_t>(blockSize) > layout.size()) {
+			spdlog::warn("[Material] '{}' : layout is {} bytes but the shader block needs {} bytes", name, layout.size(), blockSize);
+		}
+	}
+
+	const std::uint16_t id = static_cast<std::uint16_t>(m_materials.size() + 1);
+	m_materials.emplace_back(new Material(*this, id, name, program, layout, pageIndex, static_cast<std::uint32_t>(offset)));
+	return *m_materials.back();
+}
+
+Material* MaterialLibrary::find(const std::string& name) const {
+	for (const auto& material : m_materials) {
+		if (material->name() == name) {
+			return material.get();
+		}
+	}
+	return nullptr;
+}
+
+void MaterialLibrary::upload() {
+	m_uploadedBytes = 0;
+	for (Page& page : m_pages) {
+		if (page.dirtyBegin >= page.dirtyEnd) {
+			continue;
+		}
+		GLCall(glBindBuffer(GL_UNIFORM_BUFFER, page.buffer));
+		GLCall(glBufferSubData(GL_UNIFORM_BUFFER, page.dirtyBegin, page.dirtyEnd - page.dirtyBegin, page.data.data() + page.dirtyBegin));
+		m_uploadedBytes += page.dirtyEnd - page.dirtyBegin;
+		page.dirtyBegin = PAGE_SIZE;
+		page.dirtyEnd = 0;
+	}
+	GLCall(glBindBuffer(GL_UNIFORM_BUFFER, 0));
+}
+
+void MaterialLibrary::showMetrics() {
+	std::size_t usedBytes = 0;
+	for (const Page& page : m_pages) {
+		usedBytes += page.used;
+	}
+
+	ImGui::Begin("Materials");
+	ImGui::Text("%zu materials in %zu uniform buffers, %zu / %zu KB used", m_materials.size(), m_pages.size(), usedBytes / 1024, m_pages.size() * PAGE_SIZE / 1024);
+	ImGui::Text("Range alignment : %zu bytes, uploaded last frame : %zu bytes", m_offsetAlignment, m_uploadedBytes);
+	for (const auto& material : m_materials) {
+		if (!ImGui::TreeNode(material->name().c_str())) {
+			continue;
+		}
+		editParams(*material);
+		ImGui::TreePop();
+	}
+	ImGui::End();
+}
+
+std::size_t MaterialLibrary::materialCount() const { return m_materials.size(); }
+
+/////////////////////////////////////////////////////////////////////////////
+///////////////////////////// PRIVATE METHODS ///////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+void MaterialLibrary::markDirty(std::size_t page, std::size_t begin, std::size_t end) {
+	m_pages[page].dirtyBegin = std::min(m_pages[page].dirtyBegin, begin);
+	m_pages[page].dirtyEnd = std::max(m_pages[page].dirtyEnd, end);
+}
+
+void MaterialLibrary::editParams(Material& material) {
+	ImGui::Text("Range : buffer %u, offset %u, %u bytes", m_pages[material.m_page].buffer, material.m_offset, material.layout().size());
+	for (const MaterialLayout::Param& param : material.layout().params()) {
+		const std::uint32_t count = std::max(param.arraySize, 1u);
+		for (std::uint32_t i = 0; i < count; i++) {
+			const std::uint32_t offset = material.m_offset + param.offset + i * arrayStride(param.type);
+			float* value = reinterpret_cast<float*>(m_pages[material.m_page].data.data() + offset);
+			const std::string label = param.arraySize > 0 ? param.name + "[" + std::to_string(i) + "]" : param.name;
+
+			bool changed = false;
+			switch (param.type) {
+			case MaterialLayout::Type::FLOAT: changed = ImGui::DragFloat(label.c_str(), value, 0.01f); break;
+			case MaterialLayout::Type::VEC2: changed = ImGui::DragFloat2(label.c_str(), value, 0.01f); break;
+			case MaterialLayout::Type::VEC3: changed = ImGui::DragFloat3(label.c_str(), value, 0.01f); break;
+			case MaterialLayout::Type::VEC4: changed = ImGui::DragFloat4(label.c_str(), value, 0.01f); break;
+			default: ImGui::Text("%s : mat4", label.c_str()); break;
+			}
+			if (changed) {
+				markDirty(material.m_page, offset, offset + MaterialLayout::typeSize(param.type));
+			}
+		}
+	}
+}
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+class CommandBuffer;
+class MaterialLibrary;
+
+/**
+ * @brief Parameters of a material, with the std140 layout of its "Material" uniform block
+ * @note Parameters must be added in the order they are declared in the shader
+ *
+ * @code
+ * // layout (std140) uniform Material { vec4 uTint; float uRoughness; };
+ * MaterialLayout layout;
+ * layout.add("uTint", MaterialLayout::Type::VEC4).add("uRoughness", MaterialLayout::Type::FLOAT);
+ * @endcode
+ */
+class MaterialLayout {
+public:
+    enum class Type : std::uint8_t {
+        FLOAT, VEC2, VEC3, VEC4, MAT4
+    };
+
+    struct Param {
+        std::string name;
+        Type type;
+        std::uint32_t offset;
+        std::uint32_t arraySize; // 0 when not an array
+    };
+
+public:
+    MaterialLayout();
+    ~MaterialLayout() = default;
+
+    MaterialLayout& add(const std::string& name, Type type, std::uint32_t arraySize = 0);
+
+    const Param* find(const std::string& name) const;
+    const std::vector<Param>& params() const;
+
+    /**
+     * @brief Size of the whole block, rounded up to a vec4 like std140 does
+     */
+    std::uint32_t size() const;
+
+    static std::uint32_t typeSize(Type type);
+
+private:
+    static std::uint32_t typeAlignment(Type type);
+
+private:
+    std::vector<Param> m_params;
+    std::uint32_t m_size;
+};
+
+/**
+ * @brief Pipeline, parameter block and textures used by a draw
+ * @note Parameters live in the uniform buffers of the MaterialLibrary, bind() is one glBindBufferRange
+ *       plus the textures, whatever the number of parameters.
+ */
+class Material {
+public:
+    static constexpr unsigned int MAX_TEXTURES = 4;
+
+public:
+    ~Material() = default;
+
+    Material(const Material&) = delete;
+    Material& operator=(const Material&) = delete;
+
+    /**
+     * @brief Write a parameter, uploaded with the next MaterialLibrary::upload()
+     */
+    void set(const std::string& name, float value, std::uint32_t index = 0);
+    void set(const std::string& name, const glm::vec2& value, std::uint32_t index = 0);
+    void set(const std::string& name, const glm::vec3& value, std::uint32_t index = 0);
+    void set(const std::string& name, const glm::vec4& value, std::uint32_t index = 0);
+    void set(const std::string& name, const glm::mat4& value, std::uint32_t index = 0);
+
+    /**
+     * @brief Bind texture on slot when the material is bound, the sampler uniform is pointed to slot
+     * @note Must be called on the OpenGL thread
+     */
+    void setTexture(unsigned int slot, const char* samplerName, GLenum target, GLuint texture);
+
+    /**
+     * @brief Bind the parameter range and the textures, the pipeline is not bound
+     */
+    void bind() const;
+    void bind(CommandBuffer& commands) const;
+
+    /**
+     * @brief Non zero identifier, small enough for sort keys
+     */
+    std::uint16_t id() const;
+    GLuint program() const;
+    const std::string& name() const;
+    const MaterialLayout& layout() const;
+
+private:
+    friend class MaterialLibrary;
+
+    struct TextureBinding {
+        GLenum target = GL_TEXTURE_2D;
+        GLuint texture = 0;
+    };
+
+    Material(MaterialLibrary& library, std::uint16_t id, const std::string& name, GLuint program, const MaterialLayout& layout,
+             std::size_t page, std::uint32_t offset);
+
+    void write(const std::string& name, MaterialLayout::Type type, const void* value, std::uint32_t index);
+
+private:
+    MaterialLibrary& m_library;
+    std::uint16_t m_id;
+    std::string m_name;
+    GLuint m_program;
+    MaterialLayout m_layout;
+    std::size_t m_page;
+    std::uint32_t m_offset;
+    TextureBinding m_textures[MAX_TEXTURES];
+};
+
+/**
+ * @brief Owns every Material and packs their parameters in a few large uniform buffers
+ * @note Each material gets a range aligned to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT in a page of PAGE_SIZE bytes.
+ *       Parameters are written on the CPU copy, upload() sends the modified bytes of each page once per frame.
+ *
+ * Shaders declare : layout (std140) uniform Material { ... }; which is bound to BLOCK_BINDING.
+ */
+class MaterialLibrary {
+public:
+    static constexpr GLuint BLOCK_BINDING = 1;
+    static constexpr std::size_t PAGE_SIZE = 64 * 1024;
+
+public:
+    MaterialLibrary();
+    ~MaterialLibrary();
+
+    MaterialLibrary(const MaterialLibrary&) = delete;
+    MaterialLibrary& operator=(const MaterialLibrary&) = delete;
+
+    /**
+     * @brief Must be called on the OpenGL thread, parameters start at zero
+     */
+    Material& create(const std::string& name, GLuint program, const MaterialLayout& layout);
+    Material* find(const std::string& name) const;
+
+    /**
+     * @brief Upload parameters written since the last call, must be called on the OpenGL thread before drawing
+     */
+    void upload();
+
+    void showMetrics();
+
+    std::size_t materialCount() const;
+
+private:
+    friend class Material;
+
+    struct Page {
+        GLuint buffer;
+        std::vector<unsigned char> data;
+        std::size_t used;
+        std::size_t dirtyBegin;
+        std::size_t dirtyEnd;
+    };
+
+    void markDirty(std::size_t page, std::size_t begin, std::size_t end);
+    void editParams(Material& material);
+
+private:
+    std::vector<Page> m_pages;
+    std::vector<std::unique_ptr<Material>> m_materials;
+    std::size_t m_offsetAlignment;
+    std::size_t m_maxBlockSize;
+    std::size_t m_uploadedBytes;
+};
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "asset-pack.h"
+
+/**
+ * @brief Indexed triangle list with interleaved vertices
+ * @note Same layout as assetPack meshes, so it goes to AssetPackWriter::addMesh or to the GPU without conversion
+ */
+struct MeshData {
+    std::vector<assetPack::Vertex> vertices;
+    std::vector<std::uint32_t> indices;
+
+    std::size_t triangleCount() const { return indices.size() / 3; }
+};
@@ -0,0 +1,995 @@
+#include "mesh-importer.h"
+
+#include "job-system.h"
+#include <spdlog/spdlog.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+namespace {
+	using Clock = std::chrono::high_resolution_clock;
+
+	double elapsedMs(Clock::time_point start) {
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	}
+
+	template<typename F>
+	void parallelFor(JobSystem& jobs, std::uint32_t count, std::uint32_t grainSize, const F& function) {
+		Job* root = jobs.parallelFor(0, count, std::max(grainSize, 1u), function);
+		jobs.run(root);
+		jobs.wait(root);
+	}
+
+	// Keeps the number of jobs far from JobSystem::MAX_JOBS_PER_THREAD
+	std::uint32_t grainFor(std::size_t count, JobSystem& jobs) {
+		return static_cast<std::uint32_t>(std::max<std::size_t>(1024, count / (jobs.threadCount() * 16) + 1));
+	}
+
+	bool readFile(const std::string& filepath, std::vector<char>& content) {
+		std::ifstream stream(filepath, std::ios::binary | std::ios::ate);
+		if (!stream.is_open()) {
+			spdlog::warn("Failed to open file : |{}|", filepath);
+			return false;
+		}
+		content.resize(static_cast<std::size_t>(stream.tellg()));
+		stream.seekg(0);
+		stream.read(content.data(), static_cast<std::streamsize>(content.size()));
+		return stream.good();
+	}
+
+	/////////////////////////////////////////////////////////////////////////////
+	//////////////////////////////////// OBJ ////////////////////////////////////
+	/////////////////////////////////////////////////////////////////////////////
+
+	const std::int32_t MISSING = INT32_MIN;
+
+	// Indices of a face corner, 0 based
+	struct Corner {
+		std::int32_t v, vt, vn;
+	};
+
+	// Relative (negative) indices are only known from the start of the chunk until chunks are merged
+	enum RelativeFlag : std::uint8_t {
+		RELATIVE_V = 1,
+		RELATIVE_VT = 2,
+		RELATIVE_VN = 4
+	};
+
+	struct ObjChunk {
+		const char* begin;
+		const char* end;
+		std::vector<float> positions;
+		std::vector<float> texCoords;
+		std::vector<float> normals;
+		std::vector<Corner> corners; // 3 per triangle
+		std::vector<std::uint8_t> relativeFlags; // One per corner
+		std::size_t cornerBase = 0;
+		std::int32_t positionBase = 0;
+		std::int32_t texCoordBase = 0;
+		std::int32_t normalBase = 0;
+	};
+
+	inline bool isSpace(char c) { return c == ' ' || c == '\t'; }
+	inline bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+	inline const char* skipSpaces(const char* p, const char* end) {
+		while (p < end && isSpace(*p)) { p++; }
+		return p;
+	}
+
+	inline const char* skipLine(const char* p, const char* end) {
+		while (p < end && *p != '\n') { p++; }
+		return p < end ? p + 1 : end;
+	}
+
+	// Much faster than strtod, which also depends on the locale and may read past end
+	const char* parseDouble(const char* p, const char* end, double& value) {
+		static const double powers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18 };
+
+		p = skipSpaces(p, end);
+		bool negative = false;
+		if (p < end && (*p == '-' || *p == '+')) {
+			negative = *p == '-';
+			p++;
+		}
+
+		double mantissa = 0.0;
+		int exponent = 0;
+		while (p < end && isDigit(*p)) {
+			mantissa = mantissa * 10.0 + (*p++ - '0');
+		}
+		if (p < end && *p == '.') {
+			p++;
+			while (p < end && isDigit(*p)) {
+				mantissa = mantissa * 10.0 + (*p++ - '0');
+				exponent--;
+			}
+		}
+		if (p < end && (*p == 'e' || *p == 'E')) {
+			p++;
+			bool negativeExponent = false;
+			if (p < end && (*p == '-' || *p == '+')) {
+				negativeExponent = *p == '-';
+				p++;
+			}
+			int e = 0;
+			while (p < end && isDigit(*p)) {
+				e = e * 10 + (*p++ - '0');
+			}
+			exponent += negativeExponent ? -e : e;
+		}
+
+		const int absExponent = std::abs(exponent);
+		const double scale = absExponent < static_cast<int>(std::size(powers)) ? powers[absExponent] : std::pow(10.0, absExponent);
+		const double result = exponent < 0 ? mantissa / scale : mantissa * scale;
+		value = negative ? -result : result;
+		return p;
+	}
+
+	const char* parseFloat(const char* p, const char* end, float& value) {
+		double result;
+		p = parseDouble(p, end, result);
+		value = static_cast<float>(result);
+		return p;
+	}
+
+	const char* parseInt(const char* p, const char* end, std::int32_t& value) {
+		bool negative = false;
+		if (p < end && (*p == '-' || *p == '+')) {
+			negative = *p == '-';
+			p++;
+		}
+		std::int32_t result = 0;
+		while (p < end && isDigit(*p)) {
+			result = result * 10 + (*p++ - '0');
+		}
+		value = negative ? -result : result;
+		return p;
+	}
+
+	// Absolute indices are 1 based, relative ones count back from the last element
+	inline std::int32_t resolveIndex(std::int32_t index, std::size_t localCount, std::uint8_t flag, std::uint8_t& flags) {
+		if (index > 0) {
+			return index - 1;
+		} else if (index < 0) {
+			flags |= flag;
+			return static_cast<std::int32_t>(localCount) + index;
+		}
+		return MISSING;
+	}
+
+	void parseObjChunk(ObjChunk& chunk) {
+		const char* p = chunk.begin;
+		const char* end = chunk.end;
+		std::vector<Corner> polygon;
+		std::vector<std::uint8_t> polygonFlags;
+
+		while (p < end) {
+			p = skipSpaces(p, end);
+			if (p + 1 >= end) {
+				break;
+			}
+
+			if (p[0] == 'v' && isSpace(p[1])) {
+				float x, y, z;
+				p = parseFloat(p + 1, end, x);
+				p = parseFloat(p, end, y);
+				p = parseFloat(p, end, z);
+				chunk.positions.insert(chunk.positions.end(), { x, y, z });
+			} else if (p[0] == 'v' && p[1] == 't') {
+				float u, v = 0.0f;
+				p = skipSpaces(parseFloat(p + 2, end, u), end);
+				if (p < end && (isDigit(*p) || *p == '-' || *p == '+' || *p == '.')) {
+					p = parseFloat(p, end, v);
+				}
+				chunk.texCoords.insert(chunk.texCoords.end(), { u, v });
+			} else if (p[0] == 'v' && p[1] == 'n') {
+				float x, y, z;
+				p = parseFloat(p + 2, end, x);
+				p = parseFloat(p, end, y);
+				p = parseFloat(p, end, z);
+				chunk.normals.insert(chunk.normals.end(), { x, y, z });
+			} else if (p[0] == 'f' && isSpace(p[1])) {
+				polygon.clear();
+				polygonFlags.clear();
+				p++;
+				while (true) {
+					p = skipSpaces(p, end);
+					if (p >= end || !(isDigit(*p) || *p == '-' || *p == '+')) {
+						break;
+					}
+
+					std::int32_t v = 0, vt = 0, vn = 0;
+					p = parseInt(p, end, v);
+					if (p < end && *p == '/') {
+						p++;
+						if (p < end && *p != '/') {
+							p = parseInt(p, end, vt);
+						}
+						if (p < end && *p == '/') {
+							p = parseInt(p + 1, end, vn);
+						}
+					}
+
+					std::uint8_t flags = 0;
+					Corner corner;
+					corner.v = resolveIndex(v, chunk.positions.size() / 3, RELATIVE_V, flags);
+					corner.vt = resolveIndex(vt, chunk.texCoords.size() / 2, RELATIVE_VT, flags);
+					corner.vn = resolveIndex(vn, chunk.normals.size() / 3, RELATIVE_VN, flags);
+					polygon.push_back(corner);
+					polygonFlags.push_back(flags);
+				}
+
+				// Fan triangulation, fine for the convex polygons exporters write
+				for (std::size_t i = 2; i < polygon.size(); i++) {
+					chunk.corners.insert(chunk.corners.end(), { polygon[0], polygon[i - 1], polygon[i] });
+					chunk.relativeFlags.insert(chunk.relativeFlags.end(), { polygonFlags[0], polygonFlags[i - 1], polygonFlags[i] });
+				}
+			}
+
+			p = skipLine(p, end);
+		}
+	}
+
+	std::uint32_t hashCorner(const Corner& corner) {
+		std::uint64_t key = static_cast<std::uint32_t>(corner.v) * 0x9E3779B97F4A7C15ull;
+		key ^= static_cast<std::uint32_t>(corner.vt) * 0xC2B2AE3D27D4EB4Full;
+		key ^= static_cast<std::uint32_t>(corner.vn) * 0x165667B19E3779F9ull;
+		key ^= key >> 29;
+		key *= 0xBF58476D1CE4E5B9ull;
+		key ^= key >> 32;
+		return static_cast<std::uint32_t>(key);
+	}
+
+	inline bool operator==(const Corner& a, const Corner& b) {
+		return a.v == b.v && a.vt == b.vt && a.vn == b.vn;
+	}
+
+	// Smooth normals for the triangles from firstIndex, which only use vertices from firstVertex
+	void generateNormals(MeshData& mesh, std::size_t firstVertex, std::size_t firstIndex) {
+		std::vector<glm::vec3> normals(mesh.vertices.size() - firstVertex, glm::vec3(0.0f));
+		for (std::size_t i = firstIndex; i + 2 < mesh.indices.size(); i += 3) {
+			const glm::vec3 a = glm::make_vec3(mesh.vertices[mesh.indices[i]].position);
+			const glm::vec3 b = glm::make_vec3(mesh.vertices[mesh.indices[i + 1]].position);
+			const glm::vec3 c = glm::make_vec3(mesh.vertices[mesh.indices[i + 2]].position);
+			// Not normalized, so that bigger triangles weight more
+			const glm::vec3 faceNormal = glm::cross(b - a, c - a);
+			normals[mesh.indices[i] - firstVertex] += faceNormal;
+			normals[mesh.indices[i + 1] - firstVertex] += faceNormal;
+			normals[mesh.indices[i + 2] - firstVertex] += faceNormal;
+		}
+		for (std::size_t i = 0; i < normals.size(); i++) {
+			const float length = glm::length(normals[i]);
+			const glm::vec3 normal = length > 0.0f ? normals[i] / length : glm::vec3(0, 1, 0);
+			std::memcpy(mesh.vertices[firstVertex + i].normal, glm::value_ptr(normal), sizeof(mesh.vertices[i].normal));
+		}
+	}
+
+	/////////////////////////////////////////////////////////////////////////////
+	/////////////////////////////////// JSON ////////////////////////////////////
+	/////////////////////////////////////////////////////////////////////////////
+
+	// Just enough JSON for glTF
+	struct Json {
+		enum class Type { NUL, BOOLEAN, NUMBER, STRING, ARRAY, OBJECT };
+
+		Type type = Type::NUL;
+		bool boolean = false;
+		double number = 0.0;
+		std::string string;
+		std::vector<Json> array;
+		std::vector<std::pair<std::string, Json>> object;
+
+		const Json& operator[](const char* key) const {
+			for (const auto& member : object) {
+				if (member.first == key) {
+					return member.second;
+				}
+			}
+			return null();
+		}
+
+		const Json& at(std::size_t index) const {
+			return index < array.size() ? array[index] : null();
+		}
+
+		bool isNull() const { return type == Type::NUL; }
+		double numberOr(double fallback) const { return type == Type::NUMBER ? number : fallback; }
+		std::size_t indexOr(std::size_t fallback) const { return type == Type::NUMBER ? static_cast<std::size_t>(number) : fallback; }
+
+		static const Json& null() {
+			static const Json value;
+			return value;
+		}
+	};
+
+	class JsonParser {
+	public:
+		JsonParser(const char* begin, const char* end) : m_p(begin), m_end(end), m_failed(false) {}
+
+		bool parse(Json& value) {
+			parseValue(value, 0);
+			skipWhitespaces();
+			return !m_failed;
+		}
+
+	private:
+		void skipWhitespaces() {
+			while (m_p < m_end && (*m_p == ' ' || *m_p == '\t' || *m_p == '\n' || *m_p == '\r')) { m_p++; }
+		}
+
+		bool expect(char c) {
+			skipWhitespaces();
+			if (m_p < m_end && *m_p == c) {
+				m_p++;
+				return true;
+			}
+			m_failed = true;
+			return false;
+		}
+
+		bool matchWord(const char* word) {
+			const std::size_t length = std::strlen(word);
+			if (static_cast<std::size_t>(m_end - m_p) >= length && std::strncmp(m_p, word, length) == 0) {
+				m_p += length;
+				return true;
+			}
+			m_failed = true;
+			return false;
+		}
+
+		void parseValue(Json& value, int depth) {
+			skipWhitespaces();
+			if (m_failed || m_p >= m_end || depth > 64) {
+				m_failed = true;
+				return;
+			}
+
+			switch (*m_p) {
+			case '{':
+				value.type = Json::Type::OBJECT;
+				m_p++;
+				skipWhitespaces();
+				if (m_p < m_end && *m_p == '}') { m_p++; return; }
+				do {
+					std::string key;
+					skipWhitespaces();
+					parseString(key);
+					if (!expect(':')) { return; }
+					value.object.emplace_back(std::move(key), Json());
+					parseValue(value.object.back().second, depth + 1);
+					skipWhitespaces();
+				} while (!m_failed && m_p < m_end && *m_p == ',' && ++m_p);
+				expect('}');
+				return;
+
+			case '[':
+				value.type = Json::Type::ARRAY;
+				m_p++;
+				skipWhitespaces();
+				if (m_p < m_end && *m_p == ']') { m_p++; return; }
+				do {
+					value.array.emplace_back();
+					parseValue(value.array.back(), depth + 1);
+					skipWhitespaces();
+				} while (!m_failed && m_p < m_end && *m_p == ',' && ++m_p);
+				expect(']');
+				return;
+
+			case '"':
+				value.type = Json::Type::STRING;
+				parseString(value.string);
+				return;
+
+			case 't':
+				value.type = Json::Type::BOOLEAN;
+				value.boolean = matchWord("true");
+				return;
+
+			case 'f':
+				value.type = Json::Type::BOOLEAN;
+				matchWord("false");
+				return;
+
+			case 'n':
+				matchWord("null");
+				return;
+
+			default: {
+				value.type = Json::Type::NUMBER;
+				// Integers are exact up to 2^53, enough for any byte offset
+				const char* digits = m_p < m_end && *m_p == '-' ? m_p + 1 : m_p;
+				if (digits >= m_end || !isDigit(*digits)) {
+					m_failed = true;
+					return;
+				}
+				m_p = parseDouble(m_p, m_end, value.number);
+				return;
+			}
+			}
+		}
+
+		void parseString(std::string& result) {
+			if (!expect('"')) { return; }
+			while (m_p < m_end && *m_p != '"') {
+				if (*m_p != '\\') {
+					result += *m_p++;
+					continue;
+				}
+
+				if (++m_p >= m_end) { break; }
+				const char escaped = *m_p++;
+				switch (escaped) {
+				case 'b': result += '\b'; break;
+				case 'f': result += '\f'; break;
+				case 'n': result += '\n'; break;
+				case 'r': result += '\r'; break;
+				case 't': result += '\t'; break;
+				case 'u': {
+					if (m_end - m_p < 4) { m_failed = true; return; }
+					const unsigned int code = static_cast<unsigned int>(std::strtoul(std::string(m_p, 4).c_str(), nullptr, 16));
+					m_p += 4;
+					// UTF-8, surrogate pairs are not needed for the names glTF uses
+					if (code < 0x80) {
+						result += static_cast<char>(code);
+					} else if (code < 0x800) {
+						result += static_cast<char>(0xC0 | (code >> 6));
+						result += static_cast<char>(0x80 | (code & 0x3F));
+					} else {
+						result += static_cast<char>(0xE0 | (code >> 12));
+						result += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+						result += static_cast<char>(0x80 | (code & 0x3F));
+					}
+					break;
+				}
+				default: result += escaped; break;
+				}
+			}
+			expect('"');
+		}
+
+	private:
+		const char* m_p;
+		const char* m_end;
+		bool m_failed;
+	};
+
+	/////////////////////////////////////////////////////////////////////////////
+	/////////////////////////////////// GLTF ////////////////////////////////////
+	/////////////////////////////////////////////////////////////////////////////
+
+	const std::uint32_t GLB_MAGIC = 0x46546C67; // "glTF"
+	const std::uint32_t GLB_CHUNK_JSON = 0x4E4F534A;
+	const std::uint32_t GLB_CHUNK_BIN = 0x004E4942;
+
+	const int COMPONENT_UNSIGNED_BYTE = 5121;
+	const int COMPONENT_UNSIGNED_SHORT = 5123;
+	const int COMPONENT_UNSIGNED_INT = 5125;
+	const int COMPONENT_FLOAT = 5126;
+	const int MODE_TRIANGLES = 4;
+
+	bool decodeBase64(const std::string& text, std::size_t begin, std::vector<std::uint8_t>& result) {
+		auto decode = [](char c) -> int {
+			if (c >= 'A' && c <= 'Z') return c - 'A';
+			if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+			if (c >= '0' && c <= '9') return c - '0' + 52;
+			if (c == '+') return 62;
+			if (c == '/') return 63;
+			return -1;
+		};
+
+		std::uint32_t bits = 0;
+		int bitCount = 0;
+		for (std::size_t i = begin; i < text.size() && text[i] != '='; i++) {
+			const int value = decode(text[i]);
+			if (value < 0) {
+				return false;
+			}
+			bits = (bits << 6) | static_cast<std::uint32_t>(value);
+			bitCount += 6;
+			if (bitCount >= 8) {
+				bitCount -= 8;
+				result.push_back(static_cast<std::uint8_t>(bits >> bitCount));
+			}
+		}
+		return true;
+	}
+
+	// Typed view of an accessor, elements are read as float or uint32
+	struct Accessor {
+		const std::uint8_t* data = nullptr;
+		std::size_t count = 0;
+		std::size_t stride = 0;
+		int componentType = 0;
+		int componentCount = 0;
+
+		float readFloat(std::size_t element, int component) const {
+			float value;
+			std::memcpy(&value, data + element * stride + component * sizeof(float), sizeof(float));
+			return value;
+		}
+
+		std::uint32_t readIndex(std::size_t element) const {
+			const std::uint8_t* p = data + element * stride;
+			switch (componentType) {
+			case COMPONENT_UNSIGNED_BYTE: return *p;
+			case COMPONENT_UNSIGNED_SHORT: { std::uint16_t v; std::memcpy(&v, p, 2); return v; }
+			default: { std::uint32_t v; std::memcpy(&v, p, 4); return v; }
+			}
+		}
+	};
+
+	int componentSize(int componentType) {
+		switch (componentType) {
+		case COMPONENT_UNSIGNED_BYTE: return 1;
+		case COMPONENT_UNSIGNED_SHORT: return 2;
+		default: return 4;
+		}
+	}
+
+	int componentCount(const std::string& type) {
+		if (type == "SCALAR") return 1;
+		if (type == "VEC2") return 2;
+		if (type == "VEC3") return 3;
+		if (type == "VEC4") return 4;
+		return 0;
+	}
+
+	class GltfDocument {
+	public:
+		Json json;
+		std::vector<std::vector<std::uint8_t>> buffers;
+
+		bool accessor(std::size_t index, Accessor& result) const {
+			const Json& accessor = json["accessors"].at(index);
+			const Json& view = json["bufferViews"].at(accessor["bufferView"].indexOr(SIZE_MAX));
+			const std::size_t bufferIndex = view["buffer"].indexOr(SIZE_MAX);
+			if (accessor.isNull() || view.isNull() || bufferIndex >= buffers.size()) {
+				spdlog::warn("[MeshImporter] glTF accessor {} has no data, sparse accessors are not supported", index);
+				return false;
+			}
+			if (!accessor["sparse"].isNull()) {
+				spdlog::warn("[MeshImporter] glTF accessor {} is sparse, the sparse values are ignored", index);
+			}
+
+			result.componentType = static_cast<int>(accessor["componentType"].numberOr(0));
+			result.componentCount = componentCount(accessor["type"].string);
+			result.count = accessor["count"].indexOr(0);
+			result.stride = view["byteStride"].indexOr(static_cast<std::size_t>(componentSize(result.componentType) * result.componentCount));
+
+			const std::size_t offset = view["byteOffset"].indexOr(0) + accessor["byteOffset"].indexOr(0);
+			const std::size_t lastByte = offset + (result.count > 0 ? (result.count - 1) * result.stride : 0) + componentSize(result.componentType) * result.componentCount;
+			if (lastByte > buffers[bufferIndex].size()) {
+				spdlog::warn("[MeshImporter] glTF accessor {} goes past the end of its buffer", index);
+				return false;
+			}
+			result.data = buffers[bufferIndex].data() + offset;
+			return true;
+		}
+	};
+
+	glm::mat4 nodeTransform(const Json& node) {
+		const Json& matrix = node["matrix"];
+		if (matrix.array.size() == 16) {
+			glm::mat4 result;
+			for (int i = 0; i < 16; i++) {
+				glm::value_ptr(result)[i] = static_cast<float>(matrix.at(i).number);
+			}
+			return result;
+		}
+
+		const Json& t = node["translation"];
+		const Json& r = node["rotation"];
+		const Json& s = node["scale"];
+		const glm::vec3 translation(t.at(0).numberOr(0), t.at(1).numberOr(0), t.at(2).numberOr(0));
+		const glm::quat rotation(static_cast<float>(r.at(3).numberOr(1)), static_cast<float>(r.at(0).numberOr(0)), static_cast<float>(r.at(1).numberOr(0)), static_cast<float>(r.at(2).numberOr(0)));
+		const glm::vec3 scale(s.at(0).numberOr(1), s.at(1).numberOr(1), s.at(2).numberOr(1));
+		return glm::translate(glm::mat4(1.0f), translation) * glm::mat4_cast(rotation) * glm::scale(glm::mat4(1.0f), scale);
+	}
+}
+
+MeshImporter::MeshImporter(JobSystem& jobs) : m_jobs(jobs) {}
+
+bool MeshImporter::load(const std::string& filepath, MeshData& mesh) {
+	m_stats = Stats();
+	const auto start = Clock::now();
+
+	std::vector<char> content;
+	if (!readFile(filepath, content)) {
+		return false;
+	}
+	const double readMs = elapsedMs(start);
+
+	std::string extension = filepath.substr(std::min(filepath.find_last_of('.'), filepath.size()));
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return static_cast<char>(std::tolower(c)); });
+
+	bool succeeded = false;
+	if (extension == ".obj") {
+		succeeded = loadObj(content.data(), content.size(), mesh);
+	} else if (extension == ".gltf" || extension == ".glb") {
+		const std::size_t slash = filepath.find_last_of("/\\");
+		succeeded = loadGltf(content.data(), content.size(), slash == std::string::npos ? "" : filepath.substr(0, slash + 1), mesh);
+	} else {
+		spdlog::warn("[MeshImporter] Unknown mesh format |{}|", filepath);
+	}
+
+	m_stats.readMs = readMs;
+	m_stats.totalMs = elapsedMs(start);
+	if (!succeeded) {
+		spdlog::warn("[MeshImporter] Could not import |{}|", filepath);
+	}
+	return succeeded;
+}
+
+bool MeshImporter::loadObj(const char* text, std::size_t size, MeshData& mesh) {
+	m_stats.fileBytes = size;
+	auto start = Clock::now();
+
+	// ------------------ Split in chunks on line boundaries
+	const std::size_t chunkSize = std::max<std::size_t>(size / (m_jobs.threadCount() * 8) + 1, 256 * 1024);
+	std::vector<ObjChunk> chunks;
+	const char* end = text + size;
+	for (const char* p = text; p < end;) {
+		ObjChunk chunk;
+		chunk.begin = p;
+		chunk.end = p + std::min(chunkSize, static_cast<std::size_t>(end - p));
+		chunk.end = chunk.end < end ? skipLine(chunk.end, end) : end;
+		p = chunk.end;
+		chunks.push_back(std::move(chunk));
+	}
+
+	parallelFor(m_jobs, static_cast<std::uint32_t>(chunks.size()), 1, [&](std::uint32_t begin, std::uint32_t end) {
+		for (std::uint32_t i = begin; i < end; i++) {
+			parseObjChunk(chunks[i]);
+		}
+	});
+
+	// ------------------ Merge chunks, relative indices become absolute
+	std::size_t positionCount = 0, texCoordCount = 0, normalCount = 0, cornerCount = 0;
+	for (ObjChunk& chunk : chunks) {
+		chunk.positionBase = static_cast<std::int32_t>(positionCount);
+		chunk.texCoordBase = static_cast<std::int32_t>(texCoordCount);
+		chunk.normalBase = static_cast<std::int32_t>(normalCount);
+		chunk.cornerBase = cornerCount;
+		positionCount += chunk.positions.size() / 3;
+		texCoordCount += chunk.texCoords.size() / 2;
+		normalCount += chunk.normals.size() / 3;
+		cornerCount += chunk.corners.size();
+	}
+	if (cornerCount > UINT32_MAX || positionCount > INT32_MAX) {
+		spdlog::warn("[MeshImporter] OBJ has more than 4 billion face corners");
+		return false;
+	}
+
+	std::vector<float> positions(positionCount * 3), texCoords(texCoordCount * 2), normals(normalCount * 3);
+	std::vector<Corner> corners(cornerCount);
+	std::atomic<bool> invalidIndex(false);
+	parallelFor(m_jobs, static_cast<std::uint32_t>(chunks.size()), 1, [&](std::uint32_t begin, std::uint32_t end) {
+		for (std::uint32_t i = begin; i < end; i++) {
+			ObjChunk& chunk = chunks[i];
+			std::copy(chunk.positions.begin(), chunk.positions.end(), positions.begin() + chunk.positionBase * 3);
+			std::copy(chunk.texCoords.begin(), chunk.texCoords.end(), texCoords.begin() + chunk.texCoordBase * 2);
+			std::copy(chunk.normals.begin(), chunk.normals.end(), normals.begin() + chunk.normalBase * 3);
+
+			for (std::size_t c = 0; c < chunk.corners.size(); c++) {
+				Corner corner = chunk.corners[c];
+				const std::uint8_t flags = chunk.relativeFlags[c];
+				if (flags & RELATIVE_V) { corner.v += chunk.positionBase; }
+				if (flags & RELATIVE_VT) { corner.vt += chunk.texCoordBase; }
+				if (flags & RELATIVE_VN) { corner.vn += chunk.normalBase; }
+
+				if (corner.v < 0 || corner.v >= static_cast<std::int32_t>(positionCount)
+					|| (corner.vt != MISSING && (corner.vt < 0 || corner.vt >= static_cast<std::int32_t>(texCoordCount)))
+					|| (corner.vn != MISSING && (corner.vn < 0 || corner.vn >= static_cast<std::int32_t>(normalCount)))) {
+					invalidIndex = true;
+					corner = { 0, MISSING, MISSING };
+				}
+				corners[chunk.cornerBase + c] = corner;
+			}
+
+			chunk = ObjChunk();
+		}
+	});
+	if (invalidIndex) {
+		spdlog::warn("[MeshImporter] OBJ faces reference vertices which do not exist, they are collapsed");
+	}
+	m_stats.parseMs = elapsedMs(start);
+	start = Clock::now();
+
+	// ------------------ Deduplicate
+	// Corners are partitioned by hash in shards, each shard is deduplicated by one job with its own table.
+	unsigned int shardBits = 0;
+	while ((1u << shardBits) < m_jobs.threadCount() * 4) { shardBits++; }
+	const std::uint32_t shardCount = 1u << shardBits;
+	auto shardOf = [shardBits](std::uint32_t hash) { return shardBits == 0 ? 0 : hash >> (32 - shardBits); };
+
+	const std::uint32_t grain = grainFor(cornerCount, m_jobs);
+	const std::uint32_t rangeCount = static_cast<std::uint32_t>((cornerCount + grain - 1) / grain);
+	std::vector<std::uint32_t> hashes(cornerCount);
+	std::vector<std::uint32_t> rangeShardCounts(static_cast<std::size_t>(rangeCount) * shardCount, 0);
+	parallelFor(m_jobs, rangeCount, 1, [&](std::uint32_t begin, std::uint32_t end) {
+		for (std::uint32_t range = begin; range < end; range++) {
+			std::uint32_t* counts = &rangeShardCounts[static_cast<std::size_t>(range) * shardCount];
+			const std::size_t last = std::min<std::size_t>(cornerCount, static_cast<std::size_t>(range + 1) * grain);
+			for (std::size_t i = static_cast<std::size_t>(range) * grain; i < last; i++) {
+				hashes[i] = hashCorner(corners[i]);
+				counts[shardOf(hashes[i])]++;
+			}
+		}
+	});
+
+	// Scatter corner indices shard by shard, keeping the file order inside a shard
+	std::vector<std::uint32_t> shardBegins(shardCount + 1, 0);
+	for (std::uint32_t shard = 0; shard < shardCount; shard++) {
+		std::uint32_t offset = shardBegins[shard];
+		for (std::uint32_t range = 0; range < rangeCount; range++) {
+			std::uint32_t& count = rangeShardCounts[static_cast<std::size_t>(range) * shardCount + shard];
+			const std::uint32_t rangeCornerCount = count;
+			count = offset;
+			offset += rangeCornerCount;
+		}
+		shardBegins[shard + 1] = offset;
+	}
+	std::vector<std::uint32_t> shardCorners(cornerCount);
+	parallelFor(m_jobs, rangeCount, 1, [&](std::uint32_t begin, std::uint32_t end) {
+		for (std::uint32_t range = begin; range < end; range++) {
+			std::uint32_t* offsets = &rangeShardCounts[static_cast<std::size_t>(range) * shardCount];
+			const std::size_t last = std::min<std::size_t>(cornerCount, static_cast<std::size_t>(range + 1) * grain);
+			for (std::size_t i = static_cast<std::size_t>(range) * grain; i < last; i++) {
+				shardCorners[offsets[shardOf(hashes[i])]++] = static_cast<std::uint32_t>(i);
+			}
+		}
+	});
+
+	// Open addressing table per shard, indices are local to the shard until all unique counts are known
+	mesh.indices.resize(cornerCount);
+	std::vector<std::vector<std::uint32_t>> shardUniques(shardCount);
+	parallelFor(m_jobs, shardCount, 1, [&](std::uint32_t begin, std::uint32_t end) {
+		for (std::uint32_t shard = begin; shard < end; shard++) {
+			const std::uint32_t first = shardBegins[shard], last = shardBegins[shard + 1];
+			std::uint32_t capacity = 16;
+			while (capacity < (last - first) * 2) { capacity *= 2; }
+			std::vector<std::uint32_t> table(capacity, UINT32_MAX); // Local vertex
+			std::vector<std::uint32_t>& uniques = shardUniques[shard]; // First corner of each local vertex
+
+			for (std::uint32_t k = first; k < last; k++) {
+				const std::uint32_t corner = shardCorners[k];
+				std::uint32_t slot = hashes[corner] & (capacity - 1);
+				while (table[slot] != UINT32_MAX && !(corners[uniques[table[slot]]] == corners[corner])) {
+					slot = (slot + 1) & (capacity - 1);
+				}
+				if (table[slot] == UINT32_MAX) {
+					table[slot] = static_cast<std::uint32_t>(uniques.size());
+					uniques.push_back(corner);
+				}
+				mesh.indices[corner] = table[slot];
+			}
+		}
+	});
+
+	std::vector<std::uint32_t> shardVertexBases(shardCount, 0);
+	std::size_t vertexCount = 0;
+	for (std::uint32_t shard = 0; shard < shardCount; shard++) {
+		shardVertexBases[shard] = static_cast<std::uint32_t>(vertexCount);
+		vertexCount += shardUniques[shard].size();
+	}
+
+	mesh.vertices.resize(vertexCount);
+	parallelFor(m_jobs, shardCount, 1, [&](std::uint32_t begin, std::uint32_t end) {
+		for (std::uint32_t shard = begin; shard < end; shard++) {
+			assetPack::Vertex* vertices = &mesh.vertices[shardVertexBases[shard]];
+			for (std::size_t i = 0; i < shardUniques[shard].size(); i++) {
+				const Corner& corner = corners[shardUniques[shard][i]];
+				assetPack::Vertex& vertex = vertices[i];
+				std::memcpy(vertex.position, &positions[corner.v * 3], sizeof(vertex.position));
+				if (corner.vn != MISSING) {
+					std::memcpy(vertex.normal, &normals[corner.vn * 3], sizeof(vertex.normal));
+				} else {
+					std::memset(vertex.normal, 0, sizeof(vertex.normal));
+				}
+				if (corner.vt != MISSING) {
+					std::memcpy(vertex.texCoord, &texCoords[corner.vt * 2], sizeof(vertex.texCoord));
+				} else {
+					std::memset(vertex.texCoord, 0, sizeof(vertex.texCoord));
+				}
+			}
+		}
+	});
+	parallelFor(m_jobs, static_cast<std::uint32_t>(cornerCount), grain, [&](std::uint32_t begin, std::uint32_t end) {
+		for (std::uint32_t i = begin; i < end; i++) {
+			mesh.indices[i] += shardVertexBases[shardOf(hashes[i])];
+		}
+	});
+
+	if (normalCount == 0) {
+		generateNormals(mesh, 0, 0);
+	}
+	m_stats.buildMs = elapsedMs(start);
+	return true;
+}
+
+bool MeshImporter::loadGltf(const char* data, std::size_t size, const std::string& baseDirectory, MeshData& mesh) {
+	m_stats.fileBytes = size;
+	auto start = Clock::now();
+	GltfDocument document;
+
+	// ------------------ Container
+	const char* jsonBegin = data;
+	const char* jsonEnd = data + size;
+	std::vector<std::uint8_t> glbBuffer;
+	std::uint32_t header[3] = { 0, 0, 0 };
+	if (size >= sizeof(header)) {
+		std::memcpy(header, data, sizeof(header));
+	}
+	if (header[0] == GLB_MAGIC) {
+		std::size_t offset = sizeof(header);
+		while (offset + 8 <= size) {
+			std::uint32_t chunk[2];
+			std::memcpy(chunk, data + offset, sizeof(chunk));
+			offset += sizeof(chunk);
+			if (offset + chunk[0] > size) {
+				spdlog::warn("[MeshImporter] GLB chunk goes past the end of the file");
+				return false;
+			}
+			if (chunk[1] == GLB_CHUNK_JSON) {
+				jsonBegin = data + offset;
+				jsonEnd = jsonBegin + chunk[0];
+			} else if (chunk[1] == GLB_CHUNK_BIN) {
+				glbBuffer.assign(data + offset, data + offset + chunk[0]);
+			}
+			offset += (chunk[0] + 3) & ~3u;
+		}
+	}
+
+	if (!JsonParser(jsonBegin, jsonEnd).parse(document.json)) {
+		spdlog::warn("[MeshImporter] glTF JSON is not valid");
+		return false;
+	}
+
+	// ------------------ Buffers
+	const Json& buffers = document.json["buffers"];
+	for (std::size_t i = 0; i < buffers.array.size(); i++) {
+		const std::string& uri = buffers.at(i)["uri"].string;
+		std::vector<std::uint8_t> buffer;
+		if (uri.empty()) {
+			buffer = std::move(glbBuffer);
+		} else if (uri.compare(0, 5, "data:") == 0) {
+			const std::size_t comma = uri.find(',');
+			if (comma == std::string::npos || !decodeBase64(uri, comma + 1, buffer)) {
+				spdlog::warn("[MeshImporter] glTF buffer {} has an invalid data URI", i);
+				return false;
+			}
+		} else {
+			std::vector<char> content;
+			if (!readFile(baseDirectory + uri, content)) {
+				return false;
+			}
+			buffer.assign(content.begin(), content.end());
+		}
+		document.buffers.push_back(std::move(buffer));
+	}
+	m_stats.parseMs = elapsedMs(start);
+	start = Clock::now();
+
+	// ------------------ Nodes of the default scene
+	mesh.vertices.clear();
+	mesh.indices.clear();
+
+	bool succeeded = true;
+	auto addMesh = [&](std::size_t meshIndex, const glm::mat4& transform) {
+		const glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(transform)));
+		for (const Json& primitive : document.json["meshes"].at(meshIndex)["primitives"].array) {
+			if (primitive["mode"].numberOr(MODE_TRIANGLES) != MODE_TRIANGLES) {
+				spdlog::warn("[MeshImporter] Skipped a glTF primitive which is not a triangle list");
+				continue;
+			}
+
+			const Json& attributes = primitive["attributes"];
+			Accessor positions, normals, texCoords, indices;
+			if (!document.accessor(attributes["POSITION"].indexOr(SIZE_MAX), positions)) {
+				succeeded = false;
+				continue;
+			}
+			// Elements are read as they are expected, anything else would read the wrong bytes or past the buffer
+			if (positions.componentType != COMPONENT_FLOAT || positions.componentCount != 3) {
+				spdlog::warn("[MeshImporter] Skipped a glTF primitive whose POSITION is not a VEC3 of FLOAT");
+				succeeded = false;
+				continue;
+			}
+			const bool hasNormals = !attributes["NORMAL"].isNull() && document.accessor(attributes["NORMAL"].indexOr(SIZE_MAX), normals)
+				&& normals.componentType == COMPONENT_FLOAT && normals.componentCount == 3 && normals.count == positions.count;
+			const bool hasTexCoords = !attributes["TEXCOORD_0"].isNull() && document.accessor(attributes["TEXCOORD_0"].indexOr(SIZE_MAX), texCoords)
+				&& texCoords.componentType == COMPONENT_FLOAT && texCoords.componentCount == 2 && texCoords.count == positions.count;
+			const bool hasIndices = !primitive["indices"].isNull() && document.accessor(primitive["indices"].indexOr(SIZE_MAX), indices);
+			if (hasIndices && (indices.componentCount != 1 || (indices.componentType != COMPONENT_UNSIGNED_BYTE
+				&& indices.componentType != COMPONENT_UNSIGNED_SHORT && indices.componentType != COMPONENT_UNSIGNED_INT))) {
+				spdlog::warn("[MeshImporter] Skipped a glTF primitive whose indices are not unsigned SCALAR");
+				succeeded = false;
+				continue;
+			}
+
+			// ------------------ Copy straight into the final arrays
+			const std::uint32_t vertexBase = static_cast<std::uint32_t>(mesh.vertices.size());
+			const std::size_t indexBase = mesh.indices.size();
+			const std::size_t indexCount = hasIndices ? indices.count : positions.count;
+			mesh.vertices.resize(vertexBase + positions.count);
+			mesh.indices.resize(indexBase + indexCount);
+
+			parallelFor(m_jobs, static_cast<std::uint32_t>(positions.count), grainFor(positions.count, m_jobs), [&](std::uint32_t begin, std::uint32_t end) {
+				for (std::uint32_t i = begin; i < end; i++) {
+					assetPack::Vertex& vertex = mesh.vertices[vertexBase + i];
+					const glm::vec3 position = transform * glm::vec4(positions.readFloat(i, 0), positions.readFloat(i, 1), positions.readFloat(i, 2), 1.0f);
+					std::memcpy(vertex.position, glm::value_ptr(position), sizeof(vertex.position));
+
+					glm::vec3 normal(0.0f);
+					if (hasNormals) {
+						normal = glm::normalize(normalMatrix * glm::vec3(normals.readFloat(i, 0), normals.readFloat(i, 1), normals.readFloat(i, 2)));
+					}
+					std::memcpy(vertex.normal, glm::value_ptr(normal), sizeof(vertex.normal));
+
+					// glTF puts the texture origin at the top left
+					vertex.texCoord[0] = hasTexCoords ? texCoords.readFloat(i, 0) : 0.0f;
+					vertex.texCoord[1] = hasTexCoords ? 1.0f - texCoords.readFloat(i, 1) : 0.0f;
+				}
+			});
+			parallelFor(m_jobs, static_cast<std::uint32_t>(indexCount), grainFor(indexCount, m_jobs), [&](std::uint32_t begin, std::uint32_t end) {
+				for (std::uint32_t i = begin; i < end; i++) {
+					const std::uint32_t index = hasIndices ? indices.readIndex(i) : i;
+					mesh.indices[indexBase + i] = vertexBase + (index < positions.count ? index : 0);
+				}
+			});
+			if (!hasNormals) {
+				generateNormals(mesh, vertexBase, indexBase);
+			}
+		}
+	};
+
+	std::vector<std::pair<std::size_t, glm::mat4>> nodes;
+	const Json& scene = document.json["scenes"].at(document.json["scene"].indexOr(0));
+	for (const Json& root : scene["nodes"].array) {
+		nodes.emplace_back(root.indexOr(SIZE_MAX), glm::mat4(1.0f));
+	}
+	if (scene.isNull()) {
+		// No scene : every mesh, untransformed
+		for (std::size_t i = 0; i < document.json["meshes"].array.size(); i++) {
+			addMesh(i, glm::mat4(1.0f));
+		}
+	}
+	// A node has one parent at most, reaching one twice means the graph has a cycle (or is not a tree)
+	std::vector<bool> visited(document.json["nodes"].array.size(), false);
+	while (!nodes.empty()) {
+		const std::size_t nodeIndex = nodes.back().first;
+		if (nodeIndex < visited.size()) {
+			if (visited[nodeIndex]) {
+				spdlog::warn("[MeshImporter] glTF node {} is reached twice, the node graph is not a tree", nodeIndex);
+				succeeded = false;
+				break;
+			}
+			visited[nodeIndex] = true;
+		}
+		const Json& node = document.json["nodes"].at(nodeIndex);
+		const glm::mat4 transform = nodes.back().second * nodeTransform(node);
+		nodes.pop_back();
+		for (const Json& child : node["children"].array) {
+			nodes.emplace_back(child.indexOr(SIZE_MAX), transform);
+		}
+		if (!node["mesh"].isNull()) {
+			addMesh(node["mesh"].indexOr(SIZE_MAX), transform);
+		}
+	}
+
+	m_stats.buildMs = elapsedMs(start);
+	return succeeded && !mesh.indices.empty();
+}
+
+const MeshImporter::Stats& MeshImporter::stats() const {
+	return m_stats;
+}
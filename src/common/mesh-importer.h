@@ -0,0 +1,50 @@
+#pragma once
+
+#include <string>
+#include "mesh-data.h"
+
+class JobSystem;
+
+/**
+ * @brief Load OBJ and glTF 2.0 (.gltf, .glb) meshes, parsing in parallel on a JobSystem
+ * @note OBJ : every group is merged, polygons are fanned into triangles and vertices are deduplicated.
+ *       Normals are generated when the file has none.
+ *       glTF : every triangle primitive of the default scene, with its node transform applied.
+ *       Texture coordinates follow the OpenGL convention (origin at the bottom left) in both cases.
+ */
+class MeshImporter {
+public:
+    struct Stats {
+        double readMs = 0.0;
+        double parseMs = 0.0;
+        double buildMs = 0.0; // Deduplication for OBJ, copies for glTF
+        double totalMs = 0.0;
+        std::size_t fileBytes = 0;
+    };
+
+public:
+    MeshImporter(JobSystem& jobs);
+    ~MeshImporter() = default;
+
+    /**
+     * @brief Pick the format from the extension, the mesh is replaced
+     * @return false if the file could not be read or parsed, reasons are logged
+     */
+    bool load(const std::string& filepath, MeshData& mesh);
+
+    bool loadObj(const char* text, std::size_t size, MeshData& mesh);
+
+    /**
+     * @param baseDirectory - Where the external buffers of a .gltf are
+     */
+    bool loadGltf(const char* data, std::size_t size, const std::string& baseDirectory, MeshData& mesh);
+
+    /**
+     * @brief Timings of the last load
+     */
+    const Stats& stats() const;
+
+private:
+    JobSystem& m_jobs;
+    Stats m_stats;
+};
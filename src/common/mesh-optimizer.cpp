@@ -0,0 +1,262 @@
+#include "mesh-optimizer.h"
+
+#include <spdlog/spdlog.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <numeric>
+
+namespace {
+	// Exact FIFO : a vertex is cached while fewer than cacheSize misses happened after its own
+	class FifoCache {
+	public:
+		FifoCache(std::size_t vertexCount, unsigned int cacheSize)
+			: m_stamps(vertexCount, 0), m_time(cacheSize), m_cacheSize(cacheSize) {}
+
+		bool miss(std::uint32_t vertex) {
+			if (m_time - m_stamps[vertex] < m_cacheSize) {
+				return false;
+			}
+			m_stamps[vertex] = ++m_time;
+			return true;
+		}
+
+		unsigned int missTriangle(const std::uint32_t* triangle) {
+			return miss(triangle[0]) + miss(triangle[1]) + miss(triangle[2]);
+		}
+
+		// Everything misses again, without clearing the stamps
+		void flush() {
+			m_time += m_cacheSize;
+		}
+
+	private:
+		std::vector<std::uint32_t> m_stamps;
+		std::uint32_t m_time;
+		unsigned int m_cacheSize;
+	};
+
+	glm::vec3 position(const std::vector<assetPack::Vertex>& vertices, std::uint32_t index) {
+		return glm::make_vec3(vertices[index].position);
+	}
+}
+
+meshOptimizer::VertexCacheStats meshOptimizer::analyzeVertexCache(const std::vector<std::uint32_t>& indices, std::size_t vertexCount, unsigned int cacheSize) {
+	FifoCache cache(vertexCount, cacheSize);
+	std::vector<bool> used(vertexCount, false);
+	std::size_t misses = 0, usedCount = 0;
+	for (std::uint32_t index : indices) {
+		misses += cache.miss(index);
+		if (!used[index]) {
+			used[index] = true;
+			usedCount++;
+		}
+	}
+
+	const std::size_t triangleCount = indices.size() / 3;
+	return {
+		triangleCount > 0 ? static_cast<float>(misses) / triangleCount : 0.0f,
+		usedCount > 0 ? static_cast<float>(misses) / usedCount : 0.0f
+	};
+}
+
+std::vector<std::uint32_t> meshOptimizer::optimizeVertexCache(const std::vector<std::uint32_t>& indices, std::size_t vertexCount, unsigned int cacheSize) {
+	const std::size_t triangleCount = indices.size() / 3;
+
+	// ------------------ Triangles around each vertex
+	std::vector<std::uint32_t> liveTriangles(vertexCount, 0);
+	for (std::uint32_t index : indices) {
+		liveTriangles[index]++;
+	}
+	std::vector<std::uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+	for (std::size_t v = 0; v < vertexCount; v++) {
+		adjacencyOffsets[v + 1] = adjacencyOffsets[v] + liveTriangles[v];
+	}
+	std::vector<std::uint32_t> adjacency(indices.size());
+	{
+		std::vector<std::uint32_t> cursors(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (std::size_t i = 0; i < indices.size(); i++) {
+			adjacency[cursors[indices[i]]++] = static_cast<std::uint32_t>(i / 3);
+		}
+	}
+
+	// ------------------ Tipsify
+	std::vector<std::uint32_t> result;
+	result.reserve(triangleCount * 3);
+	std::vector<std::uint32_t> cacheTimes(vertexCount, 0);
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<std::uint32_t> deadEnds;
+	std::vector<std::uint32_t> candidates;
+	std::uint32_t time = cacheSize + 1;
+	std::size_t scanCursor = 0;
+	std::int64_t fanning = vertexCount > 0 ? 0 : -1;
+
+	while (fanning >= 0) {
+		// Emit every triangle left around the fanning vertex
+		candidates.clear();
+		for (std::uint32_t k = adjacencyOffsets[fanning]; k < adjacencyOffsets[fanning + 1]; k++) {
+			const std::uint32_t triangle = adjacency[k];
+			if (emitted[triangle]) {
+				continue;
+			}
+			for (int c = 0; c < 3; c++) {
+				const std::uint32_t vertex = indices[triangle * 3 + c];
+				result.push_back(vertex);
+				deadEnds.push_back(vertex);
+				candidates.push_back(vertex);
+				liveTriangles[vertex]--;
+				if (time - cacheTimes[vertex] > cacheSize) {
+					cacheTimes[vertex] = time++;
+				}
+			}
+			emitted[triangle] = true;
+		}
+
+		// Next fanning vertex : the oldest in the cache which stays cached for all its triangles
+		fanning = -1;
+		std::int64_t bestPriority = -1;
+		for (std::uint32_t vertex : candidates) {
+			if (liveTriangles[vertex] == 0) {
+				continue;
+			}
+			std::int64_t priority = 0;
+			if (time - cacheTimes[vertex] + 2 * liveTriangles[vertex] <= cacheSize) {
+				priority = time - cacheTimes[vertex];
+			}
+			if (priority > bestPriority) {
+				bestPriority = priority;
+				fanning = vertex;
+			}
+		}
+
+		// Dead end : go back to recent vertices, then to the next vertex in input order
+		while (fanning < 0 && !deadEnds.empty()) {
+			const std::uint32_t vertex = deadEnds.back();
+			deadEnds.pop_back();
+			if (liveTriangles[vertex] > 0) {
+				fanning = vertex;
+			}
+		}
+		while (fanning < 0 && scanCursor < vertexCount) {
+			if (liveTriangles[scanCursor] > 0) {
+				fanning = static_cast<std::int64_t>(scanCursor);
+			}
+			scanCursor++;
+		}
+	}
+
+	return result;
+}
+
+std::vector<std::uint32_t> meshOptimizer::optimizeOverdraw(const std::vector<std::uint32_t>& indices, const std::vector<assetPack::Vertex>& vertices,
+                                                           float threshold, unsigned int cacheSize) {
+	const std::size_t triangleCount = indices.size() / 3;
+	if (triangleCount == 0) {
+		return indices;
+	}
+
+	// ------------------ Hard boundaries : the cache optimizer jumped, all three vertices miss
+	std::vector<std::uint32_t> hardBoundaries;
+	{
+		FifoCache cache(vertices.size(), cacheSize);
+		for (std::size_t t = 0; t < triangleCount; t++) {
+			if (cache.missTriangle(&indices[t * 3]) == 3) {
+				hardBoundaries.push_back(static_cast<std::uint32_t>(t));
+			}
+		}
+	}
+	hardBoundaries.push_back(static_cast<std::uint32_t>(triangleCount));
+
+	// ------------------ Soft boundaries : split again as soon as the ACMR of a piece is close to the one of its cluster
+	std::vector<std::uint32_t> clusters;
+	FifoCache cache(vertices.size(), cacheSize);
+	for (std::size_t h = 0; h + 1 < hardBoundaries.size(); h++) {
+		const std::uint32_t begin = hardBoundaries[h], end = hardBoundaries[h + 1];
+
+		cache.flush();
+		unsigned int clusterMisses = 0;
+		for (std::uint32_t t = begin; t < end; t++) {
+			clusterMisses += cache.missTriangle(&indices[t * 3]);
+		}
+		const float clusterAcmr = static_cast<float>(clusterMisses) / (end - begin);
+
+		clusters.push_back(begin);
+		cache.flush();
+		unsigned int misses = 0, count = 0;
+		for (std::uint32_t t = begin; t < end; t++) {
+			misses += cache.missTriangle(&indices[t * 3]);
+			count++;
+			if (t + 1 < end && static_cast<float>(misses) / count <= threshold * clusterAcmr) {
+				clusters.push_back(t + 1);
+				cache.flush();
+				misses = 0;
+				count = 0;
+			}
+		}
+	}
+	clusters.push_back(static_cast<std::uint32_t>(triangleCount));
+
+	// ------------------ Sort clusters, the ones facing away from the mesh center first
+	glm::vec3 meshCentroid(0.0f);
+	for (std::uint32_t index : indices) {
+		meshCentroid += position(vertices, index);
+	}
+	meshCentroid /= static_cast<float>(indices.size());
+
+	const std::size_t clusterCount = clusters.size() - 1;
+	std::vector<float> sortKeys(clusterCount);
+	for (std::size_t c = 0; c < clusterCount; c++) {
+		glm::vec3 centroid(0.0f), normal(0.0f);
+		float area = 0.0f;
+		for (std::uint32_t t = clusters[c]; t < clusters[c + 1]; t++) {
+			const glm::vec3 a = position(vertices, indices[t * 3]);
+			const glm::vec3 b = position(vertices, indices[t * 3 + 1]);
+			const glm::vec3 v = position(vertices, indices[t * 3 + 2]);
+			const glm::vec3 triangleNormal = glm::cross(b - a, v - a);
+			const float triangleArea = glm::length(triangleNormal);
+			centroid += (a + b + v) * (triangleArea / 3.0f);
+			normal += triangleNormal;
+			area += triangleArea;
+		}
+		centroid = area > 0.0f ? centroid / area : meshCentroid;
+		const float normalLength = glm::length(normal);
+		sortKeys[c] = normalLength > 0.0f ? glm::dot(centroid - meshCentroid, normal / normalLength) : 0.0f;
+	}
+
+	std::vector<std::uint32_t> order(clusterCount);
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&](std::uint32_t a, std::uint32_t b) { return sortKeys[a] > sortKeys[b]; });
+
+	std::vector<std::uint32_t> result;
+	result.reserve(indices.size());
+	for (std::uint32_t c : order) {
+		result.insert(result.end(), indices.begin() + clusters[c] * 3, indices.begin() + clusters[c + 1] * 3);
+	}
+	return result;
+}
+
+void meshOptimizer::optimizeVertexFetch(MeshData& mesh) {
+	std::vector<std::uint32_t> remap(mesh.vertices.size(), UINT32_MAX);
+	std::vector<assetPack::Vertex> vertices;
+	vertices.reserve(mesh.vertices.size());
+
+	for (std::uint32_t& index : mesh.indices) {
+		if (remap[index] == UINT32_MAX) {
+			remap[index] = static_cast<std::uint32_t>(vertices.size());
+			vertices.push_back(mesh.vertices[index]);
+		}
+		index = remap[index];
+	}
+	mesh.vertices = std::move(vertices);
+}
+
+void meshOptimizer::optimize(MeshData& mesh, const char* name) {
+	const VertexCacheStats before = analyzeVertexCache(mesh.indices, mesh.vertices.size());
+
+	mesh.indices = optimizeVertexCache(mesh.indices, mesh.vertices.size());
+	mesh.indices = optimizeOverdraw(mesh.indices, mesh.vertices);
+	optimizeVertexFetch(mesh);
+
+	const VertexCacheStats after = analyzeVertexCache(mesh.indices, mesh.vertices.size());
+	spdlog::info("[MeshOptimizer] {} : ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}", name, before.acmr, after.acmr, before.atvr, after.atvr);
+}
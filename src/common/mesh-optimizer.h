@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "mesh-data.h"
+
+/**
+ * @brief Reorder indices and vertices of triangle lists for the GPU
+ * @note Run in this order : vertex cache, overdraw, vertex fetch. optimize() does all three.
+ */
+namespace meshOptimizer {
+    struct VertexCacheStats {
+        float acmr; // Average cache miss ratio : transformed vertices per triangle, from 0.5 (ideal) to 3
+        float atvr; // Average transform to vertex ratio : transformed vertices per used vertex, 1 is ideal
+    };
+
+    /**
+     * @brief Simulate a FIFO post-transform cache
+     */
+    VertexCacheStats analyzeVertexCache(const std::vector<std::uint32_t>& indices, std::size_t vertexCount, unsigned int cacheSize = 16);
+
+    /**
+     * @brief Tipsify (Sander et al. 2007) : fan around vertices, preferring the ones still in the cache
+     */
+    std::vector<std::uint32_t> optimizeVertexCache(const std::vector<std::uint32_t>& indices, std::size_t vertexCount, unsigned int cacheSize = 16);
+
+    /**
+     * @brief Sort clusters of the cache optimized order so that outward facing ones are drawn first
+     * @param threshold - How much worse than the input the ACMR may become, 1.05 allows 5% more transformed vertices
+     */
+    std::vector<std::uint32_t> optimizeOverdraw(const std::vector<std::uint32_t>& indices, const std::vector<assetPack::Vertex>& vertices,
+                                                float threshold = 1.05f, unsigned int cacheSize = 16);
+
+    /**
+     * @brief Renumber vertices in order of first use, so that vertex fetches are sequential. Unused vertices are removed.
+     */
+    void optimizeVertexFetch(MeshData& mesh);
+
+    /**
+     * @brief All the passes, with ACMR and ATVR logged before and after
+     */
+    void optimize(MeshData& mesh, const char* name = "mesh");
+}
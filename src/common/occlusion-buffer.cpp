@@ -0,0 +1,295 @@
+#include "occlusion-buffer.h"
+
+#include "job-system.h"
+#include <imgui.h>
+#include <assert.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+    #define OCCLUSION_BUFFER_AVX2
+#elif defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+    #include <xmmintrin.h>
+    #define OCCLUSION_BUFFER_SSE
+#endif
+
+namespace {
+    // Below this w a vertex is considered behind the camera
+    const float MIN_W = 1e-5f;
+}
+
+OcclusionBuffer::OcclusionBuffer(JobSystem& jobs, int width, int height)
+	: m_jobs(jobs), m_width(width), m_height(height), m_tilesX(width / TILE_WIDTH), m_tilesY(height / TILE_HEIGHT),
+	  m_viewProj(1.0f), m_rasterizeMs(0.0)
+{
+	assert(width % TILE_WIDTH == 0 && height % TILE_HEIGHT == 0 && "Occlusion buffer size must be a multiple of the tile size !");
+	m_tileBins.resize(m_tilesX * m_tilesY);
+
+	glm::ivec2 size(width, height);
+	for (;;) {
+		m_levelSizes.push_back(size);
+		m_levels.emplace_back(size.x * size.y, 1.0f);
+		if (size.x == 1 && size.y == 1) {
+			break;
+		}
+		size = glm::max((size + 1) / 2, glm::ivec2(1));
+	}
+}
+
+void OcclusionBuffer::begin(const glm::mat4& viewProj) {
+	m_viewProj = viewProj;
+	m_triangles.clear();
+	for (std::vector<std::uint32_t>& bin : m_tileBins) {
+		bin.clear();
+	}
+}
+
+void OcclusionBuffer::addTriangles(const glm::vec3* positions, const std::uint32_t* indices, std::size_t indexCount) {
+	for (std::size_t i = 0; i + 2 < indexCount; i += 3) {
+		// ------------------ Project to pixels, depth from 0 at the near plane to 1 at the far one
+		glm::vec3 screen[3];
+		bool behind = false;
+		for (int v = 0; v < 3; v++) {
+			const glm::vec4 clip = m_viewProj * glm::vec4(positions[indices[i + v]], 1.0f);
+			behind |= clip.w < MIN_W;
+			const glm::vec3 ndc = glm::vec3(clip) / clip.w;
+			screen[v] = glm::vec3((ndc.x * 0.5f + 0.5f) * m_width, (ndc.y * 0.5f + 0.5f) * m_height, ndc.z * 0.5f + 0.5f);
+		}
+		if (behind) {
+			continue;
+		}
+
+		float area = (screen[1].x - screen[0].x) * (screen[2].y - screen[0].y) - (screen[2].x - screen[0].x) * (screen[1].y - screen[0].y);
+		if (std::abs(area) < 1e-6f) {
+			continue;
+		}
+		if (area < 0.0f) {
+			std::swap(screen[1], screen[2]);
+			area = -area;
+		}
+
+		// ------------------ Setup
+		Triangle triangle;
+		for (int e = 0; e < 3; e++) {
+			const glm::vec3& from = screen[(e + 1) % 3];
+			const glm::vec3& to = screen[(e + 2) % 3];
+			triangle.edgeA[e] = from.y - to.y;
+			triangle.edgeB[e] = to.x - from.x;
+			triangle.edgeC[e] = from.x * to.y - to.x * from.y;
+		}
+		triangle.zA = ((screen[1].z - screen[0].z) * (screen[2].y - screen[0].y) - (screen[2].z - screen[0].z) * (screen[1].y - screen[0].y)) / area;
+		triangle.zB = ((screen[1].x - screen[0].x) * (screen[2].z - screen[0].z) - (screen[2].x - screen[0].x) * (screen[1].z - screen[0].z)) / area;
+		triangle.zC = screen[0].z - triangle.zA * screen[0].x - triangle.zB * screen[0].y;
+
+		const float minX = std::min({ screen[0].x, screen[1].x, screen[2].x });
+		const float maxX = std::max({ screen[0].x, screen[1].x, screen[2].x });
+		const float minY = std::min({ screen[0].y, screen[1].y, screen[2].y });
+		const float maxY = std::max({ screen[0].y, screen[1].y, screen[2].y });
+		if (maxX < 0.0f || maxY < 0.0f || minX >= m_width || minY >= m_height) {
+			continue;
+		}
+		triangle.minX = std::max(0, static_cast<int>(minX));
+		triangle.minY = std::max(0, static_cast<int>(minY));
+		triangle.maxX = std::min(m_width - 1, static_cast<int>(maxX));
+		triangle.maxY = std::min(m_height - 1, static_cast<int>(maxY));
+
+		// ------------------ Binning
+		const std::uint32_t index = static_cast<std::uint32_t>(m_triangles.size());
+		m_triangles.push_back(triangle);
+		for (int ty = triangle.minY / TILE_HEIGHT; ty <= triangle.maxY / TILE_HEIGHT; ty++) {
+			for (int tx = triangle.minX / TILE_WIDTH; tx <= triangle.maxX / TILE_WIDTH; tx++) {
+				m_tileBins[ty * m_tilesX + tx].push_back(index);
+			}
+		}
+	}
+}
+
+void OcclusionBuffer::addBox(const glm::vec3& min, const glm::vec3& max) {
+	const glm::vec3 corners[8] = {
+		glm::vec3(min.x, min.y, min.z), glm::vec3(max.x, min.y, min.z), glm::vec3(min.x, max.y, min.z), glm::vec3(max.x, max.y, min.z),
+		glm::vec3(min.x, min.y, max.z), glm::vec3(max.x, min.y, max.z), glm::vec3(min.x, max.y, max.z), glm::vec3(max.x, max.y, max.z)
+	};
+	static const std::uint32_t indices[36] = {
+		0, 1, 3, 0, 3, 2, // -z
+		4, 6, 7, 4, 7, 5, // +z
+		0, 2, 6, 0, 6, 4, // -x
+		1, 5, 7, 1, 7, 3, // +x
+		0, 4, 5, 0, 5, 1, // -y
+		2, 3, 7, 2, 7, 6  // +y
+	};
+	addTriangles(corners, indices, 36);
+}
+
+void OcclusionBuffer::rasterize() {
+	const auto start = std::chrono::high_resolution_clock::now();
+
+	const std::uint32_t tileCount = static_cast<std::uint32_t>(m_tileBins.size());
+	Job* root = m_jobs.parallelFor(0, tileCount, 1, [this](std::uint32_t begin, std::uint32_t end) {
+		for (std::uint32_t tile = begin; tile < end; tile++) {
+			rasterizeTile(tile);
+		}
+	});
+	m_jobs.run(root);
+	m_jobs.wait(root);
+	buildPyramid();
+
+	m_rasterizeMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+bool OcclusionBuffer::isVisible(const glm::vec3& min, const glm::vec3& max) const {
+	// ------------------ Screen rectangle and nearest depth of the box
+	float minX = 1e30f, minY = 1e30f, maxX = -1e30f, maxY = -1e30f, nearest = 1e30f;
+	// Corners are the first one plus the projected edges of the box
+	const glm::vec4 origin = m_viewProj * glm::vec4(min, 1.0f);
+	const glm::vec4 edges[3] = { m_viewProj[0] * (max.x - min.x), m_viewProj[1] * (max.y - min.y), m_viewProj[2] * (max.z - min.z) };
+	for (int c = 0; c < 8; c++) {
+		glm::vec4 clip = origin;
+		if (c & 1) clip += edges[0];
+		if (c & 2) clip += edges[1];
+		if (c & 4) clip += edges[2];
+		if (clip.w < MIN_W) {
+			return true;
+		}
+		const glm::vec3 ndc = glm::vec3(clip) / clip.w;
+		const float x = (ndc.x * 0.5f + 0.5f) * m_width;
+		const float y = (ndc.y * 0.5f + 0.5f) * m_height;
+		minX = std::min(minX, x);
+		maxX = std::max(maxX, x);
+		minY = std::min(minY, y);
+		maxY = std::max(maxY, y);
+		nearest = std::min(nearest, ndc.z * 0.5f + 0.5f);
+	}
+	if (maxX < 0.0f || maxY < 0.0f || minX >= m_width || minY >= m_height) {
+		return true; // Left to frustum culling
+	}
+
+	// ------------------ Coarsest level where the rectangle covers at most 4x4 texels
+	int x0 = std::max(0, static_cast<int>(minX));
+	int y0 = std::max(0, static_cast<int>(minY));
+	int x1 = std::min(m_width - 1, static_cast<int>(maxX));
+	int y1 = std::min(m_height - 1, static_cast<int>(maxY));
+	int level = 0;
+	while (level + 1 < levelCount() && ((x1 >> level) - (x0 >> level) >= 4 || (y1 >> level) - (y0 >> level) >= 4)) {
+		level++;
+	}
+
+	const std::vector<float>& depths = m_levels[level];
+	const int levelWidth = m_levelSizes[level].x;
+	for (int y = y0 >> level; y <= (y1 >> level); y++) {
+		for (int x = x0 >> level; x <= (x1 >> level); x++) {
+			if (nearest <= depths[y * levelWidth + x]) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+void OcclusionBuffer::showMetrics() {
+	ImGui::Begin("Occlusion");
+	ImGui::Text("Depth buffer : %dx%d in %dx%d tiles, %d levels", m_width, m_height, m_tilesX, m_tilesY, levelCount());
+	ImGui::Text("Occluders : %u triangles", triangleCount());
+	ImGui::Text("Last rasterize : %.3f ms", m_rasterizeMs);
+	ImGui::End();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//////////////////////////// GETTERS & SETTERS //////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+int OcclusionBuffer::width() const { return m_width; }
+int OcclusionBuffer::height() const { return m_height; }
+std::uint32_t OcclusionBuffer::triangleCount() const { return static_cast<std::uint32_t>(m_triangles.size()); }
+int OcclusionBuffer::levelCount() const { return static_cast<int>(m_levels.size()); }
+const float* OcclusionBuffer::depth(int level) const { return m_levels[level].data(); }
+
+/////////////////////////////////////////////////////////////////////////////
+///////////////////////////// PRIVATE METHODS ///////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+void OcclusionBuffer::rasterizeTile(int tile) {
+	const int tileX = (tile % m_tilesX) * TILE_WIDTH;
+	const int tileY = (tile / m_tilesX) * TILE_HEIGHT;
+	float* depths = m_levels[0].data();
+
+	for (int y = tileY; y < tileY + TILE_HEIGHT; y++) {
+		std::fill(depths + y * m_width + tileX, depths + y * m_width + tileX + TILE_WIDTH, 1.0f);
+	}
+
+	for (std::uint32_t index : m_tileBins[tile]) {
+		const Triangle& t = m_triangles[index];
+		// Whole lanes from the start of the tile, pixels outside the triangle fail the edge tests
+		const int x0 = tileX + (std::max(t.minX, tileX) - tileX) / 8 * 8;
+		const int x1 = std::min(t.maxX, tileX + TILE_WIDTH - 1);
+		const int y0 = std::max(t.minY, tileY);
+		const int y1 = std::min(t.maxY, tileY + TILE_HEIGHT - 1);
+
+		for (int y = y0; y <= y1; y++) {
+			const float py = y + 0.5f;
+			float* row = depths + y * m_width;
+#if defined(OCCLUSION_BUFFER_AVX2)
+			const __m256 lanes = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+			const __m256 zero = _mm256_setzero_ps();
+			for (int x = x0; x <= x1; x += 8) {
+				const __m256 px = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(x)), lanes);
+				__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+				for (int e = 0; e < 3; e++) {
+					const __m256 edge = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(t.edgeA[e]), px), _mm256_set1_ps(t.edgeB[e] * py + t.edgeC[e]));
+					inside = _mm256_and_ps(inside, _mm256_cmp_ps(edge, zero, _CMP_GE_OQ));
+				}
+				const __m256 z = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(t.zA), px), _mm256_set1_ps(t.zB * py + t.zC));
+				const __m256 previous = _mm256_loadu_ps(row + x);
+				_mm256_storeu_ps(row + x, _mm256_blendv_ps(previous, _mm256_min_ps(previous, z), inside));
+			}
+#elif defined(OCCLUSION_BUFFER_SSE)
+			const __m128 lanes = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+			const __m128 zero = _mm_setzero_ps();
+			for (int x = x0; x <= x1; x += 4) {
+				const __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), lanes);
+				__m128 inside = _mm_cmpeq_ps(zero, zero);
+				for (int e = 0; e < 3; e++) {
+					const __m128 edge = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(t.edgeA[e]), px), _mm_set1_ps(t.edgeB[e] * py + t.edgeC[e]));
+					inside = _mm_and_ps(inside, _mm_cmpge_ps(edge, zero));
+				}
+				const __m128 z = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(t.zA), px), _mm_set1_ps(t.zB * py + t.zC));
+				const __m128 previous = _mm_loadu_ps(row + x);
+				const __m128 nearer = _mm_min_ps(previous, z);
+				_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearer), _mm_andnot_ps(inside, previous)));
+			}
+#else
+			for (int x = x0; x <= x1; x++) {
+				const float px = x + 0.5f;
+				bool inside = true;
+				for (int e = 0; e < 3; e++) {
+					inside &= t.edgeA[e] * px + t.edgeB[e] * py + t.edgeC[e] >= 0.0f;
+				}
+				if (inside) {
+					row[x] = std::min(row[x], t.zA * px + t.zB * py + t.zC);
+				}
+			}
+#endif
+		}
+	}
+}
+
+void OcclusionBuffer::buildPyramid() {
+	for (std::size_t level = 1; level < m_levels.size(); level++) {
+		const std::vector<float>& source = m_levels[level - 1];
+		const glm::ivec2 sourceSize = m_levelSizes[level - 1];
+		const glm::ivec2 size = m_levelSizes[level];
+		std::vector<float>& destination = m_levels[level];
+
+		for (int y = 0; y < size.y; y++) {
+			const int y0 = y * 2, y1 = std::min(y * 2 + 1, sourceSize.y - 1);
+			for (int x = 0; x < size.x; x++) {
+				const int x0 = x * 2, x1 = std::min(x * 2 + 1, sourceSize.x - 1);
+				destination[y * size.x + x] = std::max(
+					std::max(source[y0 * sourceSize.x + x0], source[y0 * sourceSize.x + x1]),
+					std::max(source[y1 * sourceSize.x + x0], source[y1 * sourceSize.x + x1])
+				);
+			}
+		}
+	}
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+class JobSystem;
+
+/**
+ * @brief Low resolution CPU depth buffer of a few large occluders, used to skip instances hidden behind them
+ * @note Occluder triangles are projected and binned per tile when added, then rasterize() splits the tiles across
+ *       the JobSystem and fills each of them with 8 (AVX2) or 4 (SSE) pixels at a time.
+ *       A max depth pyramid is built afterwards : a box is hidden when its nearest point is behind the farthest
+ *       occluder depth of every texel it covers, tested on the level where it covers at most 4x4 texels.
+ *       Depth is [0, 1] from near to far, the cleared value 1 never hides anything.
+ *
+ * @code
+ * occlusion.begin(viewProj);
+ * occlusion.addBox(occluderMin, occluderMax);
+ * occlusion.rasterize();
+ * if (occlusion.isVisible(boundsMin, boundsMax)) { ... }
+ * @endcode
+ */
+class OcclusionBuffer {
+public:
+    static constexpr int TILE_WIDTH = 64;
+    static constexpr int TILE_HEIGHT = 32;
+
+public:
+    /**
+     * @param width, height - Multiples of the tile size
+     */
+    OcclusionBuffer(JobSystem& jobs, int width = 256, int height = 128);
+    ~OcclusionBuffer() = default;
+
+    OcclusionBuffer(const OcclusionBuffer&) = delete;
+    OcclusionBuffer& operator=(const OcclusionBuffer&) = delete;
+
+    /**
+     * @brief Forget previous occluders, the next ones and the tested boxes are in the space of viewProj
+     */
+    void begin(const glm::mat4& viewProj);
+
+    /**
+     * @brief Both faces of the triangles occlude, those crossing the near plane are skipped
+     */
+    void addTriangles(const glm::vec3* positions, const std::uint32_t* indices, std::size_t indexCount);
+    void addBox(const glm::vec3& min, const glm::vec3& max);
+
+    /**
+     * @brief Fill the depth of every tile then build the pyramid, the calling thread must be a JobSystem one
+     */
+    void rasterize();
+
+    /**
+     * @brief False when the box is entirely behind the occluders, thread safe after rasterize()
+     */
+    bool isVisible(const glm::vec3& min, const glm::vec3& max) const;
+
+    void showMetrics();
+
+    int width() const;
+    int height() const;
+    std::uint32_t triangleCount() const;
+    int levelCount() const;
+    const float* depth(int level = 0) const;
+
+private:
+    struct Triangle {
+        // Edge functions a * x + b * y + c, positive inside
+        float edgeA[3];
+        float edgeB[3];
+        float edgeC[3];
+        // Depth plane z = zA * x + zB * y + zC
+        float zA;
+        float zB;
+        float zC;
+        int minX;
+        int minY;
+        int maxX;
+        int maxY;
+    };
+
+    void rasterizeTile(int tile);
+    void buildPyramid();
+
+private:
+    JobSystem& m_jobs;
+    int m_width;
+    int m_height;
+    int m_tilesX;
+    int m_tilesY;
+    glm::mat4 m_viewProj;
+
+    std::vector<Triangle> m_triangles;
+    std::vector<std::vector<std::uint32_t>> m_tileBins; // Triangle indices overlapping each tile
+
+    // Level 0 is the depth buffer, each next level keeps the max of 2x2 texels
+    std::vector<std::vector<float>> m_levels;
+    std::vector<glm::ivec2> m_levelSizes;
+
+    // ------------------ Last frame
+    double m_rasterizeMs;
+};
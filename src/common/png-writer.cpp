@@ -0,0 +1,200 @@
+#include "png-writer.h"
+
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <fstream>
+#include <assert.h>
+
+namespace {
+	std::uint32_t crcTable[256];
+
+	void initCrcTable() {
+		for (std::uint32_t n = 0; n < 256; n++) {
+			std::uint32_t c = n;
+			for (int k = 0; k < 8; k++) {
+				c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+			}
+			crcTable[n] = c;
+		}
+	}
+
+	std::uint32_t crc32(const std::uint8_t* data, std::size_t size, std::uint32_t crc = 0) {
+		crc = ~crc;
+		for (std::size_t i = 0; i < size; i++) {
+			crc = crcTable[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+		}
+		return ~crc;
+	}
+
+	void pushU32(std::vector<std::uint8_t>& out, std::uint32_t value) {
+		out.push_back(static_cast<std::uint8_t>(value >> 24));
+		out.push_back(static_cast<std::uint8_t>(value >> 16));
+		out.push_back(static_cast<std::uint8_t>(value >> 8));
+		out.push_back(static_cast<std::uint8_t>(value));
+	}
+
+	void pushChunk(std::vector<std::uint8_t>& out, const char* type, const std::vector<std::uint8_t>& data) {
+		pushU32(out, static_cast<std::uint32_t>(data.size()));
+		const std::size_t typeStart = out.size();
+		out.insert(out.end(), type, type + 4);
+		out.insert(out.end(), data.begin(), data.end());
+		pushU32(out, crc32(&out[typeStart], data.size() + 4));
+	}
+}
+
+std::vector<std::uint8_t> png::encode(const std::uint8_t* pixels, int width, int height) {
+	if (width <= 0 || height <= 0) {
+		spdlog::warn("[PngWriter] Can't encode a {}x{} image", width, height);
+		return {};
+	}
+	static std::once_flag crcInit;
+	std::call_once(crcInit, initCrcTable);
+
+	std::vector<std::uint8_t> out = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+	// ------------------ Header
+	{
+		std::vector<std::uint8_t> header;
+		pushU32(header, static_cast<std::uint32_t>(width));
+		pushU32(header, static_cast<std::uint32_t>(height));
+		header.push_back(8); // Bit depth
+		header.push_back(6); // RGBA
+		header.push_back(0); // Deflate
+		header.push_back(0); // Adaptive filtering
+		header.push_back(0); // No interlace
+		pushChunk(out, "IHDR", header);
+	}
+
+	// ------------------ Data, zlib stream made of stored blocks
+	{
+		const std::size_t rowSize = static_cast<std::size_t>(width) * 4 + 1;
+		const std::size_t rawSize = rowSize * height;
+		const std::size_t maxBlock = 65535;
+
+		std::vector<std::uint8_t> data;
+		data.reserve(rawSize + rawSize / maxBlock * 5 + 16);
+		data.push_back(0x78);
+		data.push_back(0x01);
+
+		std::uint32_t adlerA = 1;
+		std::uint32_t adlerB = 0;
+		std::size_t blockLeft = 0;
+		std::size_t written = 0;
+		auto pushByte = [&](std::uint8_t byte) {
+			if (blockLeft == 0) {
+				const std::size_t blockSize = std::min(maxBlock, rawSize - written);
+				data.push_back(written + blockSize == rawSize ? 1 : 0);
+				data.push_back(static_cast<std::uint8_t>(blockSize));
+				data.push_back(static_cast<std::uint8_t>(blockSize >> 8));
+				data.push_back(static_cast<std::uint8_t>(~blockSize));
+				data.push_back(static_cast<std::uint8_t>(~blockSize >> 8));
+				blockLeft = blockSize;
+			}
+			data.push_back(byte);
+			adlerA = (adlerA + byte) % 65521;
+			adlerB = (adlerB + adlerA) % 65521;
+			blockLeft--;
+			written++;
+		};
+
+		for (int y = 0; y < height; y++) {
+			pushByte(0); // No filter
+			const std::uint8_t* row = pixels + static_cast<std::size_t>(y) * width * 4;
+			for (int x = 0; x < width * 4; x++) {
+				pushByte(row[x]);
+			}
+		}
+		pushU32(data, (adlerB << 16) | adlerA);
+		pushChunk(out, "IDAT", data);
+	}
+
+	pushChunk(out, "IEND", {});
+	return out;
+}
+
+bool png::writeFile(const std::string& filepath, const std::uint8_t* pixels, int width, int height) {
+	const std::vector<std::uint8_t> file = encode(pixels, width, height);
+	if (file.empty()) {
+		return false;
+	}
+	std::ofstream stream(filepath, std::ios::binary);
+	if (!stream.is_open()) {
+		spdlog::warn("Failed to open file : |{}|", filepath);
+		return false;
+	}
+	stream.write(reinterpret_cast<const char*>(file.data()), file.size());
+	return stream.good();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+///////////////////////////////// PNG WRITER ////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+PngWriter::PngWriter() : m_busy(false), m_stop(false) {
+	m_worker = std::thread(&PngWriter::workerLoop, this);
+}
+
+PngWriter::~PngWriter() {
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_wakeUp.notify_one();
+	m_worker.join();
+}
+
+void PngWriter::write(const std::string& filepath, std::vector<std::uint8_t> pixels, int width, int height, bool flipVertically) {
+	assert(pixels.size() >= static_cast<std::size_t>(width) * height * 4 && "Not enough pixels !");
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_requests.push_back({ filepath, std::move(pixels), width, height, flipVertically });
+	}
+	m_wakeUp.notify_one();
+}
+
+void PngWriter::flush() {
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_done.wait(lock, [this] { return m_requests.empty() && !m_busy; });
+}
+
+std::size_t PngWriter::pendingCount() {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_requests.size() + (m_busy ? 1 : 0);
+}
+
+void PngWriter::workerLoop() {
+	while (true) {
+		Request request;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_wakeUp.wait(lock, [this] { return !m_requests.empty() || m_stop; });
+			// Finish the queue before stopping, so that no capture is lost on exit
+			if (m_requests.empty()) {
+				return;
+			}
+			request = std::move(m_requests.front());
+			m_requests.pop_front();
+			m_busy = true;
+		}
+
+		if (request.flipVertically) {
+			const std::size_t rowSize = static_cast<std::size_t>(request.width) * 4;
+			for (int y = 0; y < request.height / 2; y++) {
+				std::swap_ranges(
+					request.pixels.begin() + y * rowSize,
+					request.pixels.begin() + (y + 1) * rowSize,
+					request.pixels.begin() + (request.height - 1 - y) * rowSize
+				);
+			}
+		}
+		if (!png::writeFile(request.filepath, request.pixels.data(), request.width, request.height)) {
+			spdlog::error("[PngWriter] Could not write '{}'", request.filepath);
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_busy = false;
+		}
+		m_done.notify_all();
+	}
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace png {
+    /**
+     * @brief Encode 8 bits RGBA pixels to a PNG file in memory
+     * @note Uses uncompressed deflate blocks : files are big but encoding is only a copy and two checksums
+     *
+     * @param pixels - width * height * 4 bytes, first row is the top of the image
+     * @return Empty if width or height is not positive, PNG has no empty images
+     */
+    std::vector<std::uint8_t> encode(const std::uint8_t* pixels, int width, int height);
+
+    bool writeFile(const std::string& filepath, const std::uint8_t* pixels, int width, int height);
+}
+
+/**
+ * @brief Encode and write PNG files on a worker thread
+ */
+class PngWriter {
+public:
+    PngWriter();
+    ~PngWriter();
+
+    PngWriter(const PngWriter&) = delete;
+    PngWriter& operator=(const PngWriter&) = delete;
+
+    /**
+     * @brief Queue an image to be written, returns immediately
+     *
+     * @param flipVertically - true for pixels coming from OpenGL, where the first row is the bottom
+     */
+    void write(const std::string& filepath, std::vector<std::uint8_t> pixels, int width, int height, bool flipVertically = true);
+
+    /**
+     * @brief Block until every queued image is written
+     */
+    void flush();
+
+    std::size_t pendingCount();
+
+private:
+    struct Request {
+        std::string filepath;
+        std::vector<std::uint8_t> pixels;
+        int width;
+        int height;
+        bool flipVertically;
+    };
+
+    void workerLoop();
+
+private:
+    std::thread m_worker;
+    std::mutex m_mutex;
+    std::condition_variable m_wakeUp;
+    std::condition_variable m_done;
+    std::deque<Request> m_requests;
+    bool m_busy;
+    bool m_stop;
+};
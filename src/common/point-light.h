@@ -0,0 +1,14 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+/**
+ * @brief Light fading to nothing at its radius, shared by the DeferredRenderer and the LightClusters
+ * @note Also the per instance attributes of the light volumes of the DeferredRenderer, so the layout must not change.
+ */
+struct PointLight {
+    glm::vec3 position;
+    float radius;
+    glm::vec3 color;
+    float intensity;
+};
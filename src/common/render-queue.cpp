@@ -0,0 +1,311 @@
+#include "render-queue.h"
+
+#include "gl-exception.h"
+#include "index-buffer.h"
+#include "job-system.h"
+#include "material.h"
+#include "shader-utils.h"
+#include <imgui.h>
+#include <algorithm>
+#include <chrono>
+
+namespace {
+	const GLuint INVALID = UINT32_MAX;
+
+	RenderPass passOf(std::uint64_t key) { return static_cast<RenderPass>(key >> 60); }
+	GLuint depthVertexArrayOf(const RenderQueue::DrawCall& call) { return call.depthVertexArray != 0 ? call.depthVertexArray : call.vertexArray; }
+	// The pre-pass draws every instance with the same model matrix, instanced draws would not match its depth
+	bool isInDepthPrePass(const RenderQueue::DrawCall& call) { return call.instanceCount <= 1; }
+}
+
+RenderQueue::RenderQueue(float depthRange, JobSystem* jobs)
+	: m_depthRange(depthRange), m_jobs(jobs), m_viewProj(1.0f), m_sortingEnabled(true),
+	  m_frontToBackEnabled(true), m_depthPrePassEnabled(false), m_overdrawEnabled(false),
+	  m_arena(jobs ? jobs->threadCount() : 1), m_sortMs(0.0), m_recordMs(0.0)
+{
+	m_depthProgram = shaderUtils::createProgram("res/depth-only.vert", "res/depth-only.frag");
+	m_overdrawProgram = shaderUtils::createProgram("res/depth-only.vert", "res/overdraw.frag");
+}
+
+RenderQueue::~RenderQueue() {
+	GLCall(glDeleteProgram(m_depthProgram));
+	GLCall(glDeleteProgram(m_overdrawProgram));
+}
+
+void RenderQueue::setViewProj(const glm::mat4& viewProj) {
+	m_viewProj = viewProj;
+}
+
+void RenderQueue::submit(RenderPass pass, const DrawCall& call, float viewDepth) {
+	const float depth01 = std::min(std::max(viewDepth / m_depthRange, 0.0f), 1.0f);
+	std::uint16_t depth = static_cast<std::uint16_t>(depth01 * 0xFFFF);
+	if (pass == RenderPass::BLENDED) {
+		depth = 0xFFFF - depth;
+	}
+
+	// The pre-pass already fills depth front to back, the main pass then only cares about state changes.
+	// Blended draws are composited in depth order whatever their state, back to front with the inverted depth.
+	const bool depthFirst = pass == RenderPass::BLENDED || (pass == RenderPass::SOLID && m_frontToBackEnabled && !m_depthPrePassEnabled);
+	const std::uint64_t key = depthFirst
+		? makeFrontToBackKey(pass, call.material->program(), call.material->id(), call.vertexArray, depth)
+		: makeKey(pass, call.material->program(), call.material->id(), call.vertexArray, depth);
+	m_items.push_back({ key, static_cast<std::uint32_t>(m_calls.size()) });
+	m_calls.push_back(call);
+	m_depths.push_back(depth);
+}
+
+void RenderQueue::flush() {
+	// Submission order first, items are sorted in place
+	m_unsortedStats = countStateChanges(m_items);
+	std::vector<Item> unsorted;
+	if (!m_sortingEnabled) {
+		unsorted = m_items;
+	}
+
+	const auto start = std::chrono::high_resolution_clock::now();
+	radixSort(m_items, m_scratch);
+	m_sortMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	m_sortedStats = countStateChanges(m_items);
+
+	const auto recordStart = std::chrono::high_resolution_clock::now();
+	m_depthItems.clear();
+	if (m_depthPrePassEnabled) {
+		collectDepthItems(m_sortingEnabled ? m_items : unsorted);
+	}
+	record(m_depthItems, m_sortingEnabled ? m_items : unsorted);
+	m_recordMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - recordStart).count();
+
+	GLfloat clearColor[4];
+	if (m_overdrawEnabled) {
+		GLCall(glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor));
+		GLCall(glClearColor(0.0f, 0.0f, 0.0f, 1.0f));
+		GLCall(glClear(GL_COLOR_BUFFER_BIT));
+		GLCall(glEnable(GL_BLEND));
+		GLCall(glBlendFunc(GL_ONE, GL_ONE));
+	}
+
+	m_replayer.replay(m_commands);
+	m_replayStats = m_replayer.takeStats();
+
+	// Slices change the depth and blend states, leave the default ones to the next draws
+	GLCall(glDepthFunc(GL_LESS));
+	GLCall(glDepthMask(GL_TRUE));
+	GLCall(glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE));
+	GLCall(glDisable(GL_BLEND));
+	if (m_overdrawEnabled) {
+		GLCall(glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]));
+	}
+
+	m_arena.reset();
+	m_items.clear();
+	m_calls.clear();
+	m_depths.clear();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//////////////////////////// GETTERS & SETTERS //////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+void RenderQueue::setSortingEnabled(bool enabled) { m_sortingEnabled = enabled; }
+bool RenderQueue::isSortingEnabled() const { return m_sortingEnabled; }
+void RenderQueue::setFrontToBackEnabled(bool enabled) { m_frontToBackEnabled = enabled; }
+bool RenderQueue::isFrontToBackEnabled() const { return m_frontToBackEnabled; }
+void RenderQueue::setDepthPrePassEnabled(bool enabled) { m_depthPrePassEnabled = enabled; }
+bool RenderQueue::isDepthPrePassEnabled() const { return m_depthPrePassEnabled; }
+void RenderQueue::setOverdrawEnabled(bool enabled) { m_overdrawEnabled = enabled; }
+bool RenderQueue::isOverdrawEnabled() const { return m_overdrawEnabled; }
+const RenderQueue::Stats& RenderQueue::sortedStats() const { return m_sortedStats; }
+const RenderQueue::Stats& RenderQueue::unsortedStats() const { return m_unsortedStats; }
+
+void RenderQueue::showMetrics() {
+	ImGui::Begin("Render queue");
+	ImGui::Checkbox("Sort draws", &m_sortingEnabled);
+	ImGui::Checkbox("Solid front to back", &m_frontToBackEnabled);
+	ImGui::Checkbox("Depth pre-pass", &m_depthPrePassEnabled);
+	ImGui::Checkbox("Show overdraw", &m_overdrawEnabled);
+	ImGui::Text("Draws : %u, sorted in %.3f ms", m_sortedStats.draws, m_sortMs);
+	ImGui::Text("Depth pre-pass : %zu draws", m_depthItems.size());
+	ImGui::Text("Commands : %u in %u buffers, recorded in %.3f ms", m_replayStats.commands, m_replayStats.buffers, m_recordMs);
+	ImGui::Text("Arena : %zu KB reserved", m_arena.reservedBytes() / 1024);
+	ImGui::Columns(3, nullptr, false);
+	ImGui::Text("Changes"); ImGui::NextColumn(); ImGui::Text("Sorted"); ImGui::NextColumn(); ImGui::Text("Unsorted"); ImGui::NextColumn();
+	ImGui::Text("Programs"); ImGui::NextColumn(); ImGui::Text("%u", m_sortedStats.programChanges); ImGui::NextColumn(); ImGui::Text("%u", m_unsortedStats.programChanges); ImGui::NextColumn();
+	ImGui::Text("Materials"); ImGui::NextColumn(); ImGui::Text("%u", m_sortedStats.materialChanges); ImGui::NextColumn(); ImGui::Text("%u", m_unsortedStats.materialChanges); ImGui::NextColumn();
+	ImGui::Text("Vertex arrays"); ImGui::NextColumn(); ImGui::Text("%u", m_sortedStats.vertexArrayChanges); ImGui::NextColumn(); ImGui::Text("%u", m_unsortedStats.vertexArrayChanges); ImGui::NextColumn();
+	ImGui::Text("Total"); ImGui::NextColumn(); ImGui::Text("%u", m_sortedStats.stateChanges()); ImGui::NextColumn(); ImGui::Text("%u", m_unsortedStats.stateChanges()); ImGui::NextColumn();
+	ImGui::Columns(1);
+	ImGui::End();
+}
+
+std::uint64_t RenderQueue::makeKey(RenderPass pass, GLuint program, std::uint16_t material, GLuint vertexArray, std::uint16_t depth) {
+	assert(program < (1u << 12) && vertexArray < (1u << 16) && "Object name does not fit in the sort key !");
+	return (static_cast<std::uint64_t>(pass) << 60)
+		| (static_cast<std::uint64_t>(program) << 48)
+		| (static_cast<std::uint64_t>(material) << 32)
+		| (static_cast<std::uint64_t>(vertexArray) << 16)
+		| depth;
+}
+
+std::uint64_t RenderQueue::makeFrontToBackKey(RenderPass pass, GLuint program, std::uint16_t material, GLuint vertexArray, std::uint16_t depth) {
+	assert(program < (1u << 12) && vertexArray < (1u << 16) && "Object name does not fit in the sort key !");
+	return (static_cast<std::uint64_t>(pass) << 60)
+		| (static_cast<std::uint64_t>(depth) << 44)
+		| (static_cast<std::uint64_t>(program) << 32)
+		| (static_cast<std::uint64_t>(material) << 16)
+		| vertexArray;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+///////////////////////////// PRIVATE METHODS ///////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+void RenderQueue::radixSort(std::vector<Item>& items, std::vector<Item>& scratch) {
+	// Least significant byte first, each pass is stable
+	scratch.resize(items.size());
+	for (int shift = 0; shift < 64; shift += 8) {
+		std::uint32_t offsets[256] = {};
+		for (const Item& item : items) {
+			offsets[(item.key >> shift) & 0xFF]++;
+		}
+
+		// Every key has the same byte here, the order would not change
+		if (offsets[(items.empty() ? 0 : items[0].key >> shift) & 0xFF] == items.size()) {
+			continue;
+		}
+
+		std::uint32_t sum = 0;
+		for (std::uint32_t& offset : offsets) {
+			const std::uint32_t count = offset;
+			offset = sum;
+			sum += count;
+		}
+		for (const Item& item : items) {
+			scratch[offsets[(item.key >> shift) & 0xFF]++] = item;
+		}
+		items.swap(scratch);
+	}
+}
+
+RenderQueue::Stats RenderQueue::countStateChanges(const std::vector<Item>& items) const {
+	Stats stats;
+	GLuint program = INVALID, vertexArray = INVALID;
+	const Material* material = nullptr;
+	for (const Item& item : items) {
+		const DrawCall& call = m_calls[item.index];
+		stats.programChanges += call.material->program() != program;
+		stats.materialChanges += call.material != material;
+		stats.vertexArrayChanges += call.vertexArray != vertexArray;
+		program = call.material->program();
+		material = call.material;
+		vertexArray = call.vertexArray;
+	}
+	stats.draws = static_cast<unsigned int>(items.size());
+	return stats;
+}
+
+void RenderQueue::collectDepthItems(const std::vector<Item>& items) {
+	// Only depth and vertex array matter, every draw of the pre-pass uses the same program
+	for (const Item& item : items) {
+		const DrawCall& call = m_calls[item.index];
+		if (passOf(item.key) != RenderPass::SOLID || !isInDepthPrePass(call)) {
+			continue;
+		}
+		m_depthItems.push_back({ (static_cast<std::uint64_t>(m_depths[item.index]) << 16) | depthVertexArrayOf(call), item.index });
+	}
+	if (m_sortingEnabled) {
+		radixSort(m_depthItems, m_scratch);
+	}
+}
+
+void RenderQueue::record(const std::vector<Item>& depthItems, const std::vector<Item>& items) {
+	// Slices of the pre-pass first, replayed before the ones of the main pass
+	const std::uint32_t depthCount = static_cast<std::uint32_t>(depthItems.size());
+	const std::uint32_t count = static_cast<std::uint32_t>(items.size());
+	const std::uint32_t depthSliceCount = (depthCount + RECORD_GRAIN - 1) / RECORD_GRAIN;
+	const std::uint32_t sliceCount = depthSliceCount + (count + RECORD_GRAIN - 1) / RECORD_GRAIN;
+	m_commands.resize(sliceCount);
+
+	auto recordSlices = [&](std::uint32_t begin, std::uint32_t end) {
+		for (std::uint32_t slice = begin; slice < end; slice++) {
+			m_commands[slice].reset(m_arena);
+			if (slice < depthSliceCount) {
+				recordDepthSlice(depthItems, slice * RECORD_GRAIN, std::min(depthCount, (slice + 1) * RECORD_GRAIN), m_commands[slice]);
+			} else {
+				const std::uint32_t first = (slice - depthSliceCount) * RECORD_GRAIN;
+				recordSlice(items, first, std::min(count, first + RECORD_GRAIN), m_commands[slice]);
+			}
+		}
+	};
+
+	if (m_jobs != nullptr && sliceCount > 1) {
+		Job* root = m_jobs->parallelFor(0, sliceCount, 1, recordSlices);
+		m_jobs->run(root);
+		m_jobs->wait(root);
+	} else {
+		recordSlices(0, sliceCount);
+	}
+}
+
+void RenderQueue::recordDepthSlice(const std::vector<Item>& items, std::uint32_t begin, std::uint32_t end, CommandBuffer& commands) const {
+	commands.bindPipeline(m_depthProgram);
+	commands.setUniformMat4("uViewProj", m_viewProj);
+	commands.setDepthState(GL_LESS, true, false);
+	GLuint vertexArray = INVALID;
+
+	for (std::uint32_t i = begin; i < end; i++) {
+		const DrawCall& call = m_calls[items[i].index];
+		if (depthVertexArrayOf(call) != vertexArray) {
+			vertexArray = depthVertexArrayOf(call);
+			commands.bindVertexArray(vertexArray);
+		}
+		commands.setUniformMat4("uModel", call.model);
+		commands.drawIndexed(*call.indices, GL_TRIANGLES, call.instanceCount);
+	}
+}
+
+void RenderQueue::recordSlice(const std::vector<Item>& items, std::uint32_t begin, std::uint32_t end, CommandBuffer& commands) const {
+	// Each slice starts from an unknown state, it may be replayed after any other
+	GLuint program = INVALID, vertexArray = INVALID;
+	const Material* material = nullptr;
+	int pass = -1;
+	GLenum depthFunc = GL_NONE;
+
+	for (std::uint32_t i = begin; i < end; i++) {
+		const DrawCall& call = m_calls[items[i].index];
+
+		// Solid fragments hidden by the pre-pass fail the depth test before being shaded, instanced ones were not in it and write their depth.
+		// Blended ones are tested against the solid depth but do not write it, overdraw keeps its additive blending.
+		const RenderPass itemPass = passOf(items[i].key);
+		const GLenum itemDepthFunc = itemPass == RenderPass::SOLID && m_depthPrePassEnabled && isInDepthPrePass(call) ? GL_EQUAL : GL_LESS;
+		if (static_cast<int>(itemPass) != pass || itemDepthFunc != depthFunc) {
+			depthFunc = itemDepthFunc;
+			commands.setDepthState(depthFunc, depthFunc == GL_LESS && itemPass != RenderPass::BLENDED);
+		}
+		if (static_cast<int>(itemPass) != pass) {
+			pass = static_cast<int>(itemPass);
+			if (!m_overdrawEnabled) {
+				commands.setBlendState(itemPass == RenderPass::BLENDED);
+			}
+		}
+
+		// Overdraw only needs the positions, like the pre-pass
+		const GLuint callProgram = m_overdrawEnabled ? m_overdrawProgram : call.material->program();
+		const GLuint callVertexArray = m_overdrawEnabled ? depthVertexArrayOf(call) : call.vertexArray;
+		if (callProgram != program) {
+			program = callProgram;
+			commands.bindPipeline(program);
+			commands.setUniformMat4("uViewProj", m_viewProj);
+		}
+		if (call.material != material && !m_overdrawEnabled) {
+			material = call.material;
+			material->bind(commands);
+		}
+		if (callVertexArray != vertexArray) {
+			vertexArray = callVertexArray;
+			commands.bindVertexArray(vertexArray);
+		}
+
+		commands.setUniformMat4("uModel", call.model);
+		commands.drawIndexed(*call.indices, GL_TRIANGLES, call.instanceCount);
+	}
+}
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+#include "command-buffer.h"
+
+class IndexBuffer;
+class JobSystem;
+class Material;
+
+/**
+ * @brief Order of the passes, the first field of sort keys
+ */
+enum class RenderPass : std::uint8_t {
+    SOLID = 0,   // Front to back
+    BLENDED = 1, // Back to front
+    OVERLAY = 2
+};
+
+/**
+ * @brief Draws collected during the frame, sorted by a 64 bits key then executed with the fewest state changes
+ * @note Key, from the most significant bits : pass 4 | pipeline 12 | material 16 | vertex array 16 | depth 16.
+ *       Solid draws are ordered front to back first when enabled, so that early depth testing rejects hidden fragments :
+ *       pass 4 | depth 16 | pipeline 12 | material 16 | vertex array 16.
+ *       Blended draws always use the depth first key with an inverted depth, they are alpha blended back to front
+ *       without writing depth. Blending and depth writes are back to their defaults (off and on) after flush().
+ *       The pipeline of the material is set once per program change with the "uViewProj" of the queue,
+ *       the material once per material change and "uModel" per draw.
+ *       Sorted draws are recorded as commands, in slices of RECORD_GRAIN draws on the JobSystem when one is given,
+ *       then replayed in order on the OpenGL thread.
+ *
+ *       With the depth pre-pass, solid draws are first drawn front to back with a position only program,
+ *       then in state order with GL_EQUAL and no depth write : heavy fragment shaders run once per pixel.
+ *       Instanced solid draws skip the pre-pass, which has no per instance attributes, and keep the regular depth test.
+ *       Vertex shaders of solid materials must declare "invariant gl_Position" to get the same depth.
+ *
+ * @code
+ * queue.setViewProj(viewProjMat);
+ * queue.submit(RenderPass::SOLID, { &material, vao, &indices, 1, modelMat }, distanceToCamera);
+ * queue.flush();
+ * @endcode
+ */
+class RenderQueue {
+public:
+    struct DrawCall {
+        const Material* material;
+        GLuint vertexArray;
+        const IndexBuffer* indices;
+        GLsizei instanceCount;
+        glm::mat4 model;
+        // Positions only at location 0 as a vec3, for the depth pre-pass. vertexArray is used instead when 0.
+        // Instanced draws are left out of it, they are drawn with GL_LESS and write their depth in the main pass.
+        GLuint depthVertexArray = 0;
+    };
+
+    struct Stats {
+        unsigned int draws = 0;
+        unsigned int programChanges = 0;
+        unsigned int materialChanges = 0;
+        unsigned int vertexArrayChanges = 0;
+
+        unsigned int stateChanges() const { return programChanges + materialChanges + vertexArrayChanges; }
+    };
+
+public:
+    static constexpr std::uint32_t RECORD_GRAIN = 256;
+
+    /**
+     * @param depthRange - View distance mapped to the 16 bits of depth in keys, further draws share the last value
+     * @param jobs - Records commands on worker threads, everything is recorded on the calling thread if null
+     */
+    RenderQueue(float depthRange = 100.0f, JobSystem* jobs = nullptr);
+    ~RenderQueue();
+
+    RenderQueue(const RenderQueue&) = delete;
+    RenderQueue& operator=(const RenderQueue&) = delete;
+
+    void setViewProj(const glm::mat4& viewProj);
+    void submit(RenderPass pass, const DrawCall& call, float viewDepth);
+
+    /**
+     * @brief Sort, execute and clear every submitted draw
+     */
+    void flush();
+
+    /**
+     * @brief When disabled, draws are executed in submission order. Both orders are still measured.
+     */
+    void setSortingEnabled(bool enabled);
+    bool isSortingEnabled() const;
+
+    /**
+     * @brief Solid draws sorted by depth before state, ignored with the depth pre-pass which already is front to back
+     */
+    void setFrontToBackEnabled(bool enabled);
+    bool isFrontToBackEnabled() const;
+
+    void setDepthPrePassEnabled(bool enabled);
+    bool isDepthPrePassEnabled() const;
+
+    /**
+     * @brief Every shaded fragment adds the same gray instead of its material, the color buffer is cleared to black first
+     */
+    void setOverdrawEnabled(bool enabled);
+    bool isOverdrawEnabled() const;
+
+    /**
+     * @brief State changes of the last flush in sorted and in submission order
+     */
+    const Stats& sortedStats() const;
+    const Stats& unsortedStats() const;
+
+    void showMetrics();
+
+    static std::uint64_t makeKey(RenderPass pass, GLuint program, std::uint16_t material, GLuint vertexArray, std::uint16_t depth);
+    static std::uint64_t makeFrontToBackKey(RenderPass pass, GLuint program, std::uint16_t material, GLuint vertexArray, std::uint16_t depth);
+
+private:
+    struct Item {
+        std::uint64_t key;
+        std::uint32_t index;
+    };
+
+    static void radixSort(std::vector<Item>& items, std::vector<Item>& scratch);
+    Stats countStateChanges(const std::vector<Item>& items) const;
+    void collectDepthItems(const std::vector<Item>& items);
+    void record(const std::vector<Item>& depthItems, const std::vector<Item>& items);
+    void recordDepthSlice(const std::vector<Item>& items, std::uint32_t begin, std::uint32_t end, CommandBuffer& commands) const;
+    void recordSlice(const std::vector<Item>& items, std::uint32_t begin, std::uint32_t end, CommandBuffer& commands) const;
+
+private:
+    float m_depthRange;
+    JobSystem* m_jobs;
+    glm::mat4 m_viewProj;
+    bool m_sortingEnabled;
+    bool m_frontToBackEnabled;
+    bool m_depthPrePassEnabled;
+    bool m_overdrawEnabled;
+
+    GLuint m_depthProgram;
+    GLuint m_overdrawProgram;
+
+    std::vector<DrawCall> m_calls;
+    std::vector<std::uint16_t> m_depths; // Per call, whatever the layout of its key
+    std::vector<Item> m_items;
+    std::vector<Item> m_depthItems; // Solid draws of the pre-pass, by depth then vertex array
+    std::vector<Item> m_scratch;
+
+    CommandArena m_arena;
+    std::vector<CommandBuffer> m_commands;
+    CommandReplayer m_replayer;
+
+    Stats m_sortedStats;
+    Stats m_unsortedStats;
+    CommandReplayer::Stats m_replayStats;
+    double m_sortMs;
+    double m_recordMs;
+};
@@ -0,0 +1,127 @@
+#include "render-target.h"
+
+#include "gl-exception.h"
+#include <spdlog/spdlog.h>
+
+RenderTarget::RenderTarget(int width, int height, int samples, bool withDepth)
+	: m_fb(0), m_color(0), m_depth(0), m_width(width), m_height(height), m_samples(samples), m_withDepth(withDepth)
+{
+	create();
+}
+
+RenderTarget::~RenderTarget() {
+	destroy();
+}
+
+void RenderTarget::resize(int width, int height) {
+	if (width == m_width && height == m_height) {
+		return;
+	}
+	destroy();
+	m_width = width;
+	m_height = height;
+	create();
+}
+
+void RenderTarget::bind(int viewportWidth, int viewportHeight) const {
+	GLCall(glBindFramebuffer(GL_FRAMEBUFFER, m_fb));
+	GLCall(glViewport(0, 0, viewportWidth, viewportHeight));
+}
+
+void RenderTarget::bind() const {
+	bind(m_width, m_height);
+}
+
+void RenderTarget::unbind() {
+	GLCall(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+}
+
+void RenderTarget::resolve(const RenderTarget& destination, int width, int height) const {
+	GLCall(glBindFramebuffer(GL_READ_FRAMEBUFFER, m_fb));
+	GLCall(glBindFramebuffer(GL_DRAW_FRAMEBUFFER, destination.m_fb));
+	GLCall(glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST));
+	GLCall(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+}
+
+void RenderTarget::blitToScreen(int srcWidth, int srcHeight, int screenWidth, int screenHeight) const {
+	const bool sameSize = srcWidth == screenWidth && srcHeight == screenHeight;
+	assert((m_samples == 0 || sameSize) && "Resolve a multisampled target before scaling it !");
+
+	GLCall(glBindFramebuffer(GL_READ_FRAMEBUFFER, m_fb));
+	GLCall(glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0));
+	GLCall(glBlitFramebuffer(
+		0, 0, srcWidth, srcHeight,
+		0, 0, screenWidth, screenHeight,
+		GL_COLOR_BUFFER_BIT, sameSize ? GL_NEAREST : GL_LINEAR
+	));
+	GLCall(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+	GLCall(glViewport(0, 0, screenWidth, screenHeight));
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//////////////////////////// GETTERS & SETTERS //////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+GLuint RenderTarget::colorTexture() const {
+	assert(m_samples == 0 && "Multisampled targets have no texture, resolve them first !");
+	return m_color;
+}
+
+int RenderTarget::width() const { return m_width; }
+int RenderTarget::height() const { return m_height; }
+int RenderTarget::samples() const { return m_samples; }
+
+/////////////////////////////////////////////////////////////////////////////
+///////////////////////////// PRIVATE METHODS ///////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+void RenderTarget::create() {
+	GLCall(glGenFramebuffers(1, &m_fb));
+	GLCall(glBindFramebuffer(GL_FRAMEBUFFER, m_fb));
+
+	// ------------------ Color
+	if (m_samples > 0) {
+		GLCall(glGenRenderbuffers(1, &m_color));
+		GLCall(glBindRenderbuffer(GL_RENDERBUFFER, m_color));
+		GLCall(glRenderbufferStorageMultisample(GL_RENDERBUFFER, m_samples, GL_RGBA8, m_width, m_height));
+		GLCall(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_color));
+	} else {
+		GLCall(glGenTextures(1, &m_color));
+		GLCall(glBindTexture(GL_TEXTURE_2D, m_color));
+		GLCall(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_width, m_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL));
+		GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
+		GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+		GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+		GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+		GLCall(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_color, 0));
+		GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+	}
+
+	// ------------------ Depth stencil
+	if (m_withDepth) {
+		GLCall(glGenRenderbuffers(1, &m_depth));
+		GLCall(glBindRenderbuffer(GL_RENDERBUFFER, m_depth));
+		GLCall(glRenderbufferStorageMultisample(GL_RENDERBUFFER, m_samples, GL_DEPTH24_STENCIL8, m_width, m_height));
+		GLCall(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_depth));
+	}
+	GLCall(glBindRenderbuffer(GL_RENDERBUFFER, 0));
+
+	GLCall(GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER));
+	if (status != GL_FRAMEBUFFER_COMPLETE) {
+		spdlog::critical("[RenderTarget] Framebuffer incomplete : {:#x}", status);
+		debug_break();
+	}
+	GLCall(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+}
+
+void RenderTarget::destroy() {
+	if (m_samples > 0) {
+		GLCall(glDeleteRenderbuffers(1, &m_color));
+	} else {
+		GLCall(glDeleteTextures(1, &m_color));
+	}
+	if (m_withDepth) {
+		GLCall(glDeleteRenderbuffers(1, &m_depth));
+	}
+	GLCall(glDeleteFramebuffers(1, &m_fb));
+}
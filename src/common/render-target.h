@@ -0,0 +1,65 @@
+#pragma once
+
+#include <glad/glad.h>
+
+/**
+ * @brief Offscreen framebuffer with a color and an optional depth-stencil attachment
+ * @note With samples > 0 the attachments are multisampled renderbuffers,
+ *       which must be resolved into a single sampled target before being sampled or scaled
+ */
+class RenderTarget {
+public:
+    /**
+     * @param samples - 0 for a regular target with a sampleable color texture
+     */
+    RenderTarget(int width, int height, int samples = 0, bool withDepth = true);
+    ~RenderTarget();
+
+    RenderTarget(const RenderTarget&) = delete;
+    RenderTarget& operator=(const RenderTarget&) = delete;
+
+    /**
+     * @brief Reallocate the attachments, content is lost
+     */
+    void resize(int width, int height);
+
+    /**
+     * @brief Render into the target, viewport is set to the given area from the origin
+     */
+    void bind(int viewportWidth, int viewportHeight) const;
+    void bind() const;
+
+    /**
+     * @brief Go back to the default framebuffer
+     */
+    static void unbind();
+
+    /**
+     * @brief Resolve (or copy) the [0, width]x[0, height] area of this target into destination
+     */
+    void resolve(const RenderTarget& destination, int width, int height) const;
+
+    /**
+     * @brief Scale the [0, srcWidth]x[0, srcHeight] area of this target to the whole default framebuffer
+     * @note Cannot be used on a multisampled target unless sizes match, resolve it first
+     */
+    void blitToScreen(int srcWidth, int srcHeight, int screenWidth, int screenHeight) const;
+
+    GLuint colorTexture() const;
+    int width() const;
+    int height() const;
+    int samples() const;
+
+private:
+    void create();
+    void destroy();
+
+private:
+    GLuint m_fb;
+    GLuint m_color;
+    GLuint m_depth;
+    int m_width;
+    int m_height;
+    int m_samples;
+    bool m_withDepth;
+};
@@ -0,0 +1,126 @@
+#include "scene-culling.h"
+
+#include "job-system.h"
+#include "occlusion-buffer.h"
+#include <imgui.h>
+#include <chrono>
+
+SceneCulling::SceneCulling(JobSystem& jobs, OcclusionBuffer* occlusion)
+	: m_jobs(jobs), m_occlusion(occlusion), m_threadBatches(jobs.threadCount()), m_threadOccluded(jobs.threadCount()),
+	  m_testedCount(0), m_visibleCount(0), m_occludedCount(0), m_cullMs(0.0)
+{}
+
+void SceneCulling::cull(EntityWorld& world, const glm::mat4& viewProj) {
+	const auto start = std::chrono::high_resolution_clock::now();
+
+	// Gribb / Hartmann : planes are sums of the last row with the others, normalized to measure distances
+	const glm::mat4 rows = glm::transpose(viewProj);
+	for (int i = 0; i < 3; i++) {
+		m_planes[i * 2] = rows[3] + rows[i];
+		m_planes[i * 2 + 1] = rows[3] - rows[i];
+	}
+	for (glm::vec4& plane : m_planes) {
+		plane /= glm::length(glm::vec3(plane));
+	}
+
+	if (m_occlusion != nullptr) {
+		m_occlusion->begin(viewProj);
+		world.each<const Transform, const Occluder>([this](const Transform& transform, const Occluder& occluder) {
+			const glm::vec3 halfExtents = occluder.halfExtents * transform.scale;
+			m_occlusion->addBox(transform.position - halfExtents, transform.position + halfExtents);
+		});
+		m_occlusion->rasterize();
+	}
+
+	for (auto& batches : m_threadBatches) {
+		for (std::vector<Instance>& instances : batches) {
+			instances.clear();
+		}
+	}
+	std::fill(m_threadOccluded.begin(), m_threadOccluded.end(), ThreadCounter{ 0 });
+
+	world.parallelEachChunk<const Transform, const Bounds, const Renderable>(m_jobs,
+		[this](std::uint32_t count, const Entity*, const Transform* transforms, const Bounds* bounds, const Renderable* renderables) {
+			cullChunk(count, transforms, bounds, renderables);
+		}
+	);
+
+	// ------------------ Concatenate the lists of every thread
+	std::size_t batchCount = 0;
+	for (const auto& batches : m_threadBatches) {
+		batchCount = std::max(batchCount, batches.size());
+	}
+	m_batches.resize(batchCount);
+	m_visibleCount = 0;
+	for (std::size_t batch = 0; batch < batchCount; batch++) {
+		std::vector<Instance>& instances = m_batches[batch];
+		instances.clear();
+		for (const auto& batches : m_threadBatches) {
+			if (batch < batches.size()) {
+				instances.insert(instances.end(), batches[batch].begin(), batches[batch].end());
+			}
+		}
+		m_visibleCount += instances.size();
+	}
+	m_testedCount = world.count<Transform, Bounds, Renderable>();
+	m_occludedCount = 0;
+	for (const ThreadCounter& counter : m_threadOccluded) {
+		m_occludedCount += counter.occluded;
+	}
+
+	m_cullMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void SceneCulling::showMetrics() {
+	ImGui::Begin("Culling");
+	ImGui::Text("Visible : %zu / %zu in %zu batches", m_visibleCount, m_testedCount, m_batches.size());
+	ImGui::Text("Occluded : %zu", m_occludedCount);
+	ImGui::Text("Last cull : %.3f ms", m_cullMs);
+	ImGui::End();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//////////////////////////// GETTERS & SETTERS //////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+const std::vector<SceneCulling::Instance>& SceneCulling::visible(std::uint32_t batch) const {
+	return batch < m_batches.size() ? m_batches[batch] : m_empty;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+///////////////////////////// PRIVATE METHODS ///////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+void SceneCulling::cullChunk(std::uint32_t count, const Transform* transforms, const Bounds* bounds, const Renderable* renderables) {
+	const unsigned int thread = JobSystem::threadIndex();
+	std::vector<std::vector<Instance>>& batches = m_threadBatches[thread];
+	std::size_t occluded = 0;
+
+	// Local copy, the planes would be reloaded after every push_back otherwise
+	glm::vec4 planes[6];
+	std::copy(std::begin(m_planes), std::end(m_planes), planes);
+
+	for (std::uint32_t i = 0; i < count; i++) {
+		const glm::vec4 center(transforms[i].position + bounds[i].center * transforms[i].scale, 1.0f);
+		const float radius = bounds[i].radius * transforms[i].scale;
+
+		float distance = glm::dot(planes[0], center);
+		for (int p = 1; p < 6; p++) {
+			distance = std::min(distance, glm::dot(planes[p], center));
+		}
+		if (distance < -radius) {
+			continue;
+		}
+		if (m_occlusion != nullptr && !m_occlusion->isVisible(glm::vec3(center) - radius, glm::vec3(center) + radius)) {
+			occluded++;
+			continue;
+		}
+
+		const Renderable& renderable = renderables[i];
+		if (renderable.batch >= batches.size()) {
+			batches.resize(renderable.batch + 1);
+		}
+		batches[renderable.batch].push_back({ transforms[i].position, renderable.textureLayer, renderable.textureRect });
+	}
+	m_threadOccluded[thread].occluded += occluded;
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+#include "ecs.h"
+
+class JobSystem;
+class OcclusionBuffer;
+
+// ------------------ Components of the objects drawn by SceneCulling
+
+struct Transform {
+    glm::vec3 position;
+    float scale = 1.0f;
+};
+
+/**
+ * @brief Bounding sphere in local space, scaled and moved by the Transform
+ */
+struct Bounds {
+    glm::vec3 center = glm::vec3(0.0f);
+    float radius = 1.0f;
+};
+
+/**
+ * @brief Box drawn into the OcclusionBuffer, centered on the Transform and scaled by it
+ */
+struct Occluder {
+    glm::vec3 halfExtents = glm::vec3(1.0f);
+};
+
+/**
+ * @brief Instance of a batch, batches are drawn with one instanced draw each
+ */
+struct Renderable {
+    std::uint32_t batch = 0;
+    float textureLayer = 0.0f;
+    glm::vec4 textureRect = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+};
+
+/**
+ * @brief Frustum culling of every entity with a Transform, Bounds and Renderable, gathering visible instances per batch
+ * @note Chunks are split across the JobSystem, each thread appends to its own lists which are concatenated at the end.
+ *       With an OcclusionBuffer, entities with an Occluder are rasterized first and instances hidden behind them are dropped.
+ *       The instance layout is the one of the per instance attributes of instanced meshes.
+ *
+ * @code
+ * culling.cull(world, viewProj * model);
+ * const std::vector<SceneCulling::Instance>& cubes = culling.visible(CUBE_BATCH);
+ * @endcode
+ */
+class SceneCulling {
+public:
+    struct Instance {
+        glm::vec3 translation;
+        float textureLayer;
+        glm::vec4 textureRect;
+    };
+
+public:
+    SceneCulling(JobSystem& jobs, OcclusionBuffer* occlusion = nullptr);
+    ~SceneCulling() = default;
+
+    /**
+     * @param viewProj - Clip space of the entities, so including the model matrix they are drawn with
+     */
+    void cull(EntityWorld& world, const glm::mat4& viewProj);
+
+    /**
+     * @brief Instances of the batch kept by the last cull()
+     */
+    const std::vector<Instance>& visible(std::uint32_t batch) const;
+
+    void showMetrics();
+
+private:
+    void cullChunk(std::uint32_t count, const Transform* transforms, const Bounds* bounds, const Renderable* renderables);
+
+private:
+    JobSystem& m_jobs;
+    OcclusionBuffer* m_occlusion;
+    glm::vec4 m_planes[6]; // Inside when dot(plane, (p, 1)) >= -radius
+
+    // ------------------ Per thread then per batch
+    std::vector<std::vector<std::vector<Instance>>> m_threadBatches;
+    struct alignas(64) ThreadCounter { // One cache line each, threads do not share one while counting
+        std::size_t occluded;
+    };
+    std::vector<ThreadCounter> m_threadOccluded;
+    std::vector<std::vector<Instance>> m_batches;
+    std::vector<Instance> m_empty;
+
+    // ------------------ Last cull
+    std::size_t m_testedCount;
+    std::size_t m_visibleCount;
+    std::size_t m_occludedCount;
+    double m_cullMs;
+};
@@ -0,0 +1,64 @@
+#include "shader-utils.h"
+
+#include "gl-exception.h"
+#include <spdlog/spdlog.h>
+#include <debug_break/debug_break.h>
+#include <fstream>
+#include <sstream>
+
+std::string shaderUtils::readFile(const std::string& filepath) {
+	std::ifstream stream(filepath);
+	if (!stream) {
+		spdlog::error("[Shader] Cannot open file '{}'", filepath);
+		debug_break();
+		return "";
+	}
+	std::stringstream buffer;
+	buffer << stream.rdbuf();
+	return buffer.str();
+}
+
+GLuint shaderUtils::createProgram(const std::vector<Stage>& stages, const std::vector<const char*>& feedbackVaryings) {
+	int success;
+	char infoLog[512];
+	GLCall(GLuint program = glCreateProgram());
+
+	std::vector<GLuint> shaders;
+	for (const Stage& stage : stages) {
+		const char* source = stage.source.c_str();
+		GLCall(GLuint shader = glCreateShader(stage.type));
+		GLCall(glShaderSource(shader, 1, &source, NULL));
+		GLCall(glCompileShader(shader));
+
+		GLCall(glGetShaderiv(shader, GL_COMPILE_STATUS, &success));
+		if (!success) {
+			GLCall(glGetShaderInfoLog(shader, 512, NULL, infoLog));
+			spdlog::critical("[Shader] Compilation failed : {}", infoLog);
+			debug_break();
+		}
+		GLCall(glAttachShader(program, shader));
+		shaders.push_back(shader);
+	}
+
+	// Must be known before linking
+	if (!feedbackVaryings.empty()) {
+		GLCall(glTransformFeedbackVaryings(program, static_cast<GLsizei>(feedbackVaryings.size()), feedbackVaryings.data(), GL_INTERLEAVED_ATTRIBS));
+	}
+
+	GLCall(glLinkProgram(program));
+	GLCall(glGetProgramiv(program, GL_LINK_STATUS, &success));
+	if (!success) {
+		GLCall(glGetProgramInfoLog(program, 512, NULL, infoLog));
+		spdlog::critical("[Pipeline] Link failed : {}", infoLog);
+		debug_break();
+	}
+
+	for (GLuint shader : shaders) {
+		GLCall(glDeleteShader(shader));
+	}
+	return program;
+}
+
+GLuint shaderUtils::createProgram(const std::string& vertexFilepath, const std::string& fragmentFilepath) {
+	return createProgram({ { GL_VERTEX_SHADER, readFile(vertexFilepath) }, { GL_FRAGMENT_SHADER, readFile(fragmentFilepath) } });
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <string>
+#include <vector>
+
+namespace shaderUtils {
+    struct Stage {
+        GLenum type; // GL_VERTEX_SHADER, GL_GEOMETRY_SHADER or GL_FRAGMENT_SHADER
+        std::string source;
+    };
+
+    std::string readFile(const std::string& filepath);
+
+    /**
+     * @brief Compile and link the stages, failures are logged and break like in ShaderPipeline
+     * @param feedbackVaryings - Outputs captured interleaved by transform feedback, in buffer order
+     */
+    GLuint createProgram(const std::vector<Stage>& stages, const std::vector<const char*>& feedbackVaryings = {});
+
+    /**
+     * @brief Same from a vertex and a fragment shader file
+     */
+    GLuint createProgram(const std::string& vertexFilepath, const std::string& fragmentFilepath);
+}
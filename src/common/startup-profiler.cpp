@@ -0,0 +1,76 @@
+#include "startup-profiler.h"
+
+#include <spdlog/spdlog.h>
+#include <chrono>
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace {
+	// Initialized with the other globals, before main : the closest we can portably get to process start
+	const std::chrono::steady_clock::time_point processStart = std::chrono::steady_clock::now();
+	const std::thread::id mainThread = std::this_thread::get_id();
+
+	std::mutex phasesMutex;
+	std::vector<startup::Phase> recordedPhases;
+	std::map<std::thread::id, unsigned int> threadIndices;
+	double firstFrameMs = 0.0;
+
+	void record(const char* name, double beginMs, double endMs) {
+		std::lock_guard<std::mutex> lock(phasesMutex);
+		const std::thread::id id = std::this_thread::get_id();
+		unsigned int thread = 0;
+		if (id != mainThread) {
+			auto it = threadIndices.find(id);
+			if (it == threadIndices.end()) {
+				it = threadIndices.emplace(id, static_cast<unsigned int>(threadIndices.size() + 1)).first;
+			}
+			thread = it->second;
+		}
+		recordedPhases.push_back({ name, beginMs, endMs, thread });
+	}
+}
+
+startup::Scope::Scope(const char* name) : m_name(name), m_beginMs(elapsedMs()) {}
+
+startup::Scope::~Scope() {
+	record(m_name, m_beginMs, elapsedMs());
+}
+
+void startup::mark(const char* name) {
+	const double now = elapsedMs();
+	record(name, now, now);
+}
+
+double startup::elapsedMs() {
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - processStart).count();
+}
+
+double startup::timeToFirstFrameMs() {
+	std::lock_guard<std::mutex> lock(phasesMutex);
+	if (firstFrameMs == 0.0) {
+		for (const Phase& phase : recordedPhases) {
+			if (phase.name == "First frame") {
+				firstFrameMs = phase.endMs;
+				break;
+			}
+		}
+	}
+	return firstFrameMs;
+}
+
+std::vector<startup::Phase> startup::phases() {
+	std::lock_guard<std::mutex> lock(phasesMutex);
+	return recordedPhases;
+}
+
+void startup::logReport() {
+	std::vector<Phase> sorted = phases();
+	std::stable_sort(sorted.begin(), sorted.end(), [](const Phase& a, const Phase& b) { return a.beginMs < b.beginMs; });
+
+	spdlog::info("[Startup] {:>9} {:>9} {:>7}  phase", "begin", "duration", "thread");
+	for (const Phase& phase : sorted) {
+		spdlog::info("[Startup] {:9.2f} {:9.2f} {:>7}  {}", phase.beginMs, phase.endMs - phase.beginMs, phase.thread, phase.name);
+	}
+}
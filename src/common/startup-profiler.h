@@ -0,0 +1,52 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+/**
+ * @brief Timestamps of the startup phases, from process start to the first presented frame
+ * @note Thread safe, so that work moved to other threads during startup can be traced too
+ */
+namespace startup {
+    struct Phase {
+        std::string name;
+        double beginMs;
+        double endMs;
+        unsigned int thread; // 0 for the main thread
+    };
+
+    /**
+     * @brief Record the duration of the enclosing block as a phase
+     */
+    class Scope {
+    public:
+        Scope(const char* name);
+        ~Scope();
+
+    private:
+        const char* m_name;
+        double m_beginMs;
+    };
+
+    /**
+     * @brief Record an instant event, like the first frame
+     */
+    void mark(const char* name);
+
+    /**
+     * @brief Time since the process started
+     */
+    double elapsedMs();
+
+    /**
+     * @brief Time of the first "First frame" mark, 0 if not reached yet
+     */
+    double timeToFirstFrameMs();
+
+    std::vector<Phase> phases();
+
+    /**
+     * @brief Print every phase to the console
+     */
+    void logReport();
+}
@@ -0,0 +1,154 @@
+#include "texture-array.h"
+
+#include "gl-exception.h"
+#include "command-buffer.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+
+// imgui_draw.cpp compiles its own static copy, this one is private to this file as well
+#define STBRP_STATIC
+#define STB_RECT_PACK_IMPLEMENTATION
+#include <imstb_rectpack.h>
+
+struct TextureArray::AtlasPage {
+	stbrp_context context;
+	std::vector<stbrp_node> nodes;
+	int layer;
+};
+
+TextureArray::TextureArray(int layerSize, int maxLayers, int padding)
+	: m_id(0), m_layerSize(layerSize), m_maxLayers(maxLayers), m_padding(padding), m_usedLayers(0), m_mipmapsDirty(false)
+{
+	GLint maxArrayLayers = 0;
+	GLCall(glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxArrayLayers));
+	if (maxLayers > maxArrayLayers) {
+		spdlog::warn("[TextureArray] {} layers requested, hardware supports {}", maxLayers, maxArrayLayers);
+		m_maxLayers = maxArrayLayers;
+	}
+
+	GLCall(glGenTextures(1, &m_id));
+	GLCall(glBindTexture(GL_TEXTURE_2D_ARRAY, m_id));
+	GLCall(glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, m_layerSize, m_layerSize, m_maxLayers, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL));
+	GLCall(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR));
+	GLCall(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+	GLCall(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+	GLCall(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+	GLCall(glGenerateMipmap(GL_TEXTURE_2D_ARRAY));
+	GLCall(glBindTexture(GL_TEXTURE_2D_ARRAY, 0));
+}
+
+TextureArray::~TextureArray() {
+	GLCall(glDeleteTextures(1, &m_id));
+}
+
+bool TextureArray::add(const std::uint8_t* pixels, int width, int height, TextureRegion& region) {
+	if (width > m_layerSize || height > m_layerSize) {
+		spdlog::warn("[TextureArray] Image of {}x{} does not fit layers of {}x{}", width, height, m_layerSize, m_layerSize);
+		return false;
+	}
+
+	// Full size, or too big to get a padding in an atlas : a layer of its own
+	if (width + 2 * m_padding > m_layerSize || height + 2 * m_padding > m_layerSize) {
+		if (m_usedLayers == m_maxLayers) {
+			spdlog::warn("[TextureArray] No layer left");
+			return false;
+		}
+		// The rest of the layer is only reached by filtering and mipmaps, it gets the edges of the image
+		upload(pixels, 0, 0, width, height, m_usedLayers, m_layerSize);
+		const float size = static_cast<float>(m_layerSize);
+		region.layer = static_cast<float>(m_usedLayers);
+		region.uvRect = glm::vec4(0.0f, 0.0f, width / size, height / size);
+		m_usedLayers++;
+		return true;
+	}
+
+	return addToAtlas(pixels, width, height, region);
+}
+
+void TextureArray::bind(unsigned int slot) {
+	GLCall(glActiveTexture(GL_TEXTURE0 + slot));
+	GLCall(glBindTexture(GL_TEXTURE_2D_ARRAY, m_id));
+	if (m_mipmapsDirty) {
+		GLCall(glGenerateMipmap(GL_TEXTURE_2D_ARRAY));
+		m_mipmapsDirty = false;
+	}
+}
+
+void TextureArray::bind(CommandBuffer& commands, unsigned int slot) const {
+	assert(!m_mipmapsDirty && "Mipmaps are outdated, call bind() on the OpenGL thread first !");
+	commands.bindTexture(slot, GL_TEXTURE_2D_ARRAY, m_id);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//////////////////////////// GETTERS & SETTERS //////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+GLuint TextureArray::id() const { return m_id; }
+int TextureArray::layerSize() const { return m_layerSize; }
+int TextureArray::usedLayers() const { return m_usedLayers; }
+int TextureArray::maxLayers() const { return m_maxLayers; }
+
+/////////////////////////////////////////////////////////////////////////////
+///////////////////////////// PRIVATE METHODS ///////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+bool TextureArray::addToAtlas(const std::uint8_t* pixels, int width, int height, TextureRegion& region) {
+	stbrp_rect rect = {};
+	rect.w = static_cast<stbrp_coord>(width + 2 * m_padding);
+	rect.h = static_cast<stbrp_coord>(height + 2 * m_padding);
+
+	// Try the existing pages first, the skyline packer accepts rectangles incrementally
+	AtlasPage* page = nullptr;
+	for (auto& candidate : m_atlasPages) {
+		if (stbrp_pack_rects(&candidate->context, &rect, 1) && rect.was_packed) {
+			page = candidate.get();
+			break;
+		}
+	}
+
+	if (page == nullptr) {
+		if (m_usedLayers == m_maxLayers) {
+			spdlog::warn("[TextureArray] No layer left for a new atlas page");
+			return false;
+		}
+		std::unique_ptr<AtlasPage> newPage(new AtlasPage());
+		newPage->nodes.resize(m_layerSize);
+		newPage->layer = m_usedLayers++;
+		stbrp_init_target(&newPage->context, m_layerSize, m_layerSize, newPage->nodes.data(), static_cast<int>(newPage->nodes.size()));
+		stbrp_pack_rects(&newPage->context, &rect, 1);
+		page = newPage.get();
+		m_atlasPages.push_back(std::move(newPage));
+	}
+
+	const int x = rect.x + m_padding;
+	const int y = rect.y + m_padding;
+	upload(pixels, x, y, width, height, page->layer, m_padding);
+
+	const float size = static_cast<float>(m_layerSize);
+	region.layer = static_cast<float>(page->layer);
+	region.uvRect = glm::vec4(x / size, y / size, width / size, height / size);
+	return true;
+}
+
+void TextureArray::upload(const std::uint8_t* pixels, int x, int y, int width, int height, int layer, int padding) {
+	// Border pixels are repeated in the padding, the storage is left undefined by glTexImage3D
+	const int left = std::max(0, x - padding);
+	const int bottom = std::max(0, y - padding);
+	const int right = std::min(m_layerSize, x + width + padding);
+	const int top = std::min(m_layerSize, y + height + padding);
+	std::vector<std::uint8_t> extruded(static_cast<std::size_t>(right - left) * (top - bottom) * 4);
+	std::uint8_t* destination = extruded.data();
+	for (int j = bottom; j < top; j++) {
+		const std::uint8_t* row = pixels + static_cast<std::size_t>(std::min(std::max(j - y, 0), height - 1)) * width * 4;
+		for (int i = left; i < right; i++) {
+			std::copy_n(row + std::min(std::max(i - x, 0), width - 1) * 4, 4, destination);
+			destination += 4;
+		}
+	}
+
+	GLCall(glBindTexture(GL_TEXTURE_2D_ARRAY, m_id));
+	GLCall(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+	GLCall(glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, left, bottom, layer, right - left, top - bottom, 1, GL_RGBA, GL_UNSIGNED_BYTE, extruded.data()));
+	GLCall(glBindTexture(GL_TEXTURE_2D_ARRAY, 0));
+	m_mipmapsDirty = true;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class CommandBuffer;
+
+/**
+ * @brief Where an image ended up in a TextureArray
+ * @note Sample with vec3(uvRect.xy + uv * uvRect.zw, layer)
+ */
+struct TextureRegion {
+    float layer = 0.0f;
+    glm::vec4 uvRect = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f); // Offset in xy, scale in zw
+};
+
+/**
+ * @brief GL_TEXTURE_2D_ARRAY holding many images, so that differently textured instances share one draw call
+ * @note Images close to the layer size get a layer of their own. Smaller ones are packed with imstb_rectpack
+ *       into atlas layers, with a padding filled with their border pixels so that bilinear filtering
+ *       and the first mip levels do not bleed between neighbours.
+ *       Storage is allocated for every layer up front.
+ */
+class TextureArray {
+public:
+    /**
+     * @param layerSize - Width and height of every layer
+     * @param maxLayers - Must fit GL_MAX_ARRAY_TEXTURE_LAYERS (at least 256 in GL 3.3)
+     * @param padding - Pixels around each atlas image, filled with its border
+     */
+    TextureArray(int layerSize, int maxLayers, int padding = 2);
+    ~TextureArray();
+
+    TextureArray(const TextureArray&) = delete;
+    TextureArray& operator=(const TextureArray&) = delete;
+
+    /**
+     * @brief Copy an RGBA 8 bits image into the array
+     * @param region - Filled with the location of the image
+     * @return false if the image is too big or the array is full
+     */
+    bool add(const std::uint8_t* pixels, int width, int height, TextureRegion& region);
+
+    /**
+     * @brief Bind to a texture unit, regenerating mipmaps if images were added since last time
+     */
+    void bind(unsigned int slot = 0);
+
+    /**
+     * @brief Record the bind for later, mipmaps are not regenerated so bind() must have been called once since the last add()
+     */
+    void bind(CommandBuffer& commands, unsigned int slot = 0) const;
+
+    GLuint id() const;
+    int layerSize() const;
+    int usedLayers() const;
+    int maxLayers() const;
+
+private:
+    struct AtlasPage;
+
+    bool addToAtlas(const std::uint8_t* pixels, int width, int height, TextureRegion& region);
+    void upload(const std::uint8_t* pixels, int x, int y, int width, int height, int layer, int padding);
+
+private:
+    GLuint m_id;
+    int m_layerSize;
+    int m_maxLayers;
+    int m_padding;
+    int m_usedLayers;
+    bool m_mipmapsDirty;
+    std::vector<std::unique_ptr<AtlasPage>> m_atlasPages;
+};
@@ -0,0 +1,233 @@
+#include "texture-loader.h"
+
+#include "gl-exception.h"
+#include <stb_image/stb_image.h>
+#include <spdlog/spdlog.h>
+#include <imgui.h>
+#include <algorithm>
+#include <cstring>
+
+TextureLoader::TextureLoader(unsigned int decodeThreads, unsigned int uploadBufferCount, std::size_t uploadBudgetPerFrame)
+	: m_stop(false), m_uploadSlots(uploadBufferCount), m_uploadBudgetPerFrame(uploadBudgetPerFrame),
+	  m_placeholder(0), m_residentCount(0), m_uploadedBytes(0)
+{
+	assert(decodeThreads > 0 && uploadBufferCount > 0 && "TextureLoader needs threads and buffers !");
+	createPlaceholder();
+
+	for (UploadSlot& slot : m_uploadSlots) {
+		GLCall(glGenBuffers(1, &slot.pbo));
+		slot.capacity = 0;
+		slot.fence = nullptr;
+		slot.textureId = 0;
+		slot.width = 0;
+		slot.height = 0;
+	}
+
+	for (unsigned int i = 0; i < decodeThreads; i++) {
+		m_decodeThreads.emplace_back(&TextureLoader::decodeLoop, this);
+	}
+}
+
+TextureLoader::~TextureLoader() {
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_wakeUp.notify_all();
+	for (auto& thread : m_decodeThreads) {
+		thread.join();
+	}
+
+	for (DecodedImage& image : m_decodedImages) {
+		stbi_image_free(image.pixels);
+	}
+	for (UploadSlot& slot : m_uploadSlots) {
+		if (slot.fence != nullptr) {
+			GLCall(glDeleteSync(slot.fence));
+			GLCall(glDeleteTextures(1, &slot.textureId));
+		}
+		GLCall(glDeleteBuffers(1, &slot.pbo));
+	}
+	GLCall(glDeleteTextures(1, &m_placeholder));
+}
+
+std::shared_ptr<Texture> TextureLoader::load(const std::string& filepath) {
+	auto cached = m_cache.find(filepath);
+	if (cached != m_cache.end()) {
+		std::shared_ptr<Texture> texture = cached->second.lock();
+		if (texture) {
+			return texture;
+		}
+	}
+
+	std::shared_ptr<Texture> texture = std::make_shared<Texture>(filepath, m_placeholder);
+	m_cache[filepath] = texture;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_decodeQueue.push_back(texture);
+	}
+	m_wakeUp.notify_one();
+	return texture;
+}
+
+void TextureLoader::update() {
+	// ------------------ Finished uploads
+	for (UploadSlot& slot : m_uploadSlots) {
+		if (slot.fence == nullptr) {
+			continue;
+		}
+		GLCall(GLenum status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0));
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+			continue;
+		}
+		GLCall(glDeleteSync(slot.fence));
+		slot.fence = nullptr;
+		slot.texture->makeResident(slot.textureId, slot.width, slot.height);
+		slot.texture.reset();
+		m_residentCount++;
+	}
+
+	// ------------------ New uploads, within the budget
+	std::size_t budget = m_uploadBudgetPerFrame;
+	for (UploadSlot& slot : m_uploadSlots) {
+		if (slot.fence != nullptr) {
+			continue;
+		}
+
+		DecodedImage image;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (m_decodedImages.empty()) {
+				break;
+			}
+			const std::size_t size = static_cast<std::size_t>(m_decodedImages.front().width) * m_decodedImages.front().height * 4;
+			// Always let at least one image through, even a huge one
+			if (size > budget && budget != m_uploadBudgetPerFrame) {
+				break;
+			}
+			image = m_decodedImages.front();
+			m_decodedImages.pop_front();
+			budget -= std::min(budget, size);
+		}
+
+		startUpload(slot, image);
+		stbi_image_free(image.pixels);
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//////////////////////////// GETTERS & SETTERS //////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+GLuint TextureLoader::placeholder() const { return m_placeholder; }
+
+std::size_t TextureLoader::pendingDecodeCount() {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_decodeQueue.size() + m_decodedImages.size();
+}
+
+std::size_t TextureLoader::pendingUploadCount() const {
+	std::size_t count = 0;
+	for (const UploadSlot& slot : m_uploadSlots) {
+		count += slot.fence != nullptr ? 1 : 0;
+	}
+	return count;
+}
+
+std::size_t TextureLoader::residentCount() const { return m_residentCount; }
+
+void TextureLoader::showMetrics() {
+	ImGui::Begin("Texture loader");
+	ImGui::Text("Waiting for decode or upload : %zu", pendingDecodeCount());
+	ImGui::Text("Uploads in flight : %zu", pendingUploadCount());
+	ImGui::Text("Resident : %zu", m_residentCount);
+	ImGui::Text("Uploaded : %.1f MB", m_uploadedBytes / (1024.0 * 1024.0));
+	ImGui::End();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+///////////////////////////// PRIVATE METHODS ///////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+void TextureLoader::decodeLoop() {
+	while (true) {
+		std::shared_ptr<Texture> texture;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_wakeUp.wait(lock, [this] { return !m_decodeQueue.empty() || m_stop; });
+			if (m_stop) {
+				return;
+			}
+			texture = m_decodeQueue.front();
+			m_decodeQueue.pop_front();
+		}
+
+		int width, height, channels;
+		std::uint8_t* pixels = stbi_load(texture->filepath().c_str(), &width, &height, &channels, 4);
+		if (pixels == nullptr) {
+			spdlog::warn("[TextureLoader] Failed to load '{}' : {}", texture->filepath(), stbi_failure_reason());
+			texture->fail();
+			continue;
+		}
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_decodedImages.push_back({ texture, pixels, width, height });
+	}
+}
+
+bool TextureLoader::startUpload(UploadSlot& slot, DecodedImage& image) {
+	const std::size_t size = static_cast<std::size_t>(image.width) * image.height * 4;
+
+	GLCall(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.pbo));
+	if (slot.capacity < size) {
+		GLCall(glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW));
+		slot.capacity = size;
+	}
+
+	// The previous upload of this slot is fenced as complete, so the buffer can be overwritten without waiting
+	GLCall(void* data = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT));
+	if (data == nullptr) {
+		GLCall(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+		image.texture->fail();
+		return false;
+	}
+	// OpenGL expects the first row at the bottom, rows are flipped here rather than with the stb_image flag which is global to the process
+	const std::size_t rowSize = static_cast<std::size_t>(image.width) * 4;
+	for (int y = 0; y < image.height; y++) {
+		std::memcpy(static_cast<std::uint8_t*>(data) + (image.height - 1 - y) * rowSize, image.pixels + y * rowSize, rowSize);
+	}
+	GLCall(glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER));
+
+	// Source pointer is an offset in the bound unpack buffer : the copy to the texture happens on the GPU timeline
+	GLCall(glGenTextures(1, &slot.textureId));
+	GLCall(glBindTexture(GL_TEXTURE_2D, slot.textureId));
+	GLCall(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+	GLCall(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, image.width, image.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, (void*)0));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+	GLCall(glGenerateMipmap(GL_TEXTURE_2D));
+	GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+	GLCall(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+
+	GLCall(slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+	slot.texture = image.texture;
+	slot.width = image.width;
+	slot.height = image.height;
+	m_uploadedBytes += size;
+	return true;
+}
+
+void TextureLoader::createPlaceholder() {
+	// 2x2 magenta and black checker, easy to spot
+	const std::uint8_t pixels[] = {
+		255, 0, 255, 255,   0, 0, 0, 255,
+		0, 0, 0, 255,       255, 0, 255, 255
+	};
+	GLCall(glGenTextures(1, &m_placeholder));
+	GLCall(glBindTexture(GL_TEXTURE_2D, m_placeholder));
+	GLCall(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+	GLCall(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 2, 2, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
+	GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+}
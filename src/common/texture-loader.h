@@ -0,0 +1,104 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "texture.h"
+
+/**
+ * @brief Load textures without ever blocking the render loop
+ * @note Files are decoded with stb_image on worker threads, then streamed to the GPU through
+ *       a ring of pixel unpack buffers, flipped to the bottom-up row order of OpenGL on the way. A texture becomes resident once the fence of its upload
+ *       is signaled, until then it shows a placeholder.
+ *
+ * @code
+ * std::shared_ptr<Texture> texture = loader.load("res/wall.png"); // Returns immediately
+ * while (app.isRunning()) {
+ *     loader.update(); // Once per frame, on the GL thread
+ *     texture->bind(0);
+ *     ...
+ * }
+ * @endcode
+ */
+class TextureLoader {
+public:
+    /**
+     * @param decodeThreads - Worker threads running stb_image
+     * @param uploadBufferCount - Pixel unpack buffers in the ring, uploads in flight at once
+     * @param uploadBudgetPerFrame - Bytes copied to the GPU per update(), bounds the frame time cost
+     */
+    TextureLoader(unsigned int decodeThreads = 2, unsigned int uploadBufferCount = 4, std::size_t uploadBudgetPerFrame = 16 * 1024 * 1024);
+    ~TextureLoader();
+
+    TextureLoader(const TextureLoader&) = delete;
+    TextureLoader& operator=(const TextureLoader&) = delete;
+
+    /**
+     * @brief Get the texture of a file, loading it in the background if needed
+     * @note Must be called on the GL thread
+     */
+    std::shared_ptr<Texture> load(const std::string& filepath);
+
+    /**
+     * @brief Check finished uploads and start new ones within the budget
+     * @note Must be called once per frame on the GL thread
+     */
+    void update();
+
+    GLuint placeholder() const;
+    std::size_t pendingDecodeCount();
+    std::size_t pendingUploadCount() const;
+    std::size_t residentCount() const;
+
+    /**
+     * @brief Display the loading state in an ImGui window
+     * @note Must be called between App::beginFrame() and App::endFrame()
+     */
+    void showMetrics();
+
+private:
+    struct DecodedImage {
+        std::shared_ptr<Texture> texture;
+        std::uint8_t* pixels; // Owned, freed with stbi_image_free
+        int width;
+        int height;
+    };
+
+    struct UploadSlot {
+        GLuint pbo;
+        std::size_t capacity;
+        GLsync fence;
+        std::shared_ptr<Texture> texture;
+        GLuint textureId;
+        int width;
+        int height;
+    };
+
+    void decodeLoop();
+    bool startUpload(UploadSlot& slot, DecodedImage& image);
+    void createPlaceholder();
+
+private:
+    std::vector<std::thread> m_decodeThreads;
+    std::mutex m_mutex;
+    std::condition_variable m_wakeUp;
+    std::deque<std::shared_ptr<Texture>> m_decodeQueue;
+    std::deque<DecodedImage> m_decodedImages;
+    bool m_stop;
+
+    std::vector<UploadSlot> m_uploadSlots;
+    std::size_t m_uploadBudgetPerFrame;
+
+    GLuint m_placeholder;
+    std::unordered_map<std::string, std::weak_ptr<Texture>> m_cache;
+    std::size_t m_residentCount;
+    std::size_t m_uploadedBytes;
+};
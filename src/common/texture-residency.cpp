@@ -0,0 +1,235 @@
+#include "texture-residency.h"
+
+#include "gl-exception.h"
+#include "image-utils.h"
+#include <imgui.h>
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+namespace {
+	// Frames during which reloading an evicted mip counts as thrashing
+	const std::uint64_t THRASH_WINDOW = 120;
+}
+
+TextureResidencyManager::TextureResidencyManager(std::size_t budgetBytes, int residentTailSize, unsigned int maxUploadsPerFrame)
+	: m_budgetBytes(budgetBytes), m_usedBytes(0), m_evictedBytes(0), m_thrashedBytes(0),
+	  m_residentTailSize(residentTailSize), m_maxUploadsPerFrame(maxUploadsPerFrame), m_frame(1)
+{}
+
+TextureResidencyManager::~TextureResidencyManager() {
+	for (ManagedTexture& texture : m_textures) {
+		GLCall(glDeleteTextures(1, &texture.id));
+	}
+}
+
+TextureResidencyManager::Handle TextureResidencyManager::add(const std::uint8_t* pixels, int width, int height) {
+	ManagedTexture texture;
+
+	// CPU mip chain to stream from
+	texture.ownedLevels = imageUtils::mipChain(pixels, width, height);
+	for (const std::vector<std::uint8_t>& level : texture.ownedLevels) {
+		texture.levels.push_back({ width, height, level.data() });
+		width = std::max(1, width / 2);
+		height = std::max(1, height / 2);
+	}
+	return addTexture(texture);
+}
+
+TextureResidencyManager::Handle TextureResidencyManager::add(const std::vector<MipLevel>& levels) {
+	assert(!levels.empty() && "At least one mip level is needed !");
+	ManagedTexture texture;
+	texture.levels = levels;
+	return addTexture(texture);
+}
+
+void TextureResidencyManager::markVisible(Handle handle, float screenSize) {
+	ManagedTexture& texture = m_textures[handle];
+	texture.importance = std::max(texture.importance, screenSize);
+	texture.lastVisibleFrame = m_frame;
+	m_lru.splice(m_lru.begin(), m_lru, texture.lruPosition);
+
+	// One texel per pixel : each halving of the covered size allows one coarser mip
+	const float finestSize = static_cast<float>(std::max(texture.levels[0].width, texture.levels[0].height));
+	const float ratio = finestSize / std::max(screenSize, 1.0f);
+	const int mip = ratio <= 1.0f ? 0 : static_cast<int>(std::floor(std::log2(ratio)));
+	texture.wantedMip = std::min(texture.wantedMip, std::min(mip, texture.tailMip));
+}
+
+unsigned int TextureResidencyManager::update() {
+	// ------------------ Textures missing detail, most important first
+	std::vector<Handle> candidates;
+	for (Handle handle = 0; handle < m_textures.size(); handle++) {
+		const ManagedTexture& texture = m_textures[handle];
+		if (texture.lastVisibleFrame == m_frame && texture.wantedMip < texture.residentMip) {
+			candidates.push_back(handle);
+		}
+	}
+	std::sort(candidates.begin(), candidates.end(), [this](Handle a, Handle b) {
+		return m_textures[a].importance > m_textures[b].importance;
+	});
+
+	unsigned int uploads = 0;
+	for (Handle handle : candidates) {
+		ManagedTexture& texture = m_textures[handle];
+		while (texture.wantedMip < texture.residentMip && uploads < m_maxUploadsPerFrame) {
+			const int level = texture.residentMip - 1;
+			const std::size_t bytes = mipBytes(texture.levels[level]);
+
+			// ------------------ Make room, least recently used first, never for something less important
+			auto victim = m_lru.rbegin();
+			while (m_usedBytes + bytes > m_budgetBytes && victim != m_lru.rend()) {
+				ManagedTexture& candidate = m_textures[*victim];
+				const bool evictable = *victim != handle
+					&& candidate.residentMip < candidate.tailMip
+					&& (candidate.lastVisibleFrame != m_frame || candidate.importance < texture.importance);
+				if (evictable) {
+					evictMip(candidate);
+				} else {
+					++victim;
+				}
+			}
+			if (m_usedBytes + bytes > m_budgetBytes) {
+				break;
+			}
+
+			loadMip(texture, level);
+			uploads++;
+		}
+	}
+
+	// ------------------ Reset per frame visibility
+	for (ManagedTexture& texture : m_textures) {
+		texture.importance = 0.0f;
+		texture.wantedMip = texture.tailMip;
+	}
+	m_frame++;
+	return uploads;
+}
+
+void TextureResidencyManager::bind(Handle handle, unsigned int slot) const {
+	GLCall(glActiveTexture(GL_TEXTURE0 + slot));
+	GLCall(glBindTexture(GL_TEXTURE_2D, m_textures[handle].id));
+}
+
+GLuint TextureResidencyManager::id(Handle handle) const {
+	return m_textures[handle].id;
+}
+
+float TextureResidencyManager::projectedSize(const glm::vec3& center, float radius, const glm::vec3& cameraPosition, float fovY, int viewportHeight) {
+	const float distance = glm::length(center - cameraPosition);
+	if (distance <= radius) {
+		return static_cast<float>(viewportHeight);
+	}
+	return radius / (distance * std::tan(fovY * 0.5f)) * viewportHeight;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//////////////////////////// GETTERS & SETTERS //////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+std::size_t TextureResidencyManager::budgetBytes() const { return m_budgetBytes; }
+std::size_t TextureResidencyManager::usedBytes() const { return m_usedBytes; }
+std::size_t TextureResidencyManager::evictedBytes() const { return m_evictedBytes; }
+std::size_t TextureResidencyManager::thrashedBytes() const { return m_thrashedBytes; }
+void TextureResidencyManager::setBudgetBytes(std::size_t budgetBytes) { m_budgetBytes = budgetBytes; }
+
+void TextureResidencyManager::showMetrics() {
+	const double mb = 1024.0 * 1024.0;
+	ImGui::Begin("Texture residency");
+	ImGui::Text("Textures : %zu", m_textures.size());
+	ImGui::Text("Used : %.1f / %.1f MB", m_usedBytes / mb, m_budgetBytes / mb);
+	ImGui::ProgressBar(m_budgetBytes > 0 ? static_cast<float>(m_usedBytes) / m_budgetBytes : 0.0f);
+	ImGui::Text("Evicted : %.1f MB", m_evictedBytes / mb);
+	ImGui::Text("Thrashed (reloaded within %llu frames) : %.1f MB", static_cast<unsigned long long>(THRASH_WINDOW), m_thrashedBytes / mb);
+	if (ImGui::TreeNode("Per texture")) {
+		for (std::size_t i = 0; i < m_textures.size(); i++) {
+			const ManagedTexture& texture = m_textures[i];
+			std::size_t bytes = 0;
+			for (int level = texture.residentMip; level < static_cast<int>(texture.levels.size()); level++) {
+				bytes += mipBytes(texture.levels[level]);
+			}
+			ImGui::Text("#%zu : mip %d resident (%dx%d), %.2f MB", i, texture.residentMip,
+				texture.levels[texture.residentMip].width, texture.levels[texture.residentMip].height, bytes / mb);
+		}
+		ImGui::TreePop();
+	}
+	ImGui::End();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+///////////////////////////// PRIVATE METHODS ///////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+TextureResidencyManager::Handle TextureResidencyManager::addTexture(ManagedTexture& texture) {
+	const int levelCount = static_cast<int>(texture.levels.size());
+
+	texture.tailMip = levelCount - 1;
+	for (int level = 0; level < levelCount; level++) {
+		if (std::max(texture.levels[level].width, texture.levels[level].height) <= m_residentTailSize) {
+			texture.tailMip = level;
+			break;
+		}
+	}
+	texture.residentMip = texture.tailMip;
+	texture.wantedMip = texture.tailMip;
+	texture.importance = 0.0f;
+	texture.lastVisibleFrame = 0;
+	texture.evictedAtFrame.assign(levelCount, 0);
+
+	// ------------------ Only the tail goes to the GPU now
+	GLCall(glGenTextures(1, &texture.id));
+	GLCall(glBindTexture(GL_TEXTURE_2D, texture.id));
+	GLCall(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+	for (int level = texture.tailMip; level < levelCount; level++) {
+		const MipLevel& mip = texture.levels[level];
+		GLCall(glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, mip.width, mip.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, mip.pixels));
+		m_usedBytes += mipBytes(mip);
+	}
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, texture.tailMip));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levelCount - 1));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+	GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+
+	const Handle handle = static_cast<Handle>(m_textures.size());
+	m_lru.push_back(handle);
+	texture.lruPosition = std::prev(m_lru.end());
+	m_textures.push_back(std::move(texture));
+	return handle;
+}
+
+void TextureResidencyManager::loadMip(ManagedTexture& texture, int level) {
+	const MipLevel& mip = texture.levels[level];
+	GLCall(glBindTexture(GL_TEXTURE_2D, texture.id));
+	GLCall(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+	GLCall(glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, mip.width, mip.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, mip.pixels));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level));
+	GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+
+	texture.residentMip = level;
+	const std::size_t bytes = mipBytes(mip);
+	m_usedBytes += bytes;
+	if (texture.evictedAtFrame[level] != 0 && m_frame - texture.evictedAtFrame[level] < THRASH_WINDOW) {
+		m_thrashedBytes += bytes;
+	}
+}
+
+void TextureResidencyManager::evictMip(ManagedTexture& texture) {
+	const int level = texture.residentMip;
+	GLCall(glBindTexture(GL_TEXTURE_2D, texture.id));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level + 1));
+	// A 0x0 image releases the storage of that level
+	GLCall(glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, 0, 0, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL));
+	GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+
+	texture.residentMip = level + 1;
+	const std::size_t bytes = mipBytes(texture.levels[level]);
+	m_usedBytes -= bytes;
+	m_evictedBytes += bytes;
+	texture.evictedAtFrame[level] = m_frame;
+}
+
+std::size_t TextureResidencyManager::mipBytes(const MipLevel& level) {
+	return static_cast<std::size_t>(level.width) * level.height * 4;
+}
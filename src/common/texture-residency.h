@@ -0,0 +1,112 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <list>
+#include <vector>
+
+/**
+ * @brief Keep texture mip levels on the GPU within a memory budget
+ * @note Each frame, visible textures are reported with the size they cover on screen.
+ *       update() then streams in the mips they need, most important first, and evicts the finest
+ *       mips of the least recently used textures when over budget. Mips smaller than
+ *       the always resident tail are never evicted, so a texture is always drawable.
+ *       Streaming only moves GL_TEXTURE_BASE_LEVEL, which works on any GL 3.3 driver.
+ */
+class TextureResidencyManager {
+public:
+    using Handle = std::uint32_t;
+
+    /**
+     * @brief One mip level of a source image, RGBA 8 bits, not owned
+     */
+    struct MipLevel {
+        int width;
+        int height;
+        const std::uint8_t* pixels;
+    };
+
+    /**
+     * @param budgetBytes - GPU memory allowed for all managed textures
+     * @param residentTailSize - Mips of this size or smaller are always resident
+     * @param maxUploadsPerFrame - Mip uploads per update(), bounds the frame time cost
+     */
+    TextureResidencyManager(std::size_t budgetBytes, int residentTailSize = 64, unsigned int maxUploadsPerFrame = 4);
+    ~TextureResidencyManager();
+
+    TextureResidencyManager(const TextureResidencyManager&) = delete;
+    TextureResidencyManager& operator=(const TextureResidencyManager&) = delete;
+
+    /**
+     * @brief Manage an image, a full CPU mip chain is built and kept to stream from
+     */
+    Handle add(const std::uint8_t* pixels, int width, int height);
+
+    /**
+     * @brief Manage an already mipmapped image, levels must stay valid as long as the manager (memory mapped pack, ...)
+     */
+    Handle add(const std::vector<MipLevel>& levels);
+
+    /**
+     * @brief Report that a texture is used this frame
+     * @param screenSize - Pixels covered on screen by the texture, see projectedSize()
+     */
+    void markVisible(Handle handle, float screenSize);
+
+    /**
+     * @brief Stream mips in and out, must be called once per frame on the GL thread
+     * @return Mips uploaded, while not 0 the next frames may still bring more detail
+     */
+    unsigned int update();
+
+    void bind(Handle handle, unsigned int slot = 0) const;
+    GLuint id(Handle handle) const;
+
+    /**
+     * @brief Height in pixels of a sphere once projected on screen
+     */
+    static float projectedSize(const glm::vec3& center, float radius, const glm::vec3& cameraPosition, float fovY, int viewportHeight);
+
+    std::size_t budgetBytes() const;
+    std::size_t usedBytes() const;
+    std::size_t evictedBytes() const;
+    std::size_t thrashedBytes() const;
+    void setBudgetBytes(std::size_t budgetBytes);
+
+    /**
+     * @brief Display budget, usage and thrash in an ImGui window
+     * @note Must be called between App::beginFrame() and App::endFrame()
+     */
+    void showMetrics();
+
+private:
+    struct ManagedTexture {
+        GLuint id;
+        std::vector<MipLevel> levels;
+        std::vector<std::vector<std::uint8_t>> ownedLevels;
+        std::vector<std::uint64_t> evictedAtFrame; // Per mip, to detect thrashing
+        int residentMip;  // Finest resident level
+        int tailMip;      // First level which is always resident
+        int wantedMip;
+        float importance;
+        std::uint64_t lastVisibleFrame;
+        std::list<Handle>::iterator lruPosition;
+    };
+
+    Handle addTexture(ManagedTexture& texture);
+    void loadMip(ManagedTexture& texture, int level);
+    void evictMip(ManagedTexture& texture);
+    static std::size_t mipBytes(const MipLevel& level);
+
+private:
+    std::vector<ManagedTexture> m_textures;
+    std::list<Handle> m_lru; // Most recently visible first
+    std::size_t m_budgetBytes;
+    std::size_t m_usedBytes;
+    std::size_t m_evictedBytes;
+    std::size_t m_thrashedBytes;
+    int m_residentTailSize;
+    unsigned int m_maxUploadsPerFrame;
+    std::uint64_t m_frame;
+};
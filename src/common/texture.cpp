@@ -0,0 +1,44 @@
+#include "texture.h"
+
+#include "gl-exception.h"
+
+Texture::Texture(const std::string& filepath, GLuint placeholder)
+	: m_filepath(filepath), m_placeholder(placeholder), m_id(0), m_width(0), m_height(0), m_resident(false), m_failed(false)
+{}
+
+Texture::~Texture() {
+	if (m_id != 0) {
+		GLCall(glDeleteTextures(1, &m_id));
+	}
+}
+
+void Texture::bind(unsigned int slot) const {
+	GLCall(glActiveTexture(GL_TEXTURE0 + slot));
+	GLCall(glBindTexture(GL_TEXTURE_2D, id()));
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//////////////////////////// GETTERS & SETTERS //////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+GLuint Texture::id() const { return m_resident.load(std::memory_order_acquire) ? m_id : m_placeholder; }
+bool Texture::isResident() const { return m_resident.load(std::memory_order_acquire); }
+bool Texture::hasFailed() const { return m_failed.load(std::memory_order_acquire); }
+int Texture::width() const { return m_width; }
+int Texture::height() const { return m_height; }
+const std::string& Texture::filepath() const { return m_filepath; }
+
+/////////////////////////////////////////////////////////////////////////////
+///////////////////////////// PRIVATE METHODS ///////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+void Texture::makeResident(GLuint id, int width, int height) {
+	m_id = id;
+	m_width = width;
+	m_height = height;
+	m_resident.store(true, std::memory_order_release);
+}
+
+void Texture::fail() {
+	m_failed.store(true, std::memory_order_release);
+}
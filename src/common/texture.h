@@ -0,0 +1,49 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <atomic>
+#include <string>
+
+/**
+ * @brief 2D RGBA texture which may still be loading
+ * @note Until it is resident, id() returns the placeholder it was created with,
+ *       so it can be bound and drawn with right away
+ */
+class Texture {
+public:
+    Texture(const std::string& filepath, GLuint placeholder);
+    ~Texture();
+
+    Texture(const Texture&) = delete;
+    Texture& operator=(const Texture&) = delete;
+
+    /**
+     * @brief Bind to a texture unit
+     */
+    void bind(unsigned int slot = 0) const;
+
+    /**
+     * @brief Real texture if resident, placeholder otherwise
+     */
+    GLuint id() const;
+    bool isResident() const;
+    bool hasFailed() const;
+    int width() const;
+    int height() const;
+    const std::string& filepath() const;
+
+private:
+    friend class TextureLoader;
+
+    void makeResident(GLuint id, int width, int height);
+    void fail();
+
+private:
+    std::string m_filepath;
+    GLuint m_placeholder;
+    GLuint m_id;
+    int m_width;
+    int m_height;
+    std::atomic<bool> m_resident;
+    std::atomic<bool> m_failed;
+};
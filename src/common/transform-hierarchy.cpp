@@ -0,0 +1,279 @@
+#include "transform-hierarchy.h"
+
+#include "gl-exception.h"
+#include "job-system.h"
+#include <imgui.h>
+#include <algorithm>
+#include <chrono>
+#include <type_traits>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+    #include <xmmintrin.h>
+    #define TRANSFORM_HIERARCHY_SSE
+#endif
+
+TransformHierarchy::TransformHierarchy(JobSystem& jobs)
+	: m_jobs(jobs), m_sorted(true), m_dirtyCount(0), m_changedBegin(0), m_changedEnd(0), m_recomputedCount(0), m_updateMs(0.0)
+{}
+
+TransformId TransformHierarchy::create(TransformId parent, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale) {
+	const std::uint32_t index = static_cast<std::uint32_t>(m_positions.size());
+	const std::uint32_t parentIndex = parent == NONE ? NONE : m_indices[parent];
+	const std::uint32_t depth = parent == NONE ? 0 : m_depths[parentIndex] + 1;
+
+	const TransformId id = static_cast<TransformId>(m_indices.size());
+	m_indices.push_back(index);
+	m_ids.push_back(id);
+	m_positions.push_back(position);
+	m_rotations.push_back(rotation);
+	m_scales.push_back(scale);
+	m_world.push_back(glm::mat4(1.0f));
+	m_parents.push_back(parentIndex);
+	m_depths.push_back(depth);
+	m_dirty.push_back(1);
+	m_changed.push_back(0);
+	m_dirtyCount++;
+
+	// Appending keeps the depth order unless the node is shallower than the last one
+	if (m_sorted) {
+		if (depth + 1 == m_levelEnds.size()) {
+			m_levelEnds.back()++;
+		} else if (depth == m_levelEnds.size()) {
+			m_levelEnds.push_back(index + 1);
+			m_levelDirty.push_back(0);
+		} else {
+			m_sorted = false;
+		}
+	}
+	if (m_sorted) {
+		m_levelDirty[depth] = 1;
+	}
+	return id;
+}
+
+void TransformHierarchy::setPosition(TransformId id, const glm::vec3& position) {
+	const std::uint32_t index = m_indices[id];
+	m_positions[index] = position;
+	markDirty(index);
+}
+
+void TransformHierarchy::setRotation(TransformId id, const glm::quat& rotation) {
+	const std::uint32_t index = m_indices[id];
+	m_rotations[index] = rotation;
+	markDirty(index);
+}
+
+void TransformHierarchy::setScale(TransformId id, const glm::vec3& scale) {
+	const std::uint32_t index = m_indices[id];
+	m_scales[index] = scale;
+	markDirty(index);
+}
+
+void TransformHierarchy::update() {
+	const auto start = std::chrono::high_resolution_clock::now();
+	if (!m_sorted) {
+		sortByDepth();
+	}
+
+	m_changedBegin = size();
+	m_changedEnd = 0;
+	m_recomputedCount = 0;
+
+	if (m_dirtyCount > 0) {
+		// Levels one after the other, a child reads the world matrix and the changed flag of its parent
+		std::uint32_t levelBegin = 0;
+		bool parentsChanged = false;
+		for (std::size_t level = 0; level < m_levelEnds.size(); level++) {
+			const std::uint32_t levelEnd = m_levelEnds[level];
+			const bool visit = m_levelDirty[level] != 0 || parentsChanged;
+			if (!visit) {
+				// Nothing to do, nor for the children of this level unless they are modified themselves
+			} else if (levelEnd - levelBegin <= GRAIN_SIZE) {
+				updateRange(levelBegin, levelEnd, parentsChanged);
+			} else {
+				Job* root = m_jobs.parallelFor(levelBegin, levelEnd, GRAIN_SIZE, [this, parentsChanged](std::uint32_t begin, std::uint32_t end) {
+					updateRange(begin, end, parentsChanged);
+				});
+				m_jobs.run(root);
+				m_jobs.wait(root);
+			}
+			parentsChanged = visit;
+			m_levelDirty[level] = 0;
+			levelBegin = levelEnd;
+		}
+		m_dirtyCount = 0;
+	}
+
+	m_updateMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void TransformHierarchy::uploadChanged(GLuint instanceBuffer) const {
+	if (m_changedBegin >= m_changedEnd) {
+		return;
+	}
+	GLCall(glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer));
+	GLCall(glBufferSubData(GL_ARRAY_BUFFER, m_changedBegin * sizeof(glm::mat4), (m_changedEnd - m_changedBegin) * sizeof(glm::mat4), &m_world[m_changedBegin]));
+	GLCall(glBindBuffer(GL_ARRAY_BUFFER, 0));
+}
+
+void TransformHierarchy::showMetrics() {
+	ImGui::Begin("Transforms");
+	ImGui::Text("Nodes : %u in %u levels", size(), levelCount());
+	ImGui::Text("Last update : %u recomputed in %.3f ms", m_recomputedCount, m_updateMs);
+	ImGui::End();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//////////////////////////// GETTERS & SETTERS //////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+const glm::vec3& TransformHierarchy::position(TransformId id) const { return m_positions[m_indices[id]]; }
+const glm::quat& TransformHierarchy::rotation(TransformId id) const { return m_rotations[m_indices[id]]; }
+const glm::vec3& TransformHierarchy::scale(TransformId id) const { return m_scales[m_indices[id]]; }
+const glm::mat4& TransformHierarchy::world(TransformId id) const { return m_world[m_indices[id]]; }
+
+TransformId TransformHierarchy::parent(TransformId id) const {
+	const std::uint32_t parentIndex = m_parents[m_indices[id]];
+	return parentIndex == NONE ? NONE : m_ids[parentIndex];
+}
+
+std::uint32_t TransformHierarchy::index(TransformId id) const { return m_indices[id]; }
+const glm::mat4* TransformHierarchy::worldMatrices() const { return m_world.data(); }
+std::pair<std::uint32_t, std::uint32_t> TransformHierarchy::changedRange() const { return { m_changedBegin, std::max(m_changedBegin, m_changedEnd) }; }
+std::uint32_t TransformHierarchy::size() const { return static_cast<std::uint32_t>(m_positions.size()); }
+std::uint32_t TransformHierarchy::levelCount() const { return static_cast<std::uint32_t>(m_levelEnds.size()); }
+
+/////////////////////////////////////////////////////////////////////////////
+///////////////////////////// PRIVATE METHODS ///////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+void TransformHierarchy::markDirty(std::uint32_t index) {
+	if (m_dirty[index] == 0) {
+		m_dirty[index] = 1;
+		m_dirtyCount++;
+		if (m_sorted) {
+			m_levelDirty[m_depths[index]] = 1;
+		}
+	}
+}
+
+void TransformHierarchy::sortByDepth() {
+	const std::uint32_t count = size();
+	const std::uint32_t levels = *std::max_element(m_depths.begin(), m_depths.end()) + 1;
+
+	// ------------------ Counting sort, stable so siblings keep their creation order
+	std::vector<std::uint32_t> levelBegins(levels + 1, 0);
+	for (std::uint32_t depth : m_depths) {
+		levelBegins[depth + 1]++;
+	}
+	for (std::uint32_t l = 0; l < levels; l++) {
+		levelBegins[l + 1] += levelBegins[l];
+	}
+	m_levelEnds.assign(levelBegins.begin() + 1, levelBegins.end());
+	m_levelDirty.assign(levels, 1);
+
+	std::vector<std::uint32_t> newIndices(count);
+	for (std::uint32_t i = 0; i < count; i++) {
+		newIndices[i] = levelBegins[m_depths[i]]++;
+	}
+
+	// ------------------ Move every array to its new order
+	auto permute = [&](auto& values) {
+		typename std::decay<decltype(values)>::type sorted(values.size());
+		for (std::uint32_t i = 0; i < count; i++) {
+			sorted[newIndices[i]] = values[i];
+		}
+		values.swap(sorted);
+	};
+	permute(m_positions);
+	permute(m_rotations);
+	permute(m_scales);
+	permute(m_world);
+	permute(m_depths);
+	permute(m_dirty);
+	permute(m_ids);
+	permute(m_parents);
+	for (std::uint32_t& parent : m_parents) {
+		if (parent != NONE) {
+			parent = newIndices[parent];
+		}
+	}
+	for (std::uint32_t i = 0; i < count; i++) {
+		m_indices[m_ids[i]] = i;
+	}
+
+	// Every matrix moved, the next update reports them all as changed
+	std::fill(m_dirty.begin(), m_dirty.end(), 1);
+	m_dirtyCount = count;
+	m_sorted = true;
+}
+
+void TransformHierarchy::updateRange(std::uint32_t begin, std::uint32_t end, bool parentsChanged) {
+	std::uint32_t first = end, last = begin, recomputed = 0;
+	glm::mat4 local;
+
+	for (std::uint32_t i = begin; i < end; i++) {
+		const std::uint32_t parent = m_parents[i];
+		const bool recompute = m_dirty[i] != 0 || (parentsChanged && m_changed[parent] != 0);
+		m_changed[i] = recompute;
+		if (!recompute) {
+			continue;
+		}
+
+		composeTRS(m_positions[i], m_rotations[i], m_scales[i], local);
+		if (parent == NONE) {
+			m_world[i] = local;
+		} else {
+			multiply(m_world[parent], local, m_world[i]);
+		}
+		m_dirty[i] = 0;
+
+		first = std::min(first, i);
+		last = i + 1;
+		recomputed++;
+	}
+
+	if (recomputed > 0) {
+		mergeChanged(first, last, recomputed);
+	}
+}
+
+void TransformHierarchy::mergeChanged(std::uint32_t first, std::uint32_t last, std::uint32_t count) {
+	std::lock_guard<std::mutex> lock(m_changedMutex);
+	m_changedBegin = std::min(m_changedBegin, first);
+	m_changedEnd = std::max(m_changedEnd, last);
+	m_recomputedCount += count;
+}
+
+void TransformHierarchy::composeTRS(const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale, glm::mat4& out) {
+	const float xx = rotation.x * rotation.x, yy = rotation.y * rotation.y, zz = rotation.z * rotation.z;
+	const float xy = rotation.x * rotation.y, xz = rotation.x * rotation.z, yz = rotation.y * rotation.z;
+	const float wx = rotation.w * rotation.x, wy = rotation.w * rotation.y, wz = rotation.w * rotation.z;
+
+	out[0] = glm::vec4(1.0f - 2.0f * (yy + zz), 2.0f * (xy + wz), 2.0f * (xz - wy), 0.0f) * scale.x;
+	out[1] = glm::vec4(2.0f * (xy - wz), 1.0f - 2.0f * (xx + zz), 2.0f * (yz + wx), 0.0f) * scale.y;
+	out[2] = glm::vec4(2.0f * (xz + wy), 2.0f * (yz - wx), 1.0f - 2.0f * (xx + yy), 0.0f) * scale.z;
+	out[3] = glm::vec4(position, 1.0f);
+}
+
+void TransformHierarchy::multiply(const glm::mat4& a, const glm::mat4& b, glm::mat4& out) {
+#ifdef TRANSFORM_HIERARCHY_SSE
+	// Each column of the result is a linear combination of the columns of a,
+	// b is affine so only its translation column uses the one of a
+	const __m128 a0 = _mm_loadu_ps(&a[0][0]);
+	const __m128 a1 = _mm_loadu_ps(&a[1][0]);
+	const __m128 a2 = _mm_loadu_ps(&a[2][0]);
+	const __m128 a3 = _mm_loadu_ps(&a[3][0]);
+	for (int c = 0; c < 4; c++) {
+		__m128 column = _mm_mul_ps(a0, _mm_set1_ps(b[c][0]));
+		column = _mm_add_ps(column, _mm_mul_ps(a1, _mm_set1_ps(b[c][1])));
+		column = _mm_add_ps(column, _mm_mul_ps(a2, _mm_set1_ps(b[c][2])));
+		if (c == 3) {
+			column = _mm_add_ps(column, a3);
+		}
+		_mm_storeu_ps(&out[c][0], column);
+	}
+#else
+	out = a * b;
+#endif
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+class JobSystem;
+
+using TransformId = std::uint32_t;
+
+/**
+ * @brief Parent / child transforms stored as structure of arrays, sorted by depth
+ * @note Parents are always before their children, so update() walks one depth level at a time and
+ *       each level is split across the JobSystem. A node is recomputed when it was modified or when
+ *       its parent was recomputed in the same update, clean subtrees are skipped and so are whole clean levels.
+ *       World matrices are contiguous in index order and can be copied as is into a mat4 instance attribute.
+ *
+ * @code
+ * TransformId arm = transforms.create(body, glm::vec3(1, 0, 0));
+ * transforms.setRotation(body, glm::angleAxis(angle, glm::vec3(0, 1, 0)));
+ * transforms.update();
+ * transforms.uploadChanged(instanceBuffer);
+ * @endcode
+ */
+class TransformHierarchy {
+public:
+    static constexpr TransformId NONE = UINT32_MAX;
+    static constexpr std::uint32_t GRAIN_SIZE = 4096;
+
+public:
+    TransformHierarchy(JobSystem& jobs);
+    ~TransformHierarchy() = default;
+
+    TransformHierarchy(const TransformHierarchy&) = delete;
+    TransformHierarchy& operator=(const TransformHierarchy&) = delete;
+
+    /**
+     * @brief New node, its world matrix is valid after the next update()
+     * @param parent - NONE for a root
+     */
+    TransformId create(TransformId parent = NONE, const glm::vec3& position = glm::vec3(0.0f),
+                       const glm::quat& rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f), const glm::vec3& scale = glm::vec3(1.0f));
+
+    void setPosition(TransformId id, const glm::vec3& position);
+    void setRotation(TransformId id, const glm::quat& rotation);
+    void setScale(TransformId id, const glm::vec3& scale);
+
+    /**
+     * @brief Recompute the world matrix of modified nodes and of their descendants
+     */
+    void update();
+
+    /**
+     * @brief Copy the world matrices recomputed by the last update() to the same indices of a buffer of mat4
+     */
+    void uploadChanged(GLuint instanceBuffer) const;
+
+    void showMetrics();
+
+    const glm::vec3& position(TransformId id) const;
+    const glm::quat& rotation(TransformId id) const;
+    const glm::vec3& scale(TransformId id) const;
+    const glm::mat4& world(TransformId id) const;
+    TransformId parent(TransformId id) const;
+
+    /**
+     * @brief Position of the node in worldMatrices(), changes when nodes are added above its depth
+     */
+    std::uint32_t index(TransformId id) const;
+    const glm::mat4* worldMatrices() const;
+
+    /**
+     * @brief Indices [first, second) recomputed by the last update()
+     */
+    std::pair<std::uint32_t, std::uint32_t> changedRange() const;
+
+    std::uint32_t size() const;
+    std::uint32_t levelCount() const;
+
+private:
+    void markDirty(std::uint32_t index);
+    void sortByDepth();
+    void updateRange(std::uint32_t begin, std::uint32_t end, bool parentsChanged);
+    void mergeChanged(std::uint32_t first, std::uint32_t last, std::uint32_t count);
+
+    static void composeTRS(const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale, glm::mat4& out);
+    /**
+     * @brief a * b where b is an affine local matrix
+     */
+    static void multiply(const glm::mat4& a, const glm::mat4& b, glm::mat4& out);
+
+private:
+    JobSystem& m_jobs;
+
+    // ------------------ Per node, in depth order
+    std::vector<glm::vec3> m_positions;
+    std::vector<glm::quat> m_rotations;
+    std::vector<glm::vec3> m_scales;
+    std::vector<glm::mat4> m_world;
+    std::vector<std::uint32_t> m_parents; // Index, NONE for roots
+    std::vector<std::uint32_t> m_depths;
+    std::vector<std::uint8_t> m_dirty;
+    std::vector<std::uint8_t> m_changed;  // Recomputed during the current update, read by children
+    std::vector<TransformId> m_ids;
+
+    // ------------------ Per id
+    std::vector<std::uint32_t> m_indices;
+
+    // Level l is [m_levelEnds[l - 1], m_levelEnds[l])
+    std::vector<std::uint32_t> m_levelEnds;
+    std::vector<std::uint8_t> m_levelDirty; // Levels without modified nodes nor changed parents are skipped
+    bool m_sorted;
+    std::uint32_t m_dirtyCount;
+
+    // ------------------ Last update
+    std::uint32_t m_changedBegin;
+    std::uint32_t m_changedEnd;
+    std::uint32_t m_recomputedCount;
+    std::mutex m_changedMutex;
+    double m_updateMs;
+};
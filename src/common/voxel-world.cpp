@@ -0,0 +1,422 @@
+#include "voxel-world.h"
+
+#include "gl-exception.h"
+#include "job-system.h"
+#include <imgui.h>
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+
+namespace {
+	using Clock = std::chrono::high_resolution_clock;
+
+	double elapsedMs(Clock::time_point start) {
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	}
+
+	int floorDiv(int value, int divisor) {
+		return value >= 0 ? value / divisor : (value - divisor + 1) / divisor;
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+////////////////////////////////// CHUNK ////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+VoxelChunk::VoxelChunk(const glm::ivec3& coords)
+	: m_coords(coords), m_voxels(SIZE * SIZE * SIZE, 0), m_solidCount(0), m_dirty(true),
+	  m_vao(0), m_depthVao(0), m_vb(0), m_quadCount(0), m_gpuBytes(0)
+{}
+
+VoxelChunk::~VoxelChunk() {
+	releaseMesh();
+}
+
+Voxel VoxelChunk::get(int x, int y, int z) const {
+	return m_voxels[index(x, y, z)];
+}
+
+void VoxelChunk::set(int x, int y, int z, Voxel voxel) {
+	Voxel& current = m_voxels[index(x, y, z)];
+	if (current == voxel) {
+		return;
+	}
+	m_solidCount += (voxel != 0) - (current != 0);
+	current = voxel;
+	m_dirty = true;
+}
+
+const glm::ivec3& VoxelChunk::coords() const { return m_coords; }
+glm::ivec3 VoxelChunk::origin() const { return m_coords * SIZE; }
+bool VoxelChunk::isDirty() const { return m_dirty; }
+std::size_t VoxelChunk::solidCount() const { return m_solidCount; }
+std::size_t VoxelChunk::quadCount() const { return m_quadCount; }
+std::size_t VoxelChunk::cpuBytes() const { return m_voxels.size() * sizeof(Voxel); }
+std::size_t VoxelChunk::gpuBytes() const { return m_gpuBytes; }
+
+void VoxelChunk::releaseMesh() {
+	if (m_vao != 0) {
+		GLCall(glDeleteBuffers(1, &m_vb));
+		GLCall(glDeleteVertexArrays(1, &m_vao));
+		GLCall(glDeleteVertexArrays(1, &m_depthVao));
+		m_vao = m_depthVao = m_vb = 0;
+	}
+	m_ib.reset();
+	m_quadCount = 0;
+	m_gpuBytes = 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+////////////////////////////////// WORLD ////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+VoxelWorld::VoxelWorld(JobSystem& jobs) : m_jobs(jobs), m_meshingMs(0.0), m_uploadMs(0.0), m_meshedCount(0) {}
+
+Voxel VoxelWorld::get(const glm::ivec3& position) const {
+	const glm::ivec3 coords(floorDiv(position.x, VoxelChunk::SIZE), floorDiv(position.y, VoxelChunk::SIZE), floorDiv(position.z, VoxelChunk::SIZE));
+	const VoxelChunk* chunk = findChunk(coords);
+	if (chunk == nullptr) {
+		return 0;
+	}
+	const glm::ivec3 local = position - coords * VoxelChunk::SIZE;
+	return chunk->get(local.x, local.y, local.z);
+}
+
+void VoxelWorld::set(const glm::ivec3& position, Voxel voxel) {
+	const glm::ivec3 coords(floorDiv(position.x, VoxelChunk::SIZE), floorDiv(position.y, VoxelChunk::SIZE), floorDiv(position.z, VoxelChunk::SIZE));
+	VoxelChunk* chunk = findChunk(coords);
+	if (chunk == nullptr) {
+		if (voxel == 0) {
+			return;
+		}
+		chunk = &getOrCreateChunk(coords);
+	}
+
+	const glm::ivec3 local = position - coords * VoxelChunk::SIZE;
+	if (chunk->get(local.x, local.y, local.z) == voxel) {
+		return;
+	}
+	chunk->set(local.x, local.y, local.z, voxel);
+
+	// Faces of the neighbor on the shared border appear or disappear too
+	for (int axis = 0; axis < 3; axis++) {
+		glm::ivec3 offset(0);
+		if (local[axis] == 0) {
+			offset[axis] = -1;
+			markDirty(coords + offset);
+		} else if (local[axis] == VoxelChunk::SIZE - 1) {
+			offset[axis] = 1;
+			markDirty(coords + offset);
+		}
+	}
+}
+
+void VoxelWorld::generate(const glm::ivec3& chunkMin, const glm::ivec3& chunkMax, const std::function<Voxel(const glm::ivec3&)>& generator) {
+	std::vector<VoxelChunk*> chunks;
+	for (int z = chunkMin.z; z <= chunkMax.z; z++) {
+		for (int y = chunkMin.y; y <= chunkMax.y; y++) {
+			for (int x = chunkMin.x; x <= chunkMax.x; x++) {
+				chunks.push_back(&getOrCreateChunk(glm::ivec3(x, y, z)));
+			}
+		}
+	}
+
+	// Chunks outside of the box may see new faces on their border
+	for (int z = chunkMin.z - 1; z <= chunkMax.z + 1; z++) {
+		for (int y = chunkMin.y - 1; y <= chunkMax.y + 1; y++) {
+			for (int x = chunkMin.x - 1; x <= chunkMax.x + 1; x++) {
+				markDirty(glm::ivec3(x, y, z));
+			}
+		}
+	}
+
+	Job* root = m_jobs.parallelFor(0, static_cast<std::uint32_t>(chunks.size()), 1, [&](std::uint32_t begin, std::uint32_t end) {
+		for (std::uint32_t i = begin; i < end; i++) {
+			VoxelChunk& chunk = *chunks[i];
+			const glm::ivec3 origin = chunk.origin();
+			for (int z = 0; z < VoxelChunk::SIZE; z++) {
+				for (int y = 0; y < VoxelChunk::SIZE; y++) {
+					for (int x = 0; x < VoxelChunk::SIZE; x++) {
+						chunk.set(x, y, z, generator(origin + glm::ivec3(x, y, z)));
+					}
+				}
+			}
+			chunk.m_dirty = true;
+		}
+	});
+	m_jobs.run(root);
+	m_jobs.wait(root);
+}
+
+void VoxelWorld::update() {
+	std::vector<VoxelChunk*> dirtyChunks;
+	for (auto& entry : m_chunks) {
+		if (entry.second->m_dirty) {
+			dirtyChunks.push_back(entry.second.get());
+		}
+	}
+	m_meshedCount = dirtyChunks.size();
+	if (dirtyChunks.empty()) {
+		return;
+	}
+
+	// ------------------ Mesh on workers, voxels are not modified meanwhile
+	auto start = Clock::now();
+	Job* root = m_jobs.parallelFor(0, static_cast<std::uint32_t>(dirtyChunks.size()), 1, [&](std::uint32_t begin, std::uint32_t end) {
+		for (std::uint32_t i = begin; i < end; i++) {
+			meshChunk(*dirtyChunks[i]);
+		}
+	});
+	m_jobs.run(root);
+	m_jobs.wait(root);
+	m_meshingMs = elapsedMs(start);
+
+	// ------------------ Upload on the OpenGL thread
+	start = Clock::now();
+	for (VoxelChunk* chunk : dirtyChunks) {
+		upload(*chunk);
+		chunk->m_dirty = false;
+	}
+	m_uploadMs = elapsedMs(start);
+}
+
+void VoxelWorld::draw(const std::function<void(const glm::vec3&)>& setChunkOrigin) const {
+	forEachMesh([&](const glm::vec3& origin, GLuint vertexArray, GLuint, const IndexBuffer& indices) {
+		setChunkOrigin(origin);
+		GLCall(glBindVertexArray(vertexArray));
+		indices.draw(GL_TRIANGLES);
+	});
+	GLCall(glBindVertexArray(0));
+}
+
+void VoxelWorld::forEachMesh(const std::function<void(const glm::vec3& origin, GLuint vertexArray, GLuint depthVertexArray, const IndexBuffer& indices)>& visitor) const {
+	for (const auto& entry : m_chunks) {
+		const VoxelChunk& chunk = *entry.second;
+		if (chunk.m_quadCount == 0) {
+			continue;
+		}
+		visitor(glm::vec3(chunk.origin()), chunk.m_vao, chunk.m_depthVao, *chunk.m_ib);
+	}
+}
+
+void VoxelWorld::showMetrics() {
+	const double mb = 1024.0 * 1024.0;
+	std::size_t quads = 0, cpuBytes = 0, gpuBytes = 0;
+	for (const auto& entry : m_chunks) {
+		quads += entry.second->quadCount();
+		cpuBytes += entry.second->cpuBytes();
+		gpuBytes += entry.second->gpuBytes();
+	}
+
+	ImGui::Begin("Voxels");
+	ImGui::Text("Chunks : %zu, %d voxels wide", m_chunks.size(), VoxelChunk::SIZE);
+	ImGui::Text("Solid voxels : %zu", solidCount());
+	ImGui::Text("Quads : %zu (%zu triangles)", quads, quads * 2);
+	ImGui::Text("Memory : %.2f MB voxels, %.2f MB meshes", cpuBytes / mb, gpuBytes / mb);
+	ImGui::Text("Last update : %zu chunks, meshing %.2f ms, upload %.2f ms", m_meshedCount, m_meshingMs, m_uploadMs);
+	if (ImGui::TreeNode("Per chunk")) {
+		std::vector<const VoxelChunk*> chunks;
+		for (const auto& entry : m_chunks) {
+			chunks.push_back(entry.second.get());
+		}
+		ImGuiListClipper clipper(static_cast<int>(chunks.size()));
+		while (clipper.Step()) {
+			for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) {
+				const VoxelChunk& chunk = *chunks[i];
+				ImGui::Text("(%d, %d, %d) : %zu voxels, %zu quads, %.1f KB voxels, %.1f KB mesh", chunk.coords().x, chunk.coords().y, chunk.coords().z,
+					chunk.solidCount(), chunk.quadCount(), chunk.cpuBytes() / 1024.0, chunk.gpuBytes() / 1024.0);
+			}
+		}
+		ImGui::TreePop();
+	}
+	ImGui::End();
+}
+
+std::size_t VoxelWorld::chunkCount() const {
+	return m_chunks.size();
+}
+
+std::size_t VoxelWorld::solidCount() const {
+	std::size_t count = 0;
+	for (const auto& entry : m_chunks) {
+		count += entry.second->solidCount();
+	}
+	return count;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+///////////////////////////// PRIVATE METHODS ///////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+VoxelChunk* VoxelWorld::findChunk(const glm::ivec3& coords) const {
+	auto it = m_chunks.find(key(coords));
+	return it != m_chunks.end() ? it->second.get() : nullptr;
+}
+
+VoxelChunk& VoxelWorld::getOrCreateChunk(const glm::ivec3& coords) {
+	std::unique_ptr<VoxelChunk>& chunk = m_chunks[key(coords)];
+	if (!chunk) {
+		chunk = std::make_unique<VoxelChunk>(coords);
+	}
+	return *chunk;
+}
+
+void VoxelWorld::markDirty(const glm::ivec3& coords) {
+	if (VoxelChunk* chunk = findChunk(coords)) {
+		chunk->m_dirty = true;
+	}
+}
+
+void VoxelWorld::meshChunk(VoxelChunk& chunk) const {
+	const int size = VoxelChunk::SIZE;
+	chunk.m_vertices.clear();
+	chunk.m_indices.clear();
+	if (chunk.m_solidCount == 0) {
+		return;
+	}
+
+	// Neighbors, to remove faces hidden by the next chunk
+	const VoxelChunk* neighbors[6];
+	for (int face = 0; face < 6; face++) {
+		glm::ivec3 offset(0);
+		offset[face / 2] = face % 2 ? 1 : -1;
+		neighbors[face] = findChunk(chunk.m_coords + offset);
+	}
+	auto sample = [&](glm::ivec3 p) -> Voxel {
+		for (int axis = 0; axis < 3; axis++) {
+			if (p[axis] < 0 || p[axis] >= size) {
+				const VoxelChunk* neighbor = neighbors[axis * 2 + (p[axis] >= size)];
+				if (neighbor == nullptr) {
+					return 0;
+				}
+				p[axis] = (p[axis] + size) % size;
+				return neighbor->get(p.x, p.y, p.z);
+			}
+		}
+		return chunk.get(p.x, p.y, p.z);
+	};
+
+	Voxel mask[VoxelChunk::SIZE * VoxelChunk::SIZE];
+	for (int axis = 0; axis < 3; axis++) {
+		const int u = (axis + 1) % 3;
+		const int v = (axis + 2) % 3;
+
+		for (int side = 0; side < 2; side++) {
+			const std::uint8_t face = static_cast<std::uint8_t>(axis * 2 + side);
+			glm::ivec3 direction(0);
+			direction[axis] = side ? 1 : -1;
+
+			for (int slice = 0; slice < size; slice++) {
+				// ------------------ Visible faces of the slice
+				glm::ivec3 p;
+				p[axis] = slice;
+				for (int j = 0; j < size; j++) {
+					for (int i = 0; i < size; i++) {
+						p[u] = i;
+						p[v] = j;
+						const Voxel voxel = chunk.get(p.x, p.y, p.z);
+						mask[j * size + i] = voxel != 0 && sample(p + direction) == 0 ? voxel : 0;
+					}
+				}
+
+				// ------------------ Merge same material faces in rectangles
+				for (int j = 0; j < size; j++) {
+					for (int i = 0; i < size;) {
+						const Voxel material = mask[j * size + i];
+						if (material == 0) {
+							i++;
+							continue;
+						}
+
+						int width = 1;
+						while (i + width < size && mask[j * size + i + width] == material) {
+							width++;
+						}
+						int height = 1;
+						for (; j + height < size; height++) {
+							bool sameRow = true;
+							for (int k = 0; k < width && sameRow; k++) {
+								sameRow = mask[(j + height) * size + i + k] == material;
+							}
+							if (!sameRow) {
+								break;
+							}
+						}
+						for (int h = 0; h < height; h++) {
+							std::fill_n(&mask[(j + h) * size + i], width, static_cast<Voxel>(0));
+						}
+
+						// Counter clockwise seen from outside : u x v points along +axis
+						const std::uint32_t first = static_cast<std::uint32_t>(chunk.m_vertices.size());
+						const int corners[4][2] = { { 0, 0 }, { width, 0 }, { width, height }, { 0, height } };
+						for (const auto& corner : corners) {
+							glm::ivec3 position;
+							position[axis] = slice + side;
+							position[u] = i + corner[0];
+							position[v] = j + corner[1];
+							chunk.m_vertices.push_back({
+								static_cast<std::uint8_t>(position.x), static_cast<std::uint8_t>(position.y), static_cast<std::uint8_t>(position.z),
+								face, material, static_cast<std::uint8_t>(corner[0]), static_cast<std::uint8_t>(corner[1]), 0
+							});
+						}
+						if (side) {
+							chunk.m_indices.insert(chunk.m_indices.end(), { first, first + 1, first + 2, first + 2, first + 3, first });
+						} else {
+							chunk.m_indices.insert(chunk.m_indices.end(), { first, first + 2, first + 1, first + 2, first, first + 3 });
+						}
+
+						i += width;
+					}
+				}
+			}
+		}
+	}
+}
+
+void VoxelWorld::upload(VoxelChunk& chunk) {
+	// Emptied by edits, its buffers would be kept for nothing
+	if (chunk.m_vertices.empty()) {
+		chunk.releaseMesh();
+		std::vector<std::uint32_t>().swap(chunk.m_indices);
+		return;
+	}
+
+	if (chunk.m_vao == 0) {
+		chunk.m_ib = std::make_unique<IndexBuffer>();
+		GLCall(glGenBuffers(1, &chunk.m_vb));
+		GLCall(glGenVertexArrays(1, &chunk.m_vao));
+		GLCall(glBindVertexArray(chunk.m_vao));
+		GLCall(glBindBuffer(GL_ARRAY_BUFFER, chunk.m_vb));
+		GLCall(glEnableVertexAttribArray(0));
+		GLCall(glVertexAttribIPointer(0, 4, GL_UNSIGNED_BYTE, sizeof(VoxelVertex), (void*)offsetof(VoxelVertex, x)));
+		GLCall(glEnableVertexAttribArray(1));
+		GLCall(glVertexAttribIPointer(1, 4, GL_UNSIGNED_BYTE, sizeof(VoxelVertex), (void*)offsetof(VoxelVertex, material)));
+		chunk.m_ib->bind();
+
+		// Same bytes, the corner converted to floats is all a depth only pass reads
+		GLCall(glGenVertexArrays(1, &chunk.m_depthVao));
+		GLCall(glBindVertexArray(chunk.m_depthVao));
+		GLCall(glEnableVertexAttribArray(0));
+		GLCall(glVertexAttribPointer(0, 3, GL_UNSIGNED_BYTE, GL_FALSE, sizeof(VoxelVertex), (void*)offsetof(VoxelVertex, x)));
+		chunk.m_ib->bind();
+		GLCall(glBindVertexArray(0));
+		GLCall(glBindBuffer(GL_ARRAY_BUFFER, 0));
+	}
+
+	GLCall(glBindBuffer(GL_ARRAY_BUFFER, chunk.m_vb));
+	GLCall(glBufferData(GL_ARRAY_BUFFER, chunk.m_vertices.size() * sizeof(VoxelVertex), chunk.m_vertices.data(), GL_STATIC_DRAW));
+	GLCall(glBindBuffer(GL_ARRAY_BUFFER, 0));
+	chunk.m_ib->setData(chunk.m_indices.data(), chunk.m_indices.size(), chunk.m_vertices.size());
+
+	chunk.m_quadCount = chunk.m_vertices.size() / 4;
+	chunk.m_gpuBytes = chunk.m_vertices.size() * sizeof(VoxelVertex) + chunk.m_ib->sizeInBytes();
+
+	// The GPU has its copy
+	std::vector<VoxelVertex>().swap(chunk.m_vertices);
+	std::vector<std::uint32_t>().swap(chunk.m_indices);
+}
+
+std::int64_t VoxelWorld::key(const glm::ivec3& coords) {
+	const std::int64_t mask = (1 << 21) - 1;
+	return (static_cast<std::int64_t>(coords.x) & mask) | ((static_cast<std::int64_t>(coords.y) & mask) << 21) | ((static_cast<std::int64_t>(coords.z) & mask) << 42);
+}
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "index-buffer.h"
+
+class JobSystem;
+
+/**
+ * @brief 0 is empty, any other value is a material
+ */
+using Voxel = std::uint8_t;
+
+/**
+ * @brief Corner of a merged quad, relative to its chunk
+ */
+struct VoxelVertex {
+    std::uint8_t x, y, z;
+    std::uint8_t face; // 0 -X, 1 +X, 2 -Y, 3 +Y, 4 -Z, 5 +Z
+    std::uint8_t material;
+    std::uint8_t u, v; // In voxels along the quad, to repeat textures
+    std::uint8_t padding;
+};
+
+/**
+ * @brief Cube of SIZE³ voxels with its own mesh
+ */
+class VoxelChunk {
+public:
+    static constexpr int SIZE = 32;
+
+    VoxelChunk(const glm::ivec3& coords);
+    ~VoxelChunk();
+
+    VoxelChunk(const VoxelChunk&) = delete;
+    VoxelChunk& operator=(const VoxelChunk&) = delete;
+
+    Voxel get(int x, int y, int z) const;
+    void set(int x, int y, int z, Voxel voxel);
+
+    const glm::ivec3& coords() const;
+    glm::ivec3 origin() const;
+    bool isDirty() const;
+    std::size_t solidCount() const;
+    std::size_t quadCount() const;
+    std::size_t cpuBytes() const;
+    std::size_t gpuBytes() const;
+
+private:
+    friend class VoxelWorld;
+
+    static int index(int x, int y, int z) { return (z * SIZE + y) * SIZE + x; }
+
+    // Delete the OpenGL objects, on the OpenGL thread
+    void releaseMesh();
+
+private:
+    glm::ivec3 m_coords;
+    std::vector<Voxel> m_voxels;
+    std::size_t m_solidCount;
+    bool m_dirty;
+
+    // Mesh built on a worker, waiting to be uploaded
+    std::vector<VoxelVertex> m_vertices;
+    std::vector<std::uint32_t> m_indices;
+
+    // Created on the first upload, so that chunks can be filled on any thread
+    GLuint m_vao;
+    GLuint m_depthVao; // Positions only, as floats
+    GLuint m_vb;
+    std::unique_ptr<IndexBuffer> m_ib;
+    std::size_t m_quadCount;
+    std::size_t m_gpuBytes;
+};
+
+/**
+ * @brief Sparse grid of chunks meshed with hidden face removal and greedy quad merging
+ * @note Only chunks whose voxels changed (or whose neighbor changed on the shared border) are meshed again.
+ *       Meshing runs on the JobSystem, uploads on the OpenGL thread in update().
+ *
+ * Vertex attributes : 0 uvec4 (x, y, z, face), 1 uvec4 (material, u, v, 0)
+ * Depth only vertex array : 0 vec3 (x, y, z)
+ */
+class VoxelWorld {
+public:
+    VoxelWorld(JobSystem& jobs);
+    ~VoxelWorld() = default;
+
+    VoxelWorld(const VoxelWorld&) = delete;
+    VoxelWorld& operator=(const VoxelWorld&) = delete;
+
+    Voxel get(const glm::ivec3& position) const;
+    void set(const glm::ivec3& position, Voxel voxel);
+
+    /**
+     * @brief Fill every chunk from chunkMin to chunkMax included, in parallel
+     * @param generator - Called with world positions from worker threads
+     */
+    void generate(const glm::ivec3& chunkMin, const glm::ivec3& chunkMax, const std::function<Voxel(const glm::ivec3&)>& generator);
+
+    /**
+     * @brief Mesh dirty chunks then upload them, must be called on the OpenGL thread
+     */
+    void update();
+
+    /**
+     * @brief Draw every chunk with the pipeline currently bound
+     * @param setChunkOrigin - Called before each chunk is drawn, with its origin in voxels
+     */
+    void draw(const std::function<void(const glm::vec3&)>& setChunkOrigin) const;
+
+    /**
+     * @brief Visit every uploaded chunk which has quads, to submit them elsewhere (eg: a RenderQueue)
+     * @note depthVertexArray reads the same buffers with positions only, for depth pre-passes
+     */
+    void forEachMesh(const std::function<void(const glm::vec3& origin, GLuint vertexArray, GLuint depthVertexArray, const IndexBuffer& indices)>& visitor) const;
+
+    void showMetrics();
+
+    std::size_t chunkCount() const;
+    std::size_t solidCount() const;
+
+private:
+    VoxelChunk* findChunk(const glm::ivec3& coords) const;
+    VoxelChunk& getOrCreateChunk(const glm::ivec3& coords);
+    void markDirty(const glm::ivec3& coords);
+    void meshChunk(VoxelChunk& chunk) const;
+    void upload(VoxelChunk& chunk);
+
+    static std::int64_t key(const glm::ivec3& coords);
+
+private:
+    JobSystem& m_jobs;
+    std::unordered_map<std::int64_t, std::unique_ptr<VoxelChunk>> m_chunks;
+
+    double m_meshingMs;
+    double m_uploadMs;
+    std::size_t m_meshedCount;
+};
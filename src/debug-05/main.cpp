@@ -8,6 +8,7 @@
 #include <unordered_map>
 
 #include "common/app.h"
+#include "common/frame-loop.h"
 #include "common/gl-exception.h"
 #include "common/square-data.h"
 
@@ -153,7 +154,9 @@ int main(int argc, char *argv[]) {
         GLCall(glUseProgram(0));
     }
 
+    FrameLoop frameLoop;
     float counter = 0.0f;
+    float previousCounter = 0.0f;
     while (app.isRunning()) {
         SDL_Event e;
         while (SDL_PollEvent(&e)) {
@@ -164,17 +167,24 @@ int main(int argc, char *argv[]) {
             };
         }
 
-        counter += 0.05f;
-        if (counter > 100) {
-            counter = 0;
+        // Fixed timestep simulation
+        frameLoop.advance();
+        while (frameLoop.step()) {
+            previousCounter = counter;
+            counter += 0.05f;
+            if (counter > 100) {
+                counter = 0;
+                previousCounter = 0;
+            }
         }
+        float renderCounter = glm::mix(previousCounter, counter, static_cast<float>(frameLoop.alpha()));
 
         app.beginFrame();
 
         // Update uniforms
         GLCall(glUseProgram(pipeline));
         {
-            modelMat = glm::rotate(glm::mat4(1.0f), counter, glm::vec3(0, 1, 0));
+            modelMat = glm::rotate(glm::mat4(1.0f), renderCounter, glm::vec3(0, 1, 0));
             GLCall(glUniformMatrix4fv(getUniformLocation("uModel", pipeline), 1, GL_FALSE, &modelMat[0][0]));
         }
         {
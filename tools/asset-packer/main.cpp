@@ -0,0 +1,117 @@
+#include <spdlog/spdlog.h>
+#include <stb_image/stb_image.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "common/asset-pack.h"
+#include "common/job-system.h"
+#include "common/mesh-importer.h"
+#include "common/mesh-optimizer.h"
+#include "common/square-data.h"
+
+// Offline packer : asset-packer [--bc1] output.pack input...
+// Shaders (.vert .frag .glsl) are stored as text, meshes (.obj .gltf .glb) as interleaved vertices,
+// images as RGBA8 or BC1 with their mip chain, and "builtin:cube" stores the cube of square-data.h.
+// Meshes are reordered for the vertex cache, overdraw and vertex fetch before being stored.
+
+namespace {
+	bool endsWith(const std::string& value, const std::string& suffix) {
+		return value.size() >= suffix.size() && value.compare(value.size() - suffix.size(), suffix.size(), suffix) == 0;
+	}
+
+	bool addShader(AssetPackWriter& writer, const std::string& filepath) {
+		std::ifstream stream(filepath);
+		if (!stream.is_open()) {
+			spdlog::error("Failed to open file : |{}|", filepath);
+			return false;
+		}
+		std::stringstream buffer;
+		buffer << stream.rdbuf();
+		writer.addShader(filepath, buffer.str());
+		return true;
+	}
+
+	bool addImage(AssetPackWriter& writer, const std::string& filepath, assetPack::TextureFormat format) {
+		int width, height, channels;
+		stbi_uc* pixels = stbi_load(filepath.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+		if (pixels == nullptr) {
+			spdlog::error("Failed to load image |{}| : {}", filepath, stbi_failure_reason());
+			return false;
+		}
+		writer.addTexture(filepath, pixels, width, height, format);
+		stbi_image_free(pixels);
+		return true;
+	}
+
+	bool addMesh(AssetPackWriter& writer, MeshImporter& importer, const std::string& filepath) {
+		MeshData mesh;
+		if (!importer.load(filepath, mesh)) {
+			return false;
+		}
+		meshOptimizer::optimize(mesh, filepath.c_str());
+		writer.addMesh(filepath, mesh.vertices, mesh.indices);
+		return true;
+	}
+
+	void addCube(AssetPackWriter& writer, const std::string& name) {
+		MeshData mesh;
+		mesh.vertices.resize(std::size(squareData::positions));
+		for (std::size_t i = 0; i < mesh.vertices.size(); i++) {
+			mesh.vertices[i] = {
+				{ squareData::positions[i].x, squareData::positions[i].y, squareData::positions[i].z },
+				{ squareData::normals[i].x, squareData::normals[i].y, squareData::normals[i].z },
+				{ squareData::texCoords[i].x, squareData::texCoords[i].y }
+			};
+		}
+		mesh.indices.assign(std::begin(squareData::indices), std::end(squareData::indices));
+		meshOptimizer::optimize(mesh, name.c_str());
+		writer.addMesh(name, mesh.vertices, mesh.indices);
+	}
+}
+
+int main(int argc, char *argv[]) {
+	std::vector<std::string> args(argv + 1, argv + argc);
+	assetPack::TextureFormat textureFormat = assetPack::TextureFormat::RGBA8;
+	if (!args.empty() && args.front() == "--bc1") {
+		textureFormat = assetPack::TextureFormat::BC1;
+		args.erase(args.begin());
+	}
+	if (args.size() < 2) {
+		spdlog::info("Usage : asset-packer [--bc1] output.pack input...");
+		return 1;
+	}
+
+	// Same orientation as the runtime loaders
+	stbi_set_flip_vertically_on_load(true);
+
+	JobSystem jobs;
+	MeshImporter importer(jobs);
+	AssetPackWriter writer;
+	bool succeeded = true;
+	for (std::size_t i = 1; i < args.size(); i++) {
+		const std::string& input = args[i];
+		if (input.rfind("builtin:", 0) == 0) {
+			if (input != "builtin:cube") {
+				spdlog::error("Unknown builtin asset |{}|", input);
+				succeeded = false;
+				continue;
+			}
+			addCube(writer, input);
+		} else if (endsWith(input, ".vert") || endsWith(input, ".frag") || endsWith(input, ".glsl")) {
+			succeeded &= addShader(writer, input);
+		} else if (endsWith(input, ".obj") || endsWith(input, ".gltf") || endsWith(input, ".glb")) {
+			succeeded &= addMesh(writer, importer, input);
+		} else {
+			succeeded &= addImage(writer, input, textureFormat);
+		}
+	}
+
+	if (!succeeded || !writer.write(args[0])) {
+		spdlog::error("Pack |{}| was not written", args[0]);
+		return 1;
+	}
+	spdlog::info("Packed {} assets into {}", args.size() - 1, args[0]);
+	return 0;
+}